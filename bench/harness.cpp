@@ -0,0 +1,110 @@
+#include "harness.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::string json_string(const std::string& s){
+    std::string out = "\"";
+    for (char c : s){
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+// Value of the string that follows `key` at or after `pos` in our own JSON
+// (no escapes in benchmark names); npos when there is none
+std::size_t find_key(const std::string& text, const std::string& key, std::size_t pos){
+    std::size_t k = text.find("\"" + key + "\"", pos);
+    if (k == std::string::npos) return k;
+    std::size_t colon = text.find(':', k);
+    return colon == std::string::npos ? colon : colon + 1;
+}
+
+// name → time_ns of every benchmark in a write_json file
+std::map<std::string, double> read_baseline(const std::string& path){
+    std::ifstream in(path);
+    if (!in){
+        throw std::runtime_error("compare_with_baseline: Cannot open " + path);
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string text = buffer.str();
+
+    std::map<std::string, double> times;
+    std::size_t pos = text.find("\"benchmarks\"");
+    while (pos != std::string::npos){
+        pos = find_key(text, "name", pos);
+        if (pos == std::string::npos) break;
+        std::size_t open = text.find('"', pos);
+        std::size_t close = text.find('"', open + 1);
+        std::string name = text.substr(open + 1, close - open - 1);
+
+        pos = find_key(text, "time_ns", close);
+        if (pos == std::string::npos) break;
+        times[name] = std::strtod(text.c_str() + pos, nullptr);
+    }
+    return times;
+}
+
+} // namespace
+
+void BenchRunner::report(const BenchResult& r){
+    std::fprintf(stderr, "%-40s %12.3f us %10.2f GFLOP/s %10.2f GB/s\n",
+                 r.name.c_str(), r.seconds * 1e6, r.gflops(), r.gbytes_per_s());
+}
+
+void write_json(std::ostream& out, const BenchContext& context, const std::vector<BenchResult>& results){
+    out << "{\n  \"context\": {";
+    for (std::size_t i = 0; i < context.size(); ++i){
+        out << (i ? ", " : "") << json_string(context[i].first) << ": " << json_string(context[i].second);
+    }
+    out << "},\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i){
+        const BenchResult& r = results[i];
+        out << std::setprecision(6)
+            << "    {\"name\": " << json_string(r.name)
+            << ", \"iterations\": " << r.iterations
+            << ", \"time_ns\": " << r.seconds * 1e9
+            << ", \"gflops\": " << r.gflops()
+            << ", \"gbytes_per_s\": " << r.gbytes_per_s() << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+int compare_with_baseline(std::ostream& out, const std::string& path,
+                          const std::vector<BenchResult>& results, double threshold){
+    std::map<std::string, double> baseline = read_baseline(path);
+
+    int regressions = 0;
+    out << std::left << std::setw(40) << "benchmark"
+        << std::right << std::setw(14) << "baseline us" << std::setw(14) << "current us"
+        << std::setw(10) << "change" << "\n";
+    for (const BenchResult& r : results){
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0){
+            out << std::left << std::setw(40) << r.name << std::right << std::setw(14) << "-"
+                << std::setw(14) << std::fixed << std::setprecision(3) << r.seconds * 1e6 << std::setw(10) << "new" << "\n";
+            continue;
+        }
+        double before = it->second * 1e-3;
+        double now = r.seconds * 1e6;
+        double change = now / before - 1.0;
+        bool regressed = change > threshold;
+        regressions += regressed;
+        out << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(14) << before << std::setw(14) << now
+            << std::setw(9) << std::showpos << std::setprecision(1) << change * 100 << "%" << std::noshowpos
+            << (regressed ? "  REGRESSION" : "") << "\n";
+    }
+    out << regressions << " regression(s) beyond " << std::setprecision(0) << threshold * 100 << "%\n";
+    return regressions;
+}
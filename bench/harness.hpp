@@ -0,0 +1,98 @@
+#ifndef BENCH_HARNESS_HPP
+#define BENCH_HARNESS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// One timed benchmark. `flops` and `bytes` are per iteration (the work a
+/// call does and the memory it must at least move); zero where they do
+/// not apply
+struct BenchResult {
+    std::string name;
+    long long iterations;
+    double seconds;        // median time of one iteration
+    double flops;
+    double bytes;
+
+    double gflops() const { return seconds > 0 ? flops / seconds * 1e-9 : 0.0; }
+    double gbytes_per_s() const { return seconds > 0 ? bytes / seconds * 1e-9 : 0.0; }
+};
+
+/// Runs benchmarks and collects their results.
+///
+/// Each benchmark is called once to warm up (buffers, page faults, thread
+/// pool), then timed in SAMPLES batches. The batch size is calibrated so
+/// all batches together take about `min_time` seconds, and the reported time
+/// is the median batch divided by its size, which shrugs off the odd
+/// preempted sample.
+class BenchRunner {
+    public:
+        static constexpr int SAMPLES = 5;
+
+        /// Only benchmarks whose name contains `filter` run
+        BenchRunner(double min_time, std::string filter)
+            : min_time(min_time), filter(std::move(filter)) {}
+
+        template <typename Fn>
+        void run(const std::string& name, double flops, double bytes, Fn&& fn){
+            if (!filter.empty() && name.find(filter) == std::string::npos) return;
+            using Clock = std::chrono::steady_clock;
+
+            fn();
+
+            // Grow the batch until one takes a sample's share of min_time
+            double sample_time = min_time / SAMPLES;
+            long long batch = 1;
+            for (;;){
+                Clock::time_point start = Clock::now();
+                for (long long i = 0; i < batch; ++i) fn();
+                double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+                if (elapsed >= sample_time) break;
+                double grow = elapsed > 0 ? 1.2 * sample_time / elapsed : 10.0;
+                batch = std::max(batch + 1, static_cast<long long>(batch * std::min(grow, 10.0)));
+            }
+
+            std::vector<double> times;
+            for (int s = 0; s < SAMPLES; ++s){
+                Clock::time_point start = Clock::now();
+                for (long long i = 0; i < batch; ++i) fn();
+                times.push_back(std::chrono::duration<double>(Clock::now() - start).count() / batch);
+            }
+            std::nth_element(times.begin(), times.begin() + SAMPLES / 2, times.end());
+
+            BenchResult r{name, batch * SAMPLES, times[SAMPLES / 2], flops, bytes};
+            report(r);
+            collected.push_back(r);
+        }
+
+        const std::vector<BenchResult>& results() const { return collected; }
+
+    private:
+        double min_time;
+        std::string filter;
+        std::vector<BenchResult> collected;
+
+        // One progress line on stderr
+        static void report(const BenchResult& r);
+};
+
+/// Key/value pairs describing the run (ISA, threads, build type, ...)
+using BenchContext = std::vector<std::pair<std::string, std::string>>;
+
+/// Writes {"context": {...}, "benchmarks": [...]}, one benchmark per line,
+/// with time_ns, gflops and gbytes_per_s for each
+void write_json(std::ostream& out, const BenchContext& context, const std::vector<BenchResult>& results);
+
+/// Compares `results` with the benchmarks of a JSON file written by
+/// write_json, matched by name, and prints a table to `out`. A benchmark
+/// regressed when its time grew by more than `threshold` (0.1 = 10%);
+/// returns how many did. Throws std::runtime_error if the file cannot be
+/// read
+int compare_with_baseline(std::ostream& out, const std::string& path,
+                          const std::vector<BenchResult>& results, double threshold);
+
+#endif
@@ -0,0 +1,352 @@
+// Microbenchmarks for Neuronite: GEMM shapes, elementwise ops, every
+// layer's forward and backward, optimizer steps, and full training and
+// inference steps of representative MLPs.
+//
+//     neuronite_bench [--filter TEXT] [--out FILE] [--baseline FILE]
+//                     [--threshold 0.10] [--min-time SECONDS] [--double]
+//
+// Progress goes to stderr and the JSON results to --out (or stdout). With
+// --baseline, the run is compared against an earlier JSON file and the
+// exit status is 1 if any benchmark slowed down by more than --threshold.
+#include "harness.hpp"
+#include "matrix.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "activation_sigmoid.hpp"
+#include "dropout.hpp"
+#include "batch_norm.hpp"
+#include "loss_logits.hpp"
+#include "adam_optimizer.hpp"
+#include "sgd_optimizer.hpp"
+#include "kernels.hpp"
+#include "thread_pool.hpp"
+#include "utils_random.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef NEURONITE_BUILD_TYPE
+#define NEURONITE_BUILD_TYPE "unknown"
+#endif
+
+namespace {
+
+struct Options {
+    std::string filter;
+    std::string out;
+    std::string baseline;
+    double threshold = 0.10;
+    double min_time = 0.5;
+    bool use_double = false;
+};
+
+template <typename T>
+Matrix<T> random_matrix(int rows, int cols){
+    Matrix<T> m(rows, cols);
+    initialize_random(m, -1.0, 1.0);
+    return m;
+}
+
+template <typename T>
+void bench_gemm(BenchRunner& runner){
+    struct Shape { int m, k, n; };
+    // Batch-1 inference, narrow MLP layers, an MNIST-sized layer, squares
+    const Shape shapes[] = {
+        {1, 512, 512}, {32, 64, 64}, {64, 256, 256}, {128, 784, 256},
+        {256, 512, 512}, {512, 512, 512}, {1024, 1024, 1024},
+    };
+    for (const Shape& s : shapes){
+        Matrix<T> a = random_matrix<T>(s.m, s.k), b = random_matrix<T>(s.k, s.n), c;
+        std::string dims = std::to_string(s.m) + "x" + std::to_string(s.k) + "x" + std::to_string(s.n);
+        double flops = 2.0 * s.m * s.k * s.n;
+        double bytes = (double(s.m) * s.k + double(s.k) * s.n + double(s.m) * s.n) * sizeof(T);
+        runner.run("dot/" + dims, flops, bytes, [&]{
+            Matrix<T>::dot_into(a, Transpose::No, b, Transpose::No, c);
+        });
+    }
+
+    // The transposed products of a Dense backward pass (256 × 512 × 512)
+    Matrix<T> x = random_matrix<T>(256, 512), g = random_matrix<T>(256, 512), w = random_matrix<T>(512, 512), c;
+    double flops = 2.0 * 256 * 512 * 512;
+    double bytes = (2.0 * 256 * 512 + 512.0 * 512) * sizeof(T);
+    runner.run("dot_tn/512x256x512", flops, bytes, [&]{
+        Matrix<T>::dot_into(x, Transpose::Yes, g, Transpose::No, c);
+    });
+    runner.run("dot_nt/256x512x512", flops, bytes, [&]{
+        Matrix<T>::dot_into(g, Transpose::No, w, Transpose::Yes, c);
+    });
+}
+
+template <typename T>
+void bench_elementwise(BenchRunner& runner){
+    for (int rows : {64, 1024}){
+        const int cols = 1024;
+        double n = double(rows) * cols;
+        Matrix<T> a = random_matrix<T>(rows, cols), b = random_matrix<T>(rows, cols), out(rows, cols);
+        std::string size = "/" + std::to_string(rows) + "x" + std::to_string(cols);
+
+        runner.run("add" + size, n, 3 * n * sizeof(T), [&]{ Matrix<T>::add_into(a, b, out); });
+        runner.run("mul" + size, n, 3 * n * sizeof(T), [&]{ Matrix<T>::mul_into(a, b, out); });
+        runner.run("scale" + size, n, 2 * n * sizeof(T), [&]{ out *= T(0.999); });
+        runner.run("axpy" + size, 2 * n, 3 * n * sizeof(T), [&]{ out.axpy(T(1e-3), a); });
+    }
+}
+
+// Forward and backward of one layer on a (batch × width) input. Backward
+// reuses the caches of the last forward, as in training
+template <typename T>
+void bench_layer(BenchRunner& runner, const std::string& name, Layer<T>& layer,
+                 int batch, int in, int out, double forward_flops, double backward_flops){
+    Matrix<T> x = random_matrix<T>(batch, in), y, g = random_matrix<T>(batch, out), dx;
+    double activations = double(batch) * (in + out);
+    double weights = double(layer.param_count());
+
+    runner.run("forward/" + name, forward_flops, (activations + weights) * sizeof(T), [&]{
+        layer.forward_into(x, y);
+    });
+    layer.forward_into(x, y);
+    runner.run("backward/" + name, backward_flops, (2 * activations + 2 * weights) * sizeof(T), [&]{
+        layer.backward_into(g, dx);
+    });
+}
+
+template <typename T>
+void bench_layers(BenchRunner& runner){
+    const int batch = 256, width = 512;
+    double gemm = 2.0 * batch * width * width;
+    double n = double(batch) * width;
+    std::string shape = std::to_string(batch) + "x" + std::to_string(width);
+
+    DenseLayer<T> dense(width, width);
+    bench_layer<T>(runner, "dense/" + shape, dense, batch, width, width, gemm, 2 * gemm);
+    FusedDenseLayer<T> fused(width, width, Activation::ReLU);
+    bench_layer<T>(runner, "fused_dense_relu/" + shape, fused, batch, width, width, gemm + n, 2 * gemm + n);
+    ActivationReLU<T> relu;
+    bench_layer<T>(runner, "relu/" + shape, relu, batch, width, width, n, n);
+    ActivationSigmoid<T> sigmoid;
+    bench_layer<T>(runner, "sigmoid/" + shape, sigmoid, batch, width, width, 4 * n, 3 * n);
+    Dropout<T> dropout(0.5);
+    bench_layer<T>(runner, "dropout/" + shape, dropout, batch, width, width, n, n);
+    BatchNorm<T> batch_norm(width, width);
+    bench_layer<T>(runner, "batch_norm/" + shape, batch_norm, batch, width, width, 8 * n, 12 * n);
+}
+
+template <typename T>
+void bench_optimizers(BenchRunner& runner){
+    const int n = 1 << 20;
+    Matrix<T> params = random_matrix<T>(1, n), grads = random_matrix<T>(1, n);
+    grads *= T(1e-3);
+
+    // θ, g, m, v read and θ, m, v written; about a dozen flops per element
+    AdamOptimizer<T> adam(1e-4);
+    int t = 0;
+    runner.run("adam_step/1M", 12.0 * n, 7.0 * n * sizeof(T), [&]{ adam.step(params, grads, ++t); });
+
+    SGDOptimizer<T> sgd(1e-4, 0.9);
+    t = 0;
+    runner.run("sgd_momentum_step/1M", 4.0 * n, 5.0 * n * sizeof(T), [&]{ sgd.step(params, grads, ++t); });
+}
+
+// Layer widths of the benchmarked MLPs: hidden layers are Dense+ReLU,
+// the output layer plain Dense feeding a logit loss
+struct Mlp {
+    const char* name;
+    std::vector<int> widths;
+    int batch;
+};
+
+template <typename T>
+void bench_models(BenchRunner& runner){
+    const Mlp mlps[] = {
+        {"mlp_narrow", {16, 32, 32, 1}, 32},
+        {"mlp_mnist", {784, 256, 128, 10}, 128},
+        {"mlp_wide", {512, 512, 512, 1}, 256},
+    };
+    for (const Mlp& mlp : mlps){
+        std::vector<std::unique_ptr<Layer<T>>> layers;
+        Model<T> model;
+        double macs = 0, params = 0;
+        for (std::size_t i = 0; i + 1 < mlp.widths.size(); ++i){
+            int in = mlp.widths[i], out = mlp.widths[i + 1];
+            bool last = i + 2 == mlp.widths.size();
+            if (last) layers.push_back(std::make_unique<DenseLayer<T>>(in, out));
+            else layers.push_back(std::make_unique<FusedDenseLayer<T>>(in, out, Activation::ReLU));
+            model.add(layers.back().get());
+            macs += double(in) * out;
+            params += double(in) * out + out;
+        }
+
+        int batch = mlp.batch;
+        Matrix<T> x = random_matrix<T>(batch, mlp.widths.front());
+        Matrix<T> y(batch, mlp.widths.back());
+        for (std::size_t i = 0; i < y.size(); ++i) y.data()[i] = T(i % 2);
+
+        LossBCEWithLogits<T> loss;
+        AdamOptimizer<T> adam(1e-4);
+        Matrix<T> grad;
+        int t = 0;
+        // Forward 2 flops per MAC and row, backward 4; Adam reads and
+        // writes the parameters, moments and gradients
+        runner.run(std::string("train_step/") + mlp.name, 6.0 * batch * macs, 7.0 * params * sizeof(T), [&]{
+            Matrix<T> prediction = model.forward(x);
+            loss.forward(prediction, y);
+            loss.backward_into(grad);
+            model.backward(grad);
+            adam.step(model.get_parameters(), model.get_gradients(), ++t);
+        });
+
+        Matrix<T> output;
+        PredictScratch<T> scratch;
+        runner.run(std::string("predict/") + mlp.name, 2.0 * batch * macs, params * sizeof(T), [&]{
+            model.predict(x, output, scratch);
+        });
+        Matrix<T> one = random_matrix<T>(1, mlp.widths.front());
+        runner.run(std::string("predict_batch1/") + mlp.name, 2.0 * macs, params * sizeof(T), [&]{
+            model.predict(one, output, scratch);
+        });
+    }
+}
+
+// 16-bit conversions, and forward + backward of a wide Dense/ReLU MLP at
+// each precision (Model::set_precision). The optimizer step is left out:
+// it is the same fp32 sweep in every case
+template <typename T>
+void bench_mixed_precision(BenchRunner& runner){
+    const std::size_t n = 1 << 20;
+    Matrix<T> values = random_matrix<T>(1, static_cast<int>(n));
+    std::vector<std::uint16_t> packed(n);
+    for (Precision p : {Precision::BFloat16, Precision::Float16}){
+        std::string name = half::precision_name(p);
+        runner.run("half_encode/" + name, double(n), double(n) * (sizeof(T) + 2), [&]{
+            half::encode(p, values.data(), packed.data(), n);
+        });
+        runner.run("half_decode/" + name, double(n), double(n) * (sizeof(T) + 2), [&]{
+            half::decode(p, packed.data(), values.data(), n);
+        });
+    }
+
+    const int width = 1024, depth = 3, batch = 256;
+    for (Precision p : {Precision::Full, Precision::BFloat16, Precision::Float16}){
+        std::vector<std::unique_ptr<Layer<T>>> layers;
+        Model<T> model;
+        for (int i = 0; i < depth; ++i){
+            layers.push_back(std::make_unique<DenseLayer<T>>(width, width));
+            layers.push_back(std::make_unique<ActivationReLU<T>>());
+        }
+        for (std::unique_ptr<Layer<T>>& layer : layers) model.add(layer.get());
+        model.set_precision(p);
+
+        Matrix<T> x = random_matrix<T>(batch, width);
+        Matrix<T> grad = random_matrix<T>(batch, width);
+        double macs = double(depth) * width * width;
+        runner.run(std::string("forward_backward/") + half::precision_name(p) + "/dense_wide",
+                   6.0 * batch * macs, 3.0 * macs * (p == Precision::Full ? sizeof(T) : 2), [&]{
+            model.forward(x);
+            model.backward(grad);
+        });
+    }
+}
+
+// A first Dense layer on wide input with 1% nonzeros, fed dense and as a
+// SparseMatrix: forward plus the backward a first layer needs (the dense
+// layer also computes ∂L/∂X, as it does in a model)
+template <typename T>
+void bench_sparse_input(BenchRunner& runner){
+    const int features = 8192, outputs = 64, batch = 256;
+    Matrix<T> dense(batch, features);
+    for (int i = 0; i < batch; ++i){
+        for (int j = (i * 37) % 100; j < features; j += 100) dense(i, j) = T(1) + T(j % 7) / 7;
+    }
+    SparseMatrix<T> sparse = SparseMatrix<T>::from_dense(dense);
+    Matrix<T> grad = random_matrix<T>(batch, outputs);
+    double macs = double(batch) * features * outputs;
+    double nnz = static_cast<double>(sparse.nnz());
+
+    DenseLayer<T> layer(features, outputs);
+    Matrix<T> output, grad_input;
+    runner.run("first_layer/dense", 6.0 * macs, (double(batch) * features + 3.0 * features * outputs) * sizeof(T), [&]{
+        layer.forward_into(dense, output);
+        layer.backward_into(grad, grad_input);
+    });
+    runner.run("first_layer/sparse", 4.0 * nnz * outputs,
+               2.0 * nnz * (sizeof(T) + sizeof(int)) + 3.0 * nnz * outputs * sizeof(T), [&]{
+        layer.forward_sparse_into(sparse, output);
+        layer.backward_sparse_into(grad);
+    });
+}
+
+template <typename T>
+std::vector<BenchResult> run_all(const Options& options){
+    set_random_seed(42);
+    BenchRunner runner(options.min_time, options.filter);
+    bench_gemm<T>(runner);
+    bench_elementwise<T>(runner);
+    bench_layers<T>(runner);
+    bench_optimizers<T>(runner);
+    bench_models<T>(runner);
+    bench_mixed_precision<T>(runner);
+    bench_sparse_input<T>(runner);
+    return runner.results();
+}
+
+[[noreturn]] void usage(const char* argv0){
+    std::cerr << "usage: " << argv0 << " [--filter TEXT] [--out FILE] [--baseline FILE]"
+              << " [--threshold FRACTION] [--min-time SECONDS] [--double]\n";
+    std::exit(2);
+}
+
+Options parse(int argc, char** argv){
+    Options o;
+    for (int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) usage(argv[0]);
+            return argv[++i];
+        };
+        if (arg == "--filter") o.filter = value();
+        else if (arg == "--out") o.out = value();
+        else if (arg == "--baseline") o.baseline = value();
+        else if (arg == "--threshold") o.threshold = std::atof(value().c_str());
+        else if (arg == "--min-time") o.min_time = std::atof(value().c_str());
+        else if (arg == "--double") o.use_double = true;
+        else usage(argv[0]);
+    }
+    return o;
+}
+
+} // namespace
+
+int main(int argc, char** argv){
+    Options options = parse(argc, argv);
+
+    std::vector<BenchResult> results = options.use_double ? run_all<double>(options) : run_all<float>(options);
+
+    BenchContext context = {
+        {"scalar", options.use_double ? "double" : "float"},
+        {"isa", kernels::isa_name(options.use_double ? kernels::active<double>().isa : kernels::active<float>().isa)},
+        {"threads", std::to_string(get_num_threads())},
+        {"build_type", NEURONITE_BUILD_TYPE},
+    };
+    if (options.out.empty()){
+        write_json(std::cout, context, results);
+    }else{
+        std::ofstream out(options.out);
+        if (!out){
+            std::cerr << "Cannot write " << options.out << "\n";
+            return 2;
+        }
+        write_json(out, context, results);
+    }
+
+    if (!options.baseline.empty()){
+        int regressions = compare_with_baseline(std::cerr, options.baseline, results, options.threshold);
+        return regressions > 0 ? 1 : 0;
+    }
+    return 0;
+}
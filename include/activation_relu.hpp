@@ -3,20 +3,33 @@
 
 #include "layer.hpp"
 
-class ActivationReLU: public Layer{
+template <typename T>
+class ActivationReLU: public Layer<T>{
     private:
-        Matrix mask;
+        Matrix<T> mask;
+
+        // With a 16-bit precision the mask is kept as 16-bit 0s and 1s
+        Precision precision = Precision::Full;
+        HalfMatrix mask_half;
+        std::uint16_t half_one = 0;
 
         std::pair<int,int> input_shape;
     
     public:
-        Matrix forward(const Matrix& input) override;
-        Matrix backward(const Matrix& grad_output) override;
+        void forward_into(const Matrix<T>& input, Matrix<T>& output) override;
+        void backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input) override;
+        void infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const override;
         void update(double learning_rate) override;
         std::string get_name() const override;
         std::pair<int,int> get_input_shape() const override;
         std::pair<int,int> get_output_shape() const override;
         int param_count() const override;
+        LayerSpec spec() const override;
+        std::vector<BatchCache<T>> caches(std::pair<int,int> input) override;
+        bool backward_reads_input() const override { return false; }
+        bool backward_reads_output() const override { return false; }
+        bool supports_precision(Precision) const override { return true; }
+        void set_precision(Precision precision) override;
 };
 
 #endif
\ No newline at end of file
@@ -3,23 +3,37 @@
 
 #include "layer.hpp"
 
-class ActivationSigmoid: public Layer{
+template <typename T>
+class ActivationSigmoid: public Layer<T>{
     private:
-        Matrix mask;
-        Matrix output_cache;
+        Matrix<T> mask;
+        Matrix<T> output_cache;
+
+        // With a 16-bit precision, σ(x) is saved here instead
+        Precision precision = Precision::Full;
+        HalfMatrix output_half;
 
         std::pair<int,int> input_shape;
     
     public:
-        static double sigmoid(double x);
+        static T sigmoid(T x);
 
-        Matrix forward(const Matrix& input) override;
-        Matrix backward(const Matrix& grad_output) override;
+        void forward_into(const Matrix<T>& input, Matrix<T>& output) override;
+        void backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input) override;
+        void infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const override;
         void update(double learning_rate) override;
         std::string get_name() const override;
         std::pair<int,int> get_input_shape() const override;
         std::pair<int,int> get_output_shape() const override;
         int param_count() const override;
+        LayerSpec spec() const override;
+        std::vector<BatchCache<T>> caches(std::pair<int,int> input) override;
+        bool backward_reads_input() const override { return false; }
+        bool backward_reads_output() const override { return false; }
+        bool supports_precision(Precision) const override { return true; }
+        void set_precision(Precision precision) override;
+        LayerCost forward_cost(const Matrix<T>& input, const Matrix<T>& output) const override;
+        LayerCost backward_cost(const Matrix<T>& grad_output, const Matrix<T>& grad_input) const override;
 };
 
 #endif
\ No newline at end of file
@@ -2,25 +2,33 @@
 #define ADAM_OPTIMIZER_HPP
 
 #include "optimizer.hpp"
-#include <unordered_map>
 
-class AdamOptimizer:public Optimizer{
-    private:
+/// Adam. Each step is one fused SIMD pass over the flat buffers: the bias
+/// corrections are folded into two per-step constants, and m, v and θ are
+/// each read and written once. Large models are split across the thread
+/// pool.
+template <typename T>
+class AdamOptimizer:public Optimizer<T>{
+    protected:
         double lr;
         double beta1;
         double beta2;
         double epsilon;
 
-        // t-th moment estimates for each layer pointer
-        std::unordered_map<Layer*, Matrix> m_weights;
-        std::unordered_map<Layer*, Matrix> v_weights;
-        std::unordered_map<Layer*, Matrix> m_bias;
-        std::unordered_map<Layer*, Matrix> v_bias;
+        // Decoupled weight decay (AdamW); 0 for plain Adam
+        double weight_decay = 0.0;
+
+    private:
+        // First and second moment estimates, one per parameter, laid out
+        // like the model's flat parameter buffer
+        Matrix<T> m;
+        Matrix<T> v;
 
     public:
         AdamOptimizer(double lr=0.001, double beta1=0.9, double beta2=0.999, double epsilon=1e-8);
 
-        void step(Layer* layer, int t) override;
+        void step(Matrix<T>& params, const Matrix<T>& grads, int t) override;
+        std::vector<Matrix<T>*> state() override;
 };
 
-#endif
\ No newline at end of file
+#endif
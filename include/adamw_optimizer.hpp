@@ -0,0 +1,16 @@
+#ifndef ADAMW_OPTIMIZER_HPP
+#define ADAMW_OPTIMIZER_HPP
+
+#include "adam_optimizer.hpp"
+
+/// Adam with decoupled weight decay (Loshchilov & Hutter): every step
+/// also shrinks each parameter by lr·weight_decay·θ, independently of the
+/// adaptive gradient step. Same fused kernel as AdamOptimizer.
+template <typename T>
+class AdamWOptimizer:public AdamOptimizer<T>{
+    public:
+        AdamWOptimizer(double lr=0.001, double weight_decay=0.01,
+                       double beta1=0.9, double beta2=0.999, double epsilon=1e-8);
+};
+
+#endif
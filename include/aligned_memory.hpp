@@ -0,0 +1,17 @@
+#ifndef ALIGNED_MEMORY_HPP
+#define ALIGNED_MEMORY_HPP
+
+#include <cstddef>
+
+/// Alignment used for every numeric buffer in the library (one cache line,
+/// and the width of an AVX-512 register)
+constexpr std::size_t NEURONITE_ALIGNMENT = 64;
+
+/// Allocates `bytes` on a NEURONITE_ALIGNMENT boundary; throws std::bad_alloc.
+/// Returns nullptr for a zero-byte request.
+void* aligned_malloc(std::size_t bytes);
+
+/// Releases memory obtained from aligned_malloc (nullptr is a no-op)
+void aligned_free(void* ptr);
+
+#endif
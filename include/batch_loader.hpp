@@ -0,0 +1,87 @@
+#ifndef BATCH_LOADER_HPP
+#define BATCH_LOADER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "matrix.hpp"
+
+/// What training does with the final, smaller batch of an epoch when the
+/// dataset size is not a multiple of the batch size
+enum class LastBatch { Keep, Drop };
+
+/// Assembles mini-batches on a background thread while the current one
+/// trains.
+///
+/// The loader owns a ring of `depth` batch slots: one is held by the
+/// consumer, the rest are filled ahead of time (depth 2 is double
+/// buffering, 3 triple). The producer walks the dataset epoch after epoch,
+/// reshuffling between epochs, and blocks when every slot is full, so it
+/// never runs more than depth - 1 batches ahead. Slots are sized once up
+/// front and reused, so steady-state loading does not allocate.
+///
+/// Rows are copied with plain memcpy on the loader thread rather than on
+/// the shared thread pool, which stays free for the training kernels.
+/// input and target are only read, and must outlive the loader; a
+/// MappedTensor's matrix() works, in which case page faults on the mapping
+/// are taken by the loader thread instead of the training step.
+///
+/// next() must be called from one thread at a time.
+template <typename T>
+class BatchLoader {
+    public:
+        struct Batch {
+            Matrix<T> input;
+            Matrix<T> target;
+        };
+
+        BatchLoader(const Matrix<T>& input,
+                    const Matrix<T>& target,
+                    int batch_size,
+                    bool shuffle = true,
+                    LastBatch last_batch = LastBatch::Keep,
+                    int depth = 2);
+        ~BatchLoader();
+
+        BatchLoader(const BatchLoader&) = delete;
+        BatchLoader& operator=(const BatchLoader&) = delete;
+
+        /// Returns the next batch, blocking until it is ready. The
+        /// reference stays valid until the following call to next(),
+        /// which hands the slot back to the loader thread
+        const Batch& next();
+
+        int batches_per_epoch() const { return num_batches; }
+        int batch_size() const { return rows_per_batch; }
+
+    private:
+        const Matrix<T>& input;
+        const Matrix<T>& target;
+        int rows_per_batch;
+        int num_batches;
+        bool shuffle;
+
+        std::vector<Batch> slots;
+        std::vector<int> order;   // row order of the epoch being produced
+        std::mt19937 rng;
+
+        std::mutex mutex;
+        std::condition_variable slot_ready;
+        std::condition_variable slot_free;
+        std::size_t produced = 0;   // batches filled so far
+        std::size_t consumed = 0;   // batches handed back by next()
+        bool holding = false;       // consumer holds slots[consumed % depth]
+        bool stopping = false;
+        std::exception_ptr error;
+
+        std::thread worker;
+
+        void run();
+        void fill(Batch& slot, int batch);
+};
+
+#endif
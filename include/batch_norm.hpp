@@ -4,35 +4,56 @@
 #include "matrix.hpp"
 #include "layer.hpp"
 
-class BatchNorm: public Layer{
+template <typename T>
+class BatchNorm: public Layer<T>{
     private:
-        Matrix gamma, beta;
-        Matrix mean, variance;
-        Matrix input_cache;
+        Matrix<T> gamma, beta;
+        Matrix<T> mean, variance;
         double epsilon = 1e-5;
 
-        Matrix d_gamma, d_beta;
+        // Exponential moving averages of the batch statistics, used by
+        // infer_into in place of the statistics of the inference batch
+        Matrix<T> running_mean, running_variance;
+        double momentum = 0.1;
+
+        Matrix<T> d_gamma, d_beta;
         
-        Matrix standard_deviation_cache;
+        Matrix<T> standard_deviation_cache;
+
+        // forward_into and recompute_into; only the former tracks the
+        // running statistics
+        void normalize_into(const Matrix<T>& input, Matrix<T>& output, bool track_statistics);
 
         std::pair<int,int> input_shape;
     
     public:
-        Matrix x_hat;
+        Matrix<T> x_hat;
 
         BatchNorm(int input_dim, int output_dim);
 
-        Matrix forward(const Matrix& input) override;
-        Matrix backward(const Matrix& grad_out) override;
+        void forward_into(const Matrix<T>& input, Matrix<T>& output) override;
+        void backward_into(const Matrix<T>& grad_out, Matrix<T>& grad_input) override;
+        void infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const override;
         void update(double learning_rate) override;
 
         std::string get_name() const override;
         std::pair<int,int> get_input_shape() const override;
         std::pair<int,int> get_output_shape() const override;
         int param_count() const override;
-
-        Matrix compute_mean(const Matrix& input);
-        Matrix compute_variance(const Matrix& input);
+        std::vector<Parameter<T>> parameters() override;
+        std::vector<Matrix<T>*> state() override;
+        LayerSpec spec() const override;
+        std::pair<int,int> infer_output_shape(std::pair<int,int> input) const override;
+        std::vector<BatchCache<T>> caches(std::pair<int,int> input) override;
+        bool supports_precision(Precision precision) const override;
+        void recompute_into(const Matrix<T>& input, Matrix<T>& output) override;
+        LayerCost forward_cost(const Matrix<T>& input, const Matrix<T>& output) const override;
+        LayerCost backward_cost(const Matrix<T>& grad_output, const Matrix<T>& grad_input) const override;
+
+        Matrix<T> compute_mean(const Matrix<T>& input);
+        Matrix<T> compute_variance(const Matrix<T>& input);
+        void compute_mean(const Matrix<T>& input, Matrix<T>& mean);
+        void compute_variance(const Matrix<T>& input, Matrix<T>& variance);
 
 };
 
@@ -0,0 +1,109 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+/// Lock-free bounded multi-producer, multi-consumer queue (Vyukov's
+/// sequence-numbered ring).
+///
+/// Every slot carries a sequence number that tells producers and consumers
+/// whose turn it is, so a push or pop is one compare-and-swap on the shared
+/// position plus a release store on the slot; no thread ever waits on a
+/// lock. try_push fails instead of blocking when the ring is full, and
+/// try_pop when it is empty; callers decide how to wait.
+///
+/// Header-only because Item is arbitrary (InferenceServer queues requests).
+template <typename Item>
+class BoundedQueue {
+    public:
+        /// `capacity` is rounded up to a power of two
+        explicit BoundedQueue(std::size_t capacity){
+            if (capacity == 0){
+                throw std::invalid_argument("BoundedQueue: capacity must be positive");
+            }
+            std::size_t size = 1;
+            while (size < capacity) size <<= 1;
+            mask = size - 1;
+            slots.reset(new Slot[size]);
+            for (std::size_t i = 0; i < size; ++i){
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        /// Moves `item` in and returns true, or returns false (leaving
+        /// `item` untouched) if the queue is full
+        bool try_push(Item& item){
+            std::size_t pos = tail.load(std::memory_order_relaxed);
+            for (;;){
+                Slot& slot = slots[pos & mask];
+                std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0){
+                    if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                        slot.item = std::move(item);
+                        slot.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }else if (diff < 0){
+                    return false;
+                }else{
+                    pos = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// Moves the oldest item into `item` and returns true, or returns
+        /// false if the queue is empty
+        bool try_pop(Item& item){
+            std::size_t pos = head.load(std::memory_order_relaxed);
+            for (;;){
+                Slot& slot = slots[pos & mask];
+                std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0){
+                    if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                        item = std::move(slot.item);
+                        slot.sequence.store(pos + mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }else if (diff < 0){
+                    return false;
+                }else{
+                    pos = head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /// Items currently queued; a snapshot that may be stale by the
+        /// time it is read when other threads are pushing or popping
+        std::size_t size() const {
+            std::size_t t = tail.load(std::memory_order_acquire);
+            std::size_t h = head.load(std::memory_order_acquire);
+            return t > h ? t - h : 0;
+        }
+
+        std::size_t capacity() const { return mask + 1; }
+
+    private:
+        struct Slot {
+            std::atomic<std::size_t> sequence;
+            Item item;
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        std::size_t mask;
+
+        // Producers and the consumer touch different ends; keep them off
+        // each other's cache line
+        alignas(64) std::atomic<std::size_t> tail{0};
+        alignas(64) std::atomic<std::size_t> head{0};
+};
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef COMMUNICATOR_HPP
+#define COMMUNICATOR_HPP
+
+#include <cstddef>
+
+/// Collective operations among the processes ("ranks") of one training job.
+///
+/// This is the transport interface multi-process training is written
+/// against (see Model::set_communicator). ShmCommunicator implements it
+/// over POSIX shared memory for processes on one host; a network backend
+/// only has to implement these calls.
+///
+/// Every operation is collective: all ranks call it, in the same order,
+/// with the same element count (and root). A communicator is used by one
+/// thread at a time.
+class Communicator {
+    public:
+        virtual int rank() const = 0;
+        virtual int size() const = 0;
+
+        /// Replaces data[0, n) on every rank with its element-wise sum over
+        /// all ranks. Every rank receives the same bits
+        virtual void all_reduce(float* data, std::size_t n) = 0;
+        virtual void all_reduce(double* data, std::size_t n) = 0;
+
+        /// Copies data[0, n) of rank `root` to every other rank
+        virtual void broadcast(float* data, std::size_t n, int root) = 0;
+        virtual void broadcast(double* data, std::size_t n, int root) = 0;
+
+        /// Returns once every rank has called it
+        virtual void barrier() = 0;
+
+        virtual ~Communicator() = default;
+};
+
+#endif
@@ -4,35 +4,81 @@
 #include <matrix.hpp>
 #include "layer.hpp"
 
-class DenseLayer: public Layer{
-    private:
+template <typename T>
+class DenseLayer: public Layer<T>{
+    protected:
 
-        Matrix input_cache;
-        Matrix d_weights;
-        Matrix d_bias;
+        // Input of the last forward call, read again by backward
+        const Matrix<T>* input_cache = nullptr;
+
+        // Copy of the input of the allocating forward(), which input_cache
+        // then points to
+        Matrix<T> forward_input;
+        Matrix<T> d_weights;
+        Matrix<T> d_bias;
+
+        // With a 16-bit precision: the weights rounded once per update,
+        // which every product reads, and the input saved for backward in
+        // place of input_cache
+        Precision precision = Precision::Full;
+        HalfMatrix weights_half;
+        HalfMatrix input_half;
+
+        // Sparse input of the last forward_sparse_into, and the weight
+        // gradient that only writes the rows of its nonzero columns. A
+        // dense backward writes every row of d_weights, so the next sparse
+        // one clears them first
+        const SparseMatrix<T>* sparse_cache = nullptr;
+        SparseRowGradient<T> sparse_gradient;
+        bool dense_gradient_written = false;
+
+        // Z = act(X · W + b) at the layer's precision (reading weights_half
+        // in 16-bit mode), keeping nothing for backward
+        void product_into(const Matrix<T>& input, Matrix<T>& output, Activation activation) const;
+
+        // Z = act(X · W + b) on a sparse X, keeping X for backward
+        void sparse_forward(const SparseMatrix<T>& input, Matrix<T>& output, Activation activation);
 
         std::pair<int,int> input_shape;
         std::pair<int,int> output_shape;
     
     public:
-        Matrix weights;
-        Matrix bias;
+        Matrix<T> weights;
+        Matrix<T> bias;
 
         DenseLayer(int input_dim, int output_dim);
+        DenseLayer(int input_dim, int output_dim, DeferInit);
 
-        Matrix forward(const Matrix& input) override;
-        Matrix backward(const Matrix& grad_output) override;
+        void forward_into(const Matrix<T>& input, Matrix<T>& output) override;
+        Matrix<T> forward(const Matrix<T>& input) override;
+        void backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input) override;
+        void infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const override;
+        void forward_sparse_into(const SparseMatrix<T>& input, Matrix<T>& output) override;
+        void backward_sparse_into(const Matrix<T>& grad_output) override;
+        void infer_sparse_into(const SparseMatrix<T>& input, Matrix<T>& output, Workspace& ws) const override;
         void update(double learning_rate) override;
         std::string get_name() const override;
         std::pair<int,int> get_input_shape() const override;
         std::pair<int,int> get_output_shape() const override;
         int param_count() const override;
-        void apply_adam_update(const Matrix& new_weights, const Matrix& new_bias);
+        std::vector<Parameter<T>> parameters() override;
+        std::vector<BatchCache<T>> caches(std::pair<int,int> input) override;
+        bool backward_reads_input() const override;
+        bool backward_reads_output() const override;
+        bool supports_precision(Precision precision) const override;
+        void set_precision(Precision precision) override;
+        LayerSpec spec() const override;
+        std::pair<int,int> infer_output_shape(std::pair<int,int> input) const override;
+        LayerCost forward_cost(const Matrix<T>& input, const Matrix<T>& output) const override;
+        LayerCost backward_cost(const Matrix<T>& grad_output, const Matrix<T>& grad_input) const override;
+        LayerCost forward_sparse_cost(const SparseMatrix<T>& input, const Matrix<T>& output) const override;
+        LayerCost backward_sparse_cost(const Matrix<T>& grad_output) const override;
+        void apply_adam_update(const Matrix<T>& new_weights, const Matrix<T>& new_bias);
 
-        Matrix get_weights() const;
-        Matrix get_bias() const; 
-        Matrix get_d_weights() const;
-        Matrix get_d_bias() const;
+        const Matrix<T>& get_weights() const;
+        const Matrix<T>& get_bias() const;
+        const Matrix<T>& get_d_weights() const;
+        const Matrix<T>& get_d_bias() const;
 };
 
 #endif
\ No newline at end of file
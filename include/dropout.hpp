@@ -1,26 +1,41 @@
 #pragma once
 #include "layer.hpp"
 #include "matrix.hpp"
+#include <cstdint>
 #include <vector>
 
-class Dropout : public Layer {
+template <typename T>
+class Dropout : public Layer<T> {
 private:
     double drop_probability;
-    Matrix mask;
+    Matrix<T> mask;
     bool is_training;
+
+    // Seed of the last training-mode mask, which is a pure function of it
+    // and the element index, so recompute_into can rebuild the same mask
+    std::uint64_t mask_seed = 0;
+    void build_mask(int rows, int cols);
     std::pair<int, int> input_shape;
 
 public:
     Dropout(double p);
 
-    Matrix forward(const Matrix& input) override;
-    Matrix backward(const Matrix& grad_output) override;
-    void update(double learning_rate) override {}
+    void forward_into(const Matrix<T>& input, Matrix<T>& output) override;
+    void backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input) override;
+    void recompute_into(const Matrix<T>& input, Matrix<T>& output) override;
+    void infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const override;
+    void update(double /*learning_rate*/) override {}
 
     void set_training(bool training);
+    bool get_training() const { return is_training; }
 
     std::string get_name() const override;
     std::pair<int, int> get_input_shape() const override;
     std::pair<int, int> get_output_shape() const override;
     int param_count() const override { return 0; }
+    LayerSpec spec() const override;
+    std::vector<BatchCache<T>> caches(std::pair<int, int> input) override;
+
+    // The mask stays in T under every precision
+    bool supports_precision(Precision) const override { return true; }
 };
@@ -0,0 +1,55 @@
+#ifndef FUSED_DENSE_LAYER_HPP
+#define FUSED_DENSE_LAYER_HPP
+
+#include "dense_layer.hpp"
+
+/// Dense layer with its activation fused in: Y = act(X · W + b).
+///
+/// Computes the same thing as a DenseLayer followed by ActivationReLU or
+/// ActivationSigmoid, in fewer passes over memory. Forward adds the bias
+/// and applies the activation in the GEMM epilogue, on each block of Y
+/// while it is still in cache. Backward turns ∂L/∂Y into ∂L/∂Z in a single
+/// sweep over Y, then runs the weight- and input-gradient GEMMs on ∂L/∂Z.
+///
+/// The derivative is read off Y, so backward needs the output of the last
+/// forward_into as well as its input. Both must stay alive and unchanged
+/// until backward, which is what Model does; forward() keeps copies of
+/// both. Optimizers treat this layer as a DenseLayer.
+template <typename T>
+class FusedDenseLayer: public DenseLayer<T>{
+    private:
+        Activation activation;
+
+        // Output of the last forward_into, read again by backward
+        const Matrix<T>* output_cache = nullptr;
+
+        // Owns the result of the allocating forward(), which is returned by copy
+        Matrix<T> forward_output;
+
+        // ∂L/∂Z from ∂L/∂Y and the cached Y, in the workspace (a view of
+        // ∂L/∂Y without an activation)
+        Matrix<T> activation_gradient(const Matrix<T>& grad_output);
+
+    public:
+        FusedDenseLayer(int input_dim, int output_dim, Activation activation);
+        FusedDenseLayer(int input_dim, int output_dim, Activation activation, DeferInit);
+
+        void forward_into(const Matrix<T>& input, Matrix<T>& output) override;
+        void backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input) override;
+        void infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const override;
+        void forward_sparse_into(const SparseMatrix<T>& input, Matrix<T>& output) override;
+        void backward_sparse_into(const Matrix<T>& grad_output) override;
+        void infer_sparse_into(const SparseMatrix<T>& input, Matrix<T>& output, Workspace& ws) const override;
+        Matrix<T> forward(const Matrix<T>& input) override;
+        bool backward_reads_output() const override;
+        std::string get_name() const override;
+        LayerSpec spec() const override;
+        LayerCost forward_cost(const Matrix<T>& input, const Matrix<T>& output) const override;
+        LayerCost backward_cost(const Matrix<T>& grad_output, const Matrix<T>& grad_input) const override;
+        LayerCost forward_sparse_cost(const SparseMatrix<T>& input, const Matrix<T>& output) const override;
+        LayerCost backward_sparse_cost(const Matrix<T>& grad_output) const override;
+
+        Activation get_activation() const;
+};
+
+#endif
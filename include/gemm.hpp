@@ -0,0 +1,77 @@
+#ifndef GEMM_HPP
+#define GEMM_HPP
+
+#include <cstdint>
+#include "half.hpp"
+
+/// Whether an operand of gemm() is read as stored or as its transpose
+enum class Transpose { No, Yes };
+
+/// Elementwise activation a GEMM epilogue can apply
+enum class Activation { None, ReLU, Sigmoid };
+
+/// Work folded into gemm() after the last K slab of each block of C, while
+/// that block is still in cache:
+///     C = act(C + bias)
+/// bias points at N values broadcast down the rows, or is nullptr.
+template <typename T>
+struct GemmEpilogue {
+    const T* bias = nullptr;
+    Activation activation = Activation::None;
+};
+
+/// General matrix multiply on row-major buffers:
+///     C = alpha · op(A) · op(B) + beta · C
+///
+/// op(A) is (M × K), op(B) is (K × N) and C is (M × N). lda/ldb/ldc are the
+/// row strides of the buffers as stored, so a transposed operand is read
+/// in place without materializing a copy.
+///
+/// When beta == 0, C is overwritten and its previous contents are ignored
+/// (NaNs included).
+///
+/// Instantiated for float and double.
+template <typename T>
+void gemm(Transpose trans_a, Transpose trans_b,
+          int M, int N, int K,
+          T alpha, const T* A, int lda,
+          const T* B, int ldb,
+          T beta, T* C, int ldc);
+
+/// Same as above, then C = act(C + bias) as described by `epilogue`. The
+/// epilogue runs block by block inside the GEMM rather than as separate
+/// passes over C.
+template <typename T>
+void gemm(Transpose trans_a, Transpose trans_b,
+          int M, int N, int K,
+          T alpha, const T* A, int lda,
+          const T* B, int ldb,
+          T beta, T* C, int ldc,
+          const GemmEpilogue<T>& epilogue);
+
+/// An input of the mixed-precision gemm() below: a row-major buffer of T,
+/// or of 16-bit floats in `precision` (see half.hpp), with row stride ld
+template <typename T>
+struct GemmOperand {
+    const T* data = nullptr;
+    const std::uint16_t* half = nullptr;
+    Precision precision = Precision::Full;
+    int ld = 0;
+
+    GemmOperand(const T* data, int ld) : data(data), ld(ld) {}
+    GemmOperand(const std::uint16_t* half, int ld, Precision precision)
+        : half(half), precision(precision), ld(ld) {}
+};
+
+/// Same as above with A and B each given in T or in bf16/fp16. Half
+/// operands are widened to T as their panels are packed, so the
+/// micro-kernel, and with it every sum, runs in T just as for two T
+/// operands; only the reads of A and B shrink.
+template <typename T>
+void gemm(Transpose trans_a, Transpose trans_b,
+          int M, int N, int K,
+          T alpha, const GemmOperand<T>& A, const GemmOperand<T>& B,
+          T beta, T* C, int ldc,
+          const GemmEpilogue<T>& epilogue = GemmEpilogue<T>{});
+
+#endif
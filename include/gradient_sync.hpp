@@ -0,0 +1,74 @@
+#ifndef GRADIENT_SYNC_HPP
+#define GRADIENT_SYNC_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "communicator.hpp"
+
+/// Averages a model's flat gradient buffer across the ranks of a
+/// Communicator, overlapping the communication with the backward pass.
+///
+/// plan() cuts the buffer into buckets of at least `bucket_bytes` at layer
+/// boundaries. Backward runs from the last layer to the first, and the
+/// buffer holds layers in order, so the gradients that are final always
+/// form a suffix of it: after each layer, layer_done() hands every bucket
+/// that is now complete to a communication thread, which all-reduces it
+/// and divides by the number of ranks while backward carries on with the
+/// earlier layers. finish() sends what is left and waits.
+///
+/// Buckets depend only on the layer sizes, so every rank sends the same
+/// sequence. The communicator must not be used by anyone else between
+/// the first layer_done() and finish().
+template <typename T>
+class GradientSync {
+    public:
+        GradientSync(Communicator& comm, std::size_t bucket_bytes);
+        ~GradientSync();
+
+        GradientSync(const GradientSync&) = delete;
+        GradientSync& operator=(const GradientSync&) = delete;
+
+        /// Sets the buffer to synchronize, `n` values at `grads`; the
+        /// gradients of layer i start at layer_begin[i] (non-decreasing)
+        void plan(T* grads, std::size_t n, const std::vector<std::size_t>& layer_begin);
+
+        /// The gradients of `layer` and every later layer are final
+        void layer_done(std::size_t layer);
+
+        /// Sends the remaining buckets and blocks until the whole buffer
+        /// holds the mean over all ranks; rethrows a communication error
+        void finish();
+
+        Communicator& communicator() const { return comm; }
+
+    private:
+        struct Bucket {
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        Communicator& comm;
+        std::size_t bucket_elements;
+
+        T* grads = nullptr;
+        std::vector<Bucket> buckets;       // in the order they complete
+        std::vector<std::size_t> ready;    // buckets complete after each layer
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        std::size_t submitted = 0;
+        std::size_t completed = 0;
+        std::exception_ptr error;
+        bool stopping = false;
+
+        std::thread worker;
+
+        void run();
+};
+
+#endif
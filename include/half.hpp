@@ -0,0 +1,45 @@
+#ifndef HALF_HPP
+#define HALF_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/// Storage format of tensors kept by a mixed-precision model (see
+/// Model::set_precision). Full is the model's own scalar type (fp32 for
+/// Model<float>); the other two are 16-bit floats:
+///     BFloat16  8 exponent bits, 7 mantissa bits: fp32's range, ~3 digits
+///     Float16   5 exponent bits, 10 mantissa bits: ±65504, ~3.3 digits
+enum class Precision : std::uint8_t { Full = 0, BFloat16 = 1, Float16 = 2 };
+
+/// Conversions between float/double and the 16-bit formats.
+///
+/// Rounding is to nearest, ties to even; values too large for fp16 become
+/// infinities and NaNs stay NaNs. bf16 flushes fp32 denormals to zero, as
+/// the AVX-512 BF16 instruction does, so every code path gives the same
+/// bits. Bulk conversions run on AVX-512 (BF16 and F16 conversion
+/// instructions), AVX2 with F16C, or portable code, picked once from the
+/// instruction set kernels::active() runs on (NEURONITE_ISA applies).
+namespace half {
+
+std::uint16_t to_bfloat16(float x);
+float from_bfloat16(std::uint16_t h);
+std::uint16_t to_float16(float x);
+float from_float16(std::uint16_t h);
+
+/// dst[i] = src[i] rounded to `precision` (BFloat16 or Float16); doubles
+/// are rounded to float first. Throws std::invalid_argument for Full
+void encode(Precision precision, const float* src, std::uint16_t* dst, std::size_t n);
+void encode(Precision precision, const double* src, std::uint16_t* dst, std::size_t n);
+
+/// dst[i] = src[i] widened from `precision`, exactly
+void decode(Precision precision, const std::uint16_t* src, float* dst, std::size_t n);
+void decode(Precision precision, const std::uint16_t* src, double* dst, std::size_t n);
+
+/// Conversion code in use: "avx512", "f16c" or "scalar"
+const char* kernel_name();
+
+const char* precision_name(Precision precision);
+
+} // namespace half
+
+#endif
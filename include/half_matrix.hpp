@@ -0,0 +1,82 @@
+#ifndef HALF_MATRIX_HPP
+#define HALF_MATRIX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "half.hpp"
+#include "matrix.hpp"
+
+/// Row-major matrix of 16-bit floats (bf16 or fp16, see half.hpp), for
+/// tensors a mixed-precision model keeps at half the bytes: the compute
+/// copy of a weight matrix and what forward saves for backward.
+///
+/// Always packed (no stride). Like Matrix it owns a 64-byte aligned buffer
+/// or is placed with rebind on external storage (Model::compile puts
+/// layer caches in its slab this way), and resize reuses the buffer. It is
+/// only written by assign, which rounds, and read back widened by
+/// decode_into or directly by gemm() (GemmOperand).
+class HalfMatrix {
+
+    public:
+        int rows, cols;
+        Precision precision;
+
+        HalfMatrix();
+        HalfMatrix(const HalfMatrix&) = delete;
+        HalfMatrix& operator=(const HalfMatrix&) = delete;
+        HalfMatrix(HalfMatrix&& other) noexcept;
+        HalfMatrix& operator=(HalfMatrix&& other) noexcept;
+        ~HalfMatrix();
+
+        /// Turns this matrix into a view of `ptr`, as Matrix::rebind does;
+        /// with a `capacity` (elements at `ptr`) it may later be resized to
+        /// any shape that fits
+        void rebind(std::uint16_t* ptr, int rows, int cols, std::size_t capacity = 0);
+
+        /// Reshapes to (rows × cols), reallocating only when an owning
+        /// buffer is too small. Throws std::invalid_argument when a view
+        /// would have to grow
+        void resize(int rows, int cols);
+
+        /// this = source rounded to `precision` (BFloat16 or Float16),
+        /// resizing to source's shape
+        template <typename T>
+        void assign(const Matrix<T>& source, Precision precision);
+
+        /// out = this widened to T, resizing out to this shape
+        template <typename T>
+        void decode_into(Matrix<T>& out) const;
+
+        std::uint16_t* row(int i) { return ptr + static_cast<std::size_t>(i) * cols; }
+        const std::uint16_t* row(int i) const { return ptr + static_cast<std::size_t>(i) * cols; }
+
+        std::uint16_t* data() { return ptr; }
+        const std::uint16_t* data() const { return ptr; }
+
+        std::size_t size() const { return static_cast<std::size_t>(rows) * cols; }
+        std::size_t bytes() const { return size() * sizeof(std::uint16_t); }
+
+    private:
+        std::uint16_t* ptr;
+        std::size_t capacity;   // elements in the buffer
+        bool owning;
+
+        void release();
+};
+
+/// Calls fn(offset, values, count) over `n` 16-bit values at `src`, widened
+/// to T a chunk at a time: values holds elements [offset, offset + count).
+/// The chunk stays in L1, so a backward pass can consume a half tensor
+/// without a full-size widened copy
+template <typename T, typename Fn>
+inline void for_each_widened(Precision precision, const std::uint16_t* src, std::size_t n, Fn&& fn){
+    constexpr std::size_t CHUNK = 1024;
+    alignas(64) T buffer[CHUNK];
+    for (std::size_t offset = 0; offset < n; offset += CHUNK){
+        std::size_t count = n - offset < CHUNK ? n - offset : CHUNK;
+        half::decode(precision, src + offset, buffer, count);
+        fn(offset, static_cast<const T*>(buffer), count);
+    }
+}
+
+#endif
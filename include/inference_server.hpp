@@ -0,0 +1,149 @@
+#ifndef INFERENCE_SERVER_HPP
+#define INFERENCE_SERVER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "bounded_queue.hpp"
+#include "model.hpp"
+
+/// Counters of an InferenceServer. Latency is from submit() until the
+/// result is delivered; percentiles cover the most recent
+/// InferenceServer::LATENCY_WINDOW requests, everything else the server's
+/// whole lifetime
+struct ServerStats {
+    std::size_t requests;        // served so far
+    std::size_t batches;
+    double mean_batch_size;
+    std::size_t queue_depth;     // waiting to be batched right now
+    double mean_latency_us;
+    double p50_latency_us;
+    double p99_latency_us;
+    double max_latency_us;
+};
+
+/// Dynamic micro-batching front end for single-row inference.
+///
+/// Any number of threads submit one input row at a time. Requests go into
+/// a lock-free bounded queue, and one server thread drains it into batches:
+/// a batch closes when it holds max_batch_size rows or when its oldest
+/// request has waited max_wait, whichever comes first. Each batch is one
+/// Model::predict call, so the GEMMs run on (batch × features) blocks
+/// instead of single rows. Results come back through a future or a
+/// callback.
+///
+/// The server thread sleeps on a condition variable only while the queue
+/// is empty; submitters signal it only when it is asleep, so a loaded
+/// server takes no locks per request. A full queue blocks submit() on a
+/// second condition variable, which the server thread signals as it pops
+/// only while someone waits there.
+///
+/// `model` is only read (through the const predict), must outlive the
+/// server, and must not be trained or modified while the server runs.
+/// Destroying the server serves everything already queued first.
+template <typename T>
+class InferenceServer {
+    public:
+        /// Receives the output row, or a null output and the exception
+        /// predict threw. Runs on the server thread, so it should be quick;
+        /// exceptions it throws are dropped
+        using Callback = std::function<void(std::vector<T> output, std::exception_ptr error)>;
+
+        /// Requests that percentiles in ServerStats are computed over
+        static constexpr std::size_t LATENCY_WINDOW = 4096;
+
+        InferenceServer(const Model<T>& model,
+                        int input_dim,
+                        int max_batch_size = 64,
+                        std::chrono::microseconds max_wait = std::chrono::microseconds(1000),
+                        std::size_t queue_capacity = 4096);
+        ~InferenceServer();
+
+        InferenceServer(const InferenceServer&) = delete;
+        InferenceServer& operator=(const InferenceServer&) = delete;
+
+        /// Queues one row of input_dim values; the future yields the
+        /// model's output row, or rethrows what predict threw
+        std::future<std::vector<T>> submit(std::vector<T> input);
+
+        /// Same, delivering the result to `callback`
+        void submit(std::vector<T> input, Callback callback);
+
+        ServerStats stats() const;
+
+    private:
+        struct Request {
+            std::vector<T> input;
+            std::promise<std::vector<T>> promise;
+            Callback callback;   // used instead of the promise when set
+            std::chrono::steady_clock::time_point enqueued;
+        };
+
+        const Model<T>& model;
+        int input_dim;
+        int max_batch_size;
+        std::chrono::microseconds max_wait;
+
+        BoundedQueue<Request> queue;
+
+        // The server thread waits here only when the queue is empty
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::atomic<bool> sleeping{false};
+        std::atomic<bool> stopping{false};
+
+        // Submitters wait here only when the queue is full
+        std::mutex room_mutex;
+        std::condition_variable room;
+        std::atomic<int> waiting_for_room{0};
+
+        // Server-thread state, reused from batch to batch
+        std::vector<Request> batch;
+        Matrix<T> batch_input;
+        Matrix<T> batch_output;
+        PredictScratch<T> scratch;
+        std::vector<double> batch_latencies;
+
+        mutable std::mutex stats_mutex;
+        std::size_t served = 0;
+        std::size_t batches = 0;
+        double latency_sum_us = 0.0;
+        double latency_max_us = 0.0;
+        std::vector<double> latency_window;   // ring of the latest latencies
+
+        std::thread worker;
+
+        void enqueue(Request& request);
+        // queue.try_pop, waking submitters blocked on a full queue
+        bool try_pop(Request& request);
+        // Pops into `request`, sleeping until one arrives or, if
+        // `deadline` is set, until then; false on timeout or shutdown
+        bool pop_wait(Request& request, const std::chrono::steady_clock::time_point* deadline);
+        void run();
+        void serve();
+};
+
+/// Outcome of drive_load
+struct LoadResult {
+    std::size_t requests;
+    double seconds;
+    double requests_per_second;
+    ServerStats stats;   // server counters at the end of the run
+};
+
+/// Local, closed-loop load generator: `clients` threads each send
+/// `requests_per_client` rows of `inputs` (cycling through them) and wait
+/// for every result before sending the next. Exercises a server without a
+/// network; with C clients, batches hold at most C rows.
+template <typename T>
+LoadResult drive_load(InferenceServer<T>& server, const Matrix<T>& inputs,
+                      int clients, int requests_per_client);
+
+#endif
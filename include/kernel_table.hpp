@@ -0,0 +1,110 @@
+#ifndef KERNEL_TABLE_HPP
+#define KERNEL_TABLE_HPP
+
+#include <cstddef>
+
+// Function table behind kernels::active() (see kernels.hpp). Kept free of
+// other library headers because the per-ISA translation units that fill it
+// are compiled with -mavx2 / -mavx512f, and any inline code they pull in
+// could otherwise be emitted with instructions older CPUs lack.
+namespace kernels {
+
+enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+/// Per-step constants of the fused Adam/AdamW update, folded once per step
+/// by the optimizer so the kernel does no pow or division by corrections:
+///     m = beta1·m + (1 - beta1)·g
+///     v = beta2·v + (1 - beta2)·g²
+///     θ = decay·θ - step_size · m / (√v · inv_sqrt_correction2 + epsilon)
+/// with step_size = lr / (1 - beta1^t), inv_sqrt_correction2 =
+/// 1 / √(1 - beta2^t) and decay = 1 - lr·weight_decay (1 for plain Adam).
+template <typename T>
+struct AdamStep {
+    T beta1, one_minus_beta1;
+    T beta2, one_minus_beta2;
+    T step_size;
+    T inv_sqrt_correction2;
+    T epsilon;
+    T decay;
+};
+
+/// Per-step constants of SGD with momentum:
+///     g' = g + weight_decay·θ
+///     u  = momentum·u + g'
+///     θ -= lr · (nesterov ? g' + momentum·u : u)
+template <typename T>
+struct SgdStep {
+    T lr;
+    T momentum;
+    T weight_decay;
+    bool nesterov;
+};
+
+/// Instantiated for float and double
+template <typename T>
+struct KernelTable {
+    Isa isa;
+
+    // out[i] = a[i] (+ - *) b[i]
+    void (*add)(const T* a, const T* b, T* out, std::size_t n);
+    void (*sub)(const T* a, const T* b, T* out, std::size_t n);
+    void (*mul)(const T* a, const T* b, T* out, std::size_t n);
+
+    // out[i] = a[i] * s
+    void (*scale)(const T* a, T s, T* out, std::size_t n);
+
+    // out[i] += a[i] * b[i]
+    void (*mul_add)(const T* a, const T* b, T* out, std::size_t n);
+
+    // out[i] += alpha * a[i]
+    void (*axpy)(const T* a, T alpha, T* out, std::size_t n);
+
+    // Row broadcast over a (rows × cols) block: out(i, j) = a(i, j) (+ - *) row[j]
+    void (*add_row)(const T* a, int lda, const T* row, T* out, int ldo, int rows, int cols);
+    void (*sub_row)(const T* a, int lda, const T* row, T* out, int ldo, int rows, int cols);
+    void (*mul_row)(const T* a, int lda, const T* row, T* out, int ldo, int rows, int cols);
+
+    // Row broadcast affine: out(i, j) = a(i, j) * scale[j] + shift[j]
+    void (*affine_row)(const T* a, int lda, const T* scale, const T* shift,
+                       T* out, int ldo, int rows, int cols);
+
+    // y = max(0, x), mask = (x > 0) ? 1 : 0
+    void (*relu_forward)(const T* x, T* y, T* mask, std::size_t n);
+    // out = grad * mask
+    void (*relu_backward)(const T* grad, const T* mask, T* out, std::size_t n);
+    // y = max(0, x), without a mask (fused epilogues)
+    void (*relu)(const T* x, T* y, std::size_t n);
+    // out = grad where y > 0, else 0; the ReLU gradient read off its output
+    void (*relu_backward_output)(const T* grad, const T* y, T* out, std::size_t n);
+
+    // y = 1 / (1 + e^(-x))
+    void (*sigmoid_forward)(const T* x, T* y, std::size_t n);
+    // out = grad * y * (1 - y)
+    void (*sigmoid_backward)(const T* grad, const T* y, T* out, std::size_t n);
+
+    // Σ (a[i] - b[i])²
+    T (*squared_diff_sum)(const T* a, const T* b, std::size_t n);
+    // out[i] = s * (a[i] - b[i])
+    void (*scaled_diff)(const T* a, const T* b, T s, T* out, std::size_t n);
+
+    // Binary cross-entropy on logits z, loss and gradient in one pass:
+    // returns Σ max(z, 0) - z·y + log(1 + e^(-|z|)), grad[i] = s · (σ(z[i]) - y[i])
+    T (*bce_logits)(const T* z, const T* y, T s, T* grad, std::size_t n);
+    // Squared error of σ(z), loss and gradient in one pass:
+    // returns Σ (σ(z) - y)², grad[i] = s · (σ(z[i]) - y[i]) · σ(z[i]) · (1 - σ(z[i]))
+    T (*sigmoid_mse)(const T* z, const T* y, T s, T* grad, std::size_t n);
+
+    // Fused optimizer updates: every state buffer read and written once
+    void (*adam_update)(T* param, const T* grad, T* m, T* v, const AdamStep<T>& s, std::size_t n);
+    void (*sgd_momentum)(T* param, const T* grad, T* velocity, const SgdStep<T>& s, std::size_t n);
+
+    // One row of the batch norm input gradient:
+    // out[j] = k[j] * (m * dy_gamma[j] - sum_dy_gamma[j] - x_hat[j] * sum_dy_gamma_xhat[j])
+    void (*batchnorm_input_grad)(const T* dy_gamma, const T* x_hat,
+                                 const T* sum_dy_gamma, const T* sum_dy_gamma_xhat,
+                                 const T* k, T m, T* out, std::size_t n);
+};
+
+} // namespace kernels
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <cstddef>
+#include "kernel_table.hpp"
+#include "thread_pool.hpp"
+
+/// Vectorized elementwise kernels with runtime CPU dispatch.
+///
+/// Every elementwise loop in the library (Matrix operators, activations,
+/// dropout, losses, batch norm) goes through the function table returned by
+/// kernels::active(). The table is chosen once, on first use, from the
+/// widest instruction set the CPU and OS support: AVX-512F, AVX2+FMA, SSE2,
+/// or a portable scalar fallback. Setting the NEURONITE_ISA environment
+/// variable (scalar, sse2, avx2, avx512) caps the choice, which is useful
+/// for comparing code paths.
+///
+/// All kernels take contiguous spans and accept unaligned pointers. `out`
+/// may alias an input of the same index (in-place updates are allowed).
+namespace kernels {
+
+/// Table for the instruction set selected at startup (float or double)
+template <typename T>
+const KernelTable<T>& active();
+
+/// Best instruction set supported by this CPU/OS (ignores NEURONITE_ISA)
+Isa detect_isa();
+
+/// Table for a specific instruction set, or nullptr if it was not compiled
+/// in or is not supported by this CPU
+template <typename T>
+const KernelTable<T>* table_for(Isa isa);
+
+const char* isa_name(Isa isa);
+
+/// Elementwise work below this many elements runs on the calling thread
+constexpr std::size_t PARALLEL_GRAIN = 1 << 15;
+
+/// Calls fn(row, n) over the spans of a (rows × cols) block. When every
+/// operand is packed, each call covers n = k * cols elements starting at
+/// `row`; otherwise each call covers a single row (n = cols). Callers index
+/// their operands with Matrix::row(row).
+///
+/// Blocks larger than PARALLEL_GRAIN are split by rows across the thread
+/// pool, so fn must only write to the rows it is given.
+template <typename Fn>
+inline void for_each_span(bool packed, int rows, int cols, Fn&& fn){
+    if (rows <= 0 || cols <= 0) return;
+    std::size_t row_grain = (PARALLEL_GRAIN + cols - 1) / cols;
+
+    parallel_for(static_cast<std::size_t>(rows), row_grain, [&](std::size_t r0, std::size_t r1){
+        if (packed){
+            fn(static_cast<int>(r0), (r1 - r0) * cols);
+            return;
+        }
+        for (std::size_t i = r0; i < r1; ++i){
+            fn(static_cast<int>(i), static_cast<std::size_t>(cols));
+        }
+    });
+}
+
+} // namespace kernels
+
+#endif
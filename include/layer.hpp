@@ -1,18 +1,238 @@
 #ifndef LAYER_HPP
 #define LAYER_HPP
 
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include "matrix.hpp"
+#include "half_matrix.hpp"
+#include "sparse_matrix.hpp"
+#include "workspace.hpp"
 
+/// A trainable tensor of a layer and the gradient backward writes for it.
+/// Both have the same shape. With a 16-bit precision (Layer::set_precision)
+/// a layer may compute with a rounded copy of the value, `half`, which
+/// Model re-encodes from the value after every optimizer step
+template <typename T>
+struct Parameter {
+    Matrix<T>* value;
+    Matrix<T>* grad;
+    HalfMatrix* half = nullptr;
+};
+
+/// A per-batch tensor a layer keeps from forward for backward, with the
+/// shape it takes for a given input (see Layer::caches). Exactly one of
+/// tensor and half is set
+template <typename T>
+struct BatchCache {
+    Matrix<T>* tensor;
+    int rows;
+    int cols;
+    HalfMatrix* half = nullptr;
+};
+
+/// Layer types a model file can store (see Model::save)
+enum class LayerKind : std::uint32_t {
+    Unknown = 0, Dense = 1, FusedDense = 2, ReLU = 3, Sigmoid = 4, Dropout = 5, BatchNorm = 6
+};
+
+/// What a model file records to rebuild a layer: its type and constructor
+/// arguments. The tensors themselves are stored via parameters() and state()
+struct LayerSpec {
+    LayerKind kind = LayerKind::Unknown;
+    std::uint32_t activation = 0;   // FusedDense: Activation
+    int input_dim = 0;
+    int output_dim = 0;
+    double value = 0.0;             // Dropout: drop probability
+};
+
+/// Estimated work of one forward or backward call, for profiling: the
+/// arithmetic performed and the bytes a call must at least move
+struct LayerCost {
+    double flops = 0.0;
+    double bytes = 0.0;
+};
+
+/// Constructor tag for layers whose parameters are about to be bound to
+/// existing storage (Model::load). The parameter and gradient matrices
+/// get their shapes but no memory, so nothing is allocated or initialized
+/// for them; using the layer before binding them is undefined.
+struct DeferInit {};
+
+/// Base class for all layers.
+///
+/// Layers implement forward_into/backward_into, which write into a
+/// caller-provided matrix (resized as needed) and keep any state they need
+/// for the backward pass in buffers that are reused from step to step, so a
+/// training loop with stable shapes performs no heap allocations after its
+/// first step. forward/backward are allocating conveniences on top.
+///
+/// A layer may keep a reference to the input of its last forward_into call
+/// until the matching backward call, so that input must stay alive in
+/// between. forward() keeps its own copy of the input instead, so its
+/// argument may be a temporary.
+///
+/// Temporaries that only live within one forward or backward call come from
+/// a Workspace arena. Model attaches its own arena with set_workspace;
+/// a standalone layer falls back to a private one.
+///
+/// Layers with trainable state list it in parameters(). Model moves every
+/// listed tensor into one flat parameter buffer and one flat gradient
+/// buffer that it owns, turning the layer's matrices into views of those
+/// buffers, so optimizers can update the whole model in a single sweep.
+/// Layers must therefore update parameters in place and never resize them.
+/// A layer must outlive every model it is added to; the model hands the
+/// tensors back as matrices of the layer's own when it is destroyed.
+template <typename T>
 class Layer{
     public:
-        virtual Matrix forward(const Matrix& input) = 0;
-        virtual Matrix backward(const Matrix& grad_output) = 0;
+        virtual void forward_into(const Matrix<T>& input, Matrix<T>& output) = 0;
+        virtual void backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input) = 0;
+
+        /// Inference-only forward pass: same result as forward_into in
+        /// evaluation mode, but it records nothing for backward and does
+        /// not touch the layer, so any number of threads may call it at
+        /// once. Temporaries come from the caller's `ws`
+        virtual void infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const = 0;
+
+        virtual Matrix<T> forward(const Matrix<T>& input){
+            Matrix<T> output;
+            forward_into(input, output);
+            return output;
+        }
+
+        virtual Matrix<T> backward(const Matrix<T>& grad_output){
+            Matrix<T> grad_input;
+            backward_into(grad_output, grad_input);
+            return grad_input;
+        }
+
         virtual void update(double learning_rate) = 0;
         virtual std::string get_name() const = 0;
         virtual std::pair<int,int> get_input_shape() const = 0;
         virtual std::pair<int,int> get_output_shape() const = 0;
         virtual int param_count() const=0;
         virtual ~Layer() = default;
+
+        /// (value, gradient) pairs of this layer's trainable tensors, in a
+        /// fixed order; empty for layers without parameters
+        virtual std::vector<Parameter<T>> parameters(){ return {}; }
+
+        /// Learned tensors that are not trained by the optimizer, such as
+        /// BatchNorm's running statistics; saved alongside parameters()
+        virtual std::vector<Matrix<T>*> state(){ return {}; }
+
+        /// Type and constructor arguments for model files. The default,
+        /// LayerKind::Unknown, makes Model::save reject the layer
+        virtual LayerSpec spec() const { return {}; }
+
+        /// Shape of the output for an input of shape `input` (rows, cols),
+        /// worked out without running the layer (Model::compile). The
+        /// default keeps the shape, as elementwise layers do. Throws
+        /// std::invalid_argument for an input the layer cannot take
+        virtual std::pair<int,int> infer_output_shape(std::pair<int,int> input) const { return input; }
+
+        /// Per-batch tensors forward keeps for backward (ReLU's mask,
+        /// BatchNorm's x_hat, ...) and their shapes for an input of shape
+        /// `input`. Model::compile places them in its slab alongside the
+        /// activations, so a layer may resize or assign them but must not
+        /// move or swap their storage
+        virtual std::vector<BatchCache<T>> caches(std::pair<int,int> /*input*/){ return {}; }
+
+        /// Whether backward reads the input or the output of the last
+        /// forward call itself, rather than a cache of its own. Model::compile
+        /// frees an activation for reuse as soon as no layer reads it; the
+        /// defaults assume both are read
+        virtual bool backward_reads_input() const { return true; }
+        virtual bool backward_reads_output() const { return true; }
+
+        /// Whether the layer can train and infer under `precision` (see
+        /// set_precision). Layers opt in: the default supports Full only,
+        /// and Model::set_precision rejects a model with a layer that does
+        /// not support the requested precision
+        virtual bool supports_precision(Precision precision) const { return precision == Precision::Full; }
+
+        /// Storage format for what the layer keeps between forward and
+        /// backward, and for the copy of its weights it computes with
+        /// (see Model::set_precision). Inputs, outputs and gradients passed
+        /// between layers stay in T, as do parameters and their gradients.
+        /// The default keeps everything in T, and throws for a precision
+        /// the layer does not support
+        virtual void set_precision(Precision precision){
+            if (!supports_precision(precision)){
+                throw std::invalid_argument(get_name() + " does not support " + half::precision_name(precision));
+            }
+        }
+
+        /// Repeats the last forward_into on the same input, to rebuild the
+        /// output and caches backward needs after their memory was reused
+        /// (Model::compile with checkpoint segments). The result must match
+        /// the original call without touching any other state: the same
+        /// Dropout mask, no second BatchNorm running-statistics update. The
+        /// default calls forward_into, which suits stateless layers
+        virtual void recompute_into(const Matrix<T>& input, Matrix<T>& output){ forward_into(input, output); }
+
+        /// Sparse (CSR) input, for a first layer fed wide, mostly-zero
+        /// features (Model::train with a SparseMatrix). forward_sparse_into
+        /// and infer_sparse_into work like forward_into and infer_into;
+        /// backward_sparse_into follows forward_sparse_into and only
+        /// computes parameter gradients, since nothing upstream of the
+        /// model input needs ∂L/∂input. The defaults throw
+        /// std::invalid_argument: only Dense layers take sparse input
+        virtual void forward_sparse_into(const SparseMatrix<T>& /*input*/, Matrix<T>& /*output*/){
+            throw std::invalid_argument(get_name() + " cannot take sparse input");
+        }
+        virtual void backward_sparse_into(const Matrix<T>& /*grad_output*/){
+            throw std::invalid_argument(get_name() + " cannot take sparse input");
+        }
+        virtual void infer_sparse_into(const SparseMatrix<T>& /*input*/, Matrix<T>& /*output*/, Workspace& /*ws*/) const {
+            throw std::invalid_argument(get_name() + " cannot take sparse input");
+        }
+
+        /// Work of the forward call that turned `input` into `output`. The
+        /// default suits elementwise layers: one flop per output element,
+        /// reading the input and writing the output
+        virtual LayerCost forward_cost(const Matrix<T>& input, const Matrix<T>& output) const {
+            return {double(output.size()), double(input.size() + output.size()) * sizeof(T)};
+        }
+
+        /// Work of the backward call that turned `grad_output` into
+        /// `grad_input`. The default reads the incoming gradient and one
+        /// cached tensor and writes the outgoing gradient
+        virtual LayerCost backward_cost(const Matrix<T>& grad_output, const Matrix<T>& grad_input) const {
+            return {double(grad_input.size()), double(grad_output.size() + 2 * grad_input.size()) * sizeof(T)};
+        }
+
+        /// Work of forward_sparse_into and backward_sparse_into; zero for
+        /// layers that cannot take sparse input
+        virtual LayerCost forward_sparse_cost(const SparseMatrix<T>& /*input*/, const Matrix<T>& /*output*/) const { return {}; }
+        virtual LayerCost backward_sparse_cost(const Matrix<T>& /*grad_output*/) const { return {}; }
+
+        /// Arena for per-call temporaries; nullptr selects the layer's own
+        void set_workspace(Workspace* ws){ workspace = ws; }
+
+    protected:
+        /// Arena to carve this call's temporaries from. Call once at the top
+        /// of forward_into/backward_into: the private fallback arena is
+        /// reset here, while a shared one is reset by its owner.
+        Workspace& begin_scratch(){
+            if (workspace) return *workspace;
+            own_workspace.reset();
+            return own_workspace;
+        }
+
+    private:
+        Workspace* workspace = nullptr;
+        Workspace own_workspace;
 };
 
+/// Builds a fresh layer from a LayerSpec (Model::load, data-parallel
+/// replicas). Dense and FusedDense layers come with DeferInit parameters,
+/// to be bound by the caller; other layers are constructed normally.
+/// Throws std::invalid_argument for LayerKind::Unknown or invalid arguments
+template <typename T>
+std::unique_ptr<Layer<T>> make_layer(const LayerSpec& spec);
+
 #endif
\ No newline at end of file
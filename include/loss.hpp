@@ -1,13 +1,45 @@
 #ifndef LOSS_HPP
 #define LOSS_HPP
 
+#include <memory>
 #include "matrix.hpp"
 
+/// Base class for loss functions.
+///
+/// forward() may keep references to its prediction and target until the
+/// matching backward call, so both must stay alive in between.
+/// backward_into() writes ∂L/∂prediction into a caller-provided matrix,
+/// resized as needed.
+template <typename T>
 class Loss{
     public:
-        virtual double forward(const Matrix& prediction, const Matrix& target) = 0;
-        virtual Matrix backward() = 0;
+        virtual double forward(const Matrix<T>& prediction, const Matrix<T>& target) = 0;
+        virtual void backward_into(Matrix<T>& grad) = 0;
+
+        virtual Matrix<T> backward(){
+            Matrix<T> grad;
+            backward_into(grad);
+            return grad;
+        }
+
+        /// Model output at which the two classes are split when accuracy
+        /// is reported: 0.5 for probabilities, 0 for losses that take logits
+        virtual double decision_threshold() const { return 0.5; }
+
+        /// A fresh loss of the same kind and settings, for another thread
+        /// (Model's data-parallel training runs one per worker). nullptr
+        /// when the loss cannot be copied
+        virtual std::unique_ptr<Loss<T>> clone() const { return nullptr; }
+
+        /// Multiplies the gradient backward_into writes by `scale`, leaving
+        /// the loss forward reports unchanged (Model's fp16 loss scaling)
+        void set_gradient_scale(T scale){ gradient_scale = scale; }
+        T get_gradient_scale() const { return gradient_scale; }
+
         virtual ~Loss() = default;
+
+    protected:
+        T gradient_scale = 1;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef LOSS_LOGITS_HPP
+#define LOSS_LOGITS_HPP
+
+#include <cstddef>
+#include "loss.hpp"
+
+/// Base of the fused loss heads that take raw logits z instead of σ(z).
+///
+/// The model ends in its last DenseLayer (no ActivationSigmoid), and the
+/// sigmoid is evaluated inside the loss in a numerically stable form.
+/// forward() computes the loss and ∂L/∂z together in a single pass over
+/// (z, y) and does not keep the prediction or target. backward_into()
+/// hands that gradient over by swapping buffers, without copying (it copies
+/// only when `grad` is a view). Call forward once before each backward.
+///
+/// Accuracy is reported with a decision threshold of 0 on the logits. For
+/// probabilities at inference, apply a sigmoid to the model output.
+template <typename T>
+class LogitLoss: public Loss<T>{
+    private:
+        Matrix<T> grad_cache;
+        bool grad_ready = false;
+
+    protected:
+        // sum = kernel(z, y, s, grad, n), see KernelTable
+        using Kernel = T (*)(const T* z, const T* y, T s, T* grad, std::size_t n);
+
+        virtual Kernel kernel() const = 0;
+        // Gradient scale s for a batch of `count` elements
+        virtual T grad_scale(int count) const = 0;
+
+    public:
+        double forward(const Matrix<T>& logits, const Matrix<T>& target) override;
+        void backward_into(Matrix<T>& grad) override;
+        double decision_threshold() const override { return 0.0; }
+};
+
+/// Binary cross-entropy with logits, averaged over all elements:
+///     L = mean( max(z, 0) - z·y + log(1 + e^(-|z|)) )
+///     ∂L/∂z = (σ(z) - y) / n
+/// Equal to BCE(σ(z), y), but without the log(0) and vanishing-gradient
+/// problems of a saturated sigmoid.
+template <typename T>
+class LossBCEWithLogits: public LogitLoss<T>{
+    protected:
+        typename LogitLoss<T>::Kernel kernel() const override;
+        T grad_scale(int count) const override;
+
+    public:
+        std::unique_ptr<Loss<T>> clone() const override { return std::make_unique<LossBCEWithLogits<T>>(); }
+};
+
+/// Mean squared error of σ(z), the fused form of ActivationSigmoid → LossMSE:
+///     L = mean( (σ(z) - y)² )
+///     ∂L/∂z = 2 (σ(z) - y) σ(z) (1 - σ(z)) / n
+template <typename T>
+class LossSigmoidMSE: public LogitLoss<T>{
+    protected:
+        typename LogitLoss<T>::Kernel kernel() const override;
+        T grad_scale(int count) const override;
+
+    public:
+        std::unique_ptr<Loss<T>> clone() const override { return std::make_unique<LossSigmoidMSE<T>>(); }
+};
+
+#endif
@@ -3,14 +3,16 @@
 
 #include "loss.hpp"
 
-class LossMSE: public Loss{
+template <typename T>
+class LossMSE: public Loss<T>{
     private:
-        Matrix prediction_cache;
-        Matrix target_cache;
+        const Matrix<T>* prediction_cache = nullptr;
+        const Matrix<T>* target_cache = nullptr;
     
     public:
-        double forward(const Matrix& prediction, const Matrix& target) override;
-        Matrix backward() override;
+        double forward(const Matrix<T>& prediction, const Matrix<T>& target) override;
+        void backward_into(Matrix<T>& grad) override;
+        std::unique_ptr<Loss<T>> clone() const override { return std::make_unique<LossMSE<T>>(); }
 };
 
 #endif
\ No newline at end of file
@@ -3,28 +3,133 @@
 
 #include <vector>
 #include <iostream>
+#include <cstddef>
+#include "aligned_memory.hpp"
+#include "gemm.hpp"
 
+/// Row-major matrix backed by a single 64-byte aligned buffer.
+///
+/// Element (i, j) lives at data()[i * stride + j]. Owning matrices are
+/// always packed (stride == cols) so the whole buffer can be swept as one
+/// contiguous run; views created with Matrix::view may use a wider stride
+/// to address a block of a larger buffer.
+///
+/// Templated on the scalar type; Matrix<float> and Matrix<double> are
+/// instantiated in matrix.cpp.
+template <typename T>
 class Matrix {
 
     public:
+        static constexpr std::size_t ALIGNMENT = NEURONITE_ALIGNMENT;
+
         int rows, cols;
-        std::vector<std::vector<double>> data;
+        int stride;
 
         Matrix();
         Matrix(int rows, int cols);
-        Matrix(int rows, int cols, double init_val);
-        Matrix(const std::vector<std::vector<double>>& values);
+        Matrix(int rows, int cols, T init_val);
+        Matrix(const std::vector<std::vector<T>>& values);
+
+        Matrix(const Matrix& other);
+        Matrix(Matrix&& other) noexcept;
+        Matrix& operator=(const Matrix& other);
+        Matrix& operator=(Matrix&& other);
+        ~Matrix();
+
+        /// Non-owning view over external storage. The caller keeps `ptr`
+        /// alive for the lifetime of the view. Assigning to a view copies
+        /// into the viewed memory instead of rebinding it.
+        static Matrix view(T* ptr, int rows, int cols, int stride);
+        static Matrix view(T* ptr, int rows, int cols) { return view(ptr, rows, cols, cols); }
+
+        /// Turns this matrix into a packed view of `ptr`, freeing any owned
+        /// buffer. Unlike assignment, this also rebinds an existing view.
+        /// With a `capacity` (elements available at `ptr`), the view may
+        /// later be resized or assigned to any shape that fits, but never
+        /// reallocates (Model::compile places buffers this way).
+        void rebind(T* ptr, int rows, int cols, std::size_t capacity = 0);
+
+        T& operator()(int i, int j) { return ptr[static_cast<std::size_t>(i) * stride + j]; }
+        const T& operator()(int i, int j) const { return ptr[static_cast<std::size_t>(i) * stride + j]; }
+
+        T* row(int i) { return ptr + static_cast<std::size_t>(i) * stride; }
+        const T* row(int i) const { return ptr + static_cast<std::size_t>(i) * stride; }
+
+        T* data() { return ptr; }
+        const T* data() const { return ptr; }
+
+        std::size_t size() const { return static_cast<std::size_t>(rows) * cols; }
+        bool is_contiguous() const { return stride == cols || rows <= 1; }
+        bool owns_data() const { return owning; }
+
+        void fill(T value);
+
+        /// Reshapes to (rows × cols), reusing the current buffer when it is
+        /// large enough, so steady-state callers never touch the heap.
+        /// Contents are unspecified afterwards. A view cannot change shape
+        /// and throws unless the shape already matches, or fits in the
+        /// capacity it was rebound with.
+        void resize(int rows, int cols);
+
+        static Matrix dot(const Matrix& A, const Matrix& B);      // A · B
+        static Matrix dot_tn(const Matrix& A, const Matrix& B);   // Aᵀ · B
+        static Matrix dot_nt(const Matrix& A, const Matrix& B);   // A · Bᵀ
+
+        /// C = alpha · op(A) · op(B) + beta · C into an existing, correctly
+        /// shaped C. Transposed operands are read in place.
+        static void dot_accumulate(const Matrix& A, Transpose trans_a,
+                                   const Matrix& B, Transpose trans_b,
+                                   Matrix& C, T alpha = 1, T beta = 1);
+
+        /// C = op(A) · op(B), resizing C to fit and overwriting its contents
+        static void dot_into(const Matrix& A, Transpose trans_a,
+                             const Matrix& B, Transpose trans_b, Matrix& C);
+
+        /// C = act(op(A) · op(B) + bias), resizing C to fit. bias is a
+        /// (1 × N) row; bias and activation are applied in the GEMM
+        /// epilogue instead of as extra passes over C
+        static void dot_bias_act_into(const Matrix& A, Transpose trans_a,
+                                      const Matrix& B, Transpose trans_b,
+                                      const Matrix& bias, Activation activation,
+                                      Matrix& C);
+
+        /// out.row(k) = src.row(rows[k]) for k < count, resizing out to
+        /// (count × src.cols)
+        static void gather_rows(const Matrix& src, const int* rows, int count, Matrix& out);
 
-        static Matrix dot(const Matrix& A, const Matrix& B);
         Matrix transpose() const;
         Matrix col_sum() const;
+        void col_sum_into(Matrix& out) const;
+
+        /// out = a (+ - *) b with the same broadcasting as the operators;
+        /// out is resized to a's shape and may alias a
+        static void add_into(const Matrix& a, const Matrix& b, Matrix& out);
+        static void sub_into(const Matrix& a, const Matrix& b, Matrix& out);
+        static void mul_into(const Matrix& a, const Matrix& b, Matrix& out);
 
         Matrix operator+(const Matrix& other) const;
         Matrix operator-(const Matrix& other) const;
         Matrix operator*(const Matrix& other) const;
-        Matrix operator*(double scalar) const;
+        Matrix operator*(T scalar) const;
+
+        Matrix& operator+=(const Matrix& other);
+        Matrix& operator-=(const Matrix& other);
+        Matrix& operator*=(const Matrix& other);
+        Matrix& operator*=(T scalar);
+
+        /// this += alpha · x, for x of the same shape
+        void axpy(T alpha, const Matrix& x);
 
         void print() const;
+
+    private:
+        T* ptr;
+        std::size_t capacity;   // elements in the owned buffer
+        bool owning;
+
+        void allocate(int rows, int cols);
+        void release();
+        void copy_from(const Matrix& other);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,28 @@
+#ifndef MEMORY_PLAN_HPP
+#define MEMORY_PLAN_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// A tensor to place in a shared slab: its size and the steps of the
+/// schedule during which it must hold its contents, as inclusive
+/// (first, last) ranges. A tensor that is written again after its
+/// contents died (recomputed activations) has several ranges. Two tensors
+/// may share memory when none of their ranges intersect.
+struct TensorLifetime {
+    std::size_t bytes;
+    std::vector<std::pair<int,int>> live;
+};
+
+/// Assigns each tensor a byte offset in one slab so that tensors alive at
+/// the same step never overlap, and returns the slab size.
+///
+/// Greedy by size: the largest tensors are placed first, each at the
+/// lowest NEURONITE_ALIGNMENT-aligned offset that clears every already
+/// placed tensor it coexists with. `offsets` receives one entry per
+/// tensor, in input order. Throws std::invalid_argument if a range ends
+/// before it starts
+std::size_t plan_memory(const std::vector<TensorLifetime>& tensors, std::vector<std::size_t>& offsets);
+
+#endif
@@ -1,31 +1,544 @@
 #ifndef MODEL_HPP
 #define MODEL_HPP
 
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 #include "matrix.hpp"
 #include "layer.hpp"
 #include "loss.hpp"
 #include "optimizer.hpp"
+#include "workspace.hpp"
+#include "batch_loader.hpp"
+#include "communicator.hpp"
+#include "gradient_sync.hpp"
 
+class Profiler;
+
+/// Scratch for Model::predict: ping-pong buffers for the intermediate
+/// activations and an arena for layer temporaries. One per thread;
+/// buffers grow to the largest batch seen and are then reused.
+template <typename T>
+struct PredictScratch {
+    Matrix<T> ping;
+    Matrix<T> pong;
+    Workspace workspace;
+};
+
+/// How int8 quantization changed a model's predictions on an evaluation
+/// set (see Model::quantize). Errors are over all outputs; accuracies use
+/// the threshold given to quantize
+struct QuantizationReport {
+    double reference_accuracy;
+    double quantized_accuracy;
+    double accuracy_delta;      // quantized - reference
+    double max_abs_error;
+    double mean_abs_error;
+};
+
+/// Memory layout worked out by Model::compile. Byte counts are for a
+/// batch of max_batch rows
+struct MemoryPlan {
+    int input_dim = 0;
+    int max_batch = 0;
+    int segments = 1;                         // checkpoint segments
+    bool sparse_input = false;                // planned for SparseMatrix input
+    std::vector<std::pair<int,int>> shapes;   // output shape of each layer
+    std::size_t slab_bytes = 0;        // the slab: activations, gradients and layer caches
+    std::size_t unshared_bytes = 0;    // the same tensors in buffers of their own
+    std::size_t parameter_bytes = 0;   // flat parameter and gradient buffers
+    std::size_t inference_bytes = 0;   // predict's two scratch buffers (see reserve)
+};
+
+template <typename T>
 class Model{
     private:
-        std::vector<Layer*> layers;
+        std::vector<Layer<T>*> layers;
+
+        // Layers created by load(); layers passed to add() belong to the caller
+        std::vector<std::unique_ptr<Layer<T>>> owned_layers;
+
+        // Mapped model file that loaded weights point into; unmapped when
+        // the model goes away
+        std::shared_ptr<void> mapping;
+
+        // Output of each layer and gradient w.r.t. each layer's input,
+        // reused across steps so training does not allocate once warm
+        std::vector<Matrix<T>> activations;
+        std::vector<Matrix<T>> gradients;
+        Matrix<T> loss_grad;
+
+        // Scratch arena shared by all layers, reset after every step
+        Workspace workspace;
+
+        // Every layer parameter and gradient, back to back; the layers'
+        // matrices are views into these (see bind_parameters)
+        Matrix<T> param_buffer;
+        Matrix<T> grad_buffer;
+        bool parameters_bound = false;
+
+        // Gathered rows of the current shuffled mini-batch
+        Matrix<T> input_batch;
+        Matrix<T> target_batch;
+        SparseMatrix<T> sparse_batch;
+
+        // A data-parallel worker other than the model itself: layers
+        // rebuilt from their LayerSpec whose parameters are views of
+        // param_buffer, with private gradients laid out like grad_buffer
+        struct Replica {
+            std::vector<std::unique_ptr<Layer<T>>> layers;
+            std::vector<Matrix<T>> activations;
+            std::vector<Matrix<T>> gradients;
+            Matrix<T> loss_grad;
+            Matrix<T> slab;                  // placed like the model's, after compile
+            Matrix<T> grad_buffer;
+            std::vector<Matrix<T>*> state;   // state() of every layer, in order
+            std::unique_ptr<Loss<T>> loss;
+            Workspace workspace;
+        };
+
+        int data_parallel = 1;
+        std::vector<std::unique_ptr<Replica>> replicas;
+        const Loss<T>* replica_loss_source = nullptr;
+        std::vector<Matrix<T>*> layer_state;   // the model's own, matching Replica::state
+
+        // Per-worker results of the current step, and reduction inputs
+        std::vector<double> shard_loss;
+        std::vector<int> shard_correct;
+        std::vector<T> shard_weights;
+        std::vector<T*> shard_parts;
+
+        // Elements per chunk of the parallel gradient reduction
+        static constexpr std::size_t REDUCE_GRAIN = 1 << 14;
+
+        // Multi-process training (set_communicator); planned against the
+        // current flat buffers once the parameters have been broadcast
+        Communicator* communicator = nullptr;
+        std::unique_ptr<GradientSync<T>> gradient_sync;
+        bool gradient_sync_planned = false;
+
+        // Storage of activations, gradients, loss_grad and the layers'
+        // caches once compiled; they are views placed in it at the offsets
+        // of memory_plan
+        Matrix<T> activation_slab;
+        MemoryPlan memory_plan;
+        bool compiled = false;
+
+        // Checkpointing: for the last layer of every checkpoint segment but
+        // the final one, the segment's first layer; -1 elsewhere. Empty
+        // unless compiled. backward reruns the segment before entering it
+        std::vector<int> checkpoint_from;
+
+        // Copy of the input of the public forward(), which the first layer
+        // and checkpoint recomputation may read again until backward
+        Matrix<T> forward_copy;
+        SparseMatrix<T> sparse_forward_copy;
+
+        // Input of the last forward_pass, which recomputing the first
+        // segment starts from; sparse_input instead when it was sparse
+        const Matrix<T>* forward_input = nullptr;
+        const SparseMatrix<T>* sparse_input = nullptr;
+
+        // Receives timing and cost events while attached (set_profiler)
+        Profiler* profiler = nullptr;
+
+        // Mixed precision (set_precision): the 16-bit compute copies of
+        // the parameters, re-encoded after every optimizer step
+        Precision precision = Precision::Full;
+        std::vector<Parameter<T>> half_parameters;
+
+        // Dynamic loss scaling, Float16 only (set_loss_scaling)
+        double loss_scale = 65536.0;
+        int loss_scale_growth_interval = 2000;
+        int steps_since_rescale = 0;
+        long long skipped_steps = 0;
+
+        static int count_correct(const Matrix<T>& prediction, const Matrix<T>& target,
+                                 double threshold = 0.5);
+
+        const Matrix<T>& forward_pass(const Matrix<T>& input);
+        const Matrix<T>& forward_pass(const SparseMatrix<T>& input);
+
+        // Throws unless a (rows × cols) input, sparse or not, fits the
+        // compiled plan
+        void check_plan(int rows, int cols, bool sparse) const;
+
+        // Forward of layer i into activations[i], layer 0 reading the
+        // model input; `replay` recomputes it for a checkpoint segment
+        void forward_layer(int i, bool replay);
+        // Backward pass; with `sync`, reports each finished layer to it
+        const Matrix<T>& backward_pass(const Matrix<T>& grad_output, GradientSync<T>* sync = nullptr);
+
+        // Checkpointing: forward again over layers [first, last], whose
+        // outputs and caches were overwritten after forward_pass
+        void recompute(int first, int last);
+
+        // Inference over layers [first, end) from `input`, the model input
+        // or the output of layer first - 1
+        void infer_layers(std::size_t first, const Matrix<T>& input, Matrix<T>& output,
+                          PredictScratch<T>& scratch) const;
+
+        // Output shape of every layer for a (rows × input_dim) input;
+        // `caller` prefixes the error of a layer that rejects its input
+        std::vector<std::pair<int,int>> infer_shapes(int input_dim, int rows, const char* caller) const;
+
+        // Places one set of step buffers and the caches of `stack` (the
+        // model's layers or a replica's) in `slab`, sized for batches of
+        // up to `rows` rows, reusing memory between tensors whose
+        // lifetimes within a step do not overlap; returns the bytes the
+        // tensors would take without sharing
+        std::size_t place_buffers(int rows, const std::vector<Layer<T>*>& stack,
+                                  std::vector<Matrix<T>>& activations,
+                                  std::vector<Matrix<T>>& gradients, Matrix<T>& loss_grad,
+                                  Matrix<T>& slab);
+
+        // Returns the step buffers to ordinary owned matrices
+        void drop_memory_plan();
+
+        // Lists the parameters with a 16-bit copy and encodes them all;
+        // refresh_half_parameters re-encodes the listed ones
+        void collect_half_parameters();
+        void refresh_half_parameters();
+
+        // Divides the gradients by the loss scale; false if any of them is
+        // not finite, in which case the step must be skipped
+        bool unscale_gradients();
+
+        // Moves every layer's parameters and gradients into the flat
+        // buffers, if a layer was added since the last call
+        void bind_parameters();
+
+        // Copies a layer's parameters and gradients back out of the flat
+        // buffers into storage of its own, for a layer leaving the model
+        void unbind_parameters(Layer<T>* layer);
+
+        // Starts every rank from rank 0's parameters and layer state, and
+        // cuts the gradient buffer into buckets at layer boundaries
+        void prepare_gradient_sync();
+
+        // Sums the epoch totals over all ranks, so every rank logs and
+        // stops early on the same global numbers
+        void reduce_epoch_totals(double& loss_sum, int& correct, int& rows_seen);
+
+        // Creates the data_parallel - 1 replicas if they do not exist yet,
+        // and gives them copies of `loss_fn` if they have other ones
+        void prepare_replicas(const Loss<T>& loss_fn);
+
+        // Forward/backward of rows [row0, row0 + rows) of (x, y) on worker
+        // w (0 is the model itself), leaving the gradients in its buffer.
+        // Input is Matrix<T> or SparseMatrix<T>, as in train_step
+        template <typename Input>
+        void train_shard(int w, const Input& x, const Matrix<T>& y,
+                         int row0, int rows, Loss<T>& loss_fn);
+
+        // Waits for the cross-process gradient average, steps the
+        // optimizer and resets the workspace
+        void finish_step(Optimizer<T>& optimizer, int step);
+
+        // One forward/backward/optimizer step on a batch; adds the
+        // row-weighted loss and the number of correct rows to the totals
+        template <typename Input>
+        void train_step(const Input& x, const Matrix<T>& y,
+                        Loss<T>& loss_fn, Optimizer<T>& optimizer, int step,
+                        double& loss_sum, int& correct);
+
+        // The epoch and mini-batch loop of train, for dense or sparse input
+        template <typename Input>
+        void train_rows(const Input& input, const Matrix<T>& target,
+                        Loss<T>& loss_fn, Optimizer<T>& optimizer, int epochs,
+                        int patience, int batch_size, bool shuffle, LastBatch last_batch);
+
+        // Rows rows[0..count) of `input` gathered into input_batch or
+        // sparse_batch
+        const Matrix<T>& gather_batch(const Matrix<T>& input, const int* rows, int count);
+        const SparseMatrix<T>& gather_batch(const SparseMatrix<T>& input, const int* rows, int count);
+
+        // Prints the epoch summary and updates the early-stopping state;
+        // returns true when training should stop
+        static bool end_epoch(int epoch, double loss, double acc, int patience,
+                              double& best_loss, int& epochs_without_improvement);
     
     public:
-        void add(Layer* layer);
-        Matrix forward(const Matrix& loss_grad);
-        Matrix backward(const Matrix& loss_grad);
+        Model() = default;
+        ~Model();
+        Model(const Model&) = delete;
+        Model& operator=(const Model&) = delete;
+
+        /// Appends a layer, which stays owned by the caller and must outlive
+        /// the model. While added, the layer's parameters and gradients are
+        /// views into the model's flat buffers (see bind_parameters), and
+        /// once compiled its caches live in the model's slab, and its
+        /// temporaries come from the model's workspace. The model's
+        /// destructor copies the tensors back into storage of the layer's
+        /// own and detaches the workspace, so the layer remains usable
+        /// afterwards
+        void add(Layer<T>* layer);
+
+        /// Forward pass through every layer, recording what backward needs.
+        /// The input is copied first, so it may be a temporary
+        Matrix<T> forward(const Matrix<T>& input);
+
+        /// Forward pass on a sparse input (see train); a following
+        /// backward returns an empty matrix, as there is no ∂L/∂input
+        Matrix<T> forward(const SparseMatrix<T>& input);
+        Matrix<T> backward(const Matrix<T>& loss_grad);
         void update(double learning_rate);
-        static double compute_accuracy(const Matrix& prediction,
-                                const Matrix& target);
-        void train(const Matrix& input,
-                    const Matrix& target,
-                    Loss& loss_fn,
-                    Optimizer& optimizer,
+
+        /// Inference: runs the layers' infer_into into `output`, skipping
+        /// all backward bookkeeping (Dropout scales, BatchNorm uses its
+        /// running statistics). const and free of shared mutable state, so
+        /// one model can serve many threads at once, as long as nothing
+        /// trains or modifies it meanwhile. Intermediates live in `scratch`,
+        /// or in a thread-local one when none is given
+        void predict(const Matrix<T>& input, Matrix<T>& output, PredictScratch<T>& scratch) const;
+        void predict(const Matrix<T>& input, Matrix<T>& output) const;
+        Matrix<T> predict(const Matrix<T>& input) const;
+
+        /// Same, on a sparse input (see train)
+        void predict(const SparseMatrix<T>& input, Matrix<T>& output, PredictScratch<T>& scratch) const;
+        void predict(const SparseMatrix<T>& input, Matrix<T>& output) const;
+        Matrix<T> predict(const SparseMatrix<T>& input) const;
+        static double compute_accuracy(const Matrix<T>& prediction,
+                                const Matrix<T>& target);
+
+        /// Trains for up to `epochs` passes over (input, target), stopping
+        /// early once the epoch loss has not improved for `patience` epochs.
+        ///
+        /// batch_size <= 0 (or >= the number of rows) trains on the whole
+        /// dataset as one batch. Otherwise every epoch walks a fresh random
+        /// permutation of the rows (unless shuffle is false), gathering each
+        /// batch into a reused buffer, and runs one optimizer step per batch.
+        /// Unshuffled batches are views of the input and are not copied. The
+        /// reported loss and accuracy are averaged over all rows seen in
+        /// the epoch. Throws std::invalid_argument if input has no rows.
+        void train(const Matrix<T>& input,
+                    const Matrix<T>& target,
+                    Loss<T>& loss_fn,
+                    Optimizer<T>& optimizer,
+                    int epochs,
+                    int patience = 10,
+                    int batch_size = 0,
+                    bool shuffle = true,
+                    LastBatch last_batch = LastBatch::Keep
+                );
+
+        /// Same as above on a sparse (CSR) input, for wide features that
+        /// are mostly zero. The first layer must be a DenseLayer or
+        /// FusedDenseLayer; it computes X · W as a sum of the rows of W
+        /// picked by each row's nonzeros, and its weight gradient Xᵀ · ∂L/∂Z
+        /// only in the rows of the features present in the batch, so both
+        /// cost O(nnz · output_dim) instead of O(rows · input_dim ·
+        /// output_dim). The rest of the model runs as usual. Shuffled
+        /// batches are gathered into a reused sparse buffer, unshuffled
+        /// ones are views.
+        ///
+        /// The other rows of the gradient stay zero from step to step
+        /// without being swept, except under set_data_parallel or
+        /// set_communicator: combining the workers' gradients writes every
+        /// row anyway, and the gradient buffer is cleared before each step.
+        /// The first layer multiplies with its T weights under every
+        /// precision (set_precision)
+        void train(const SparseMatrix<T>& input,
+                    const Matrix<T>& target,
+                    Loss<T>& loss_fn,
+                    Optimizer<T>& optimizer,
+                    int epochs,
+                    int patience = 10,
+                    int batch_size = 0,
+                    bool shuffle = true,
+                    LastBatch last_batch = LastBatch::Keep
+                );
+
+        /// Like the first train, but batches come from `loader`, which
+        /// assembles the next one on its own thread while the current one
+        /// trains. An epoch is loader.batches_per_epoch() batches
+        void train(BatchLoader<T>& loader,
+                    Loss<T>& loss_fn,
+                    Optimizer<T>& optimizer,
                     int epochs,
                     int patience = 10
                 );
+        /// Prints each layer's shapes for a single row of `input_dim`
+        /// features and its parameter count, without running the model
         void summarize(int input_dim);
+
+        /// Plans the model's memory for inputs of `input_dim` columns and
+        /// at most `max_batch` rows, before any data flows.
+        ///
+        /// Every layer's output shape is inferred statically
+        /// (Layer::infer_output_shape), so a mismatch throws
+        /// std::invalid_argument here rather than in the first step. The
+        /// activations, gradients and layer caches (Layer::caches) of a
+        /// training step are then laid out in one preallocated slab: from
+        /// the order forward, loss and backward use them, each tensor gets
+        /// a lifetime, and tensors whose lifetimes are disjoint share
+        /// memory (gradients reuse the activations that backward has
+        /// finished with). Parameters are moved into their flat buffers
+        /// as well.
+        ///
+        /// With `checkpoint_segments` > 1 the layers are cut into that many
+        /// consecutive segments of about equal length, and only the
+        /// outputs at segment boundaries outlive the forward pass. Backward
+        /// reruns each segment but the last from its stored input
+        /// (Layer::recompute_into, which replays the same Dropout masks)
+        /// just before differentiating it, so the slab holds the
+        /// boundaries plus one segment's activations and caches instead of
+        /// all of them, for about one extra forward pass of compute. The
+        /// gradients are unchanged.
+        ///
+        /// With `sparse_input` the plan is for a SparseMatrix input: the
+        /// slab holds no ∂L/∂input, which backward never writes for one
+        /// and which would be as wide as the features, and none of the
+        /// first layer's caches.
+        ///
+        /// Afterwards steps with up to max_batch rows run in this fixed
+        /// footprint, and larger or differently shaped inputs throw, as do
+        /// dense inputs to a sparse plan and sparse inputs to a dense one.
+        /// Data-parallel replicas get slabs of their own, planned the same
+        /// way for their shard size. Layer temporaries still come from the
+        /// workspace arena, which settles after the first step. Adding a
+        /// layer discards the plan; compile again to replace it
+        const MemoryPlan& compile(int input_dim, int max_batch, int checkpoint_segments = 1,
+                                  bool sparse_input = false);
+        bool is_compiled() const;
+
+        /// Presizes `scratch` for every input the compiled plan allows, so
+        /// predict with it never allocates outside the workspace. Throws
+        /// std::invalid_argument before compile
+        void reserve(PredictScratch<T>& scratch) const;
+
+        /// Synchronous data-parallel training over `workers` replicas of
+        /// the layer stack (1, the default, turns it off).
+        ///
+        /// Every training step splits its batch into `workers` contiguous
+        /// shards. The model trains on the first, and replicas rebuilt from
+        /// each layer's spec() train on the others, all at once on the
+        /// shared thread pool (so get_num_threads() bounds the concurrency;
+        /// the kernels inside each worker run single-threaded). Replicas
+        /// read the model's own weights, so nothing is copied to them; each
+        /// writes its gradients to a private flat buffer, and the buffers
+        /// are reduced into get_gradients() by a parallel chunked sum,
+        /// weighted by shard size, before the optimizer steps once. With a
+        /// loss that averages over rows (all losses here do) the step
+        /// matches single-worker training up to rounding, except for
+        /// per-shard batch statistics (BatchNorm) and Dropout masks.
+        /// BatchNorm running statistics are averaged the same way.
+        ///
+        /// Every layer needs a LayerSpec (as for save) and the loss must
+        /// implement clone(); train throws std::invalid_argument otherwise
+        void set_data_parallel(int workers);
+        int get_data_parallel() const;
+
+        /// Synchronous multi-process training: every process (rank) of the
+        /// job builds the same model, calls this with its end of a shared
+        /// Communicator (e.g. ShmCommunicator) and trains on its own part
+        /// of the data.
+        ///
+        /// The first training step copies rank 0's parameters and layer
+        /// state to every rank. In each step, backward hands the gradients
+        /// of finished layers, in buckets of about `bucket_bytes`, to a
+        /// communication thread that averages them across ranks while the
+        /// earlier layers are still being differentiated; the optimizer then
+        /// steps on identical gradients everywhere, so the ranks stay in
+        /// lockstep without exchanging weights. Combined with
+        /// set_data_parallel, the threads' gradients are reduced first and
+        /// then averaged across ranks. Epoch loss and accuracy are summed
+        /// over all ranks, so logging and early stopping agree.
+        ///
+        /// Every rank must run the same number of steps per epoch. The
+        /// communicator must outlive training (nullptr turns this off) and
+        /// must not be used elsewhere while train runs
+        void set_communicator(Communicator* comm, std::size_t bucket_bytes = std::size_t(1) << 20);
+
+        /// Records training into `profiler` (nullptr detaches it): each
+        /// layer's forward and backward calls, the loss, gradient reduction
+        /// and synchronization, the optimizer step and whole epochs. With
+        /// set_data_parallel, layer events come from the model's own shard.
+        /// predict is not profiled. The profiler must outlive training
+        void set_profiler(Profiler* profiler);
+
+        /// All trainable parameters as one (1 × n) buffer, and the matching
+        /// gradients from the last backward pass. Each layer parameter is a
+        /// view of a slice, starting on a 64-byte boundary (the padding
+        /// between slices is zero in both buffers)
+        Matrix<T>& get_parameters();
+        Matrix<T>& get_gradients();
+
+        /// Replaces every DenseLayer and FusedDenseLayer with an int8
+        /// QuantizedDenseLayer built from its current weights, for
+        /// inference. The model cannot be trained or saved afterwards. The
+        /// replaced layers keep their weights and gradients, in storage of
+        /// their own again. Drops the compile() plan. Throws
+        /// std::invalid_argument unless the precision is Full
+        void quantize();
+
+        /// Same, and evaluates the model on (input, target) before and after,
+        /// reporting the accuracy change and the output error
+        QuantizationReport quantize(const Matrix<T>& input, const Matrix<T>& target,
+                                    double threshold = 0.5);
+
+        /// Writes the layers, their parameters and state, and (if given)
+        /// the optimizer's state to `path` in the format of model_file.hpp.
+        /// Throws std::invalid_argument if a layer has no LayerSpec and
+        /// std::runtime_error on I/O failure
+        void save(const std::string& path, Optimizer<T>* optimizer = nullptr);
+
+        /// Rebuilds a saved model into this (empty) model.
+        ///
+        /// The file is memory-mapped copy-on-write and the layer weights
+        /// are views of the mapped pages: nothing is parsed or copied
+        /// beyond the layer table, so loading takes constant time and
+        /// predict() faults in only the pages it reads. Writes to the
+        /// weights stay private to the process, and the first training
+        /// step moves them into the model's own flat buffer. Optimizer
+        /// state, when `optimizer` is given and the file has it, is
+        /// copied into the optimizer. Throws std::runtime_error if the
+        /// file cannot be read and std::invalid_argument if it is
+        /// malformed, of another element type, or this model has layers
+        void load(const std::string& path, Optimizer<T>* optimizer = nullptr);
+
+        /// Layer scratch arena; high_water_mark() reports the peak per-step
+        /// use and reserve() presizes it
+        Workspace& get_workspace();
+
+        /// Mixed-precision training and inference. With BFloat16 or Float16
+        /// the layers that support it (DenseLayer, FusedDenseLayer,
+        /// ActivationReLU, ActivationSigmoid) keep what forward saves for
+        /// backward in that format, at half the bytes, and the dense layers
+        /// multiply with a 16-bit copy of their weights and, in backward,
+        /// of ∂L/∂output. The parameters themselves stay in T as master
+        /// weights: the optimizer updates them and the 16-bit copies are
+        /// rounded from them after every step. Products widen their 16-bit
+        /// operands while packing and accumulate in T (see GemmOperand), as
+        /// do all reductions.
+        /// Activations and gradients passed between layers stay in T; once
+        /// compiled, an activation whose consumers keep their own 16-bit
+        /// copy is dead after the next layer's forward and its memory is
+        /// reused. Dropout and BatchNorm keep everything in T. Throws
+        /// std::invalid_argument, changing nothing, if a layer does not
+        /// support the precision (Layer::supports_precision; a
+        /// QuantizedDenseLayer, for one), and add() rejects such a layer
+        /// while a 16-bit precision is set.
+        ///
+        /// Float16 keeps 3.3 significant digits but only reaches down to
+        /// 6e-8, so small gradients would flush to zero: every step then
+        /// multiplies the loss gradient by a loss scale (set_loss_scaling)
+        /// and divides the weight gradients by it before the optimizer
+        /// runs. A step whose gradients overflow is skipped and the scale
+        /// halved. BFloat16 has fp32's range and needs no scaling.
+        ///
+        /// Discards the compiled plan, like add(); compile again afterwards
+        void set_precision(Precision precision);
+        Precision get_precision() const;
+
+        /// Float16 loss scaling: start at `initial_scale` and double the
+        /// scale after `growth_interval` consecutive steps without overflow
+        void set_loss_scaling(double initial_scale = 65536.0, int growth_interval = 2000);
+        double get_loss_scale() const;
+
+        /// Optimizer steps skipped because Float16 gradients overflowed
+        long long get_skipped_steps() const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef MODEL_FILE_HPP
+#define MODEL_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "tensor_file.hpp"
+
+/// On-disk model format (.nnm), written by Model::save:
+///
+///     offset 0   ModelFileHeader (64 bytes)
+///                LayerRecord × layer_count, in model order
+///                TensorRecord × tensor_count
+///     ...        tensor sections, each starting on a MODEL_FILE_PAGE boundary
+///
+/// The parameter section is the model's flat parameter buffer exactly as
+/// Model lays it out (see Model::get_parameters): every layer parameter
+/// has a Parameter record pointing at its slice, and optimizer state is
+/// stored in sections of the same length, indexed the same way. Since
+/// sections are page-aligned, a mapped file hands out SIMD-aligned
+/// weights and no page holds bytes of two different tensors.
+///
+/// All integers are little-endian; elements are TensorDType.
+enum class TensorRole : std::uint32_t {
+    ParameterBuffer = 0,   // the flat parameter buffer; one per file
+    Parameter = 1,         // one layer parameter, inside ParameterBuffer
+    LayerState = 2,        // Layer::state()[index] of layer `layer`
+    OptimizerState = 3     // Optimizer::state()[index]
+};
+
+struct ModelFileHeader {
+    char magic[8];                // "NNMODEL\0"
+    std::uint32_t version;        // MODEL_FILE_VERSION
+    std::uint32_t dtype;          // TensorDType
+    std::uint32_t layer_count;
+    std::uint32_t tensor_count;
+    std::uint64_t file_bytes;     // total size, to detect truncation
+    char reserved[32];            // zero
+};
+
+struct LayerRecord {
+    std::uint32_t kind;           // LayerKind
+    std::uint32_t activation;     // LayerSpec::activation
+    std::int32_t input_dim;
+    std::int32_t output_dim;
+    double value;                 // LayerSpec::value
+    char reserved[8];             // zero
+};
+
+struct TensorRecord {
+    std::uint64_t offset;         // byte offset of the first element
+    std::uint32_t rows;
+    std::uint32_t cols;
+    std::uint32_t role;           // TensorRole
+    std::uint32_t layer;          // owning layer, for Parameter and LayerState
+    std::uint32_t index;          // position in parameters() / state()
+    std::uint32_t reserved;       // zero
+};
+
+static_assert(sizeof(ModelFileHeader) == 64, "ModelFileHeader must stay one cache line");
+static_assert(sizeof(LayerRecord) == 32, "LayerRecord layout is part of the format");
+static_assert(sizeof(TensorRecord) == 32, "TensorRecord layout is part of the format");
+
+constexpr std::uint32_t MODEL_FILE_VERSION = 1;
+constexpr std::size_t MODEL_FILE_PAGE = 4096;
+
+#endif
@@ -1,11 +1,25 @@
 #ifndef OPTIMIZER_HPP
 #define OPTIMIZER_HPP
 
-#include "layer.hpp"
+#include <vector>
+#include "matrix.hpp"
 
+/// Base class for optimizers.
+///
+/// step() updates every parameter of a model at once. params and grads
+/// are the model's flat buffers (see Model::get_parameters), holding all
+/// layers' parameters and gradients back to back, so per-parameter state
+/// such as Adam's moments is a flat buffer of the same length, indexed
+/// the same way. t is the 1-based step count.
+template <typename T>
 class Optimizer {
 public:
-    virtual void step(Layer* layer, int t) = 0;
+    virtual void step(Matrix<T>& params, const Matrix<T>& grads, int t) = 0;
+
+    /// Per-parameter state buffers (e.g. Adam's m and v), saved and
+    /// restored by Model::save/load. Empty until the first step
+    virtual std::vector<Matrix<T>*> state(){ return {}; }
+
     virtual ~Optimizer() = default;
 };
 
@@ -0,0 +1,128 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Library-wide memory counters behind Profiler. aligned_malloc counts
+/// every heap allocation and Matrix its live storage, but only while a
+/// Profiler exists; otherwise each check is one relaxed load on the
+/// allocation path, which a warm training step never takes.
+namespace profiling {
+
+extern std::atomic<int> active_profilers;
+
+inline bool tracking(){ return active_profilers.load(std::memory_order_relaxed) > 0; }
+
+/// One heap allocation of `bytes` (aligned_malloc)
+void count_allocation(std::size_t bytes);
+
+/// Matrix storage allocated (positive) or released (negative)
+void count_matrix_bytes(long long delta);
+
+} // namespace profiling
+
+/// Opt-in profiler for training.
+///
+/// Attach one with Model::set_profiler and every forward and backward call
+/// of each layer becomes an event, as do the loss, the optimizer step,
+/// gradient reduction and synchronization, and whole epochs. Each event
+/// records wall time, the FLOPs and bytes the layer estimates for the call
+/// (Layer::forward_cost / backward_cost), and the heap allocations made
+/// during it. While a profiler exists, the library also tracks live Matrix
+/// storage and its peak.
+///
+/// Results come out as a per-layer summary table (print_summary) and as a
+/// Chrome trace (write_chrome_trace; open it in chrome://tracing or
+/// Perfetto) with one span per event plus a live-memory counter track.
+///
+/// A detached model only tests a null pointer per layer call. Recording
+/// is thread-safe. Memory counters are process-wide, so keep one profiler
+/// alive at a time for meaningful peaks.
+class Profiler {
+    public:
+        struct Event {
+            std::string name;
+            std::string category;     // forward, recompute, backward, loss, ...
+            int layer;                // index in the model, -1 for model-level events
+            std::uint64_t start_ns;   // since the profiler was created
+            std::uint64_t duration_ns;
+            double flops;
+            double bytes;
+            std::uint64_t allocations;
+            std::uint64_t allocated_bytes;
+            long long live_matrix_bytes;   // at the end of the event, relative to the start
+            int thread;
+        };
+
+        /// Start of an event, from begin()
+        struct Mark {
+            std::uint64_t start_ns = 0;
+            std::uint64_t allocations = 0;
+            std::uint64_t allocated_bytes = 0;
+        };
+
+        /// At most `max_events` events are kept for the trace; the summary
+        /// covers all of them
+        explicit Profiler(std::size_t max_events = std::size_t(1) << 20);
+        ~Profiler();
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        Mark begin() const;
+        void end(const Mark& mark, const std::string& name, const char* category, int layer,
+                 double flops = 0.0, double bytes = 0.0);
+
+        /// Per layer and phase: calls, total and mean time, share of the
+        /// profiled time, GFLOP/s, GB/s and allocations; then the heap and
+        /// peak Matrix memory totals
+        void print_summary(std::ostream& out) const;
+
+        /// Chrome trace event format (JSON). Throws std::runtime_error if
+        /// the file cannot be written
+        void write_chrome_trace(const std::string& path) const;
+
+        /// Drops all events and restarts the memory counters
+        void reset();
+
+        std::vector<Event> events() const;
+        std::uint64_t allocations() const;
+        std::uint64_t allocated_bytes() const;
+        long long peak_matrix_bytes() const;   // above the level at creation / reset
+
+    private:
+        struct Totals {
+            std::string name;
+            std::uint64_t calls = 0;
+            std::uint64_t ns = 0;
+            double flops = 0.0;
+            double bytes = 0.0;
+            std::uint64_t allocations = 0;
+        };
+
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point origin;
+        std::size_t max_events;
+
+        mutable std::mutex mutex;
+        std::vector<Event> recorded;
+        std::size_t dropped = 0;
+        std::map<std::pair<int, std::string>, Totals> totals;   // by (layer, category)
+
+        std::uint64_t allocation_base = 0;
+        std::uint64_t allocated_bytes_base = 0;
+        long long matrix_base = 0;
+
+        std::uint64_t now_ns() const;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef QGEMM_HPP
+#define QGEMM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/// int8 × int8 → int32 matrix multiply for quantized inference:
+///     C(i, j) = Σ_k A(i, k) · B(k, j)
+///
+/// A (M × K) is row-major int8 with its rows zero-padded to padded_k(K)
+/// bytes. B (K × N), the weights, is packed once by pack_b into 16-column
+/// panels of 4-deep k groups, the layout the VNNI `vpdpbusd` instruction
+/// consumes directly:
+///
+///     panel p, group g (64 bytes): bytes 4c .. 4c+3 = B(4g .. 4g+3, 16p + c)
+///
+/// with K and N zero-padded. Sums are exact in int32 as long as operands
+/// stay within [-127, 127] and K is at most MAX_K.
+///
+/// The kernel is picked once, from the instruction set kernels::active()
+/// runs on (so NEURONITE_ISA applies here too): AVX-512 VNNI, AVX2
+/// (sign-extend and vpmaddwd), or portable scalar code. Large products are
+/// split by column panels across the thread pool.
+namespace qgemm {
+
+/// Largest depth whose sums fit int32 on every kernel (the VNNI one
+/// accumulates A + 128, up to 255 · 127 per term)
+constexpr int MAX_K = 1 << 16;
+
+/// Row length of A, and rows of packed B: K rounded up to a multiple of 4
+int padded_k(int K);
+
+/// Columns of packed B: N rounded up to a multiple of 16
+int padded_n(int N);
+
+/// Packs row-major B (K × N, row stride ldb) into `packed`, which must hold
+/// padded_k(K) · padded_n(N) bytes, and writes the column sums of B to
+/// `col_sums` (padded_n(N) values; the VNNI kernel corrects with them)
+void pack_b(const std::int8_t* B, int ldb, int K, int N,
+            std::int8_t* packed, std::int32_t* col_sums);
+
+/// C (M × N, row stride ldc) = A · B, with B and col_sums from pack_b
+void gemm(int M, int N, int K,
+          const std::int8_t* A, int lda,
+          const std::int8_t* packed_b, const std::int32_t* col_sums,
+          std::int32_t* C, int ldc);
+
+/// Kernel in use: "vnni", "avx2" or "scalar"
+const char* kernel_name();
+
+} // namespace qgemm
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef QUANTIZED_DENSE_LAYER_HPP
+#define QUANTIZED_DENSE_LAYER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "dense_layer.hpp"
+#include "gemm.hpp"
+
+/// Int8 inference version of a trained DenseLayer or FusedDenseLayer.
+///
+/// Weights are quantized once, symmetrically and per output column:
+///     W(k, j) ≈ s_j · q(k, j),   s_j = max_k |W(k, j)| / 127,   q ∈ [-127, 127]
+/// Inputs are quantized on the fly the same way, with one scale s_x for
+/// the whole batch. The product runs as an int8 × int8 → int32 GEMM
+/// (qgemm.hpp), and one pass over the int32 result rescales, adds the
+/// bias and applies the source layer's activation:
+///     Y(i, j) = act( s_x · s_j · Σ_k q_x(i, k) · q(k, j) + b_j )
+///
+/// The weights take a quarter of their float32 size. The layer is for
+/// inference only: it has no trainable parameters, and backward_into throws.
+/// Model::quantize swaps it in for the dense layers of a trained model.
+template <typename T>
+class QuantizedDenseLayer: public Layer<T>{
+    private:
+        int input_dim;
+        int output_dim;
+        Activation activation;
+
+        // Packed int8 weights (see qgemm::pack_b) and their column sums
+        std::int8_t* packed_weights = nullptr;
+        std::vector<std::int32_t> column_sums;
+
+        // s_j per output column, and the bias in full precision
+        std::vector<T> weight_scales;
+        Matrix<T> bias;
+
+        std::pair<int,int> input_shape;
+        std::pair<int,int> output_shape;
+
+    public:
+        explicit QuantizedDenseLayer(const DenseLayer<T>& source);
+        ~QuantizedDenseLayer();
+
+        QuantizedDenseLayer(const QuantizedDenseLayer&) = delete;
+        QuantizedDenseLayer& operator=(const QuantizedDenseLayer&) = delete;
+
+        void forward_into(const Matrix<T>& input, Matrix<T>& output) override;
+        void backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input) override;
+        void infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const override;
+        void update(double /*learning_rate*/) override {}
+        std::string get_name() const override;
+        std::pair<int,int> get_input_shape() const override;
+        std::pair<int,int> get_output_shape() const override;
+        int param_count() const override;
+        std::pair<int,int> infer_output_shape(std::pair<int,int> input) const override;
+
+        /// Bytes of packed int8 weights
+        std::size_t weight_bytes() const;
+};
+
+#endif
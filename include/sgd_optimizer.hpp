@@ -0,0 +1,31 @@
+#ifndef SGD_OPTIMIZER_HPP
+#define SGD_OPTIMIZER_HPP
+
+#include "optimizer.hpp"
+
+/// Stochastic gradient descent with optional momentum, Nesterov momentum
+/// and (coupled, L2-style) weight decay:
+///     g' = g + weight_decay·θ
+///     u  = momentum·u + g'
+///     θ -= lr · (nesterov ? g' + momentum·u : u)
+/// With momentum 0 this is plain SGD. One fused SIMD pass per step,
+/// split across the thread pool for large models.
+template <typename T>
+class SGDOptimizer:public Optimizer<T>{
+    private:
+        double lr;
+        double momentum;
+        bool nesterov;
+        double weight_decay;
+
+        // Momentum buffer, laid out like the model's flat parameter buffer
+        Matrix<T> velocity;
+
+    public:
+        SGDOptimizer(double lr=0.01, double momentum=0.0, bool nesterov=false, double weight_decay=0.0);
+
+        void step(Matrix<T>& params, const Matrix<T>& grads, int t) override;
+        std::vector<Matrix<T>*> state() override;
+};
+
+#endif
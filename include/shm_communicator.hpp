@@ -0,0 +1,76 @@
+#ifndef SHM_COMMUNICATOR_HPP
+#define SHM_COMMUNICATOR_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include "communicator.hpp"
+
+/// Communicator for training processes on one host, over a POSIX shared
+/// memory segment.
+///
+/// The segment holds one staging slot per rank and two result buffers.
+/// all_reduce is a reduce-scatter followed by an all-gather: every rank
+/// copies its data into its slot, sums its own 1/size share of the
+/// elements across all slots into a result buffer, and then copies the
+/// whole result back. Each element is summed once, in rank order, so all
+/// ranks get identical bits, and every rank moves about 3n elements
+/// however many ranks there are. Data larger than a slot goes through in
+/// slot-sized pieces. Ranks synchronize with a barrier on shared atomics;
+/// a waiting rank spins briefly and then sleeps on a futex.
+///
+/// Rank 0 creates the segment under `name` (a shared memory object name
+/// like "/neuronite-job42", unique to the job) and the other ranks attach
+/// to it. All ranks must be constructed within `timeout` of each other.
+/// Once all have attached, the name is removed, so nothing is left behind
+/// when the job exits. Any collective that waits longer than `timeout` for
+/// another rank throws std::runtime_error, so a crashed peer does not
+/// hang the job. The ranks are out of step after that, so every later
+/// collective on this communicator throws as well.
+class ShmCommunicator : public Communicator {
+    public:
+        ShmCommunicator(const std::string& name, int rank, int size,
+                        std::size_t slot_bytes = std::size_t(4) << 20,
+                        std::chrono::milliseconds timeout = std::chrono::seconds(60));
+        ~ShmCommunicator() override;
+
+        ShmCommunicator(const ShmCommunicator&) = delete;
+        ShmCommunicator& operator=(const ShmCommunicator&) = delete;
+
+        int rank() const override { return my_rank; }
+        int size() const override { return world_size; }
+
+        void all_reduce(float* data, std::size_t n) override;
+        void all_reduce(double* data, std::size_t n) override;
+        void broadcast(float* data, std::size_t n, int root) override;
+        void broadcast(double* data, std::size_t n, int root) override;
+        void barrier() override;
+
+    private:
+        struct Header;
+
+        std::string name;
+        int my_rank;
+        int world_size;
+        std::size_t slot_bytes;
+        std::chrono::milliseconds timeout;
+
+        Header* header = nullptr;
+        unsigned char* base = nullptr;
+        std::size_t mapped_bytes = 0;
+        bool name_linked = false;
+        bool timed_out = false;   // a barrier gave up; see barrier()
+
+        // Result buffers alternate so a piece can be reduced while ranks
+        // still read the previous one; see all_reduce_impl
+        int next_result = 0;
+
+        unsigned char* slot(int rank) const;
+        unsigned char* result(int index) const;
+        void attach();
+
+        template <typename T> void all_reduce_impl(T* data, std::size_t n);
+        template <typename T> void broadcast_impl(T* data, std::size_t n, int root);
+};
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef SPARSE_MATRIX_HPP
+#define SPARSE_MATRIX_HPP
+
+#include <cstddef>
+#include <vector>
+#include "matrix.hpp"
+
+/// Row-major sparse matrix in CSR (compressed sparse row) form, for wide
+/// inputs that are mostly zeros. Model::train, forward and predict take
+/// one as the input of a model whose first layer is a DenseLayer.
+///
+/// The nonzeros of row i are columns()[k] and values()[k] for k in
+/// [row_offsets()[i], row_offsets()[i + 1]). Offsets are absolute
+/// positions in the column/value arrays, so a block of consecutive rows
+/// (view_rows) is just a shorter offset array over the same arrays, and
+/// row_offsets()[0] need not be 0. Columns within a row are strictly
+/// increasing.
+///
+/// Templated on the scalar type; SparseMatrix<float> and
+/// SparseMatrix<double> are instantiated in sparse_matrix.cpp.
+template <typename T>
+class SparseMatrix {
+
+    public:
+        int rows, cols;
+
+        SparseMatrix();
+
+        /// Takes the three CSR arrays: rows + 1 offsets starting at 0, and
+        /// one column index and value per nonzero. Throws
+        /// std::invalid_argument unless offsets are non-decreasing and
+        /// columns in range and strictly increasing within each row
+        SparseMatrix(int rows, int cols, std::vector<int> row_offsets,
+                     std::vector<int> columns, std::vector<T> values);
+
+        /// Deep copies; a copy of a view owns its arrays
+        SparseMatrix(const SparseMatrix& other);
+        SparseMatrix(SparseMatrix&& other) noexcept;
+        SparseMatrix& operator=(const SparseMatrix& other);
+        SparseMatrix& operator=(SparseMatrix&& other) noexcept;
+
+        /// The nonzeros of a dense matrix (entries equal to 0 are dropped)
+        static SparseMatrix from_dense(const Matrix<T>& dense);
+
+        /// Rows [row0, row0 + count) without copying: the view reads this
+        /// matrix's arrays, which must outlive it
+        SparseMatrix view_rows(int row0, int count) const;
+
+        /// out = rows rows[0..count) of src, in that order, reusing out's
+        /// arrays so shuffled mini-batches do not allocate once warm
+        static void gather_rows(const SparseMatrix& src, const int* rows, int count, SparseMatrix& out);
+
+        /// C = activation(A · B + bias), resizing C to (A.rows × B.cols);
+        /// bias is a (1 × B.cols) row, as in Matrix::dot_bias_act_into.
+        /// Each output row sums the rows of B picked by the nonzeros of A's
+        /// row, so the cost is O(nnz · B.cols) however wide A is
+        static void dot_bias_act_into(const SparseMatrix& A, const Matrix<T>& B,
+                                      const Matrix<T>& bias, Activation activation, Matrix<T>& C);
+
+        Matrix<T> to_dense() const;
+
+        std::size_t nnz() const { return rows > 0 ? static_cast<std::size_t>(offsets[rows] - offsets[0]) : 0; }
+
+        const int* row_offsets() const { return offsets; }
+        const int* columns() const { return column_data; }
+        const T* values() const { return value_data; }
+
+    private:
+        // Owned arrays; empty for a view, and for a matrix without rows
+        std::vector<int> offset_storage;
+        std::vector<int> column_storage;
+        std::vector<T> value_storage;
+
+        // What is read: the owned arrays, or another matrix's
+        const int* offsets;
+        const int* column_data;
+        const T* value_data;
+
+        void point_at_storage();
+};
+
+/// D = Aᵀ · G for a sparse A, touching only the rows of D that belong to
+/// columns (features) present in A, for the weight gradient of a layer
+/// fed sparse input: O(nnz · G.cols) per call.
+///
+/// D keeps its shape, (A.cols × G.cols). Rows written by the previous call
+/// and not by this one are cleared, so every other row stays zero as long
+/// as D starts out zero and only this object writes to it. The per-column
+/// table is sized to A.cols once; later calls reuse it and their work
+/// depends only on the nonzeros.
+template <typename T>
+class SparseRowGradient {
+    public:
+        void compute(const SparseMatrix<T>& A, const Matrix<T>& G, Matrix<T>& D);
+
+        /// Rows of D written by the last compute
+        const std::vector<int>& rows() const { return touched; }
+
+    private:
+        std::vector<int> slot;      // per column of A: index into touched, or -1
+        std::vector<int> touched;   // columns of A with a nonzero, in first-seen order
+        std::vector<int> previous;  // touched of the previous call
+        std::vector<int> begin;     // per touched column: start of its entries in entries
+        std::vector<int> fill;
+        std::vector<int> entries;   // nonzero positions of A grouped by column
+        std::vector<int> entry_row;
+};
+
+#endif
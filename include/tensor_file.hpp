@@ -0,0 +1,64 @@
+#ifndef TENSOR_FILE_HPP
+#define TENSOR_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "matrix.hpp"
+
+/// On-disk tensor format (.nnt):
+///
+///     offset 0   TensorFileHeader (64 bytes)
+///     offset 64  rows × cols elements, row-major, little-endian
+///
+/// The header is one cache line, so the payload of a mapped file starts on
+/// a 64-byte boundary and can be handed to the kernels as is.
+enum class TensorDType : std::uint32_t { Float32 = 0, Float64 = 1 };
+
+struct TensorFileHeader {
+    char magic[8];           // "NNTENSOR"
+    std::uint32_t version;   // TENSOR_FILE_VERSION
+    std::uint32_t dtype;     // TensorDType
+    std::uint64_t rows;
+    std::uint64_t cols;
+    char reserved[32];       // zero
+};
+
+static_assert(sizeof(TensorFileHeader) == 64, "TensorFileHeader must stay one cache line");
+
+constexpr std::uint32_t TENSOR_FILE_VERSION = 1;
+
+/// Writes `m` to `path` in the format above; throws std::runtime_error on
+/// I/O failure
+template <typename T>
+void write_tensor_file(const std::string& path, const Matrix<T>& m);
+
+/// Read-only, memory-mapped view of a tensor file.
+///
+/// Opening only maps the file; pages are read in by the OS on first touch,
+/// so a file of any size opens in constant time and is served from the
+/// page cache. matrix() is a non-owning view of the mapping: pass it
+/// wherever a const Matrix is expected (e.g. BatchLoader or Model::train),
+/// but do not write through it. Throws std::runtime_error if the file
+/// cannot be opened, and std::invalid_argument if it is malformed or its
+/// dtype is not T.
+template <typename T>
+class MappedTensor {
+    public:
+        explicit MappedTensor(const std::string& path);
+        ~MappedTensor();
+
+        MappedTensor(const MappedTensor&) = delete;
+        MappedTensor& operator=(const MappedTensor&) = delete;
+
+        int rows() const { return view.rows; }
+        int cols() const { return view.cols; }
+        const Matrix<T>& matrix() const { return view; }
+
+    private:
+        void* mapping = nullptr;
+        std::size_t mapped_bytes = 0;
+        Matrix<T> view;
+};
+
+#endif
\ No newline at end of file
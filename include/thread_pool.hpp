@@ -0,0 +1,98 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// Library-wide fork/join pool used by the Matrix kernels.
+///
+/// A pool of size N runs N - 1 worker threads; the thread calling
+/// parallel_for always takes part, so a pool of size 1 is fully serial.
+/// The default size is std::thread::hardware_concurrency(), overridable
+/// with the NEURONITE_NUM_THREADS environment variable or set_num_threads().
+///
+/// Work that would form a single chunk runs inline on the caller without any
+/// synchronization, as do nested calls made from inside a parallel region
+/// and calls that arrive while another thread is already using the pool.
+class ThreadPool {
+    public:
+        using RangeFn = void (*)(void* ctx, std::size_t begin, std::size_t end);
+
+        explicit ThreadPool(int num_threads);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /// The shared pool used by the library
+        static ThreadPool& instance();
+
+        /// Number of threads that take part in a parallel region (workers + caller)
+        int size() const { return static_cast<int>(workers.size()) + 1; }
+
+        /// Restarts the pool with `num_threads` participants (minimum 1).
+        /// Must not be called while a parallel region is running.
+        void resize(int num_threads);
+
+        /// Splits [0, n) into at most size() chunks of at least `grain`
+        /// elements, with interior boundaries on multiples of `align`, and
+        /// calls fn(begin, end) for each chunk. Blocks until every chunk is
+        /// done; the first exception thrown by fn is rethrown here.
+        template <typename Fn>
+        void parallel_for(std::size_t n, std::size_t grain, Fn&& fn, std::size_t align = 1){
+            using F = std::remove_reference_t<Fn>;
+            run(n, grain, align,
+                [](void* ctx, std::size_t b, std::size_t e){ (*static_cast<F*>(ctx))(b, e); },
+                const_cast<void*>(static_cast<const void*>(&fn)));
+        }
+
+        /// True on a pool worker, or on the caller while it runs a chunk
+        static bool in_parallel_region();
+
+    private:
+        std::vector<std::thread> workers;
+
+        // One job at a time; concurrent callers fall back to inline execution
+        std::mutex submit_mutex;
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        unsigned long long generation = 0;
+        bool stopping = false;
+
+        // Current job
+        RangeFn job_fn = nullptr;
+        void* job_ctx = nullptr;
+        std::size_t job_n = 0;
+        std::size_t job_chunks = 0;
+        std::size_t job_align = 1;
+        std::atomic<std::size_t> next_chunk{0};
+        std::atomic<std::size_t> done_chunks{0};
+        std::atomic<int> active_workers{0};
+        std::exception_ptr job_error;
+        std::mutex error_mutex;
+
+        void start(int num_threads);
+        void stop();
+        void worker_main();
+        void execute_chunks();
+        void run(std::size_t n, std::size_t grain, std::size_t align, RangeFn fn, void* ctx);
+};
+
+void set_num_threads(int num_threads);
+int get_num_threads();
+
+/// parallel_for on the shared pool
+template <typename Fn>
+inline void parallel_for(std::size_t n, std::size_t grain, Fn&& fn, std::size_t align = 1){
+    ThreadPool::instance().parallel_for(n, grain, std::forward<Fn>(fn), align);
+}
+
+#endif
@@ -3,10 +3,27 @@
 
 #pragma once
 
+#include <cstdint>
 #include "matrix.hpp"
 
+/// Seeds the shared generator (weights, shuffling) and the calling
+/// thread's own one (random_double, random_u64, and so Dropout masks).
+/// Other threads' generators are left alone, so Dropout in data-parallel
+/// replicas does not repeat
 void set_random_seed(unsigned int seed);
-void initialize_random(Matrix& mat, double min=-1.0, double max = 1.0);
+template <typename T>
+void initialize_random(Matrix<T>& mat, double min=-1.0, double max = 1.0);
+/// Uniform draw from a per-thread generator
 double random_double(double min = 0.0, double max = 1.0);
 
+/// Uniform 64-bit draw from the same per-thread generator
+std::uint64_t random_u64();
+
+/// Shuffles `values` in place using the generator seeded by set_random_seed
+void shuffle_indices(std::vector<int>& values);
+
+/// Draws a seed from the generator seeded by set_random_seed, for
+/// components that own a generator (e.g. BatchLoader's thread)
+unsigned int random_seed();
+
 #endif
\ No newline at end of file
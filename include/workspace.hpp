@@ -0,0 +1,74 @@
+#ifndef WORKSPACE_HPP
+#define WORKSPACE_HPP
+
+#include <cstddef>
+#include <vector>
+#include "matrix.hpp"
+
+/// Bump-pointer arena for per-step temporaries.
+///
+/// allocate() hands out 64-byte aligned slices by advancing an offset;
+/// nothing is freed individually. reset() releases every slice at once.
+/// When a step outgrows the current block, a new block is chained on so
+/// earlier slices stay valid. The next reset() then merges the blocks
+/// into a single block sized to the high-water mark. After a step or two
+/// the arena therefore settles into one block and stops touching the heap.
+///
+/// Model owns one workspace and resets it at the end of every training
+/// step. Not thread-safe; it is meant to be used from the thread that
+/// drives forward/backward.
+class Workspace {
+    public:
+        explicit Workspace(std::size_t initial_bytes = 0);
+        ~Workspace();
+
+        Workspace(const Workspace&) = delete;
+        Workspace& operator=(const Workspace&) = delete;
+
+        /// `bytes` of uninitialized, NEURONITE_ALIGNMENT-aligned scratch,
+        /// valid until the next reset()
+        void* allocate(std::size_t bytes);
+
+        /// Uninitialized (rows × cols) view into the arena, valid until the
+        /// next reset()
+        template <typename T>
+        Matrix<T> matrix(int rows, int cols){
+            std::size_t count = static_cast<std::size_t>(rows) * cols;
+            return Matrix<T>::view(static_cast<T*>(allocate(count * sizeof(T))), rows, cols);
+        }
+
+        /// Releases everything handed out since the last reset
+        void reset();
+
+        /// Ensures the arena can serve `bytes` between resets without
+        /// allocating, e.g. reserve(high_water_mark()) from an earlier run.
+        /// Takes effect immediately when nothing is handed out, otherwise
+        /// at the next reset()
+        void reserve(std::size_t bytes);
+
+        /// Bytes handed out since the last reset
+        std::size_t used() const { return used_bytes; }
+
+        /// Largest used() seen at any point
+        std::size_t high_water_mark() const { return peak_bytes; }
+
+        /// Total bytes currently held by the arena
+        std::size_t capacity() const;
+
+    private:
+        struct Block {
+            char* ptr;
+            std::size_t size;
+        };
+
+        std::vector<Block> blocks;   // slices come from blocks.back()
+        std::size_t offset = 0;      // bump offset within blocks.back()
+        std::size_t used_bytes = 0;
+        std::size_t peak_bytes = 0;
+        std::size_t reserved_bytes = 0;
+
+        void add_block(std::size_t bytes);
+        void release_blocks();
+};
+
+#endif
\ No newline at end of file
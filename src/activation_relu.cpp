@@ -1,31 +1,50 @@
 #include <algorithm>
 #include "matrix.hpp"
 #include "activation_relu.hpp"
+#include "kernels.hpp"
 
 /// Forward pass of ReLU activation
 /// ReLU(x) = max(0, x)
 ///
 /// For each element x in input:
 ///   y = max(0, x)
-/// Also store a binary mask (1 if x > 0, 0 otherwise) for use in backprop
-Matrix ActivationReLU::forward(const Matrix& input){
-    Matrix output = Matrix(input.rows, input.cols);
-    mask = Matrix(input.rows, input.cols);
-
+/// Also store a binary mask (1 if x > 0, 0 otherwise) for use in backprop;
+/// the mask buffer is reused while the input shape stays the same
+template <typename T>
+void ActivationReLU<T>::forward_into(const Matrix<T>& input, Matrix<T>& output){
+    output.resize(input.rows, input.cols);
     input_shape = {input.rows, input.cols};
 
-    for(int i=0;i<input.rows;++i){
-        for(int j=0;j<input.cols;++j){
-            output.data[i][j] = std::max(0.0, input.data[i][j]);
-            if(input.data[i][j] > 0){
-                mask.data[i][j] = 1;
-            }else{
-                mask.data[i][j] = 0;
-            }
-        }
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    if (precision != Precision::Full){
+        // 0 and 1 are exact in both formats, so the mask is written
+        // directly in 16 bits
+        mask_half.resize(input.rows, input.cols);
+        mask_half.precision = precision;
+        const std::uint16_t one = half_one;
+        kernels::for_each_span(input.is_contiguous(), input.rows, input.cols, [&](int i, std::size_t n){
+            const T* x = input.row(i);
+            std::uint16_t* m = mask_half.row(i);
+            for (std::size_t j = 0; j < n; ++j) m[j] = x[j] > 0 ? one : 0;
+            k.relu(x, output.row(i), n);
+        });
+        return;
     }
 
-    return output;
+    mask.resize(input.rows, input.cols);
+    kernels::for_each_span(input.is_contiguous(), input.rows, input.cols, [&](int i, std::size_t n){
+        k.relu_forward(input.row(i), output.row(i), mask.row(i), n);
+    });
+}
+
+/// Inference pass of ReLU: y = max(0, x) without building the mask
+template <typename T>
+void ActivationReLU<T>::infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& /*ws*/) const{
+    output.resize(input.rows, input.cols);
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(input.is_contiguous(), input.rows, input.cols, [&](int i, std::size_t n){
+        k.relu(input.row(i), output.row(i), n);
+    });
 }
 
 /// Backward pass of ReLU
@@ -38,34 +57,75 @@ Matrix ActivationReLU::forward(const Matrix& input){
 ///   dL/dx = dL/dy if x > 0, else 0
 ///
 /// Uses the `mask` from forward pass.
-Matrix ActivationReLU::backward(const Matrix& grad_output){
-    Matrix grad_input = Matrix(grad_output.rows, grad_output.cols);
-    for(int i=0;i<grad_output.rows;++i){
-        for(int j=0;j<grad_output.cols;++j){
-            grad_input.data[i][j] = grad_output.data[i][j] * mask.data[i][j];
-        }
+template <typename T>
+void ActivationReLU<T>::backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input){
+    grad_input.resize(grad_output.rows, grad_output.cols);
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    if (precision != Precision::Full){
+        kernels::for_each_span(grad_output.is_contiguous(), grad_output.rows, grad_output.cols, [&](int i, std::size_t n){
+            const T* g = grad_output.row(i);
+            T* out = grad_input.row(i);
+            for_each_widened<T>(precision, mask_half.row(i), n, [&](std::size_t at, const T* m, std::size_t count){
+                k.relu_backward(g + at, m, out + at, count);
+            });
+        });
+        return;
     }
-    return grad_input;
+    kernels::for_each_span(grad_output.is_contiguous(), grad_output.rows, grad_output.cols, [&](int i, std::size_t n){
+        k.relu_backward(grad_output.row(i), mask.row(i), grad_input.row(i), n);
+    });
 }
 
 /// No-op for ReLU — it has no learnable parameters
-void ActivationReLU::update(double learning_rate){
+template <typename T>
+void ActivationReLU<T>::update(double /*learning_rate*/){
     return;
 }
 
 
-std::string ActivationReLU:: get_name() const {
+template <typename T>
+std::string ActivationReLU<T>:: get_name() const {
     return "ReLU";
 }
 
-std::pair<int,int> ActivationReLU::get_input_shape() const {
+template <typename T>
+std::pair<int,int> ActivationReLU<T>::get_input_shape() const {
     return input_shape;
 }
 
-std::pair<int,int> ActivationReLU::get_output_shape() const {
+template <typename T>
+std::pair<int,int> ActivationReLU<T>::get_output_shape() const {
     return input_shape;
 }
 
-int ActivationReLU::param_count() const{
+template <typename T>
+int ActivationReLU<T>::param_count() const{
     return 0;
-}
\ No newline at end of file
+}
+
+template <typename T>
+LayerSpec ActivationReLU<T>::spec() const{
+    LayerSpec s;
+    s.kind = LayerKind::ReLU;
+    return s;
+}
+
+template <typename T>
+std::vector<BatchCache<T>> ActivationReLU<T>::caches(std::pair<int,int> input){
+    if (precision != Precision::Full) return {{nullptr, input.first, input.second, &mask_half}};
+    return {{&mask, input.first, input.second}};
+}
+
+template <typename T>
+void ActivationReLU<T>::set_precision(Precision precision){
+    this->precision = precision;
+    if (precision == Precision::Full){
+        mask_half = HalfMatrix();
+        return;
+    }
+    mask = Matrix<T>();
+    half_one = precision == Precision::BFloat16 ? half::to_bfloat16(1.0f) : half::to_float16(1.0f);
+}
+
+template class ActivationReLU<float>;
+template class ActivationReLU<double>;
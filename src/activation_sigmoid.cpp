@@ -1,12 +1,14 @@
 #include <algorithm>
 #include "matrix.hpp"
 #include "activation_sigmoid.hpp"
+#include "kernels.hpp"
 #include <cmath>
 
 /// Static sigmoid function
 /// σ(x) = 1 / (1 + e^(-x))
-double ActivationSigmoid::sigmoid(double x){
-    return 1.0 / (1.0 + std::exp(-x));
+template <typename T>
+T ActivationSigmoid<T>::sigmoid(T x){
+    return T(1) / (T(1) + std::exp(-x));
 }
 
 /// Forward pass for sigmoid activation
@@ -15,20 +17,30 @@ double ActivationSigmoid::sigmoid(double x){
 ///
 /// Also stores the output σ(x) in `output_cache`
 /// for use in the backward pass.
-Matrix ActivationSigmoid::forward(const Matrix& input){
-    Matrix output = Matrix(input.rows, input.cols);
+template <typename T>
+void ActivationSigmoid<T>::forward_into(const Matrix<T>& input, Matrix<T>& output){
+    output.resize(input.rows, input.cols);
 
     input_shape = {input.rows, input.cols};
 
-    for(int i=0;i<input.rows;++i){
-        for(int j=0;j<input.cols;++j){
-            output.data[i][j] = ActivationSigmoid::sigmoid(input.data[i][j]);
-        }
-    }
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(input.is_contiguous(), input.rows, input.cols, [&](int i, std::size_t n){
+        k.sigmoid_forward(input.row(i), output.row(i), n);
+    });
 
-    output_cache = output;
+    // Copy-assignment reuses output_cache's buffer
+    if (precision == Precision::Full) output_cache = output;
+    else output_half.assign(output, precision);
+}
 
-    return output;
+/// Inference pass for sigmoid: y = σ(x) without filling `output_cache`
+template <typename T>
+void ActivationSigmoid<T>::infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& /*ws*/) const{
+    output.resize(input.rows, input.cols);
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(input.is_contiguous(), input.rows, input.cols, [&](int i, std::size_t n){
+        k.sigmoid_forward(input.row(i), output.row(i), n);
+    });
 }
 
 /// Backward pass for sigmoid
@@ -37,36 +49,85 @@ Matrix ActivationSigmoid::forward(const Matrix& input){
 ///
 /// This uses the derivative of the sigmoid function:
 ///     dσ/dx = σ(x) * (1 - σ(x))
-Matrix ActivationSigmoid::backward(const Matrix& grad_output){
-    Matrix grad_input = Matrix(grad_output.rows, output_cache.cols);
-
-    for(int i=0;i<grad_input.rows;++i){
-        for(int j=0;j<grad_input.cols;++j){
-            grad_input.data[i][j] = grad_output.data[i][j] * output_cache.data[i][j] * (1.0 - output_cache.data[i][j]);
-        }
+template <typename T>
+void ActivationSigmoid<T>::backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input){
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    if (precision != Precision::Full){
+        grad_input.resize(grad_output.rows, output_half.cols);
+        kernels::for_each_span(grad_output.is_contiguous(), grad_input.rows, grad_input.cols, [&](int i, std::size_t n){
+            const T* g = grad_output.row(i);
+            T* out = grad_input.row(i);
+            for_each_widened<T>(precision, output_half.row(i), n, [&](std::size_t at, const T* s, std::size_t count){
+                k.sigmoid_backward(g + at, s, out + at, count);
+            });
+        });
+        return;
     }
 
-    return grad_input;
+    grad_input.resize(grad_output.rows, output_cache.cols);
+    kernels::for_each_span(grad_output.is_contiguous(), grad_input.rows, grad_input.cols, [&](int i, std::size_t n){
+        k.sigmoid_backward(grad_output.row(i), output_cache.row(i), grad_input.row(i), n);
+    });
 }
 
 /// No-op update — sigmoid has no learnable parameters
-void ActivationSigmoid::update(double learning_rate){
+template <typename T>
+void ActivationSigmoid<T>::update(double /*learning_rate*/){
     return;
 }
 
 
-std::string ActivationSigmoid:: get_name() const {
+template <typename T>
+std::string ActivationSigmoid<T>:: get_name() const {
     return "Sigmoid";
 }
 
-std::pair<int,int> ActivationSigmoid::get_input_shape() const {
+template <typename T>
+std::pair<int,int> ActivationSigmoid<T>::get_input_shape() const {
     return input_shape;
 }
 
-std::pair<int,int> ActivationSigmoid::get_output_shape() const {
+template <typename T>
+std::pair<int,int> ActivationSigmoid<T>::get_output_shape() const {
     return input_shape;
 }
 
-int ActivationSigmoid::param_count() const{
+template <typename T>
+int ActivationSigmoid<T>::param_count() const{
     return 0;
-}
\ No newline at end of file
+}
+
+template <typename T>
+LayerSpec ActivationSigmoid<T>::spec() const{
+    LayerSpec s;
+    s.kind = LayerKind::Sigmoid;
+    return s;
+}
+
+template <typename T>
+std::vector<BatchCache<T>> ActivationSigmoid<T>::caches(std::pair<int,int> input){
+    if (precision != Precision::Full) return {{nullptr, input.first, input.second, &output_half}};
+    return {{&output_cache, input.first, input.second}};
+}
+
+template <typename T>
+void ActivationSigmoid<T>::set_precision(Precision precision){
+    this->precision = precision;
+    if (precision == Precision::Full) output_half = HalfMatrix();
+    else output_cache = Matrix<T>();
+}
+
+// About four flops per element forward (negate, exp, add, divide) and
+// three backward, s·(1 − s)·g
+template <typename T>
+LayerCost ActivationSigmoid<T>::forward_cost(const Matrix<T>& input, const Matrix<T>& output) const {
+    return {4.0 * output.size(), double(input.size() + output.size()) * sizeof(T)};
+}
+
+template <typename T>
+LayerCost ActivationSigmoid<T>::backward_cost(const Matrix<T>& grad_output, const Matrix<T>& grad_input) const {
+    return {3.0 * grad_input.size(), double(grad_output.size() + 2 * grad_input.size()) * sizeof(T)};
+}
+
+template class ActivationSigmoid<float>;
+template class ActivationSigmoid<double>;
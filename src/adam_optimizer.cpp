@@ -1,74 +1,66 @@
 #include "adam_optimizer.hpp"
-#include "dense_layer.hpp"
+#include "kernels.hpp"
 #include <cmath>
+#include <stdexcept>
 
-AdamOptimizer::AdamOptimizer(double lr, double beta1, double beta2, double epsilon)
+template <typename T>
+AdamOptimizer<T>::AdamOptimizer(double lr, double beta1, double beta2, double epsilon)
     : lr(lr), beta1(beta1), beta2(beta2), epsilon(epsilon) {}
 
-/// Performs one step of the Adam optimization algorithm on a single layer
-/// 
-/// Uses the layer's stored gradients (d_weights and d_bias) to compute updates.
-/// Maintains per-layer first and second moment estimates for weights and bias.
+/// Performs one step of the Adam optimization algorithm on every parameter
+/// of the model
+///
+/// params and grads are the model's flat buffers, so the whole model is one
+/// fused kernel sweep with no per-layer lookups. The moment buffers are
+/// sized on the first step (and reset if the parameter count changes).
 ///
 /// Parameters:
-/// - layer: pointer to the Layer (must be DenseLayer)
+/// - params: all trainable values, updated in place
+/// - grads: matching gradients from the last backward pass
 /// - t: current timestep (starting from 1), used for bias correction
-void AdamOptimizer::step(Layer* layer, int t) {
-
-    // Only apply Adam to Dense layers (skip ReLU/Sigmoid etc.)
-    auto* dense = dynamic_cast<DenseLayer*>(layer);
-    if (!dense) return;
-
-    Matrix dw = dense->get_d_weights();
-    Matrix db = dense->get_d_bias();
-
-    // Initialize moment vectors if this is the first time seeing this layer
-    if (m_weights.count(layer) == 0) {
-        m_weights[layer] = Matrix(dw.rows, dw.cols);
-        v_weights[layer] = Matrix(dw.rows, dw.cols);
-        m_bias[layer] = Matrix(db.rows, db.cols);
-        v_bias[layer] = Matrix(db.rows, db.cols);
+template <typename T>
+void AdamOptimizer<T>::step(Matrix<T>& params, const Matrix<T>& grads, int t) {
+    if (params.rows != grads.rows || params.cols != grads.cols){
+        throw std::invalid_argument("AdamOptimizer::step: Parameter and gradient shapes differ");
     }
 
-    // Aliases for convenience
-    auto& mw = m_weights[layer]; // First moment (mean) for weights
-    auto& vw = v_weights[layer]; // Second moment (variance) for weights
-    auto& mb = m_bias[layer];    // First moment (mean) for bias
-    auto& vb = v_bias[layer];    // Second moment (variance) for bias
-
-    // Get current weights and biases to update them
-    Matrix updated_weights = dense->get_weights();
-    Matrix updated_bias = dense->get_bias();
-
-    // ==== Update Weights ====
-    for (int i = 0; i < dw.rows; ++i) {
-        for (int j = 0; j < dw.cols; ++j) {
-            // m ← β1·m + (1−β1)·∇θ
-            mw.data[i][j] = beta1 * mw.data[i][j] + (1 - beta1) * dw.data[i][j];
-
-            // v ← β2·v + (1−β2)·(∇θ)^2
-            vw.data[i][j] = beta2 * vw.data[i][j] + (1 - beta2) * std::pow(dw.data[i][j], 2);
-
-            // Bias-corrected moment estimates
-            double m_hat = mw.data[i][j] / (1 - std::pow(beta1, t));
-            double v_hat = vw.data[i][j] / (1 - std::pow(beta2, t));
-
-            // θ ← θ − α·m̂ / (√v̂ + ε)
-            updated_weights.data[i][j] -= lr * m_hat / (std::sqrt(v_hat) + epsilon);
-        }
+    // Initialize moment vectors on the first step
+    if (m.rows != params.rows || m.cols != params.cols) {
+        m = Matrix<T>(params.rows, params.cols);
+        v = Matrix<T>(params.rows, params.cols);
     }
 
-    for (int j = 0; j < db.cols; ++j) {
-        mb.data[0][j] = beta1 * mb.data[0][j] + (1 - beta1) * db.data[0][j];
-        vb.data[0][j] = beta2 * vb.data[0][j] + (1 - beta2) * std::pow(db.data[0][j], 2);
-
-        double m_hat = mb.data[0][j] / (1 - std::pow(beta1, t));
-        double v_hat = vb.data[0][j] / (1 - std::pow(beta2, t));
-
-        updated_bias.data[0][j] -= lr * m_hat / (std::sqrt(v_hat) + epsilon);
-    }
+    // Bias corrections depend only on t; fold them into the step size
+    // and the scale on √v once per step
+    double correction1 = 1 - std::pow(beta1, t);
+    double correction2 = 1 - std::pow(beta2, t);
+
+    kernels::AdamStep<T> s;
+    s.beta1 = static_cast<T>(beta1);
+    s.one_minus_beta1 = static_cast<T>(1 - beta1);
+    s.beta2 = static_cast<T>(beta2);
+    s.one_minus_beta2 = static_cast<T>(1 - beta2);
+    s.step_size = static_cast<T>(lr / correction1);
+    s.inv_sqrt_correction2 = static_cast<T>(1 / std::sqrt(correction2));
+    s.epsilon = static_cast<T>(epsilon);
+    s.decay = static_cast<T>(1 - lr * weight_decay);
+
+    T* theta = params.data();
+    const T* g = grads.data();
+    T* mp = m.data();
+    T* vp = v.data();
+
+    // m, v and θ in one pass, split across the pool for large models
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    parallel_for(params.size(), kernels::PARALLEL_GRAIN, [&](std::size_t i0, std::size_t i1){
+        k.adam_update(theta + i0, g + i0, mp + i0, vp + i0, s, i1 - i0);
+    }, NEURONITE_ALIGNMENT / sizeof(T));
+}
 
-    // Apply updated parameters to the layer
-    dense->apply_adam_update(updated_weights, updated_bias);
+template <typename T>
+std::vector<Matrix<T>*> AdamOptimizer<T>::state(){
+    return {&m, &v};
 }
 
+template class AdamOptimizer<float>;
+template class AdamOptimizer<double>;
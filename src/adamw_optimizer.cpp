@@ -0,0 +1,11 @@
+#include "adamw_optimizer.hpp"
+
+template <typename T>
+AdamWOptimizer<T>::AdamWOptimizer(double lr, double weight_decay,
+                                  double beta1, double beta2, double epsilon)
+    : AdamOptimizer<T>(lr, beta1, beta2, epsilon) {
+    this->weight_decay = weight_decay;
+}
+
+template class AdamWOptimizer<float>;
+template class AdamWOptimizer<double>;
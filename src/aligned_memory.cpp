@@ -0,0 +1,18 @@
+#include "aligned_memory.hpp"
+#include "profiler.hpp"
+#include <cstdlib>
+#include <new>
+
+void* aligned_malloc(std::size_t bytes){
+    if (bytes == 0) return nullptr;
+    // std::aligned_alloc requires the size to be a multiple of the alignment
+    bytes = (bytes + NEURONITE_ALIGNMENT - 1) / NEURONITE_ALIGNMENT * NEURONITE_ALIGNMENT;
+    void* p = std::aligned_alloc(NEURONITE_ALIGNMENT, bytes);
+    if (!p) throw std::bad_alloc();
+    if (profiling::tracking()) profiling::count_allocation(bytes);
+    return p;
+}
+
+void aligned_free(void* ptr){
+    std::free(ptr);
+}
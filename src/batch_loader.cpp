@@ -0,0 +1,129 @@
+#include "batch_loader.hpp"
+#include "utils_random.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+template <typename T>
+BatchLoader<T>::BatchLoader(const Matrix<T>& input,
+                            const Matrix<T>& target,
+                            int batch_size,
+                            bool shuffle,
+                            LastBatch last_batch,
+                            int depth)
+    : input(input), target(target), shuffle(shuffle) {
+
+    if (input.rows != target.rows){
+        throw std::invalid_argument("BatchLoader: Input and target row counts differ");
+    }
+    if (depth < 2){
+        throw std::invalid_argument("BatchLoader: depth must be at least 2");
+    }
+
+    int num_rows = input.rows;
+    if (batch_size <= 0 || batch_size > num_rows) batch_size = num_rows;
+    rows_per_batch = batch_size;
+
+    // A single batch covering the dataset needs no permutation
+    this->shuffle = shuffle && batch_size < num_rows;
+
+    num_batches = batch_size > 0 ? num_rows / batch_size : 0;
+    if (batch_size > 0 && num_rows % batch_size != 0 && last_batch == LastBatch::Keep) ++num_batches;
+    if (num_batches == 0){
+        throw std::invalid_argument("BatchLoader: No complete batch to load");
+    }
+
+    order.resize(num_rows);
+    for (int i = 0; i < num_rows; ++i) order[i] = i;
+
+    // Seeded here, on the caller's thread, so set_random_seed makes the
+    // batch order reproducible
+    rng.seed(random_seed());
+
+    slots.resize(depth);
+    for (Batch& slot : slots){
+        slot.input.resize(batch_size, input.cols);
+        slot.target.resize(batch_size, target.cols);
+    }
+
+    worker = std::thread(&BatchLoader::run, this);
+}
+
+template <typename T>
+BatchLoader<T>::~BatchLoader(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    slot_free.notify_all();
+    worker.join();
+}
+
+template <typename T>
+const typename BatchLoader<T>::Batch& BatchLoader<T>::next(){
+    std::unique_lock<std::mutex> lock(mutex);
+    if (holding){
+        // The previous batch is done with; its slot can be refilled
+        ++consumed;
+        holding = false;
+        slot_free.notify_one();
+    }
+    slot_ready.wait(lock, [this]{ return produced > consumed || error; });
+    if (produced == consumed && error){
+        std::rethrow_exception(error);
+    }
+    holding = true;
+    return slots[consumed % slots.size()];
+}
+
+template <typename T>
+void BatchLoader<T>::run(){
+    try {
+        for (std::size_t n = 0; ; ++n){
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                // Every slot is either held by the consumer or filled ahead
+                slot_free.wait(lock, [&]{ return stopping || n - consumed < slots.size(); });
+                if (stopping) return;
+            }
+
+            int batch = static_cast<int>(n % num_batches);
+            if (batch == 0 && shuffle){
+                std::shuffle(order.begin(), order.end(), rng);
+            }
+
+            // Filled outside the lock: the consumer never touches this slot
+            // until `produced` moves past it
+            fill(slots[n % slots.size()], batch);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                produced = n + 1;
+            }
+            slot_ready.notify_one();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        error = std::current_exception();
+        slot_ready.notify_one();
+    }
+}
+
+template <typename T>
+void BatchLoader<T>::fill(Batch& slot, int batch){
+    int row0 = batch * rows_per_batch;
+    int rows = std::min(rows_per_batch, input.rows - row0);
+
+    // resize() keeps the capacity reserved in the constructor
+    slot.input.resize(rows, input.cols);
+    slot.target.resize(rows, target.cols);
+
+    const int* idx = order.data() + row0;
+    for (int k = 0; k < rows; ++k){
+        std::memcpy(slot.input.row(k), input.row(idx[k]), input.cols * sizeof(T));
+        std::memcpy(slot.target.row(k), target.row(idx[k]), target.cols * sizeof(T));
+    }
+}
+
+template class BatchLoader<float>;
+template class BatchLoader<double>;
@@ -1,156 +1,289 @@
 #include "batch_norm.hpp"
 #include "matrix.hpp"
+#include "kernels.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
 #include <cmath>
+#include <stdexcept>
 
-BatchNorm:: BatchNorm(int input_dim, int output_dim)
+template <typename T>
+BatchNorm<T>:: BatchNorm(int input_dim, int output_dim)
     : input_shape({input_dim, output_dim}){
-        gamma = Matrix(1, output_dim, 1.0);
-        beta = Matrix(1, output_dim, 0.0);
+        gamma = Matrix<T>(1, output_dim, 1.0);
+        beta = Matrix<T>(1, output_dim, 0.0);
 
-        d_gamma = Matrix(1, output_dim, 0.0);
-        d_beta = Matrix(1, output_dim, 0.0);
+        d_gamma = Matrix<T>(1, output_dim, 0.0);
+        d_beta = Matrix<T>(1, output_dim, 0.0);
 
-        x_hat = Matrix(input_dim, output_dim);
+        x_hat = Matrix<T>(input_dim, output_dim);
+
+        running_mean = Matrix<T>(1, output_dim, 0.0);
+        running_variance = Matrix<T>(1, output_dim, 1.0);
 
     }
 
-Matrix BatchNorm::forward(const Matrix& input) {
-    input_cache = input;  // cache input for backward use
+template <typename T>
+void BatchNorm<T>::forward_into(const Matrix<T>& input, Matrix<T>& output) {
+    normalize_into(input, output, true);
+}
+
+/// Same batch statistics and output, but the running statistics already
+/// saw this batch
+template <typename T>
+void BatchNorm<T>::recompute_into(const Matrix<T>& input, Matrix<T>& output) {
+    normalize_into(input, output, false);
+}
 
+template <typename T>
+void BatchNorm<T>::normalize_into(const Matrix<T>& input, Matrix<T>& output, bool track_statistics) {
     int m = input.rows;   // batch size
     int n = input.cols;   // number of features
 
+    // Temporaries below come from the step arena
+    Workspace& ws = this->begin_scratch();
+
     // Step 1: Compute mean for each feature (column-wise)
     // μ_j = (1/m) ∑_i x_ij
-    mean = BatchNorm::compute_mean(input);  // shape: (1 × n)
+    compute_mean(input, mean);  // shape: (1 × n)
 
     // Step 2: Center the input by subtracting the mean
     // x_centered_ij = x_ij - μ_j
-    Matrix centered(m, n);
-    for (int i = 0; i < m; ++i)
-        for (int j = 0; j < n; ++j)
-            centered.data[i][j] = input.data[i][j] - mean.data[0][j];
+    Matrix<T> centered = ws.matrix<T>(m, n);
+    Matrix<T>::sub_into(input, mean, centered);  // row broadcast
 
     // Step 3: Compute variance for each feature (on centered data)
     // σ²_j = (1/m) ∑_i (x_ij - μ_j)^2
-    variance = BatchNorm::compute_variance(centered);  // shape: (1 × n)
+    compute_variance(centered, variance);  // shape: (1 × n)
+
+    // Track the statistics for inference:
+    // running ← (1 - momentum)·running + momentum·batch
+    for (int j = 0; track_statistics && j < n; ++j) {
+        running_mean(0, j) = (1 - momentum) * running_mean(0, j) + momentum * mean(0, j);
+        running_variance(0, j) = (1 - momentum) * running_variance(0, j) + momentum * variance(0, j);
+    }
 
     // Step 4: Compute standard deviation with epsilon for numerical stability
     // σ_j = sqrt(σ²_j + ε)
-    Matrix standard_deviation(1, n);
-    for (int j = 0; j < n; ++j)
-        standard_deviation.data[0][j] = std::sqrt(variance.data[0][j] + epsilon);
-
-    standard_deviation_cache = standard_deviation;  // cache for backward()
+    // (kept in standard_deviation_cache for backward())
+    standard_deviation_cache.resize(1, n);
+    Matrix<T> inv_standard_deviation = ws.matrix<T>(1, n);
+    for (int j = 0; j < n; ++j) {
+        standard_deviation_cache(0, j) = std::sqrt(variance(0, j) + epsilon);
+        inv_standard_deviation(0, j) = 1.0 / standard_deviation_cache(0, j);
+    }
 
     // Step 5: Normalize the input
     // x̂_ij = (x_ij - μ_j) / σ_j
-    for (int i = 0; i < m; ++i)
-        for (int j = 0; j < n; ++j)
-            x_hat.data[i][j] = centered.data[i][j] / standard_deviation.data[0][j];
+    Matrix<T>::mul_into(centered, inv_standard_deviation, x_hat);  // row broadcast
 
     // Step 6: Scale and shift
     // y_ij = γ_j * x̂_ij + β_j
-    Matrix output(m, n);
-    for (int i = 0; i < m; ++i)
-        for (int j = 0; j < n; ++j)
-            output.data[i][j] = gamma.data[0][j] * x_hat.data[i][j] + beta.data[0][j];
+    output.resize(m, n);
+    kernels::active<T>().affine_row(x_hat.data(), x_hat.stride, gamma.data(), beta.data(),
+                                    output.data(), output.stride, m, n);
+}
+
+/// Inference pass: normalizes with the running statistics, folded into one
+/// affine map per feature
+///     y_ij = x_ij · s_j + (β_j - μ_j · s_j),  s_j = γ_j / sqrt(σ²_j + ε)
+template <typename T>
+void BatchNorm<T>::infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const {
+    int m = input.rows;
+    int n = input.cols;
+    if (n != gamma.cols) {
+        throw std::invalid_argument("BatchNorm::infer: Feature count mismatch");
+    }
 
-    return output;
+    Matrix<T> scale = ws.matrix<T>(1, n);
+    Matrix<T> shift = ws.matrix<T>(1, n);
+    for (int j = 0; j < n; ++j) {
+        scale(0, j) = gamma(0, j) / std::sqrt(running_variance(0, j) + epsilon);
+        shift(0, j) = beta(0, j) - running_mean(0, j) * scale(0, j);
+    }
+
+    output.resize(m, n);
+    kernels::active<T>().affine_row(input.data(), input.stride, scale.data(), shift.data(),
+                                    output.data(), output.stride, m, n);
+}
+
+template <typename T>
+Matrix<T> BatchNorm<T>::compute_mean(const Matrix<T>&input) {
+    Matrix<T> mean;
+    compute_mean(input, mean);
+    return mean;
 }
 
-Matrix BatchNorm::compute_mean(const Matrix&input) {
-    Matrix mean = input.col_sum();
+template <typename T>
+void BatchNorm<T>::compute_mean(const Matrix<T>&input, Matrix<T>& mean) {
+    input.col_sum_into(mean);
     for(int j=0;j<mean.cols;++j){
-        mean.data[0][j] /= input.rows;
+        mean(0, j) /= input.rows;
     }
-    return mean;
 }
 
-Matrix BatchNorm::compute_variance(const Matrix&input) {
-    Matrix variance = Matrix(1, input.cols);
+template <typename T>
+Matrix<T> BatchNorm<T>::compute_variance(const Matrix<T>&input) {
+    Matrix<T> variance;
+    compute_variance(input, variance);
+    return variance;
+}
+
+template <typename T>
+void BatchNorm<T>::compute_variance(const Matrix<T>&input, Matrix<T>& variance) {
+    variance.resize(1, input.cols);
+    variance.fill(0);
 
-    for(int i=0;i<input.rows;++i){
-        for(int j=0;j<input.cols;++j){
-            variance.data[0][j] += input.data[i][j]*input.data[i][j];
+    T* var = variance.row(0);
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+
+    // Column ranges are independent, so threads split the features
+    std::size_t col_grain = std::max<std::size_t>(64, kernels::PARALLEL_GRAIN / std::max(input.rows, 1));
+    parallel_for(static_cast<std::size_t>(input.cols), col_grain, [&](std::size_t j0, std::size_t j1){
+        for(int i=0;i<input.rows;++i){
+            const T* x = input.row(i) + j0;
+            k.mul_add(x, x, var + j0, j1 - j0);
         }
-    }
+    }, 8);
 
     for(int j=0;j<variance.cols;++j){
-        variance.data[0][j] /= input.rows;
+        var[j] /= input.rows;
     }
-
-    return variance;
 }
 
-Matrix BatchNorm::backward(const Matrix& grad_out) {
+template <typename T>
+void BatchNorm<T>::backward_into(const Matrix<T>& grad_out, Matrix<T>& grad_input) {
     int m = grad_out.rows;
     int n = grad_out.cols;
 
+    Workspace& ws = this->begin_scratch();
+
     // dy * gamma — element-wise scaling
     // ∂L/∂y * γ : broadcast γ across batch
-    Matrix dy_gamma(m, n);
-    for (int i = 0; i < m; ++i)
-        for (int j = 0; j < n; ++j)
-            dy_gamma.data[i][j] = grad_out.data[i][j] * gamma.data[0][j];
+    Matrix<T> dy_gamma = ws.matrix<T>(m, n);
+    Matrix<T>::mul_into(grad_out, gamma, dy_gamma);
 
     // ∑(dy * gamma) — sum over the batch (along rows)
-    Matrix sum_dy_gamma = dy_gamma.col_sum(); // shape (1 x n)
+    Matrix<T> sum_dy_gamma = ws.matrix<T>(1, n);
+    dy_gamma.col_sum_into(sum_dy_gamma); // shape (1 x n)
 
     // (dy * gamma) * x̂ — element-wise product
     // Used in ∑(∂L/∂y * γ * x̂) term
-    Matrix dy_gamma_xhat(m, n);
-    for (int i = 0; i < m; ++i)
-        for (int j = 0; j < n; ++j)
-            dy_gamma_xhat.data[i][j] = dy_gamma.data[i][j] * x_hat.data[i][j];
+    Matrix<T> dy_gamma_xhat = ws.matrix<T>(m, n);
+    Matrix<T>::mul_into(dy_gamma, x_hat, dy_gamma_xhat);
 
     // ∑((dy * gamma) * x_hat)
-    Matrix sum_dy_gamma_xhat = dy_gamma_xhat.col_sum(); // shape (1 x n)
+    Matrix<T> sum_dy_gamma_xhat = ws.matrix<T>(1, n);
+    dy_gamma_xhat.col_sum_into(sum_dy_gamma_xhat); // shape (1 x n)
 
     // Final gradient input calculation using canonical batchnorm derivative
     // ∂L/∂x = (1 / mσ) * [ m·(dy·γ) - ∑(dy·γ) - x̂·∑((dy·γ)·x̂) ]
-    Matrix grad_input(m, n);
-    for (int i = 0; i < m; ++i) {
-        for (int j = 0; j < n; ++j) {
-            double sigma = standard_deviation_cache.data[0][j]; // σ = sqrt(var + ε)
-            double term1 = dy_gamma.data[i][j] * m;             // m·(dy·γ)
-            double term2 = sum_dy_gamma.data[0][j];             // ∑(dy·γ)
-            double term3 = x_hat.data[i][j] * sum_dy_gamma_xhat.data[0][j]; // x̂·∑((dy·γ)·x̂)
-            grad_input.data[i][j] = (1.0 / (m * sigma)) * (term1 - term2 - term3);
-        }
-    }
+    //   term1 = m·(dy·γ), term2 = ∑(dy·γ), term3 = x̂·∑((dy·γ)·x̂)
+    Matrix<T> inv_m_sigma = ws.matrix<T>(1, n);  // 1 / (mσ), σ = sqrt(var + ε)
+    for (int j = 0; j < n; ++j)
+        inv_m_sigma(0, j) = 1.0 / (m * standard_deviation_cache(0, j));
 
-    // ∂L/∂γ = ∑(∂L/∂y · x̂)
-    d_gamma = (grad_out * x_hat).col_sum();
+    grad_input.resize(m, n);
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(false, m, n, [&](int i, std::size_t cols) {
+        k.batchnorm_input_grad(dy_gamma.row(i), x_hat.row(i),
+                               sum_dy_gamma.data(), sum_dy_gamma_xhat.data(),
+                               inv_m_sigma.data(), m, grad_input.row(i), cols);
+    });
 
-    // ∂L/∂β = ∑(∂L/∂y)
-    d_beta = grad_out.col_sum();
+    // ∂L/∂γ = ∑(∂L/∂y · x̂); dy_gamma_xhat is no longer needed, so its
+    // buffer holds the product
+    Matrix<T>::mul_into(grad_out, x_hat, dy_gamma_xhat);
+    dy_gamma_xhat.col_sum_into(d_gamma);
 
-    return grad_input;
+    // ∂L/∂β = ∑(∂L/∂y)
+    grad_out.col_sum_into(d_beta);
 }
 
-void BatchNorm::update(double learning_rate){
+template <typename T>
+void BatchNorm<T>::update(double learning_rate){
     // Gradient descent update:
     // γ ← γ - η * ∂L/∂γ
     // β ← β - η * ∂L/∂β
     for (int j = 0; j < gamma.cols; ++j) {
-        gamma.data[0][j] -= learning_rate * d_gamma.data[0][j];
-        beta.data[0][j]  -= learning_rate * d_beta.data[0][j];
+        gamma(0, j) -= learning_rate * d_gamma(0, j);
+        beta(0, j)  -= learning_rate * d_beta(0, j);
     }
 }
 
-std::string BatchNorm::get_name() const{
+template <typename T>
+std::string BatchNorm<T>::get_name() const{
     return "BatchNormalization";
 }
 
-std::pair<int,int> BatchNorm::get_input_shape() const {
+template <typename T>
+std::pair<int,int> BatchNorm<T>::get_input_shape() const {
     return input_shape;
 }
 
-std::pair<int,int> BatchNorm::get_output_shape() const {
+template <typename T>
+std::pair<int,int> BatchNorm<T>::get_output_shape() const {
     return input_shape;
 }
 
-int BatchNorm::param_count() const{
+template <typename T>
+int BatchNorm<T>::param_count() const{
     return gamma.rows * gamma.cols + beta.rows * beta.cols;
 }
+
+template <typename T>
+std::vector<Parameter<T>> BatchNorm<T>::parameters(){
+    return {{&gamma, &d_gamma}, {&beta, &d_beta}};
+}
+
+template <typename T>
+std::vector<Matrix<T>*> BatchNorm<T>::state(){
+    return {&running_mean, &running_variance};
+}
+
+template <typename T>
+LayerSpec BatchNorm<T>::spec() const{
+    LayerSpec s;
+    s.kind = LayerKind::BatchNorm;
+    s.input_dim = input_shape.first;
+    s.output_dim = gamma.cols;
+    return s;
+}
+
+template <typename T>
+std::pair<int,int> BatchNorm<T>::infer_output_shape(std::pair<int,int> input) const{
+    if (input.second != gamma.cols){
+        throw std::invalid_argument("BatchNorm: Expected " + std::to_string(gamma.cols) +
+                                    " input columns, got " + std::to_string(input.second));
+    }
+    return input;
+}
+
+template <typename T>
+std::vector<BatchCache<T>> BatchNorm<T>::caches(std::pair<int,int> input){
+    return {{&x_hat, input.first, input.second}};
+}
+
+// Statistics and x_hat stay in T under every precision: the
+// normalization is sensitive to rounding and its parameters are few
+template <typename T>
+bool BatchNorm<T>::supports_precision(Precision /*precision*/) const{
+    return true;
+}
+
+// Forward: mean, variance, normalize, scale and shift, about eight flops
+// per element, writing the output and x_hat. Backward: about twelve,
+// reading the gradient and x_hat. Plus the per-column vectors
+template <typename T>
+LayerCost BatchNorm<T>::forward_cost(const Matrix<T>& input, const Matrix<T>& output) const {
+    double n = output.size();
+    return {8 * n, (double(input.size()) + 2 * n + 4.0 * gamma.cols) * sizeof(T)};
+}
+
+template <typename T>
+LayerCost BatchNorm<T>::backward_cost(const Matrix<T>& grad_output, const Matrix<T>& grad_input) const {
+    double n = grad_input.size();
+    return {12 * n, (double(grad_output.size()) + 2 * n + 4.0 * gamma.cols) * sizeof(T)};
+}
+
+template class BatchNorm<float>;
+template class BatchNorm<double>;
@@ -2,6 +2,7 @@
 #include "dense_layer.hpp"
 #include "utils_random.hpp"
 #include <cmath>
+#include <stdexcept>
 
 // DenseLayer constructor
 // Initializes weights and biases, and allocates memory for gradients
@@ -9,36 +10,136 @@
 // bias shape:   (1 × output_dim)
 // d_weights:    (input_dim × output_dim)
 // d_bias:       (1 × output_dim)
-DenseLayer:: DenseLayer(int input_dim, int output_dim)
-    : weights(input_dim, output_dim),
-        bias(1, output_dim),
-        d_weights(input_dim, output_dim),
-        d_bias(1, output_dim){
+template <typename T>
+DenseLayer<T>:: DenseLayer(int input_dim, int output_dim)
+    : d_weights(input_dim, output_dim),
+        d_bias(1, output_dim),
+        weights(input_dim, output_dim),
+        bias(1, output_dim){
     
     double limit = std::sqrt(6.0 / (input_dim + output_dim));
     initialize_random(weights, -1*limit, 1*limit);
 }
 
+// Deferred constructor: shapes only, no storage (see DeferInit)
+template <typename T>
+DenseLayer<T>:: DenseLayer(int input_dim, int output_dim, DeferInit){
+    weights.rebind(nullptr, input_dim, output_dim);
+    bias.rebind(nullptr, 1, output_dim);
+    d_weights.rebind(nullptr, input_dim, output_dim);
+    d_bias.rebind(nullptr, 1, output_dim);
+}
+
 // Forward pass of the dense layer
 // input shape:  (batch_size × input_dim)
 // output shape: (batch_size × output_dim)
 // Computes: Z = X · W + b
-Matrix DenseLayer:: forward(const Matrix& input){
-    // Cache input for use in backward pass
-    input_cache = input;
+//
+// With a 16-bit precision, W is read from weights_half and X is rounded
+// into input_half for backward; the products still accumulate in T.
+template <typename T>
+void DenseLayer<T>:: forward_into(const Matrix<T>& input, Matrix<T>& output){
     input_shape = {input.rows, input.cols};
 
-    // Matrix multiplication: (batch_size × input_dim) · (input_dim × output_dim)
-    Matrix output = Matrix::dot(input, weights);
+    sparse_cache = nullptr;
+    if (precision == Precision::Full){
+        // Keep a reference to the input for the backward pass instead of a copy
+        input_cache = &input;
 
-    // Broadcast and add bias: bias is (1 × output_dim)
-    output = output + bias;
+        // Matrix multiplication: (batch_size × input_dim) · (input_dim × output_dim)
+        // with the bias row (1 × output_dim) broadcast-added in the GEMM epilogue
+        Matrix<T>::dot_bias_act_into(input, Transpose::No, weights, Transpose::No,
+                                     bias, Activation::None, output);
+    }else{
+        // Only marks that forward ran: backward reads input_half
+        input_cache = &input;
+        input_half.assign(input, precision);
+        product_into(input, output, Activation::None);
+    }
 
     output_shape = {output.rows, output.cols};
+}
 
+// The allocating forward keeps a copy of the input for backward, as the
+// caller's matrix may be a temporary
+template <typename T>
+Matrix<T> DenseLayer<T>:: forward(const Matrix<T>& input){
+    forward_input = input;
+    Matrix<T> output;
+    forward_into(forward_input, output);
     return output;
 }
 
+// Inference pass: Z = X · W + b without caching the input
+template <typename T>
+void DenseLayer<T>:: infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& /*ws*/) const{
+    product_into(input, output, Activation::None);
+}
+
+// act(X · W + b) with the bias and activation in the GEMM epilogue; in
+// 16-bit mode W is widened from weights_half as it is packed
+template <typename T>
+void DenseLayer<T>:: product_into(const Matrix<T>& input, Matrix<T>& output, Activation activation) const{
+    if (precision == Precision::Full){
+        Matrix<T>::dot_bias_act_into(input, Transpose::No, weights, Transpose::No,
+                                     bias, activation, output);
+        return;
+    }
+    if (input.cols != weights_half.rows){
+        throw std::invalid_argument("Dot: Incompatible dimensions");
+    }
+    output.resize(input.rows, weights_half.cols);
+    GemmEpilogue<T> epilogue;
+    epilogue.bias = bias.data();
+    epilogue.activation = activation;
+    gemm(Transpose::No, Transpose::No, input.rows, weights_half.cols, input.cols,
+         T(1), GemmOperand<T>(input.data(), input.stride),
+         GemmOperand<T>(weights_half.data(), weights_half.cols, precision),
+         T(0), output.data(), output.stride, epilogue);
+}
+
+// Forward pass on a sparse input: Z = X · W + b as a sum of the rows of W
+// picked by each row's nonzeros, O(nnz · output_dim) however wide X is.
+// The product reads the T weights even under a 16-bit precision: it only
+// touches nnz rows of W, so the 16-bit copy would save little, and X is
+// kept by reference rather than rounded.
+template <typename T>
+void DenseLayer<T>:: forward_sparse_into(const SparseMatrix<T>& input, Matrix<T>& output){
+    sparse_forward(input, output, Activation::None);
+}
+
+template <typename T>
+void DenseLayer<T>:: sparse_forward(const SparseMatrix<T>& input, Matrix<T>& output, Activation activation){
+    input_shape = {input.rows, input.cols};
+    input_cache = nullptr;
+    sparse_cache = &input;
+    SparseMatrix<T>::dot_bias_act_into(input, weights, bias, activation, output);
+    output_shape = {output.rows, output.cols};
+}
+
+template <typename T>
+void DenseLayer<T>:: infer_sparse_into(const SparseMatrix<T>& input, Matrix<T>& output, Workspace& /*ws*/) const{
+    SparseMatrix<T>::dot_bias_act_into(input, weights, bias, Activation::None, output);
+}
+
+// Backward pass after forward_sparse_into
+// d_weights = Xᵗ · ∂L/∂Z, written only in the rows of features that occur
+// in the batch; every other row is zero, as X is zero in that column
+// d_bias    = sum_rows(∂L/∂Z)
+// No ∂L/∂X: a sparse input is the model input.
+template <typename T>
+void DenseLayer<T>:: backward_sparse_into(const Matrix<T>& grad_output){
+    if (!sparse_cache){
+        throw std::invalid_argument("DenseLayer::backward: forward must be called first.");
+    }
+    if (dense_gradient_written){
+        d_weights.fill(T(0));
+        dense_gradient_written = false;
+    }
+    sparse_gradient.compute(*sparse_cache, grad_output, d_weights);
+    grad_output.col_sum_into(d_bias);
+}
+
 // Backward pass of the dense layer
 // grad_output = ∂L/∂Z (gradient of loss w.r.t. layer output)
 // grad_output shape: (batch_size × output_dim)
@@ -48,66 +149,220 @@ Matrix DenseLayer:: forward(const Matrix& input){
 // d_weights = Xᵗ · ∂L/∂Z       (input_dim × output_dim)
 // d_bias    = sum_rows(∂L/∂Z)  (1 × output_dim)
 // grad_input = ∂L/∂Z · Wᵗ      (batch_size × input_dim)
-Matrix DenseLayer:: backward(const Matrix& grad_output){
-    // ∂L/∂W = inputᵗ · grad_output
-    d_weights = Matrix::dot(input_cache.transpose(),grad_output);
+//
+// Neither transpose is materialized: the GEMM reads Xᵗ and Wᵗ in place.
+template <typename T>
+void DenseLayer<T>:: backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input){
+    if (!input_cache){
+        throw std::invalid_argument("DenseLayer::backward: forward must be called first.");
+    }
+    dense_gradient_written = true;
+
+    if (precision != Precision::Full){
+        // Both products take ∂L/∂Z rounded to 16 bits alongside the saved
+        // X and the rounded W. This is where fp16 needs loss scaling: small
+        // gradients would otherwise flush to zero (see Model::set_precision)
+        int rows = grad_output.rows, out = grad_output.cols, in = weights_half.rows;
+        Workspace& ws = this->begin_scratch();
+        HalfMatrix grad_half;
+        grad_half.rebind(static_cast<std::uint16_t*>(ws.allocate(grad_output.size() * sizeof(std::uint16_t))),
+                         rows, out);
+        grad_half.assign(grad_output, precision);
+
+        gemm(Transpose::Yes, Transpose::No, in, out, rows,
+             T(1), GemmOperand<T>(input_half.data(), in, precision),
+             GemmOperand<T>(grad_half.data(), out, precision),
+             T(0), d_weights.data(), d_weights.stride);
+        grad_output.col_sum_into(d_bias);
+        grad_input.resize(rows, in);
+        gemm(Transpose::No, Transpose::Yes, rows, in, out,
+             T(1), GemmOperand<T>(grad_half.data(), out, precision),
+             GemmOperand<T>(weights_half.data(), out, precision),
+             T(0), grad_input.data(), grad_input.stride);
+        return;
+    }
+
+    // ∂L/∂W = inputᵗ · grad_output, written straight into d_weights
+    Matrix<T>::dot_accumulate(*input_cache, Transpose::Yes, grad_output, Transpose::No,
+                              d_weights, T(1), T(0));
 
     // ∂L/∂b = row-wise sum of grad_output
-    d_bias = grad_output.col_sum();
+    grad_output.col_sum_into(d_bias);
 
     // ∂L/∂X = grad_output · weightsᵗ
-    Matrix grad_input = Matrix::dot(grad_output, weights.transpose());
-
-    return grad_input;
+    Matrix<T>::dot_into(grad_output, Transpose::No, weights, Transpose::Yes, grad_input);
 }
 
 // Update step: performs SGD on weights and bias
 // W := W - η ∂L/∂W
 // b := b - η ∂L/∂b
-void DenseLayer:: update(double learning_rate){
-    // apply gradient updates
-    Matrix scaled_weights = d_weights*learning_rate;
-    Matrix scaled_bias = d_bias*learning_rate;
-
-    weights = weights - scaled_weights;
-    bias = bias - scaled_bias;
+template <typename T>
+void DenseLayer<T>:: update(double learning_rate){
+    // apply gradient updates in place
+    weights.axpy(static_cast<T>(-learning_rate), d_weights);
+    bias.axpy(static_cast<T>(-learning_rate), d_bias);
+    if (precision != Precision::Full) weights_half.assign(weights, precision);
 }
 
-Matrix DenseLayer:: get_weights() const{
+template <typename T>
+const Matrix<T>& DenseLayer<T>:: get_weights() const{
     return weights;
 }
 
-Matrix DenseLayer:: get_bias() const{
+template <typename T>
+const Matrix<T>& DenseLayer<T>:: get_bias() const{
     return bias;
 }
 
-Matrix DenseLayer:: get_d_weights() const{
+template <typename T>
+const Matrix<T>& DenseLayer<T>:: get_d_weights() const{
     return d_weights;
 }
 
-Matrix DenseLayer:: get_d_bias() const{
+template <typename T>
+const Matrix<T>& DenseLayer<T>:: get_d_bias() const{
     return d_bias;
 }
 
-std::string DenseLayer:: get_name() const {
+template <typename T>
+std::string DenseLayer<T>:: get_name() const {
     return "Dense("+std::to_string(weights.rows)+" -> "+std::to_string(weights.cols)+")";
 }
 
-std::pair<int,int> DenseLayer::get_input_shape() const {
+template <typename T>
+std::pair<int,int> DenseLayer<T>::get_input_shape() const {
     return input_shape;
 }
 
-std::pair<int,int> DenseLayer::get_output_shape() const {
+template <typename T>
+std::pair<int,int> DenseLayer<T>::get_output_shape() const {
     return output_shape;
 }
 
-int DenseLayer::param_count() const{
-    int input_dim = input_shape.second;
-    int output_dim = output_shape.second;
-    return input_dim*output_dim + output_dim;
+template <typename T>
+int DenseLayer<T>::param_count() const{
+    return weights.rows * weights.cols + weights.cols;
 }
 
-void DenseLayer::apply_adam_update(const Matrix& new_weights, const Matrix& new_bias) {
+template <typename T>
+void DenseLayer<T>::apply_adam_update(const Matrix<T>& new_weights, const Matrix<T>& new_bias) {
     weights = new_weights;
     bias = new_bias;
-}
\ No newline at end of file
+    if (precision != Precision::Full) weights_half.assign(weights, precision);
+}
+
+template <typename T>
+std::vector<Parameter<T>> DenseLayer<T>::parameters(){
+    HalfMatrix* half = precision == Precision::Full ? nullptr : &weights_half;
+    return {{&weights, &d_weights, half}, {&bias, &d_bias}};
+}
+
+template <typename T>
+std::vector<BatchCache<T>> DenseLayer<T>::caches(std::pair<int,int> input){
+    if (precision == Precision::Full) return {};
+    return {{nullptr, input.first, input.second, &input_half}};
+}
+
+// Backward reads X itself only at full precision, and never Z
+template <typename T>
+bool DenseLayer<T>::backward_reads_input() const{
+    return precision == Precision::Full;
+}
+
+template <typename T>
+bool DenseLayer<T>::backward_reads_output() const{
+    return false;
+}
+
+// Every precision: 16-bit mode rounds W and the saved X
+template <typename T>
+bool DenseLayer<T>::supports_precision(Precision /*precision*/) const{
+    return true;
+}
+
+// Weights without storage yet (DeferInit) are encoded by whoever binds
+// them, through parameters()
+template <typename T>
+void DenseLayer<T>::set_precision(Precision precision){
+    this->precision = precision;
+    input_cache = nullptr;
+    sparse_cache = nullptr;
+    if (precision == Precision::Full){
+        weights_half = HalfMatrix();
+        input_half = HalfMatrix();
+        return;
+    }
+    weights_half.precision = precision;
+    if (weights.data()) weights_half.assign(weights, precision);
+}
+
+template <typename T>
+LayerSpec DenseLayer<T>::spec() const{
+    LayerSpec s;
+    s.kind = LayerKind::Dense;
+    s.input_dim = weights.rows;
+    s.output_dim = weights.cols;
+    return s;
+}
+
+template <typename T>
+std::pair<int,int> DenseLayer<T>::infer_output_shape(std::pair<int,int> input) const{
+    if (input.second != weights.rows){
+        throw std::invalid_argument("DenseLayer: Expected " + std::to_string(weights.rows) +
+                                    " input columns, got " + std::to_string(input.second));
+    }
+    return {input.first, weights.cols};
+}
+
+// Y = XW + b: a (B × I)·(I × O) product plus the bias
+template <typename T>
+LayerCost DenseLayer<T>::forward_cost(const Matrix<T>& input, const Matrix<T>& output) const {
+    double b = input.rows, in = weights.rows, out = weights.cols;
+    if (precision != Precision::Full){
+        // W is read in 16 bits, and X written once more in 16 bits
+        return {2 * b * in * out + b * out,
+                (b * in + out + output.size()) * sizeof(T) + (in * out + b * in) * 2.0};
+    }
+    return {2 * b * in * out + b * out,
+            (b * in + in * out + out + output.size()) * sizeof(T)};
+}
+
+// dW = Xᵀ·dY and dX = dY·Wᵀ, two products of the forward size, plus the
+// bias gradient; reads X, dY and W, writes dW, db and dX
+template <typename T>
+LayerCost DenseLayer<T>::backward_cost(const Matrix<T>& grad_output, const Matrix<T>& grad_input) const {
+    double b = grad_output.rows, in = weights.rows, out = weights.cols;
+    if (precision != Precision::Full){
+        // X, W and the rounded dY are read in 16 bits; dY is read once in
+        // T to round it and sum it
+        return {4 * b * in * out + b * out,
+                (grad_output.size() + in * out + out + grad_input.size()) * sizeof(T) +
+                (b * in + in * out + 2.0 * grad_output.size()) * 2.0};
+    }
+    return {4 * b * in * out + b * out,
+            (b * in + grad_output.size() + 2 * in * out + out + grad_input.size()) * sizeof(T)};
+}
+
+// Y = XW + b on a sparse X: one row of W per nonzero, plus the bias; reads
+// X's nonzeros (values and column indices) and those rows of W
+template <typename T>
+LayerCost DenseLayer<T>::forward_sparse_cost(const SparseMatrix<T>& input, const Matrix<T>& output) const {
+    double nnz = static_cast<double>(input.nnz()), b = input.rows, out = weights.cols;
+    return {2 * nnz * out + b * out,
+            nnz * (sizeof(T) + sizeof(int)) + (nnz * out + out + output.size()) * sizeof(T)};
+}
+
+// dW = Xᵀ·dY on the rows of the features present, plus the bias gradient;
+// reads X's nonzeros and one row of dY per nonzero, writes the touched
+// rows of dW
+template <typename T>
+LayerCost DenseLayer<T>::backward_sparse_cost(const Matrix<T>& grad_output) const {
+    double nnz = sparse_cache ? static_cast<double>(sparse_cache->nnz()) : 0.0;
+    double touched = static_cast<double>(sparse_gradient.rows().size()), out = weights.cols;
+    return {2 * nnz * out + grad_output.size(),
+            nnz * (sizeof(T) + sizeof(int)) +
+            (nnz * out + touched * out + grad_output.size() + out) * sizeof(T)};
+}
+
+template class DenseLayer<float>;
+template class DenseLayer<double>;
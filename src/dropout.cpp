@@ -1,52 +1,124 @@
 #include "dropout.hpp"
 #include "utils_random.hpp"
+#include "kernels.hpp"
 #include <random>
 
-Dropout::Dropout(double p) : drop_probability(p), is_training(true) {}
+namespace {
 
-void Dropout::set_training(bool training) {
+// Uniform [0, 1) value of element `index` of the mask drawn with `seed`:
+// the splitmix64 finalizer of a Weyl sequence, top 53 bits
+inline double mask_uniform(std::uint64_t seed, std::uint64_t index) {
+    std::uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return static_cast<double>(z >> 11) * 0x1.0p-53;
+}
+
+} // namespace
+
+template <typename T>
+Dropout<T>::Dropout(double p) : drop_probability(p), is_training(true) {}
+
+template <typename T>
+void Dropout<T>::set_training(bool training) {
     is_training = training;
 }
 
-Matrix Dropout::forward(const Matrix& input) {
+template <typename T>
+void Dropout<T>::forward_into(const Matrix<T>& input, Matrix<T>& output) {
     input_shape = {input.rows, input.cols};
-    Matrix output = input;
 
     if (is_training) {
-        mask = Matrix(input.rows, input.cols);
-        for (int i = 0; i < input.rows; ++i)
-            for (int j = 0; j < input.cols; ++j) {
-                mask.data[i][j] = (random_double(0.0, 1.0) > drop_probability) ? 1.0 : 0.0;
-                output.data[i][j] *= mask.data[i][j];
-            }
-    } else {
-        // Scale output by (1 - p) at inference
-        for (int i = 0; i < input.rows; ++i)
-            for (int j = 0; j < input.cols; ++j)
-                output.data[i][j] *= (1.0 - drop_probability);
+        // A fresh mask; applying it is the same as recomputing
+        mask_seed = random_u64();
+        recompute_into(input, output);
+        return;
     }
 
-    return output;
+    // Scale output by (1 - p) at inference
+    output.resize(input.rows, input.cols);
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(input.is_contiguous(), input.rows, input.cols, [&](int i, std::size_t n) {
+        k.scale(input.row(i), 1.0 - drop_probability, output.row(i), n);
+    });
 }
 
-Matrix Dropout::backward(const Matrix& grad_output) {
-    Matrix grad_input = grad_output;
-    if (is_training) {
-        for (int i = 0; i < grad_output.rows; ++i)
-            for (int j = 0; j < grad_output.cols; ++j)
-                grad_input.data[i][j] *= mask.data[i][j];  // apply same dropout mask
+/// Keeps element i with probability 1 - p. The draw is a hash of
+/// (mask_seed, i) rather than a generator stream, so the same seed always
+/// rebuilds the same mask
+template <typename T>
+void Dropout<T>::build_mask(int rows, int cols) {
+    mask.resize(rows, cols);
+    T* m = mask.data();
+    for (std::size_t i = 0; i < mask.size(); ++i)
+        m[i] = (mask_uniform(mask_seed, i) > drop_probability) ? T(1) : T(0);
+}
+
+/// Applies the mask of mask_seed: the one the last forward call drew
+template <typename T>
+void Dropout<T>::recompute_into(const Matrix<T>& input, Matrix<T>& output) {
+    if (!is_training) {
+        forward_into(input, output);
+        return;
+    }
+    output.resize(input.rows, input.cols);
+    build_mask(input.rows, input.cols);
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(input.is_contiguous(), input.rows, input.cols, [&](int i, std::size_t n) {
+        k.mul(input.row(i), mask.row(i), output.row(i), n);
+    });
+}
+
+/// Inference never drops: the output is the input scaled by (1 - p), as in
+/// forward with training off, regardless of the training flag
+template <typename T>
+void Dropout<T>::infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& /*ws*/) const {
+    output.resize(input.rows, input.cols);
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(input.is_contiguous(), input.rows, input.cols, [&](int i, std::size_t n) {
+        k.scale(input.row(i), 1.0 - drop_probability, output.row(i), n);
+    });
+}
+
+template <typename T>
+void Dropout<T>::backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input) {
+    if (!is_training) {
+        grad_input = grad_output;
+        return;
     }
-    return grad_input;
+
+    // apply same dropout mask
+    Matrix<T>::mul_into(grad_output, mask, grad_input);
 }
 
-std::string Dropout::get_name() const {
+template <typename T>
+std::string Dropout<T>::get_name() const {
     return "Dropout";
 }
 
-std::pair<int, int> Dropout::get_input_shape() const {
+template <typename T>
+std::pair<int, int> Dropout<T>::get_input_shape() const {
     return input_shape;
 }
 
-std::pair<int, int> Dropout::get_output_shape() const {
+template <typename T>
+std::pair<int, int> Dropout<T>::get_output_shape() const {
     return input_shape;
 }
+
+template <typename T>
+LayerSpec Dropout<T>::spec() const {
+    LayerSpec s;
+    s.kind = LayerKind::Dropout;
+    s.value = drop_probability;
+    return s;
+}
+
+template <typename T>
+std::vector<BatchCache<T>> Dropout<T>::caches(std::pair<int, int> input) {
+    return {{&mask, input.first, input.second}};
+}
+
+template class Dropout<float>;
+template class Dropout<double>;
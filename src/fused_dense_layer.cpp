@@ -0,0 +1,174 @@
+#include "fused_dense_layer.hpp"
+#include "kernels.hpp"
+#include <stdexcept>
+
+template <typename T>
+FusedDenseLayer<T>::FusedDenseLayer(int input_dim, int output_dim, Activation activation)
+    : DenseLayer<T>(input_dim, output_dim), activation(activation) {}
+
+template <typename T>
+FusedDenseLayer<T>::FusedDenseLayer(int input_dim, int output_dim, Activation activation, DeferInit)
+    : DenseLayer<T>(input_dim, output_dim, DeferInit{}), activation(activation) {}
+
+// Forward pass
+// Computes: Y = act(X · W + b)
+// The bias add and the activation run in the GEMM epilogue, so Y is
+// written once instead of three times. With a 16-bit precision X is
+// rounded into input_half for backward, as in DenseLayer.
+template <typename T>
+void FusedDenseLayer<T>::forward_into(const Matrix<T>& input, Matrix<T>& output){
+    this->input_cache = &input;
+    this->sparse_cache = nullptr;
+    this->input_shape = {input.rows, input.cols};
+
+    if (this->precision != Precision::Full) this->input_half.assign(input, this->precision);
+    this->product_into(input, output, activation);
+
+    this->output_shape = {output.rows, output.cols};
+
+    // Y is needed for the activation derivative; keep a reference, not a copy
+    output_cache = &output;
+}
+
+// Inference pass: Y = act(X · W + b), nothing kept for backward
+template <typename T>
+void FusedDenseLayer<T>::infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& /*ws*/) const{
+    this->product_into(input, output, activation);
+}
+
+// Backward pass
+// ∂L/∂Z = ∂L/∂Y ⊙ act'(Z), where act' is read off Y:
+//     ReLU:    1 where Y > 0, else 0
+//     Sigmoid: Y ⊙ (1 - Y)
+// ∂L/∂Z lives in the workspace, and the dense gradients are then computed
+// from it exactly as in DenseLayer.
+template <typename T>
+void FusedDenseLayer<T>::backward_into(const Matrix<T>& grad_output, Matrix<T>& grad_input){
+    if (!this->input_cache || !output_cache){
+        throw std::invalid_argument("FusedDenseLayer::backward: forward must be called first.");
+    }
+    DenseLayer<T>::backward_into(activation_gradient(grad_output), grad_input);
+}
+
+template <typename T>
+Matrix<T> FusedDenseLayer<T>::activation_gradient(const Matrix<T>& grad_output){
+    const Matrix<T>& output = *output_cache;
+    if (grad_output.rows != output.rows || grad_output.cols != output.cols){
+        throw std::invalid_argument("FusedDenseLayer::backward: Gradient shape does not match the last output.");
+    }
+    if (activation == Activation::None){
+        return Matrix<T>::view(const_cast<T*>(grad_output.data()), grad_output.rows, grad_output.cols, grad_output.stride);
+    }
+
+    Workspace& ws = this->begin_scratch();
+    Matrix<T> grad_z = ws.matrix<T>(grad_output.rows, grad_output.cols);
+
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    bool packed = grad_output.is_contiguous() && output.is_contiguous();
+    kernels::for_each_span(packed, grad_z.rows, grad_z.cols, [&](int i, std::size_t n){
+        if (activation == Activation::ReLU){
+            k.relu_backward_output(grad_output.row(i), output.row(i), grad_z.row(i), n);
+        }else{
+            k.sigmoid_backward(grad_output.row(i), output.row(i), grad_z.row(i), n);
+        }
+    });
+    return grad_z;
+}
+
+// Sparse input: the activation is applied to each output row as it is
+// summed, and backward differentiates it as above before the row-sparse
+// weight gradient
+template <typename T>
+void FusedDenseLayer<T>::forward_sparse_into(const SparseMatrix<T>& input, Matrix<T>& output){
+    this->sparse_forward(input, output, activation);
+    output_cache = &output;
+}
+
+template <typename T>
+void FusedDenseLayer<T>::infer_sparse_into(const SparseMatrix<T>& input, Matrix<T>& output, Workspace& /*ws*/) const{
+    SparseMatrix<T>::dot_bias_act_into(input, this->weights, this->bias, activation, output);
+}
+
+template <typename T>
+void FusedDenseLayer<T>::backward_sparse_into(const Matrix<T>& grad_output){
+    if (!this->sparse_cache || !output_cache){
+        throw std::invalid_argument("FusedDenseLayer::backward: forward must be called first.");
+    }
+    DenseLayer<T>::backward_sparse_into(activation_gradient(grad_output));
+}
+
+// The activation derivative is read off Y (not needed without one)
+template <typename T>
+bool FusedDenseLayer<T>::backward_reads_output() const{
+    return activation != Activation::None;
+}
+
+template <typename T>
+Matrix<T> FusedDenseLayer<T>::forward(const Matrix<T>& input){
+    // Keep the input and output in members so backward can still read
+    // them after the caller's copies go away
+    this->forward_input = input;
+    forward_into(this->forward_input, forward_output);
+    return forward_output;
+}
+
+template <typename T>
+std::string FusedDenseLayer<T>::get_name() const {
+    std::string act = (activation == Activation::ReLU) ? "+ReLU"
+                    : (activation == Activation::Sigmoid) ? "+Sigmoid" : "";
+    return "Dense" + act + "(" + std::to_string(this->weights.rows) + " -> " + std::to_string(this->weights.cols) + ")";
+}
+
+template <typename T>
+LayerSpec FusedDenseLayer<T>::spec() const {
+    LayerSpec s = DenseLayer<T>::spec();
+    s.kind = LayerKind::FusedDense;
+    s.activation = static_cast<std::uint32_t>(activation);
+    return s;
+}
+
+// The fused activation adds a pass over the output (a few flops each for
+// the sigmoid) and backward reads the cached output once more
+template <typename T>
+LayerCost FusedDenseLayer<T>::forward_cost(const Matrix<T>& input, const Matrix<T>& output) const {
+    LayerCost c = DenseLayer<T>::forward_cost(input, output);
+    double per_element = activation == Activation::Sigmoid ? 4 : activation == Activation::ReLU ? 1 : 0;
+    c.flops += per_element * output.size();
+    return c;
+}
+
+template <typename T>
+LayerCost FusedDenseLayer<T>::backward_cost(const Matrix<T>& grad_output, const Matrix<T>& grad_input) const {
+    LayerCost c = DenseLayer<T>::backward_cost(grad_output, grad_input);
+    if (activation != Activation::None){
+        c.flops += (activation == Activation::Sigmoid ? 3.0 : 1.0) * grad_output.size();
+        c.bytes += double(grad_output.size()) * sizeof(T);
+    }
+    return c;
+}
+
+template <typename T>
+LayerCost FusedDenseLayer<T>::forward_sparse_cost(const SparseMatrix<T>& input, const Matrix<T>& output) const {
+    LayerCost c = DenseLayer<T>::forward_sparse_cost(input, output);
+    double per_element = activation == Activation::Sigmoid ? 4 : activation == Activation::ReLU ? 1 : 0;
+    c.flops += per_element * output.size();
+    return c;
+}
+
+template <typename T>
+LayerCost FusedDenseLayer<T>::backward_sparse_cost(const Matrix<T>& grad_output) const {
+    LayerCost c = DenseLayer<T>::backward_sparse_cost(grad_output);
+    if (activation != Activation::None){
+        c.flops += (activation == Activation::Sigmoid ? 3.0 : 1.0) * grad_output.size();
+        c.bytes += double(grad_output.size()) * sizeof(T);
+    }
+    return c;
+}
+
+template <typename T>
+Activation FusedDenseLayer<T>::get_activation() const {
+    return activation;
+}
+
+template class FusedDenseLayer<float>;
+template class FusedDenseLayer<double>;
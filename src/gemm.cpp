@@ -0,0 +1,456 @@
+#include "gemm.hpp"
+#include "aligned_memory.hpp"
+#include "kernels.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+
+// Blocked GEMM in the Goto/BLIS style.
+//
+// The K dimension is split into KC-deep slabs and N into NC-wide column
+// blocks. For each (KC × NC) block of op(B) we pack it once into NR-wide
+// column panels sized to stay in L2/L3, then walk MC-tall row blocks of
+// op(A), packed into MR-tall row panels sized for L1/L2. The micro-kernel
+// multiplies one MR-panel by one NR-panel into an MR × NR register tile.
+//
+// Packing is where transposes are resolved, so NN, TN and NT all run the
+// same micro-kernel on unit-stride data. It is also where bf16/fp16
+// operands (GemmOperand) are widened, so the rest of the engine only ever
+// sees T.
+
+namespace {
+
+// Register tile and cache blocking per scalar type. A float tile holds
+// twice as many lanes per register, so NR doubles and KC grows to keep the
+// packed panels the same size in bytes.
+template <typename T> struct Blocking;
+
+template <> struct Blocking<double> {
+    static constexpr int MR = 4;
+    static constexpr int NR = 8;
+    static constexpr int KC = 256;
+    static constexpr int MC = 128;   // multiple of MR
+    static constexpr int NC = 2048;  // multiple of NR
+};
+
+template <> struct Blocking<float> {
+    static constexpr int MR = 4;
+    static constexpr int NR = 16;
+    static constexpr int KC = 512;
+    static constexpr int MC = 128;
+    static constexpr int NC = 2048;
+};
+
+// Grow-only, 64-byte aligned scratch buffer reused across calls so that
+// steady-state GEMMs do not touch the heap.
+template <typename T>
+struct PackBuffer {
+    T* ptr = nullptr;
+    std::size_t capacity = 0;
+
+    T* reserve(std::size_t count){
+        if (count > capacity){
+            aligned_free(ptr);
+            ptr = nullptr;
+            capacity = 0;
+            ptr = static_cast<T*>(aligned_malloc(count * sizeof(T)));
+            capacity = count;
+        }
+        return ptr;
+    }
+
+    ~PackBuffer(){ aligned_free(ptr); }
+};
+
+inline int round_up(int x, int multiple){
+    return (x + multiple - 1) / multiple * multiple;
+}
+
+// Function-local rather than thread_local variable templates: GCC does
+// not run the destructors of the latter when a thread exits, so every
+// pool thread stopped by set_num_threads would leak its panels
+template <typename T>
+PackBuffer<T>& packed_a(){
+    thread_local PackBuffer<T> buffer;
+    return buffer;
+}
+template <typename T>
+PackBuffer<T>& packed_b(){
+    thread_local PackBuffer<T> buffer;
+    return buffer;
+}
+
+/// Packs rows [i0, i0+mc) and columns [p0, p0+kc) of op(A) into MR-tall panels.
+/// Panel layout: for each k, the MR values of that column are contiguous.
+/// Rows past the edge are zero-padded so the micro-kernel never branches.
+template <typename T>
+void pack_a(Transpose trans, const T* A, int lda,
+            int i0, int mc, int p0, int kc, T* dst){
+    constexpr int MR = Blocking<T>::MR;
+    for (int ir = 0; ir < mc; ir += MR){
+        int mr = std::min(MR, mc - ir);
+        if (trans == Transpose::No){
+            for (int p = 0; p < kc; ++p){
+                for (int i = 0; i < mr; ++i)
+                    dst[i] = A[static_cast<std::size_t>(i0 + ir + i) * lda + p0 + p];
+                for (int i = mr; i < MR; ++i) dst[i] = 0;
+                dst += MR;
+            }
+        }else{
+            // op(A)(i, k) = A(k, i): each k is one contiguous run of A
+            for (int p = 0; p < kc; ++p){
+                const T* src = A + static_cast<std::size_t>(p0 + p) * lda + i0 + ir;
+                for (int i = 0; i < mr; ++i) dst[i] = src[i];
+                for (int i = mr; i < MR; ++i) dst[i] = 0;
+                dst += MR;
+            }
+        }
+    }
+}
+
+/// Packs rows [p0, p0+kc) and columns [j0, j0+nc) of op(B) into NR-wide panels.
+/// Panel layout: for each k, the NR values of that row are contiguous.
+template <typename T>
+void pack_b(Transpose trans, const T* B, int ldb,
+            int p0, int kc, int j0, int nc, T* dst){
+    constexpr int NR = Blocking<T>::NR;
+    for (int jr = 0; jr < nc; jr += NR){
+        int nr = std::min(NR, nc - jr);
+        if (trans == Transpose::No){
+            for (int p = 0; p < kc; ++p){
+                const T* src = B + static_cast<std::size_t>(p0 + p) * ldb + j0 + jr;
+                for (int j = 0; j < nr; ++j) dst[j] = src[j];
+                for (int j = nr; j < NR; ++j) dst[j] = 0;
+                dst += NR;
+            }
+        }else{
+            // op(B)(k, j) = B(j, k)
+            for (int p = 0; p < kc; ++p){
+                for (int j = 0; j < nr; ++j)
+                    dst[j] = B[static_cast<std::size_t>(j0 + jr + j) * ldb + p0 + p];
+                for (int j = nr; j < NR; ++j) dst[j] = 0;
+                dst += NR;
+            }
+        }
+    }
+}
+
+/// A GEMM operand stored as 16-bit floats
+struct HalfSource {
+    const std::uint16_t* data;
+    Precision precision;
+};
+
+// Widened copy of one contiguous run of a half operand: at most KC, MC or
+// NC elements, whichever the packing routine walks
+constexpr int WIDEN_MAX = 2048;
+static_assert(WIDEN_MAX >= Blocking<float>::KC && WIDEN_MAX >= Blocking<float>::MC &&
+              WIDEN_MAX >= Blocking<float>::NC, "widening buffer too short");
+static_assert(WIDEN_MAX >= Blocking<double>::KC && WIDEN_MAX >= Blocking<double>::MC &&
+              WIDEN_MAX >= Blocking<double>::NC, "widening buffer too short");
+
+// Function-local for the same reason as packed_a
+template <typename T>
+PackBuffer<T>& widened(){
+    thread_local PackBuffer<T> buffer;
+    return buffer;
+}
+
+/// Same panels as pack_a above, from a half operand. Every contiguous run
+/// of the source is decoded in one call (rows of A, or rows of Aᵀ) and
+/// then scattered into the panels
+template <typename T>
+void pack_a(Transpose trans, HalfSource A, int lda,
+            int i0, int mc, int p0, int kc, T* dst){
+    constexpr int MR = Blocking<T>::MR;
+    T* buf = widened<T>().reserve(WIDEN_MAX);
+    if (trans == Transpose::No){
+        for (int ir = 0; ir < mc; ir += MR){
+            int mr = std::min(MR, mc - ir);
+            T* panel = dst + static_cast<std::size_t>(ir) * kc;
+            for (int i = 0; i < mr; ++i){
+                half::decode(A.precision, A.data + static_cast<std::size_t>(i0 + ir + i) * lda + p0, buf, kc);
+                for (int p = 0; p < kc; ++p) panel[p * MR + i] = buf[p];
+            }
+            for (int p = 0; p < kc; ++p){
+                for (int i = mr; i < MR; ++i) panel[p * MR + i] = 0;
+            }
+        }
+    }else{
+        for (int p = 0; p < kc; ++p){
+            half::decode(A.precision, A.data + static_cast<std::size_t>(p0 + p) * lda + i0, buf, mc);
+            for (int ir = 0; ir < mc; ir += MR){
+                int mr = std::min(MR, mc - ir);
+                T* d = dst + static_cast<std::size_t>(ir) * kc + p * MR;
+                for (int i = 0; i < mr; ++i) d[i] = buf[ir + i];
+                for (int i = mr; i < MR; ++i) d[i] = 0;
+            }
+        }
+    }
+}
+
+/// Same panels as pack_b above, from a half operand
+template <typename T>
+void pack_b(Transpose trans, HalfSource B, int ldb,
+            int p0, int kc, int j0, int nc, T* dst){
+    constexpr int NR = Blocking<T>::NR;
+    T* buf = widened<T>().reserve(WIDEN_MAX);
+    if (trans == Transpose::No){
+        for (int p = 0; p < kc; ++p){
+            half::decode(B.precision, B.data + static_cast<std::size_t>(p0 + p) * ldb + j0, buf, nc);
+            for (int jr = 0; jr < nc; jr += NR){
+                int nr = std::min(NR, nc - jr);
+                T* d = dst + static_cast<std::size_t>(jr) * kc + p * NR;
+                for (int j = 0; j < nr; ++j) d[j] = buf[jr + j];
+                for (int j = nr; j < NR; ++j) d[j] = 0;
+            }
+        }
+    }else{
+        for (int jr = 0; jr < nc; jr += NR){
+            int nr = std::min(NR, nc - jr);
+            T* panel = dst + static_cast<std::size_t>(jr) * kc;
+            for (int j = 0; j < nr; ++j){
+                half::decode(B.precision, B.data + static_cast<std::size_t>(j0 + jr + j) * ldb + p0, buf, kc);
+                for (int p = 0; p < kc; ++p) panel[p * NR + j] = buf[p];
+            }
+            for (int p = 0; p < kc; ++p){
+                for (int j = nr; j < NR; ++j) panel[p * NR + j] = 0;
+            }
+        }
+    }
+}
+
+/// Operand `offset` elements further into its buffer
+template <typename T>
+const T* advance(const T* src, std::size_t offset){ return src + offset; }
+inline HalfSource advance(HalfSource src, std::size_t offset){ return {src.data + offset, src.precision}; }
+
+/// C[0:mr, 0:nr] += alpha · (a-panel · b-panel)
+/// The accumulator tile is a fixed MR × NR array so the compiler keeps it
+/// in vector registers and unrolls the inner loops.
+template <typename T>
+void micro_kernel(int kc, const T* a, const T* b,
+                  T alpha, T* C, int ldc, int mr, int nr){
+    constexpr int MR = Blocking<T>::MR;
+    constexpr int NR = Blocking<T>::NR;
+    T acc[MR][NR] = {};
+
+    for (int p = 0; p < kc; ++p){
+        const T* ap = a + p * MR;
+        const T* bp = b + p * NR;
+        for (int i = 0; i < MR; ++i){
+            const T ai = ap[i];
+            for (int j = 0; j < NR; ++j){
+                acc[i][j] += ai * bp[j];
+            }
+        }
+    }
+
+    for (int i = 0; i < mr; ++i){
+        T* c = C + static_cast<std::size_t>(i) * ldc;
+        for (int j = 0; j < nr; ++j){
+            c[j] += alpha * acc[i][j];
+        }
+    }
+}
+
+/// C = beta · C, treating beta == 0 as an overwrite
+template <typename T>
+void scale_c(int M, int N, T beta, T* C, int ldc){
+    if (beta == 1) return;
+    for (int i = 0; i < M; ++i){
+        T* c = C + static_cast<std::size_t>(i) * ldc;
+        if (beta == 0){
+            std::memset(c, 0, N * sizeof(T));
+        }else{
+            for (int j = 0; j < N; ++j) c[j] *= beta;
+        }
+    }
+}
+
+/// C = act(C + bias) over an (M × N) block; bias is indexed from the
+/// block's first column. Rows go through the SIMD kernel table.
+template <typename T>
+void apply_epilogue(int M, int N, T* C, int ldc, const GemmEpilogue<T>& ep){
+    if (!ep.bias && ep.activation == Activation::None) return;
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    for (int i = 0; i < M; ++i){
+        T* c = C + static_cast<std::size_t>(i) * ldc;
+        if (ep.bias) k.add(c, ep.bias, c, N);
+        switch (ep.activation){
+            case Activation::ReLU:    k.relu(c, c, N); break;
+            case Activation::Sigmoid: k.sigmoid_forward(c, c, N); break;
+            case Activation::None:    break;
+        }
+    }
+}
+
+// Problems below this many multiply-adds run on the calling thread
+constexpr double PARALLEL_MIN_FLOPS = 1 << 18;
+
+/// Single-threaded blocked GEMM; C must already be scaled by beta. The
+/// epilogue is applied to each MC × NC block of C right after its last
+/// K slab, before the next block evicts it. SA and SB are const T* or
+/// HalfSource.
+template <typename T, typename SA, typename SB>
+void gemm_serial(Transpose trans_a, Transpose trans_b,
+                 int M, int N, int K,
+                 T alpha, SA A, int lda,
+                 SB B, int ldb,
+                 T* C, int ldc,
+                 const GemmEpilogue<T>& ep){
+    constexpr int MR = Blocking<T>::MR, NR = Blocking<T>::NR;
+    constexpr int KC = Blocking<T>::KC, MC = Blocking<T>::MC, NC = Blocking<T>::NC;
+
+    // Panels are padded up to whole MR / NR tiles
+    std::size_t kc_max = std::min(K, KC);
+    std::size_t mc_max = round_up(std::min(M, MC), MR);
+    std::size_t nc_max = round_up(std::min(N, NC), NR);
+    T* a_buf = packed_a<T>().reserve(mc_max * kc_max);
+    T* b_buf = packed_b<T>().reserve(kc_max * nc_max);
+
+    for (int jc = 0; jc < N; jc += NC){
+        int nc = std::min(NC, N - jc);
+
+        for (int pc = 0; pc < K; pc += KC){
+            int kc = std::min(KC, K - pc);
+            pack_b(trans_b, B, ldb, pc, kc, jc, nc, b_buf);
+
+            for (int ic = 0; ic < M; ic += MC){
+                int mc = std::min(MC, M - ic);
+                pack_a(trans_a, A, lda, ic, mc, pc, kc, a_buf);
+
+                // Macro-kernel: sweep the packed block tile by tile
+                for (int jr = 0; jr < nc; jr += NR){
+                    int nr = std::min(NR, nc - jr);
+                    const T* b_panel = b_buf + static_cast<std::size_t>(jr) * kc;
+
+                    for (int ir = 0; ir < mc; ir += MR){
+                        int mr = std::min(MR, mc - ir);
+                        const T* a_panel = a_buf + static_cast<std::size_t>(ir) * kc;
+                        T* c_tile = C + static_cast<std::size_t>(ic + ir) * ldc + jc + jr;
+                        micro_kernel(kc, a_panel, b_panel, alpha, c_tile, ldc, mr, nr);
+                    }
+                }
+
+                if (pc + kc == K){
+                    GemmEpilogue<T> block_ep = ep;
+                    if (ep.bias) block_ep.bias = ep.bias + jc;
+                    apply_epilogue(mc, nc, C + static_cast<std::size_t>(ic) * ldc + jc, ldc, block_ep);
+                }
+            }
+        }
+    }
+}
+
+// Multi-threaded GEMM splits C into independent row blocks (or column
+// blocks when C is short and wide) and runs the serial engine on each.
+// Every thread packs its own panels into thread-local buffers, so the only
+// shared state is the read-only inputs.
+template <typename T, typename SA, typename SB>
+void gemm_parallel(Transpose trans_a, Transpose trans_b,
+                   int M, int N, int K,
+                   T alpha, SA A, int lda,
+                   SB B, int ldb,
+                   T beta, T* C, int ldc,
+                   const GemmEpilogue<T>& epilogue){
+
+    if (M <= 0 || N <= 0) return;
+
+    constexpr int MR = Blocking<T>::MR, NR = Blocking<T>::NR;
+
+    scale_c(M, N, beta, C, ldc);
+    if (K <= 0 || alpha == 0){
+        apply_epilogue(M, N, C, ldc, epilogue);
+        return;
+    }
+
+    double flops = static_cast<double>(M) * N * K;
+    int threads = get_num_threads();
+    if (threads <= 1 || flops < PARALLEL_MIN_FLOPS || ThreadPool::in_parallel_region()){
+        gemm_serial(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, C, ldc, epilogue);
+        return;
+    }
+
+    // Keep each block at least one register tile wide along the split
+    // dimension and big enough to amortize packing the other operand
+    std::size_t grain_flops = static_cast<std::size_t>(PARALLEL_MIN_FLOPS);
+
+    if (M >= N){
+        std::size_t grain = std::max<std::size_t>(MR, grain_flops / (static_cast<std::size_t>(N) * K) + 1);
+        parallel_for(static_cast<std::size_t>(M), grain, [&](std::size_t i0, std::size_t i1){
+            SA a = advance(A, (trans_a == Transpose::No) ? i0 * lda : i0);
+            gemm_serial(trans_a, trans_b, static_cast<int>(i1 - i0), N, K,
+                        alpha, a, lda, B, ldb, C + i0 * ldc, ldc, epilogue);
+        }, MR);
+    }else{
+        std::size_t grain = std::max<std::size_t>(NR, grain_flops / (static_cast<std::size_t>(M) * K) + 1);
+        parallel_for(static_cast<std::size_t>(N), grain, [&](std::size_t j0, std::size_t j1){
+            SB b = advance(B, (trans_b == Transpose::No) ? j0 : j0 * ldb);
+            GemmEpilogue<T> block_ep = epilogue;
+            if (epilogue.bias) block_ep.bias = epilogue.bias + j0;
+            gemm_serial(trans_a, trans_b, M, static_cast<int>(j1 - j0), K,
+                        alpha, A, lda, b, ldb, C + j0, ldc, block_ep);
+        }, NR);
+    }
+}
+
+} // namespace
+
+template <typename T>
+void gemm(Transpose trans_a, Transpose trans_b,
+          int M, int N, int K,
+          T alpha, const T* A, int lda,
+          const T* B, int ldb,
+          T beta, T* C, int ldc,
+          const GemmEpilogue<T>& epilogue){
+    gemm_parallel(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, epilogue);
+}
+
+template <typename T>
+void gemm(Transpose trans_a, Transpose trans_b,
+          int M, int N, int K,
+          T alpha, const GemmOperand<T>& A, const GemmOperand<T>& B,
+          T beta, T* C, int ldc,
+          const GemmEpilogue<T>& epilogue){
+    if (A.half && B.half){
+        gemm_parallel(trans_a, trans_b, M, N, K, alpha, HalfSource{A.half, A.precision}, A.ld,
+                      HalfSource{B.half, B.precision}, B.ld, beta, C, ldc, epilogue);
+    }else if (A.half){
+        gemm_parallel(trans_a, trans_b, M, N, K, alpha, HalfSource{A.half, A.precision}, A.ld,
+                      B.data, B.ld, beta, C, ldc, epilogue);
+    }else if (B.half){
+        gemm_parallel(trans_a, trans_b, M, N, K, alpha, A.data, A.ld,
+                      HalfSource{B.half, B.precision}, B.ld, beta, C, ldc, epilogue);
+    }else{
+        gemm_parallel(trans_a, trans_b, M, N, K, alpha, A.data, A.ld, B.data, B.ld, beta, C, ldc, epilogue);
+    }
+}
+
+template <typename T>
+void gemm(Transpose trans_a, Transpose trans_b,
+          int M, int N, int K,
+          T alpha, const T* A, int lda,
+          const T* B, int ldb,
+          T beta, T* C, int ldc){
+    gemm(trans_a, trans_b, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, GemmEpilogue<T>{});
+}
+
+template void gemm<float>(Transpose, Transpose, int, int, int,
+                          float, const float*, int, const float*, int,
+                          float, float*, int);
+template void gemm<double>(Transpose, Transpose, int, int, int,
+                           double, const double*, int, const double*, int,
+                           double, double*, int);
+template void gemm<float>(Transpose, Transpose, int, int, int,
+                          float, const float*, int, const float*, int,
+                          float, float*, int, const GemmEpilogue<float>&);
+template void gemm<double>(Transpose, Transpose, int, int, int,
+                           double, const double*, int, const double*, int,
+                           double, double*, int, const GemmEpilogue<double>&);
+template void gemm<float>(Transpose, Transpose, int, int, int,
+                          float, const GemmOperand<float>&, const GemmOperand<float>&,
+                          float, float*, int, const GemmEpilogue<float>&);
+template void gemm<double>(Transpose, Transpose, int, int, int,
+                           double, const GemmOperand<double>&, const GemmOperand<double>&,
+                           double, double*, int, const GemmEpilogue<double>&);
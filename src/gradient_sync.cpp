@@ -0,0 +1,108 @@
+#include "gradient_sync.hpp"
+#include "kernels.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+template <typename T>
+GradientSync<T>::GradientSync(Communicator& comm, std::size_t bucket_bytes)
+    : comm(comm), bucket_elements(std::max<std::size_t>(1, bucket_bytes / sizeof(T))){
+    // A single rank has nothing to exchange and needs no thread
+    if (comm.size() > 1) worker = std::thread(&GradientSync::run, this);
+}
+
+template <typename T>
+GradientSync<T>::~GradientSync(){
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+/// Walks the layers from last to first, closing a bucket at the first
+/// layer boundary where it reaches bucket_elements; whatever is left at
+/// the front becomes the last bucket, sent by finish()
+template <typename T>
+void GradientSync<T>::plan(T* grads, std::size_t n, const std::vector<std::size_t>& layer_begin){
+    this->grads = grads;
+    buckets.clear();
+    ready.assign(layer_begin.size(), 0);
+
+    std::size_t end = n;
+    for (std::size_t i = layer_begin.size(); i-- > 0;){
+        if (layer_begin[i] > end){
+            throw std::invalid_argument("GradientSync::plan: Layer offsets must not decrease");
+        }
+        if (end - layer_begin[i] >= bucket_elements){
+            buckets.push_back({layer_begin[i], end});
+            end = layer_begin[i];
+        }
+        ready[i] = buckets.size();
+    }
+    if (end > 0) buckets.push_back({0, end});
+}
+
+template <typename T>
+void GradientSync<T>::layer_done(std::size_t layer){
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ready[layer] <= submitted) return;
+        submitted = ready[layer];
+    }
+    wake.notify_one();
+}
+
+template <typename T>
+void GradientSync<T>::finish(){
+    if (!worker.joinable()) return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    submitted = buckets.size();
+    wake.notify_one();
+    done.wait(lock, [&]{ return completed == submitted; });
+
+    submitted = completed = 0;
+    if (error){
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+// Communication thread: reduces submitted buckets in order. After an
+// error the remaining buckets of the step are only counted off
+template <typename T>
+void GradientSync<T>::run(){
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    T inv_size = T(1) / comm.size();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;){
+        wake.wait(lock, [&]{ return stopping || completed < submitted; });
+        if (completed == submitted) return;
+
+        Bucket b = buckets[completed];
+        bool failed = static_cast<bool>(error);
+        lock.unlock();
+
+        if (!failed){
+            try{
+                comm.all_reduce(grads + b.begin, b.end - b.begin);
+                k.scale(grads + b.begin, inv_size, grads + b.begin, b.end - b.begin);
+            }catch(...){
+                lock.lock();
+                error = std::current_exception();
+                lock.unlock();
+            }
+        }
+
+        lock.lock();
+        if (++completed == submitted) done.notify_all();
+    }
+}
+
+template class GradientSync<float>;
+template class GradientSync<double>;
@@ -0,0 +1,229 @@
+#include "half.hpp"
+#include "half_impl.hpp"
+#include "kernels.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define NEURONITE_HAS_CPUID 1
+#endif
+
+namespace half {
+
+namespace {
+
+inline std::uint32_t bits_of(float x){
+    std::uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    return u;
+}
+
+inline float float_of(std::uint32_t u){
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+// Portable conversions, also the reference for the vector ones
+std::size_t scalar_encode_bf16(const float* src, std::uint16_t* dst, std::size_t n){
+    for (std::size_t i = 0; i < n; ++i) dst[i] = to_bfloat16(src[i]);
+    return n;
+}
+
+std::size_t scalar_decode_bf16(const std::uint16_t* src, float* dst, std::size_t n){
+    for (std::size_t i = 0; i < n; ++i) dst[i] = from_bfloat16(src[i]);
+    return n;
+}
+
+std::size_t scalar_encode_fp16(const float* src, std::uint16_t* dst, std::size_t n){
+    for (std::size_t i = 0; i < n; ++i) dst[i] = to_float16(src[i]);
+    return n;
+}
+
+std::size_t scalar_decode_fp16(const std::uint16_t* src, float* dst, std::size_t n){
+    for (std::size_t i = 0; i < n; ++i) dst[i] = from_float16(src[i]);
+    return n;
+}
+
+const impl::Converters scalar_converters = {
+    &scalar_encode_bf16, &scalar_decode_bf16, &scalar_encode_fp16, &scalar_decode_fp16,
+};
+
+// F16C is its own CPUID bit; AVX-512 BF16 sits in leaf 7, subleaf 1. The
+// register-state checks are already part of kernels::detect_isa
+bool cpu_has_f16c(){
+#ifdef NEURONITE_HAS_CPUID
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    return ecx & (1u << 29);
+#else
+    return false;
+#endif
+}
+
+bool cpu_has_avx512_bf16(){
+#ifdef NEURONITE_HAS_CPUID
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) return false;
+    return eax & (1u << 5);
+#else
+    return false;
+#endif
+}
+
+struct Selected {
+    const impl::Converters* converters;
+    const char* name;
+};
+
+Selected select_converters(){
+    kernels::Isa isa = kernels::active<float>().isa;
+    if (isa >= kernels::Isa::AVX512 && cpu_has_avx512_bf16()){
+        if (const impl::Converters* c = impl::avx512_converters()) return {c, "avx512"};
+    }
+    if (isa >= kernels::Isa::AVX2 && cpu_has_f16c()){
+        if (const impl::Converters* c = impl::f16c_converters()) return {c, "f16c"};
+    }
+    return {&scalar_converters, "scalar"};
+}
+
+const Selected& selected(){
+    static const Selected s = select_converters();
+    return s;
+}
+
+// Doubles go through a float buffer this long
+constexpr std::size_t CHUNK = 512;
+
+} // namespace
+
+std::uint16_t to_bfloat16(float x){
+    std::uint32_t u = bits_of(x);
+    if ((u & 0x7fffffffu) > 0x7f800000u) return static_cast<std::uint16_t>((u >> 16) | 0x40);   // quiet NaN
+    if ((u & 0x7f800000u) == 0) return static_cast<std::uint16_t>((u >> 16) & 0x8000);         // ±0, denormals
+    u += 0x7fffu + ((u >> 16) & 1);
+    return static_cast<std::uint16_t>(u >> 16);
+}
+
+float from_bfloat16(std::uint16_t h){
+    return float_of(static_cast<std::uint32_t>(h) << 16);
+}
+
+std::uint16_t to_float16(float x){
+    std::uint32_t u = bits_of(x);
+    std::uint32_t sign = (u >> 16) & 0x8000u;
+    std::uint32_t a = u & 0x7fffffffu;
+
+    if (a >= 0x7f800000u){
+        // Infinity, or NaN with its payload's top bits, made quiet
+        std::uint32_t nan = a > 0x7f800000u ? 0x200u | ((a >> 13) & 0x3ffu) : 0;
+        return static_cast<std::uint16_t>(sign | 0x7c00u | nan);
+    }
+    // 65520 and up round past the largest half, 65504
+    if (a >= 0x477ff000u) return static_cast<std::uint16_t>(sign | 0x7c00u);
+
+    if (a < 0x38800000u){
+        // Below 2^-14: a subnormal half, round(|x| / 2^-24). Under 2^-25
+        // everything rounds to zero
+        if (a < 0x33000000u) return static_cast<std::uint16_t>(sign);
+        std::uint32_t mantissa = (a & 0x7fffffu) | 0x800000u;
+        int shift = 126 - static_cast<int>(a >> 23);
+        std::uint32_t q = mantissa >> shift;
+        std::uint32_t rest = mantissa & ((1u << shift) - 1);
+        std::uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (q & 1))) ++q;
+        return static_cast<std::uint16_t>(sign | q);
+    }
+
+    // Normal: rebias the exponent (127 → 15) and round 23 mantissa bits to
+    // 10; a carry out of the mantissa correctly bumps the exponent
+    std::uint32_t h = (a - 0x38000000u) >> 13;
+    std::uint32_t rest = a & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (h & 1))) ++h;
+    return static_cast<std::uint16_t>(sign | h);
+}
+
+float from_float16(std::uint16_t h){
+    std::uint32_t sign = static_cast<std::uint32_t>(h & 0x8000u) << 16;
+    std::uint32_t exponent = (h >> 10) & 0x1fu;
+    std::uint32_t mantissa = h & 0x3ffu;
+
+    if (exponent == 0x1f) return float_of(sign | 0x7f800000u | (mantissa << 13));
+    if (exponent == 0){
+        // Zero or subnormal: mantissa · 2^-24, exact in float
+        float value = static_cast<float>(mantissa) * 0x1p-24f;
+        return sign ? -value : value;
+    }
+    return float_of(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+void encode(Precision precision, const float* src, std::uint16_t* dst, std::size_t n){
+    const impl::Converters& c = *selected().converters;
+    std::size_t done;
+    switch (precision){
+        case Precision::BFloat16:
+            done = c.encode_bf16(src, dst, n);
+            scalar_encode_bf16(src + done, dst + done, n - done);
+            return;
+        case Precision::Float16:
+            done = c.encode_fp16(src, dst, n);
+            scalar_encode_fp16(src + done, dst + done, n - done);
+            return;
+        case Precision::Full:
+            break;
+    }
+    throw std::invalid_argument("half::encode: Precision::Full is not a 16-bit format");
+}
+
+void decode(Precision precision, const std::uint16_t* src, float* dst, std::size_t n){
+    const impl::Converters& c = *selected().converters;
+    std::size_t done;
+    switch (precision){
+        case Precision::BFloat16:
+            done = c.decode_bf16(src, dst, n);
+            scalar_decode_bf16(src + done, dst + done, n - done);
+            return;
+        case Precision::Float16:
+            done = c.decode_fp16(src, dst, n);
+            scalar_decode_fp16(src + done, dst + done, n - done);
+            return;
+        case Precision::Full:
+            break;
+    }
+    throw std::invalid_argument("half::decode: Precision::Full is not a 16-bit format");
+}
+
+void encode(Precision precision, const double* src, std::uint16_t* dst, std::size_t n){
+    float buffer[CHUNK];
+    for (std::size_t at = 0; at < n; at += CHUNK){
+        std::size_t count = std::min(CHUNK, n - at);
+        for (std::size_t i = 0; i < count; ++i) buffer[i] = static_cast<float>(src[at + i]);
+        encode(precision, buffer, dst + at, count);
+    }
+}
+
+void decode(Precision precision, const std::uint16_t* src, double* dst, std::size_t n){
+    float buffer[CHUNK];
+    for (std::size_t at = 0; at < n; at += CHUNK){
+        std::size_t count = std::min(CHUNK, n - at);
+        decode(precision, src + at, buffer, count);
+        for (std::size_t i = 0; i < count; ++i) dst[at + i] = buffer[i];
+    }
+}
+
+const char* kernel_name(){
+    return selected().name;
+}
+
+const char* precision_name(Precision precision){
+    switch (precision){
+        case Precision::Full:     return "full";
+        case Precision::BFloat16: return "bf16";
+        case Precision::Float16:  return "fp16";
+    }
+    return "unknown";
+}
+
+} // namespace half
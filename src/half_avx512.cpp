@@ -0,0 +1,70 @@
+#include "half_impl.hpp"
+
+// Built with -mavx512f -mavx512bf16 (see CMakeLists.txt). Only reached
+// after half::encode/decode have confirmed AVX-512 BF16 at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__AVX512F__) && defined(__AVX512BF16__)
+
+#include <immintrin.h>
+#include <cstring>
+
+namespace half {
+namespace impl {
+
+namespace {
+
+// vcvtneps2bf16 rounds to nearest even, quiets NaNs and flushes
+// denormals, which is exactly what the scalar code does
+std::size_t encode_bf16(const float* src, std::uint16_t* dst, std::size_t n){
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16){
+        __m256bh h = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+        std::memcpy(dst + i, &h, sizeof(h));
+    }
+    return i;
+}
+
+std::size_t decode_bf16(const std::uint16_t* src, float* dst, std::size_t n){
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16){
+        __m512i h = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+        _mm512_storeu_ps(dst + i, _mm512_castsi512_ps(_mm512_slli_epi32(h, 16)));
+    }
+    return i;
+}
+
+std::size_t encode_fp16(const float* src, std::uint16_t* dst, std::size_t n){
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16){
+        __m256i h = _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), h);
+    }
+    return i;
+}
+
+std::size_t decode_fp16(const std::uint16_t* src, float* dst, std::size_t n){
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16){
+        __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(h));
+    }
+    return i;
+}
+
+const Converters converters = {&encode_bf16, &decode_bf16, &encode_fp16, &decode_fp16};
+
+} // namespace
+
+const Converters* avx512_converters(){ return &converters; }
+
+} // namespace impl
+} // namespace half
+
+#else
+
+namespace half {
+namespace impl {
+const Converters* avx512_converters(){ return nullptr; }
+} // namespace impl
+} // namespace half
+
+#endif
@@ -0,0 +1,92 @@
+#include "half_impl.hpp"
+
+// Built with -mavx2 -mf16c (see CMakeLists.txt). Only reached after
+// half::encode/decode have confirmed AVX2 and F16C at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__AVX2__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+namespace half {
+namespace impl {
+
+namespace {
+
+// bf16 is the top half of an fp32, rounded to nearest even: add 0x7fff
+// plus the lowest kept bit, then shift. NaNs are made quiet and
+// denormals flushed to signed zero, matching the scalar code
+std::size_t encode_bf16(const float* src, std::uint16_t* dst, std::size_t n){
+    const __m256i abs_mask = _mm256_set1_epi32(0x7fffffff);
+    const __m256i exponent_mask = _mm256_set1_epi32(0x7f800000);
+    const __m256i infinity = _mm256_set1_epi32(0x7f800000);
+    const __m256i sign_mask = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    const __m256i bias = _mm256_set1_epi32(0x7fff);
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i quiet = _mm256_set1_epi32(0x40);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m256i u = _mm256_castps_si256(_mm256_loadu_ps(src + i));
+        __m256i is_nan = _mm256_cmpgt_epi32(_mm256_and_si256(u, abs_mask), infinity);
+        __m256i is_tiny = _mm256_cmpeq_epi32(_mm256_and_si256(u, exponent_mask), _mm256_setzero_si256());
+
+        __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(u, 16), one);
+        __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(u, _mm256_add_epi32(bias, lsb)), 16);
+        __m256i nan = _mm256_or_si256(_mm256_srli_epi32(u, 16), quiet);
+        __m256i zero = _mm256_srli_epi32(_mm256_and_si256(u, sign_mask), 16);
+
+        __m256i h = _mm256_blendv_epi8(rounded, nan, is_nan);
+        h = _mm256_blendv_epi8(h, zero, is_tiny);
+
+        // Every lane is below 2^16, so the unsigned-saturating pack is
+        // exact; it works per 128-bit lane, hence the permute
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(h, h), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_castsi256_si128(packed));
+    }
+    return i;
+}
+
+std::size_t decode_bf16(const std::uint16_t* src, float* dst, std::size_t n){
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m256i h = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(h, 16)));
+    }
+    return i;
+}
+
+std::size_t encode_fp16(const float* src, std::uint16_t* dst, std::size_t n){
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), h);
+    }
+    return i;
+}
+
+std::size_t decode_fp16(const std::uint16_t* src, float* dst, std::size_t n){
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8){
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(h));
+    }
+    return i;
+}
+
+const Converters converters = {&encode_bf16, &decode_bf16, &encode_fp16, &decode_fp16};
+
+} // namespace
+
+const Converters* f16c_converters(){ return &converters; }
+
+} // namespace impl
+} // namespace half
+
+#else
+
+namespace half {
+namespace impl {
+const Converters* f16c_converters(){ return nullptr; }
+} // namespace impl
+} // namespace half
+
+#endif
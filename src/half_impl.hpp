@@ -0,0 +1,29 @@
+#ifndef HALF_IMPL_HPP
+#define HALF_IMPL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Vector conversions behind half::encode/decode (see half.hpp). Like
+// kernel_table.hpp, this header holds declarations only, because
+// half_f16c.cpp and half_avx512.cpp include it under -mf16c / -mavx512bf16.
+namespace half {
+namespace impl {
+
+// Each converts the longest prefix of whole vectors and returns how many
+// elements that was; half::encode/decode finish the rest in scalar code
+struct Converters {
+    std::size_t (*encode_bf16)(const float* src, std::uint16_t* dst, std::size_t n);
+    std::size_t (*decode_bf16)(const std::uint16_t* src, float* dst, std::size_t n);
+    std::size_t (*encode_fp16)(const float* src, std::uint16_t* dst, std::size_t n);
+    std::size_t (*decode_fp16)(const std::uint16_t* src, float* dst, std::size_t n);
+};
+
+// Each returns nullptr when its instruction set was not compiled in
+const Converters* f16c_converters();
+const Converters* avx512_converters();
+
+} // namespace impl
+} // namespace half
+
+#endif
@@ -0,0 +1,102 @@
+#include "half_matrix.hpp"
+#include "aligned_memory.hpp"
+#include "profiler.hpp"
+#include "kernels.hpp"
+#include <stdexcept>
+
+HalfMatrix::HalfMatrix()
+    : rows(0), cols(0), precision(Precision::BFloat16), ptr(nullptr), capacity(0), owning(true) {}
+
+HalfMatrix::HalfMatrix(HalfMatrix&& other) noexcept
+    : rows(other.rows), cols(other.cols), precision(other.precision),
+      ptr(other.ptr), capacity(other.capacity), owning(other.owning) {
+        other.rows = other.cols = 0;
+        other.ptr = nullptr;
+        other.capacity = 0;
+        other.owning = true;
+    }
+
+HalfMatrix& HalfMatrix::operator=(HalfMatrix&& other) noexcept{
+    if (this == &other) return *this;
+    release();
+    rows = other.rows;
+    cols = other.cols;
+    precision = other.precision;
+    ptr = other.ptr;
+    capacity = other.capacity;
+    owning = other.owning;
+
+    other.rows = other.cols = 0;
+    other.ptr = nullptr;
+    other.capacity = 0;
+    other.owning = true;
+    return *this;
+}
+
+HalfMatrix::~HalfMatrix(){
+    release();
+}
+
+void HalfMatrix::release(){
+    if (owning){
+        if (ptr && profiling::tracking()) profiling::count_matrix_bytes(-static_cast<long long>(capacity * sizeof(std::uint16_t)));
+        aligned_free(ptr);
+    }
+    ptr = nullptr;
+    capacity = 0;
+}
+
+void HalfMatrix::rebind(std::uint16_t* ptr, int rows, int cols, std::size_t capacity){
+    release();
+    this->ptr = ptr;
+    this->rows = rows;
+    this->cols = cols;
+    this->capacity = capacity;
+    owning = false;
+}
+
+void HalfMatrix::resize(int rows, int cols){
+    if (this->rows == rows && this->cols == cols) return;
+    if (rows < 0 || cols < 0){
+        throw std::invalid_argument("HalfMatrix: Negative dimensions.");
+    }
+    std::size_t count = static_cast<std::size_t>(rows) * cols;
+    if (count > capacity){
+        if (!owning){
+            throw std::invalid_argument("HalfMatrix::resize: Shape exceeds the storage the view was placed in.");
+        }
+        release();
+        ptr = static_cast<std::uint16_t*>(aligned_malloc(count * sizeof(std::uint16_t)));
+        capacity = count;
+        if (profiling::tracking()) profiling::count_matrix_bytes(static_cast<long long>(count * sizeof(std::uint16_t)));
+    }
+    this->rows = rows;
+    this->cols = cols;
+}
+
+// Conversions are bandwidth-bound sweeps, split across the pool like the
+// elementwise kernels
+template <typename T>
+void HalfMatrix::assign(const Matrix<T>& source, Precision precision){
+    if (precision == Precision::Full){
+        throw std::invalid_argument("HalfMatrix::assign: Precision::Full is not a 16-bit format");
+    }
+    resize(source.rows, source.cols);
+    this->precision = precision;
+    kernels::for_each_span(source.is_contiguous(), rows, cols, [&](int i, std::size_t n){
+        half::encode(precision, source.row(i), row(i), n);
+    });
+}
+
+template <typename T>
+void HalfMatrix::decode_into(Matrix<T>& out) const{
+    out.resize(rows, cols);
+    kernels::for_each_span(out.is_contiguous(), rows, cols, [&](int i, std::size_t n){
+        half::decode(precision, row(i), out.row(i), n);
+    });
+}
+
+template void HalfMatrix::assign<float>(const Matrix<float>&, Precision);
+template void HalfMatrix::assign<double>(const Matrix<double>&, Precision);
+template void HalfMatrix::decode_into<float>(Matrix<float>&) const;
+template void HalfMatrix::decode_into<double>(Matrix<double>&) const;
@@ -0,0 +1,287 @@
+#include "inference_server.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double micros_between(Clock::time_point from, Clock::time_point to){
+    return std::chrono::duration<double, std::micro>(to - from).count();
+}
+
+// Value at fraction q of the sorted order of `values` (which is reordered)
+double percentile(std::vector<double>& values, double q){
+    if (values.empty()) return 0.0;
+    std::size_t k = static_cast<std::size_t>(q * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+} // namespace
+
+template <typename T>
+InferenceServer<T>::InferenceServer(const Model<T>& model,
+                                    int input_dim,
+                                    int max_batch_size,
+                                    std::chrono::microseconds max_wait,
+                                    std::size_t queue_capacity)
+    : model(model), input_dim(input_dim), max_batch_size(max_batch_size),
+      max_wait(max_wait), queue(queue_capacity) {
+
+    if (input_dim <= 0){
+        throw std::invalid_argument("InferenceServer: input_dim must be positive");
+    }
+    if (max_batch_size <= 0){
+        throw std::invalid_argument("InferenceServer: max_batch_size must be positive");
+    }
+    if (max_wait.count() < 0){
+        throw std::invalid_argument("InferenceServer: max_wait must not be negative");
+    }
+
+    batch.reserve(max_batch_size);
+    batch_input.resize(max_batch_size, input_dim);
+    batch_latencies.reserve(max_batch_size);
+    latency_window.reserve(LATENCY_WINDOW);
+
+    worker = std::thread(&InferenceServer::run, this);
+}
+
+template <typename T>
+InferenceServer<T>::~InferenceServer(){
+    stopping.store(true);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+template <typename T>
+std::future<std::vector<T>> InferenceServer<T>::submit(std::vector<T> input){
+    Request request;
+    request.input = std::move(input);
+    std::future<std::vector<T>> result = request.promise.get_future();
+    enqueue(request);
+    return result;
+}
+
+template <typename T>
+void InferenceServer<T>::submit(std::vector<T> input, Callback callback){
+    Request request;
+    request.input = std::move(input);
+    request.callback = std::move(callback);
+    enqueue(request);
+}
+
+template <typename T>
+void InferenceServer<T>::enqueue(Request& request){
+    if (static_cast<int>(request.input.size()) != input_dim){
+        throw std::invalid_argument("InferenceServer::submit: Input has " + std::to_string(request.input.size()) +
+                                    " values, expected " + std::to_string(input_dim));
+    }
+    if (stopping.load()){
+        throw std::runtime_error("InferenceServer::submit: Server is shutting down");
+    }
+
+    request.enqueued = Clock::now();
+    // Backpressure: wait for the server thread to make room. Announcing
+    // the wait before looking at the queue again pairs with the fence in
+    // try_pop: either this thread sees the room, or the server sees it
+    // waiting and notifies, which the held lock keeps from being missed
+    while (!queue.try_push(request)){
+        std::unique_lock<std::mutex> lock(room_mutex);
+        waiting_for_room.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue.size() >= queue.capacity()) room.wait(lock);
+        waiting_for_room.fetch_sub(1);
+    }
+
+    // Pairs with the fence in pop_wait: either the server sees this
+    // request before it sleeps, or this thread sees it asleep and wakes it
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load()){
+        { std::lock_guard<std::mutex> lock(wake_mutex); }
+        wake.notify_one();
+    }
+}
+
+template <typename T>
+bool InferenceServer<T>::try_pop(Request& request){
+    if (!queue.try_pop(request)) return false;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_for_room.load() > 0){
+        { std::lock_guard<std::mutex> lock(room_mutex); }
+        room.notify_all();
+    }
+    return true;
+}
+
+template <typename T>
+bool InferenceServer<T>::pop_wait(Request& request, const Clock::time_point* deadline){
+    for (;;){
+        if (try_pop(request)) return true;
+        if (stopping.load()) return try_pop(request);
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (queue.size() == 0 && !stopping.load()){
+            if (deadline){
+                if (wake.wait_until(lock, *deadline) == std::cv_status::timeout){
+                    sleeping.store(false);
+                    return try_pop(request);
+                }
+            }else{
+                wake.wait(lock);
+            }
+        }
+        sleeping.store(false);
+    }
+}
+
+// Server thread: block for the first request of a batch, then keep
+// collecting until the batch is full or that request's deadline passes
+template <typename T>
+void InferenceServer<T>::run(){
+    Request request;
+    while (pop_wait(request, nullptr)){
+        batch.push_back(std::move(request));
+        Clock::time_point deadline = batch.front().enqueued + max_wait;
+
+        while (static_cast<int>(batch.size()) < max_batch_size){
+            if (try_pop(request)){
+                batch.push_back(std::move(request));
+                continue;
+            }
+            if (stopping.load() || Clock::now() >= deadline) break;
+            if (!pop_wait(request, &deadline)) break;
+            batch.push_back(std::move(request));
+        }
+
+        serve();
+    }
+}
+
+// Runs one batch through the model and delivers every row of the result
+template <typename T>
+void InferenceServer<T>::serve(){
+    int n = static_cast<int>(batch.size());
+    batch_input.resize(n, input_dim);
+    for (int i = 0; i < n; ++i){
+        std::copy(batch[i].input.begin(), batch[i].input.end(), batch_input.row(i));
+    }
+
+    std::exception_ptr error;
+    try{
+        model.predict(batch_input, batch_output, scratch);
+    }catch(...){
+        error = std::current_exception();
+    }
+
+    Clock::time_point done = Clock::now();
+    double latency_total = 0.0;
+    double latency_max = 0.0;
+    batch_latencies.resize(n);
+    for (int i = 0; i < n; ++i){
+        batch_latencies[i] = micros_between(batch[i].enqueued, done);
+        latency_total += batch_latencies[i];
+        latency_max = std::max(latency_max, batch_latencies[i]);
+    }
+
+    // Counted before delivery, so stats() already covers any result a
+    // caller has received
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        for (double l : batch_latencies){
+            if (latency_window.size() < LATENCY_WINDOW){
+                latency_window.push_back(l);
+            }else{
+                latency_window[served % LATENCY_WINDOW] = l;
+            }
+            ++served;
+        }
+        ++batches;
+        latency_sum_us += latency_total;
+        latency_max_us = std::max(latency_max_us, latency_max);
+    }
+
+    for (int i = 0; i < n; ++i){
+        Request& r = batch[i];
+        std::vector<T> output;
+        if (!error) output.assign(batch_output.row(i), batch_output.row(i) + batch_output.cols);
+
+        if (r.callback){
+            try{
+                r.callback(std::move(output), error);
+            }catch(...){
+            }
+        }else if (error){
+            r.promise.set_exception(error);
+        }else{
+            r.promise.set_value(std::move(output));
+        }
+    }
+    batch.clear();
+}
+
+template <typename T>
+ServerStats InferenceServer<T>::stats() const{
+    std::vector<double> window;
+    ServerStats s{};
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        window = latency_window;
+        s.requests = served;
+        s.batches = batches;
+        s.mean_latency_us = served ? latency_sum_us / served : 0.0;
+        s.max_latency_us = latency_max_us;
+    }
+    s.mean_batch_size = s.batches ? static_cast<double>(s.requests) / s.batches : 0.0;
+    s.queue_depth = queue.size();
+    s.p50_latency_us = percentile(window, 0.50);
+    s.p99_latency_us = percentile(window, 0.99);
+    return s;
+}
+
+template <typename T>
+LoadResult drive_load(InferenceServer<T>& server, const Matrix<T>& inputs,
+                      int clients, int requests_per_client){
+    if (inputs.rows == 0 || clients <= 0 || requests_per_client < 0){
+        throw std::invalid_argument("drive_load: Need input rows, clients and a request count");
+    }
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(clients);
+    for (int c = 0; c < clients; ++c){
+        threads.emplace_back([&, c]{
+            try{
+                for (int k = 0; k < requests_per_client; ++k){
+                    int row = (c * requests_per_client + k) % inputs.rows;
+                    const T* x = inputs.row(row);
+                    server.submit(std::vector<T>(x, x + inputs.cols)).get();
+                }
+            }catch(...){
+                errors[c] = std::current_exception();
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    for (const std::exception_ptr& e : errors){
+        if (e) std::rethrow_exception(e);
+    }
+
+    LoadResult result{};
+    result.requests = static_cast<std::size_t>(clients) * requests_per_client;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.requests_per_second = result.seconds > 0 ? result.requests / result.seconds : 0.0;
+    result.stats = server.stats();
+    return result;
+}
+
+template class InferenceServer<float>;
+template class InferenceServer<double>;
+
+template LoadResult drive_load<float>(InferenceServer<float>&, const Matrix<float>&, int, int);
+template LoadResult drive_load<double>(InferenceServer<double>&, const Matrix<double>&, int, int);
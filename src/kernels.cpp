@@ -0,0 +1,279 @@
+#include "kernels.hpp"
+#include "kernels_impl.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define NEURONITE_HAS_CPUID 1
+#endif
+
+namespace kernels {
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Portable scalar fallback, also the reference for the vector paths
+// ---------------------------------------------------------------------------
+
+template <typename T>
+struct Scalar {
+    static void add(const T* a, const T* b, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) out[i] = a[i] + b[i];
+    }
+
+    static void sub(const T* a, const T* b, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) out[i] = a[i] - b[i];
+    }
+
+    static void mul(const T* a, const T* b, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) out[i] = a[i] * b[i];
+    }
+
+    static void scale(const T* a, T s, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) out[i] = a[i] * s;
+    }
+
+    static void mul_add(const T* a, const T* b, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) out[i] += a[i] * b[i];
+    }
+
+    static void axpy(const T* a, T alpha, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) out[i] += alpha * a[i];
+    }
+
+    static void add_row(const T* a, int lda, const T* row, T* out, int ldo, int rows, int cols){
+        for (int i = 0; i < rows; ++i)
+            add(a + static_cast<std::size_t>(i) * lda, row, out + static_cast<std::size_t>(i) * ldo, cols);
+    }
+
+    static void sub_row(const T* a, int lda, const T* row, T* out, int ldo, int rows, int cols){
+        for (int i = 0; i < rows; ++i)
+            sub(a + static_cast<std::size_t>(i) * lda, row, out + static_cast<std::size_t>(i) * ldo, cols);
+    }
+
+    static void mul_row(const T* a, int lda, const T* row, T* out, int ldo, int rows, int cols){
+        for (int i = 0; i < rows; ++i)
+            mul(a + static_cast<std::size_t>(i) * lda, row, out + static_cast<std::size_t>(i) * ldo, cols);
+    }
+
+    static void affine_row(const T* a, int lda, const T* scale_row, const T* shift_row,
+                           T* out, int ldo, int rows, int cols){
+        for (int i = 0; i < rows; ++i){
+            const T* x = a + static_cast<std::size_t>(i) * lda;
+            T* y = out + static_cast<std::size_t>(i) * ldo;
+            for (int j = 0; j < cols; ++j) y[j] = x[j] * scale_row[j] + shift_row[j];
+        }
+    }
+
+    static void relu_forward(const T* x, T* y, T* mask, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i){
+            T v = x[i];
+            y[i] = std::max(T(0), v);
+            mask[i] = (v > 0) ? T(1) : T(0);
+        }
+    }
+
+    static void relu_backward(const T* grad, const T* mask, T* out, std::size_t n){
+        mul(grad, mask, out, n);
+    }
+
+    static void relu(const T* x, T* y, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) y[i] = std::max(T(0), x[i]);
+    }
+
+    static void relu_backward_output(const T* grad, const T* y, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) out[i] = (y[i] > 0) ? grad[i] : T(0);
+    }
+
+    static void sigmoid_forward(const T* x, T* y, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) y[i] = T(1) / (T(1) + std::exp(-x[i]));
+    }
+
+    static void sigmoid_backward(const T* grad, const T* y, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) out[i] = grad[i] * y[i] * (T(1) - y[i]);
+    }
+
+    static T squared_diff_sum(const T* a, const T* b, std::size_t n){
+        T sum = 0;
+        for (std::size_t i = 0; i < n; ++i){
+            T d = a[i] - b[i];
+            sum += d * d;
+        }
+        return sum;
+    }
+
+    static void scaled_diff(const T* a, const T* b, T s, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i) out[i] = s * (a[i] - b[i]);
+    }
+
+    static T bce_logits(const T* z, const T* y, T s, T* grad, std::size_t n){
+        T sum = 0;
+        for (std::size_t i = 0; i < n; ++i){
+            // e^(-|z|) never overflows; σ(z) is recovered from it on either side
+            T e = std::exp(-std::fabs(z[i]));
+            T p = (z[i] > 0) ? T(1) / (T(1) + e) : e / (T(1) + e);
+            sum += std::max(z[i], T(0)) - z[i] * y[i] + std::log1p(e);
+            grad[i] = s * (p - y[i]);
+        }
+        return sum;
+    }
+
+    static T sigmoid_mse(const T* z, const T* y, T s, T* grad, std::size_t n){
+        T sum = 0;
+        for (std::size_t i = 0; i < n; ++i){
+            T e = std::exp(-std::fabs(z[i]));
+            T p = (z[i] > 0) ? T(1) / (T(1) + e) : e / (T(1) + e);
+            T d = p - y[i];
+            sum += d * d;
+            grad[i] = s * d * p * (T(1) - p);
+        }
+        return sum;
+    }
+
+    static void adam_update(T* param, const T* grad, T* m, T* v, const AdamStep<T>& s, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i){
+            T g = grad[i];
+            T mi = s.beta1 * m[i] + s.one_minus_beta1 * g;
+            T vi = s.beta2 * v[i] + s.one_minus_beta2 * g * g;
+            m[i] = mi;
+            v[i] = vi;
+            param[i] = s.decay * param[i] - s.step_size * mi / (std::sqrt(vi) * s.inv_sqrt_correction2 + s.epsilon);
+        }
+    }
+
+    static void sgd_momentum(T* param, const T* grad, T* velocity, const SgdStep<T>& s, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i){
+            T g = grad[i] + s.weight_decay * param[i];
+            T u = s.momentum * velocity[i] + g;
+            velocity[i] = u;
+            param[i] -= s.lr * (s.nesterov ? g + s.momentum * u : u);
+        }
+    }
+
+    static void batchnorm_input_grad(const T* dy_gamma, const T* x_hat,
+                                     const T* sum_dy_gamma, const T* sum_dy_gamma_xhat,
+                                     const T* k, T m, T* out, std::size_t n){
+        for (std::size_t i = 0; i < n; ++i){
+            out[i] = k[i] * (m * dy_gamma[i] - sum_dy_gamma[i] - x_hat[i] * sum_dy_gamma_xhat[i]);
+        }
+    }
+};
+
+template <typename T>
+const KernelTable<T> scalar_table = {
+    Isa::Scalar,
+    &Scalar<T>::add, &Scalar<T>::sub, &Scalar<T>::mul,
+    &Scalar<T>::scale, &Scalar<T>::mul_add, &Scalar<T>::axpy,
+    &Scalar<T>::add_row, &Scalar<T>::sub_row, &Scalar<T>::mul_row,
+    &Scalar<T>::affine_row,
+    &Scalar<T>::relu_forward, &Scalar<T>::relu_backward,
+    &Scalar<T>::relu, &Scalar<T>::relu_backward_output,
+    &Scalar<T>::sigmoid_forward, &Scalar<T>::sigmoid_backward,
+    &Scalar<T>::squared_diff_sum, &Scalar<T>::scaled_diff,
+    &Scalar<T>::bce_logits, &Scalar<T>::sigmoid_mse,
+    &Scalar<T>::adam_update, &Scalar<T>::sgd_momentum,
+    &Scalar<T>::batchnorm_input_grad,
+};
+
+// ---------------------------------------------------------------------------
+// CPU feature detection
+// ---------------------------------------------------------------------------
+
+#ifdef NEURONITE_HAS_CPUID
+// XCR0 tells us which register states the OS saves on context switch;
+// a CPU flag alone is not enough to use the wider registers.
+unsigned long long read_xcr0(){
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+}
+#endif
+
+Isa parse_isa(const char* name, Isa fallback){
+    if (!name) return fallback;
+    if (std::strcmp(name, "scalar") == 0) return Isa::Scalar;
+    if (std::strcmp(name, "sse2") == 0) return Isa::SSE2;
+    if (std::strcmp(name, "avx2") == 0) return Isa::AVX2;
+    if (std::strcmp(name, "avx512") == 0) return Isa::AVX512;
+    return fallback;
+}
+
+template <typename T>
+const KernelTable<T>* select_table(){
+    Isa best = detect_isa();
+    Isa wanted = std::min(best, parse_isa(std::getenv("NEURONITE_ISA"), best));
+
+    // Walk down from the requested ISA to the first one that was compiled in
+    for (int level = static_cast<int>(wanted); level >= 0; --level){
+        if (const KernelTable<T>* t = table_for<T>(static_cast<Isa>(level))) return t;
+    }
+    return &scalar_table<T>;
+}
+
+} // namespace
+
+Isa detect_isa(){
+#ifdef NEURONITE_HAS_CPUID
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return Isa::Scalar;
+
+    bool sse2 = edx & (1u << 26);
+    bool fma = ecx & (1u << 12);
+    bool osxsave = ecx & (1u << 27);
+    bool avx = ecx & (1u << 28);
+
+    bool avx2 = false;
+    bool avx512f = false;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)){
+        avx2 = ebx & (1u << 5);
+        avx512f = ebx & (1u << 16);
+    }
+
+    unsigned long long xcr0 = osxsave ? read_xcr0() : 0;
+    bool ymm_state = (xcr0 & 0x6) == 0x6;      // XMM + YMM
+    bool zmm_state = (xcr0 & 0xe6) == 0xe6;    // + opmask, ZMM_Hi256, Hi16_ZMM
+
+    if (avx512f && avx2 && fma && avx && zmm_state) return Isa::AVX512;
+    if (avx2 && fma && avx && ymm_state) return Isa::AVX2;
+    if (sse2) return Isa::SSE2;
+#endif
+    return Isa::Scalar;
+}
+
+template <typename T>
+const KernelTable<T>* table_for(Isa isa){
+    if (static_cast<int>(isa) > static_cast<int>(detect_isa())) return nullptr;
+    switch (isa){
+        case Isa::Scalar: return &scalar_table<T>;
+        case Isa::SSE2:   return impl::sse2_table<T>();
+        case Isa::AVX2:   return impl::avx2_table<T>();
+        case Isa::AVX512: return impl::avx512_table<T>();
+    }
+    return nullptr;
+}
+
+template <typename T>
+const KernelTable<T>& active(){
+    static const KernelTable<T>* table = select_table<T>();
+    return *table;
+}
+
+const char* isa_name(Isa isa){
+    switch (isa){
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2:   return "sse2";
+        case Isa::AVX2:   return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+template const KernelTable<float>* table_for<float>(Isa);
+template const KernelTable<double>* table_for<double>(Isa);
+template const KernelTable<float>& active<float>();
+template const KernelTable<double>& active<double>();
+
+} // namespace kernels
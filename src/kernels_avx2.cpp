@@ -0,0 +1,113 @@
+#include "kernels_impl.hpp"
+
+// Built with -mavx2 -mfma (see CMakeLists.txt). Only reached after
+// kernels::detect_isa() has confirmed AVX2 and FMA at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__AVX2__) && defined(__FMA__)
+
+#include <immintrin.h>
+
+namespace kernels {
+namespace impl {
+
+namespace {
+
+struct Avx2D {
+    using scalar = double;
+    using reg = __m256d;
+    static constexpr int width = 4;
+
+    static reg load(const double* p){ return _mm256_loadu_pd(p); }
+    static void store(double* p, reg v){ _mm256_storeu_pd(p, v); }
+    static reg set1(double x){ return _mm256_set1_pd(x); }
+    static reg zero(){ return _mm256_setzero_pd(); }
+
+    static reg add(reg a, reg b){ return _mm256_add_pd(a, b); }
+    static reg sub(reg a, reg b){ return _mm256_sub_pd(a, b); }
+    static reg mul(reg a, reg b){ return _mm256_mul_pd(a, b); }
+    static reg div(reg a, reg b){ return _mm256_div_pd(a, b); }
+    static reg min(reg a, reg b){ return _mm256_min_pd(a, b); }
+    static reg max(reg a, reg b){ return _mm256_max_pd(a, b); }
+    static reg sqrt(reg a){ return _mm256_sqrt_pd(a); }
+    static reg fmadd(reg a, reg b, reg c){ return _mm256_fmadd_pd(a, b, c); }
+
+    static reg gt_zero_select(reg x, reg one){
+        return _mm256_and_pd(_mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_GT_OQ), one);
+    }
+
+    static reg pow2n(reg t){
+        __m256i bits = _mm256_add_epi64(_mm256_castpd_si256(t), _mm256_set1_epi64x(1023));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(bits, 52));
+    }
+
+    static double reduce_add(reg v){
+        __m128d lo = _mm256_castpd256_pd128(v);
+        __m128d hi = _mm256_extractf128_pd(v, 1);
+        lo = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo, lo)));
+    }
+};
+
+struct Avx2F {
+    using scalar = float;
+    using reg = __m256;
+    static constexpr int width = 8;
+
+    static reg load(const float* p){ return _mm256_loadu_ps(p); }
+    static void store(float* p, reg v){ _mm256_storeu_ps(p, v); }
+    static reg set1(float x){ return _mm256_set1_ps(x); }
+    static reg zero(){ return _mm256_setzero_ps(); }
+
+    static reg add(reg a, reg b){ return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b){ return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b){ return _mm256_mul_ps(a, b); }
+    static reg div(reg a, reg b){ return _mm256_div_ps(a, b); }
+    static reg min(reg a, reg b){ return _mm256_min_ps(a, b); }
+    static reg max(reg a, reg b){ return _mm256_max_ps(a, b); }
+    static reg sqrt(reg a){ return _mm256_sqrt_ps(a); }
+    static reg fmadd(reg a, reg b, reg c){ return _mm256_fmadd_ps(a, b, c); }
+
+    static reg gt_zero_select(reg x, reg one){
+        return _mm256_and_ps(_mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_GT_OQ), one);
+    }
+
+    static reg pow2n(reg t){
+        __m256i bits = _mm256_add_epi32(_mm256_castps_si256(t), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(bits, 23));
+    }
+
+    static float reduce_add(reg v){
+        __m128 lo = _mm256_castps256_ps128(v);
+        __m128 hi = _mm256_extractf128_ps(v, 1);
+        lo = _mm_add_ps(lo, hi);
+        lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+        return _mm_cvtss_f32(_mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 1)));
+    }
+};
+
+} // namespace
+
+template <>
+const KernelTable<double>* avx2_table<double>(){
+    static const KernelTable<double> table = make_table<Avx2D>(Isa::AVX2);
+    return &table;
+}
+
+template <>
+const KernelTable<float>* avx2_table<float>(){
+    static const KernelTable<float> table = make_table<Avx2F>(Isa::AVX2);
+    return &table;
+}
+
+} // namespace impl
+} // namespace kernels
+
+#else
+
+namespace kernels {
+namespace impl {
+template <> const KernelTable<double>* avx2_table<double>(){ return nullptr; }
+template <> const KernelTable<float>* avx2_table<float>(){ return nullptr; }
+} // namespace impl
+} // namespace kernels
+
+#endif
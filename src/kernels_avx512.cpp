@@ -0,0 +1,104 @@
+#include "kernels_impl.hpp"
+
+// Built with -mavx512f (see CMakeLists.txt). Only reached after
+// kernels::detect_isa() has confirmed AVX-512F at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__AVX512F__)
+
+#include <immintrin.h>
+
+namespace kernels {
+namespace impl {
+
+namespace {
+
+struct Avx512D {
+    using scalar = double;
+    using reg = __m512d;
+    static constexpr int width = 8;
+
+    static reg load(const double* p){ return _mm512_loadu_pd(p); }
+    static void store(double* p, reg v){ _mm512_storeu_pd(p, v); }
+    static reg set1(double x){ return _mm512_set1_pd(x); }
+    static reg zero(){ return _mm512_setzero_pd(); }
+
+    static reg add(reg a, reg b){ return _mm512_add_pd(a, b); }
+    static reg sub(reg a, reg b){ return _mm512_sub_pd(a, b); }
+    static reg mul(reg a, reg b){ return _mm512_mul_pd(a, b); }
+    static reg div(reg a, reg b){ return _mm512_div_pd(a, b); }
+    static reg min(reg a, reg b){ return _mm512_min_pd(a, b); }
+    static reg max(reg a, reg b){ return _mm512_max_pd(a, b); }
+    static reg sqrt(reg a){ return _mm512_sqrt_pd(a); }
+    static reg fmadd(reg a, reg b, reg c){ return _mm512_fmadd_pd(a, b, c); }
+
+    static reg gt_zero_select(reg x, reg one){
+        __mmask8 k = _mm512_cmp_pd_mask(x, _mm512_setzero_pd(), _CMP_GT_OQ);
+        return _mm512_maskz_mov_pd(k, one);
+    }
+
+    static reg pow2n(reg t){
+        __m512i bits = _mm512_add_epi64(_mm512_castpd_si512(t), _mm512_set1_epi64(1023));
+        return _mm512_castsi512_pd(_mm512_slli_epi64(bits, 52));
+    }
+
+    static double reduce_add(reg v){ return _mm512_reduce_add_pd(v); }
+};
+
+struct Avx512F {
+    using scalar = float;
+    using reg = __m512;
+    static constexpr int width = 16;
+
+    static reg load(const float* p){ return _mm512_loadu_ps(p); }
+    static void store(float* p, reg v){ _mm512_storeu_ps(p, v); }
+    static reg set1(float x){ return _mm512_set1_ps(x); }
+    static reg zero(){ return _mm512_setzero_ps(); }
+
+    static reg add(reg a, reg b){ return _mm512_add_ps(a, b); }
+    static reg sub(reg a, reg b){ return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b){ return _mm512_mul_ps(a, b); }
+    static reg div(reg a, reg b){ return _mm512_div_ps(a, b); }
+    static reg min(reg a, reg b){ return _mm512_min_ps(a, b); }
+    static reg max(reg a, reg b){ return _mm512_max_ps(a, b); }
+    static reg sqrt(reg a){ return _mm512_sqrt_ps(a); }
+    static reg fmadd(reg a, reg b, reg c){ return _mm512_fmadd_ps(a, b, c); }
+
+    static reg gt_zero_select(reg x, reg one){
+        __mmask16 k = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ);
+        return _mm512_maskz_mov_ps(k, one);
+    }
+
+    static reg pow2n(reg t){
+        __m512i bits = _mm512_add_epi32(_mm512_castps_si512(t), _mm512_set1_epi32(127));
+        return _mm512_castsi512_ps(_mm512_slli_epi32(bits, 23));
+    }
+
+    static float reduce_add(reg v){ return _mm512_reduce_add_ps(v); }
+};
+
+} // namespace
+
+template <>
+const KernelTable<double>* avx512_table<double>(){
+    static const KernelTable<double> table = make_table<Avx512D>(Isa::AVX512);
+    return &table;
+}
+
+template <>
+const KernelTable<float>* avx512_table<float>(){
+    static const KernelTable<float> table = make_table<Avx512F>(Isa::AVX512);
+    return &table;
+}
+
+} // namespace impl
+} // namespace kernels
+
+#else
+
+namespace kernels {
+namespace impl {
+template <> const KernelTable<double>* avx512_table<double>(){ return nullptr; }
+template <> const KernelTable<float>* avx512_table<float>(){ return nullptr; }
+} // namespace impl
+} // namespace kernels
+
+#endif
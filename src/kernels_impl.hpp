@@ -0,0 +1,522 @@
+#ifndef KERNELS_IMPL_HPP
+#define KERNELS_IMPL_HPP
+
+// Generic bodies of the vectorized kernels.
+//
+// Each ISA translation unit (kernels_sse2.cpp, kernels_avx2.cpp,
+// kernels_avx512.cpp) is compiled with its own -m flags, defines a traits
+// struct V wrapping that ISA's intrinsics, and instantiates
+// make_table<V>() once per scalar type. V provides:
+//
+//   using scalar; using reg; static constexpr int width;
+//   load, store, set1, zero, add, sub, mul, div, min, max, sqrt, fmadd (a*b+c),
+//   gt_zero_select(x, one)  -> one where x > 0, else 0
+//   pow2n(t)                -> 2^n, where t = n + ExpConstants::magic (see vexp)
+//   reduce_add(v)           -> horizontal sum
+//
+// Tails shorter than one register are run through a zero-padded stack
+// buffer so that every element sees exactly the same arithmetic.
+
+#include "kernel_table.hpp"
+#include <cstring>
+
+namespace kernels {
+namespace impl {
+
+// Per-ISA tables, defined in kernels_<isa>.cpp. Each returns nullptr when
+// the target is not x86 and the ISA was not compiled in.
+template <typename T> const KernelTable<T>* sse2_table();
+template <typename T> const KernelTable<T>* avx2_table();
+template <typename T> const KernelTable<T>* avx512_table();
+
+template <class V>
+using S = typename V::scalar;
+
+template <class V>
+using R = typename V::reg;
+
+// ---------------------------------------------------------------------------
+// Span drivers
+// ---------------------------------------------------------------------------
+
+template <class V, class F>
+inline void map1(const S<V>* a, S<V>* out, std::size_t n, F f){
+    constexpr int W = V::width;
+    std::size_t i = 0;
+    for (; i + W <= n; i += W){
+        V::store(out + i, f(V::load(a + i)));
+    }
+    if (i < n){
+        std::size_t rem = n - i;
+        alignas(64) S<V> ta[W] = {};
+        alignas(64) S<V> to[W];
+        std::memcpy(ta, a + i, rem * sizeof(S<V>));
+        V::store(to, f(V::load(ta)));
+        std::memcpy(out + i, to, rem * sizeof(S<V>));
+    }
+}
+
+template <class V, class F>
+inline void map2(const S<V>* a, const S<V>* b, S<V>* out, std::size_t n, F f){
+    constexpr int W = V::width;
+    std::size_t i = 0;
+    for (; i + W <= n; i += W){
+        V::store(out + i, f(V::load(a + i), V::load(b + i)));
+    }
+    if (i < n){
+        std::size_t rem = n - i;
+        alignas(64) S<V> ta[W] = {};
+        alignas(64) S<V> tb[W] = {};
+        alignas(64) S<V> to[W];
+        std::memcpy(ta, a + i, rem * sizeof(S<V>));
+        std::memcpy(tb, b + i, rem * sizeof(S<V>));
+        V::store(to, f(V::load(ta), V::load(tb)));
+        std::memcpy(out + i, to, rem * sizeof(S<V>));
+    }
+}
+
+template <class V, class F>
+inline void map3(const S<V>* a, const S<V>* b, const S<V>* c, S<V>* out, std::size_t n, F f){
+    constexpr int W = V::width;
+    std::size_t i = 0;
+    for (; i + W <= n; i += W){
+        V::store(out + i, f(V::load(a + i), V::load(b + i), V::load(c + i)));
+    }
+    if (i < n){
+        std::size_t rem = n - i;
+        alignas(64) S<V> ta[W] = {};
+        alignas(64) S<V> tb[W] = {};
+        alignas(64) S<V> tc[W] = {};
+        alignas(64) S<V> to[W];
+        std::memcpy(ta, a + i, rem * sizeof(S<V>));
+        std::memcpy(tb, b + i, rem * sizeof(S<V>));
+        std::memcpy(tc, c + i, rem * sizeof(S<V>));
+        V::store(to, f(V::load(ta), V::load(tb), V::load(tc)));
+        std::memcpy(out + i, to, rem * sizeof(S<V>));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// exp(x)
+// ---------------------------------------------------------------------------
+
+// Cody-Waite range reduction x = n·ln2 + r, |r| <= ln2/2, followed by a
+// Taylor polynomial for e^r and a 2^n scale built directly in the exponent
+// bits. The "magic" constant rounds x·log2(e) to an integer in the low
+// mantissa bits of t, which pow2n shifts into the exponent field.
+template <typename T> struct ExpConstants;
+
+template <> struct ExpConstants<double> {
+    static constexpr double lo = -708.0;
+    static constexpr double hi = 709.0;
+    static constexpr double log2e = 1.4426950408889634074;
+    static constexpr double ln2_hi = 0.693145751953125;
+    static constexpr double ln2_lo = 1.42860682030941723212e-6;
+    static constexpr double magic = 6755399441055744.0;  // 1.5 · 2^52
+    static constexpr int degree = 13;
+};
+
+template <> struct ExpConstants<float> {
+    static constexpr float lo = -87.0f;
+    static constexpr float hi = 88.0f;
+    static constexpr float log2e = 1.44269504088896341f;
+    static constexpr float ln2_hi = 0.693359375f;
+    static constexpr float ln2_lo = -2.12194440e-4f;
+    static constexpr float magic = 12582912.0f;  // 1.5 · 2^23
+    static constexpr int degree = 7;
+};
+
+// 1/k! for k = 0..N, folded at compile time
+template <typename T, int N>
+struct InvFactorials {
+    T v[N + 1];
+    constexpr InvFactorials() : v(){
+        T f = 1;
+        for (int k = 0; k <= N; ++k){
+            if (k > 0) f /= k;
+            v[k] = f;
+        }
+    }
+};
+
+template <class V>
+inline R<V> vexp(R<V> x){
+    using T = S<V>;
+    using C = ExpConstants<T>;
+
+    // min/max return their second operand on NaN, so keep x second to let
+    // NaN propagate instead of being clamped to a finite value
+    x = V::min(V::set1(C::hi), V::max(V::set1(C::lo), x));
+
+    R<V> t = V::fmadd(x, V::set1(C::log2e), V::set1(C::magic));
+    R<V> n = V::sub(t, V::set1(C::magic));
+    R<V> r = V::fmadd(n, V::set1(-C::ln2_hi), x);
+    r = V::fmadd(n, V::set1(-C::ln2_lo), r);
+
+    // Horner evaluation of Σ r^k / k!
+    static constexpr InvFactorials<T, C::degree> coeff{};
+    R<V> p = V::set1(coeff.v[C::degree]);
+    for (int k = C::degree - 1; k >= 0; --k){
+        p = V::fmadd(p, r, V::set1(coeff.v[k]));
+    }
+
+    return V::mul(p, V::pow2n(t));
+}
+
+// ---------------------------------------------------------------------------
+// log(1 + u) for u in [0, 1]
+// ---------------------------------------------------------------------------
+
+// log(1 + u) = 2·atanh(s) with s = u / (2 + u) in [0, 1/3], summed as the
+// odd series 2·(s + s³/3 + s⁵/5 + ...). Each term shrinks by at least 9×,
+// so a fixed number of terms reaches full precision without any
+// exponent-bit manipulation.
+template <typename T> struct Log1pTerms;
+template <> struct Log1pTerms<double> { static constexpr int count = 17; };
+template <> struct Log1pTerms<float>  { static constexpr int count = 8; };
+
+template <class V>
+inline R<V> vlog1p_unit(R<V> u){
+    using T = S<V>;
+    constexpr int N = Log1pTerms<T>::count;
+    R<V> s = V::div(u, V::add(V::set1(T(2)), u));
+    R<V> s2 = V::mul(s, s);
+    // Horner over s² of Σ s^(2k) / (2k + 1)
+    R<V> p = V::set1(T(1) / (2 * (N - 1) + 1));
+    for (int k = N - 2; k >= 0; --k){
+        p = V::fmadd(p, s2, V::set1(T(1) / (2 * k + 1)));
+    }
+    return V::mul(V::mul(V::set1(T(2)), s), p);
+}
+
+// ---------------------------------------------------------------------------
+// Kernels
+// ---------------------------------------------------------------------------
+
+template <class V>
+struct Ops {
+    using T = S<V>;
+
+    static void add(const T* a, const T* b, T* out, std::size_t n){
+        map2<V>(a, b, out, n, [](R<V> x, R<V> y){ return V::add(x, y); });
+    }
+
+    static void sub(const T* a, const T* b, T* out, std::size_t n){
+        map2<V>(a, b, out, n, [](R<V> x, R<V> y){ return V::sub(x, y); });
+    }
+
+    static void mul(const T* a, const T* b, T* out, std::size_t n){
+        map2<V>(a, b, out, n, [](R<V> x, R<V> y){ return V::mul(x, y); });
+    }
+
+    static void scale(const T* a, T s, T* out, std::size_t n){
+        R<V> vs = V::set1(s);
+        map1<V>(a, out, n, [vs](R<V> x){ return V::mul(x, vs); });
+    }
+
+    static void mul_add(const T* a, const T* b, T* out, std::size_t n){
+        map3<V>(a, b, out, out, n, [](R<V> x, R<V> y, R<V> acc){ return V::fmadd(x, y, acc); });
+    }
+
+    static void axpy(const T* a, T alpha, T* out, std::size_t n){
+        R<V> va = V::set1(alpha);
+        map2<V>(a, out, out, n, [va](R<V> x, R<V> acc){ return V::fmadd(va, x, acc); });
+    }
+
+    // The broadcast row is re-read from L1 for every row of the block, so
+    // these stay a plain row loop over the contiguous kernels above.
+    static void add_row(const T* a, int lda, const T* row, T* out, int ldo, int rows, int cols){
+        for (int i = 0; i < rows; ++i)
+            add(a + static_cast<std::size_t>(i) * lda, row, out + static_cast<std::size_t>(i) * ldo, cols);
+    }
+
+    static void sub_row(const T* a, int lda, const T* row, T* out, int ldo, int rows, int cols){
+        for (int i = 0; i < rows; ++i)
+            sub(a + static_cast<std::size_t>(i) * lda, row, out + static_cast<std::size_t>(i) * ldo, cols);
+    }
+
+    static void mul_row(const T* a, int lda, const T* row, T* out, int ldo, int rows, int cols){
+        for (int i = 0; i < rows; ++i)
+            mul(a + static_cast<std::size_t>(i) * lda, row, out + static_cast<std::size_t>(i) * ldo, cols);
+    }
+
+    static void affine_row(const T* a, int lda, const T* scale_row, const T* shift_row,
+                           T* out, int ldo, int rows, int cols){
+        for (int i = 0; i < rows; ++i){
+            map3<V>(a + static_cast<std::size_t>(i) * lda, scale_row, shift_row,
+                    out + static_cast<std::size_t>(i) * ldo, cols,
+                    [](R<V> x, R<V> s, R<V> b){ return V::fmadd(x, s, b); });
+        }
+    }
+
+    // Single pass over x writing both the output and the mask
+    static void relu_forward(const T* x, T* y, T* mask, std::size_t n){
+        constexpr int W = V::width;
+        const R<V> zero = V::zero();
+        const R<V> one = V::set1(T(1));
+        std::size_t i = 0;
+        for (; i + W <= n; i += W){
+            R<V> v = V::load(x + i);
+            V::store(y + i, V::max(v, zero));
+            V::store(mask + i, V::gt_zero_select(v, one));
+        }
+        if (i < n){
+            std::size_t rem = n - i;
+            alignas(64) T tx[W] = {};
+            alignas(64) T ty[W];
+            alignas(64) T tm[W];
+            std::memcpy(tx, x + i, rem * sizeof(T));
+            R<V> v = V::load(tx);
+            V::store(ty, V::max(v, zero));
+            V::store(tm, V::gt_zero_select(v, one));
+            std::memcpy(y + i, ty, rem * sizeof(T));
+            std::memcpy(mask + i, tm, rem * sizeof(T));
+        }
+    }
+
+    static void relu_backward(const T* grad, const T* mask, T* out, std::size_t n){
+        mul(grad, mask, out, n);
+    }
+
+    static void relu(const T* x, T* y, std::size_t n){
+        const R<V> zero = V::zero();
+        map1<V>(x, y, n, [zero](R<V> v){ return V::max(v, zero); });
+    }
+
+    static void relu_backward_output(const T* grad, const T* y, T* out, std::size_t n){
+        const R<V> one = V::set1(T(1));
+        map2<V>(grad, y, out, n, [one](R<V> g, R<V> s){
+            return V::mul(g, V::gt_zero_select(s, one));
+        });
+    }
+
+    static void sigmoid_forward(const T* x, T* y, std::size_t n){
+        const R<V> one = V::set1(T(1));
+        map1<V>(x, y, n, [one](R<V> v){
+            R<V> e = vexp<V>(V::sub(V::zero(), v));
+            return V::div(one, V::add(one, e));
+        });
+    }
+
+    static void sigmoid_backward(const T* grad, const T* y, T* out, std::size_t n){
+        const R<V> one = V::set1(T(1));
+        map2<V>(grad, y, out, n, [one](R<V> g, R<V> s){
+            return V::mul(V::mul(g, s), V::sub(one, s));
+        });
+    }
+
+    static T squared_diff_sum(const T* a, const T* b, std::size_t n){
+        constexpr int W = V::width;
+        R<V> acc0 = V::zero();
+        R<V> acc1 = V::zero();
+        std::size_t i = 0;
+        for (; i + 2 * W <= n; i += 2 * W){
+            R<V> d0 = V::sub(V::load(a + i), V::load(b + i));
+            R<V> d1 = V::sub(V::load(a + i + W), V::load(b + i + W));
+            acc0 = V::fmadd(d0, d0, acc0);
+            acc1 = V::fmadd(d1, d1, acc1);
+        }
+        for (; i + W <= n; i += W){
+            R<V> d = V::sub(V::load(a + i), V::load(b + i));
+            acc0 = V::fmadd(d, d, acc0);
+        }
+        if (i < n){
+            alignas(64) T ta[W] = {};
+            alignas(64) T tb[W] = {};
+            std::memcpy(ta, a + i, (n - i) * sizeof(T));
+            std::memcpy(tb, b + i, (n - i) * sizeof(T));
+            R<V> d = V::sub(V::load(ta), V::load(tb));
+            acc1 = V::fmadd(d, d, acc1);
+        }
+        return V::reduce_add(V::add(acc0, acc1));
+    }
+
+    static void scaled_diff(const T* a, const T* b, T s, T* out, std::size_t n){
+        R<V> vs = V::set1(s);
+        map2<V>(a, b, out, n, [vs](R<V> x, R<V> y){ return V::mul(vs, V::sub(x, y)); });
+    }
+
+    // Shared driver of the fused logit losses: body(z, y, p, e, g) gets
+    // σ(z) = p and e = e^(-|z|), stores the gradient lanes in g and returns
+    // the loss lanes. Padded tail lanes are left out of the sum.
+    template <class F>
+    static T logit_loss(const T* z, const T* y, T* grad, std::size_t n, F body){
+        constexpr int W = V::width;
+        const R<V> one = V::set1(T(1));
+        auto eval = [&](R<V> vz, R<V> vy, R<V>& g){
+            R<V> e = vexp<V>(V::sub(V::zero(), V::max(vz, V::sub(V::zero(), vz))));
+            // σ(z) = 1 / (1 + e) for z > 0, e / (1 + e) otherwise
+            R<V> num = V::fmadd(V::gt_zero_select(vz, one), V::sub(one, e), e);
+            R<V> p = V::div(num, V::add(one, e));
+            return body(vz, vy, p, e, g);
+        };
+        R<V> acc = V::zero();
+        std::size_t i = 0;
+        for (; i + W <= n; i += W){
+            R<V> g;
+            acc = V::add(acc, eval(V::load(z + i), V::load(y + i), g));
+            V::store(grad + i, g);
+        }
+        T sum = V::reduce_add(acc);
+        if (i < n){
+            std::size_t rem = n - i;
+            alignas(64) T tz[W] = {};
+            alignas(64) T ty[W] = {};
+            alignas(64) T tl[W];
+            alignas(64) T tg[W];
+            std::memcpy(tz, z + i, rem * sizeof(T));
+            std::memcpy(ty, y + i, rem * sizeof(T));
+            R<V> g;
+            V::store(tl, eval(V::load(tz), V::load(ty), g));
+            V::store(tg, g);
+            for (std::size_t j = 0; j < rem; ++j) sum += tl[j];
+            std::memcpy(grad + i, tg, rem * sizeof(T));
+        }
+        return sum;
+    }
+
+    static T bce_logits(const T* z, const T* y, T s, T* grad, std::size_t n){
+        const R<V> vs = V::set1(s);
+        return logit_loss(z, y, grad, n, [vs](R<V> vz, R<V> vy, R<V> p, R<V> e, R<V>& g){
+            g = V::mul(vs, V::sub(p, vy));
+            // max(z, 0) - z·y + log(1 + e^(-|z|))
+            R<V> l = V::sub(V::max(vz, V::zero()), V::mul(vz, vy));
+            return V::add(l, vlog1p_unit<V>(e));
+        });
+    }
+
+    static T sigmoid_mse(const T* z, const T* y, T s, T* grad, std::size_t n){
+        const R<V> vs = V::set1(s);
+        const R<V> one = V::set1(T(1));
+        return logit_loss(z, y, grad, n, [vs, one](R<V>, R<V> vy, R<V> p, R<V>, R<V>& g){
+            R<V> d = V::sub(p, vy);
+            g = V::mul(V::mul(vs, d), V::mul(p, V::sub(one, p)));
+            return V::mul(d, d);
+        });
+    }
+
+    // Loads g, m, v and θ once per lane and stores m, v and θ once. Tails go
+    // through padded stack buffers; zero padding is harmless since ε > 0.
+    static void adam_update(T* param, const T* grad, T* m, T* v, const AdamStep<T>& s, std::size_t n){
+        constexpr int W = V::width;
+        const R<V> b1 = V::set1(s.beta1), c1 = V::set1(s.one_minus_beta1);
+        const R<V> b2 = V::set1(s.beta2), c2 = V::set1(s.one_minus_beta2);
+        const R<V> step = V::set1(s.step_size), inv_c2 = V::set1(s.inv_sqrt_correction2);
+        const R<V> eps = V::set1(s.epsilon), decay = V::set1(s.decay);
+        auto body = [&](T* p, const T* g, T* mp, T* vp){
+            R<V> vg = V::load(g);
+            R<V> vm = V::fmadd(b1, V::load(mp), V::mul(c1, vg));
+            R<V> vv = V::fmadd(b2, V::load(vp), V::mul(c2, V::mul(vg, vg)));
+            V::store(mp, vm);
+            V::store(vp, vv);
+            R<V> denom = V::fmadd(V::sqrt(vv), inv_c2, eps);
+            V::store(p, V::sub(V::mul(decay, V::load(p)), V::div(V::mul(step, vm), denom)));
+        };
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) body(param + i, grad + i, m + i, v + i);
+        if (i < n){
+            std::size_t rem = n - i;
+            alignas(64) T tp[W] = {}, tg[W] = {}, tm[W] = {}, tv[W] = {};
+            std::memcpy(tp, param + i, rem * sizeof(T));
+            std::memcpy(tg, grad + i, rem * sizeof(T));
+            std::memcpy(tm, m + i, rem * sizeof(T));
+            std::memcpy(tv, v + i, rem * sizeof(T));
+            body(tp, tg, tm, tv);
+            std::memcpy(param + i, tp, rem * sizeof(T));
+            std::memcpy(m + i, tm, rem * sizeof(T));
+            std::memcpy(v + i, tv, rem * sizeof(T));
+        }
+    }
+
+    static void sgd_momentum(T* param, const T* grad, T* velocity, const SgdStep<T>& s, std::size_t n){
+        constexpr int W = V::width;
+        const R<V> lr = V::set1(s.lr), mu = V::set1(s.momentum), wd = V::set1(s.weight_decay);
+        const bool nesterov = s.nesterov;
+        auto body = [&](T* p, const T* g, T* up){
+            R<V> vp = V::load(p);
+            R<V> vg = V::fmadd(wd, vp, V::load(g));
+            R<V> vu = V::fmadd(mu, V::load(up), vg);
+            V::store(up, vu);
+            R<V> step = nesterov ? V::fmadd(mu, vu, vg) : vu;
+            V::store(p, V::sub(vp, V::mul(lr, step)));
+        };
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) body(param + i, grad + i, velocity + i);
+        if (i < n){
+            std::size_t rem = n - i;
+            alignas(64) T tp[W] = {}, tg[W] = {}, tu[W] = {};
+            std::memcpy(tp, param + i, rem * sizeof(T));
+            std::memcpy(tg, grad + i, rem * sizeof(T));
+            std::memcpy(tu, velocity + i, rem * sizeof(T));
+            body(tp, tg, tu);
+            std::memcpy(param + i, tp, rem * sizeof(T));
+            std::memcpy(velocity + i, tu, rem * sizeof(T));
+        }
+    }
+
+    static void batchnorm_input_grad(const T* dy_gamma, const T* x_hat,
+                                     const T* sum_dy_gamma, const T* sum_dy_gamma_xhat,
+                                     const T* k, T m, T* out, std::size_t n){
+        constexpr int W = V::width;
+        const R<V> vm = V::set1(m);
+        auto body = [vm](R<V> dyg, R<V> xh, R<V> s1, R<V> s2, R<V> kk){
+            R<V> t = V::sub(V::mul(vm, dyg), s1);
+            t = V::sub(t, V::mul(xh, s2));
+            return V::mul(kk, t);
+        };
+        std::size_t i = 0;
+        for (; i + W <= n; i += W){
+            V::store(out + i, body(V::load(dy_gamma + i), V::load(x_hat + i),
+                                   V::load(sum_dy_gamma + i), V::load(sum_dy_gamma_xhat + i),
+                                   V::load(k + i)));
+        }
+        if (i < n){
+            std::size_t rem = n - i;
+            alignas(64) T t0[W] = {}, t1[W] = {}, t2[W] = {}, t3[W] = {}, t4[W] = {};
+            alignas(64) T to[W];
+            std::memcpy(t0, dy_gamma + i, rem * sizeof(T));
+            std::memcpy(t1, x_hat + i, rem * sizeof(T));
+            std::memcpy(t2, sum_dy_gamma + i, rem * sizeof(T));
+            std::memcpy(t3, sum_dy_gamma_xhat + i, rem * sizeof(T));
+            std::memcpy(t4, k + i, rem * sizeof(T));
+            V::store(to, body(V::load(t0), V::load(t1), V::load(t2), V::load(t3), V::load(t4)));
+            std::memcpy(out + i, to, rem * sizeof(T));
+        }
+    }
+};
+
+template <class V>
+KernelTable<S<V>> make_table(Isa isa){
+    using O = Ops<V>;
+    KernelTable<S<V>> t;
+    t.isa = isa;
+    t.add = &O::add;
+    t.sub = &O::sub;
+    t.mul = &O::mul;
+    t.scale = &O::scale;
+    t.mul_add = &O::mul_add;
+    t.axpy = &O::axpy;
+    t.add_row = &O::add_row;
+    t.sub_row = &O::sub_row;
+    t.mul_row = &O::mul_row;
+    t.affine_row = &O::affine_row;
+    t.relu_forward = &O::relu_forward;
+    t.relu_backward = &O::relu_backward;
+    t.relu = &O::relu;
+    t.relu_backward_output = &O::relu_backward_output;
+    t.sigmoid_forward = &O::sigmoid_forward;
+    t.sigmoid_backward = &O::sigmoid_backward;
+    t.squared_diff_sum = &O::squared_diff_sum;
+    t.scaled_diff = &O::scaled_diff;
+    t.bce_logits = &O::bce_logits;
+    t.sigmoid_mse = &O::sigmoid_mse;
+    t.adam_update = &O::adam_update;
+    t.sgd_momentum = &O::sgd_momentum;
+    t.batchnorm_input_grad = &O::batchnorm_input_grad;
+    return t;
+}
+
+} // namespace impl
+} // namespace kernels
+
+#endif
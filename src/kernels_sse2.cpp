@@ -0,0 +1,109 @@
+#include "kernels_impl.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <emmintrin.h>
+
+namespace kernels {
+namespace impl {
+
+namespace {
+
+struct Sse2D {
+    using scalar = double;
+    using reg = __m128d;
+    static constexpr int width = 2;
+
+    static reg load(const double* p){ return _mm_loadu_pd(p); }
+    static void store(double* p, reg v){ _mm_storeu_pd(p, v); }
+    static reg set1(double x){ return _mm_set1_pd(x); }
+    static reg zero(){ return _mm_setzero_pd(); }
+
+    static reg add(reg a, reg b){ return _mm_add_pd(a, b); }
+    static reg sub(reg a, reg b){ return _mm_sub_pd(a, b); }
+    static reg mul(reg a, reg b){ return _mm_mul_pd(a, b); }
+    static reg div(reg a, reg b){ return _mm_div_pd(a, b); }
+    static reg min(reg a, reg b){ return _mm_min_pd(a, b); }
+    static reg max(reg a, reg b){ return _mm_max_pd(a, b); }
+    static reg sqrt(reg a){ return _mm_sqrt_pd(a); }
+
+    // No FMA before AVX2: separate multiply and add
+    static reg fmadd(reg a, reg b, reg c){ return _mm_add_pd(_mm_mul_pd(a, b), c); }
+
+    static reg gt_zero_select(reg x, reg one){
+        return _mm_and_pd(_mm_cmpgt_pd(x, _mm_setzero_pd()), one);
+    }
+
+    static reg pow2n(reg t){
+        __m128i bits = _mm_add_epi64(_mm_castpd_si128(t), _mm_set1_epi64x(1023));
+        return _mm_castsi128_pd(_mm_slli_epi64(bits, 52));
+    }
+
+    static double reduce_add(reg v){
+        return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+    }
+};
+
+struct Sse2F {
+    using scalar = float;
+    using reg = __m128;
+    static constexpr int width = 4;
+
+    static reg load(const float* p){ return _mm_loadu_ps(p); }
+    static void store(float* p, reg v){ _mm_storeu_ps(p, v); }
+    static reg set1(float x){ return _mm_set1_ps(x); }
+    static reg zero(){ return _mm_setzero_ps(); }
+
+    static reg add(reg a, reg b){ return _mm_add_ps(a, b); }
+    static reg sub(reg a, reg b){ return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b){ return _mm_mul_ps(a, b); }
+    static reg div(reg a, reg b){ return _mm_div_ps(a, b); }
+    static reg min(reg a, reg b){ return _mm_min_ps(a, b); }
+    static reg max(reg a, reg b){ return _mm_max_ps(a, b); }
+    static reg sqrt(reg a){ return _mm_sqrt_ps(a); }
+    static reg fmadd(reg a, reg b, reg c){ return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+    static reg gt_zero_select(reg x, reg one){
+        return _mm_and_ps(_mm_cmpgt_ps(x, _mm_setzero_ps()), one);
+    }
+
+    static reg pow2n(reg t){
+        __m128i bits = _mm_add_epi32(_mm_castps_si128(t), _mm_set1_epi32(127));
+        return _mm_castsi128_ps(_mm_slli_epi32(bits, 23));
+    }
+
+    static float reduce_add(reg v){
+        __m128 hi = _mm_movehl_ps(v, v);
+        __m128 sum = _mm_add_ps(v, hi);
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum);
+    }
+};
+
+} // namespace
+
+template <>
+const KernelTable<double>* sse2_table<double>(){
+    static const KernelTable<double> table = make_table<Sse2D>(Isa::SSE2);
+    return &table;
+}
+
+template <>
+const KernelTable<float>* sse2_table<float>(){
+    static const KernelTable<float> table = make_table<Sse2F>(Isa::SSE2);
+    return &table;
+}
+
+} // namespace impl
+} // namespace kernels
+
+#else
+
+namespace kernels {
+namespace impl {
+template <> const KernelTable<double>* sse2_table<double>(){ return nullptr; }
+template <> const KernelTable<float>* sse2_table<float>(){ return nullptr; }
+} // namespace impl
+} // namespace kernels
+
+#endif
@@ -0,0 +1,40 @@
+#include "layer.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "activation_sigmoid.hpp"
+#include "dropout.hpp"
+#include "batch_norm.hpp"
+#include <stdexcept>
+
+template <typename T>
+std::unique_ptr<Layer<T>> make_layer(const LayerSpec& spec){
+    bool dense = spec.kind == LayerKind::Dense || spec.kind == LayerKind::FusedDense;
+    if ((dense || spec.kind == LayerKind::BatchNorm) && (spec.input_dim <= 0 || spec.output_dim <= 0)){
+        throw std::invalid_argument("make_layer: Invalid layer dimensions");
+    }
+
+    switch (spec.kind){
+        case LayerKind::Dense:
+            return std::make_unique<DenseLayer<T>>(spec.input_dim, spec.output_dim, DeferInit{});
+        case LayerKind::FusedDense:
+            if (spec.activation > static_cast<std::uint32_t>(Activation::Sigmoid)){
+                throw std::invalid_argument("make_layer: Unknown activation");
+            }
+            return std::make_unique<FusedDenseLayer<T>>(spec.input_dim, spec.output_dim,
+                                                        static_cast<Activation>(spec.activation), DeferInit{});
+        case LayerKind::ReLU:
+            return std::make_unique<ActivationReLU<T>>();
+        case LayerKind::Sigmoid:
+            return std::make_unique<ActivationSigmoid<T>>();
+        case LayerKind::Dropout:
+            return std::make_unique<Dropout<T>>(spec.value);
+        case LayerKind::BatchNorm:
+            return std::make_unique<BatchNorm<T>>(spec.input_dim, spec.output_dim);
+        default:
+            throw std::invalid_argument("make_layer: Unknown layer type");
+    }
+}
+
+template std::unique_ptr<Layer<float>> make_layer<float>(const LayerSpec&);
+template std::unique_ptr<Layer<double>> make_layer<double>(const LayerSpec&);
@@ -0,0 +1,77 @@
+#include "loss_logits.hpp"
+#include "kernels.hpp"
+#include <stdexcept>
+#include <utility>
+
+/// Forward pass: loss and ∂L/∂z in one sweep over the logits and targets
+///
+/// The gradient is written to grad_cache, which is reused from step to
+/// step, and handed out by the next backward_into call.
+template <typename T>
+double LogitLoss<T>::forward(const Matrix<T>& logits, const Matrix<T>& target){
+    if (logits.rows != target.rows || logits.cols != target.cols){
+        throw std::invalid_argument("LogitLoss::forward: Shape mismatch");
+    }
+
+    grad_cache.resize(logits.rows, logits.cols);
+
+    int total_elements = logits.rows * logits.cols;
+    T s = grad_scale(total_elements) * this->gradient_scale;
+    Kernel fused = kernel();
+
+    double loss = 0.0;
+    if (logits.is_contiguous() && target.is_contiguous()){
+        loss = fused(logits.data(), target.data(), s, grad_cache.data(), logits.size());
+    }else{
+        for (int i = 0; i < logits.rows; ++i){
+            loss += fused(logits.row(i), target.row(i), s, grad_cache.row(i), logits.cols);
+        }
+    }
+
+    grad_ready = true;
+    return loss / total_elements;
+}
+
+/// Backward pass: returns the gradient computed by the last forward
+///
+/// An owning `grad` trades buffers with grad_cache, so after the first
+/// couple of steps both are warm and nothing is copied or allocated.
+template <typename T>
+void LogitLoss<T>::backward_into(Matrix<T>& grad){
+    if (!grad_ready){
+        throw std::invalid_argument("LogitLoss::backward: forward must be called first");
+    }
+    if (grad.owns_data()){
+        std::swap(grad, grad_cache);
+    }else{
+        grad = grad_cache;
+    }
+    grad_ready = false;
+}
+
+template <typename T>
+typename LogitLoss<T>::Kernel LossBCEWithLogits<T>::kernel() const {
+    return kernels::active<T>().bce_logits;
+}
+
+template <typename T>
+T LossBCEWithLogits<T>::grad_scale(int count) const {
+    return T(1) / count;
+}
+
+template <typename T>
+typename LogitLoss<T>::Kernel LossSigmoidMSE<T>::kernel() const {
+    return kernels::active<T>().sigmoid_mse;
+}
+
+template <typename T>
+T LossSigmoidMSE<T>::grad_scale(int count) const {
+    return T(2) / count;
+}
+
+template class LogitLoss<float>;
+template class LogitLoss<double>;
+template class LossBCEWithLogits<float>;
+template class LossBCEWithLogits<double>;
+template class LossSigmoidMSE<float>;
+template class LossSigmoidMSE<double>;
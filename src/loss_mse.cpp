@@ -1,5 +1,6 @@
 #include "matrix.hpp"
 #include "loss_mse.hpp"
+#include "kernels.hpp"
 #include <cmath>
 
 /// Forward pass for Mean Squared Error (MSE) loss
@@ -9,21 +10,26 @@
 ///     y_pred = predicted output
 ///     y_true = ground truth (target)
 ///
-/// Also caches the prediction and target for use in the backward pass.
-double LossMSE::forward(const Matrix& prediction, const Matrix& target){
+/// Also keeps references to the prediction and target for use in the
+/// backward pass.
+template <typename T>
+double LossMSE<T>::forward(const Matrix<T>& prediction, const Matrix<T>& target){
 
     if(prediction.rows!=target.rows || prediction.cols!=target.cols){
         throw std::invalid_argument("LossMSE::forward: Shape mismatch");
     }
 
-    prediction_cache = prediction;
-    target_cache = target;
+    prediction_cache = &prediction;
+    target_cache = &target;
 
     double loss = 0.0;
+    const kernels::KernelTable<T>& k = kernels::active<T>();
 
-    for(int i=0;i<prediction.rows;++i){
-        for(int j=0;j<target.cols;++j){
-            loss += std::pow(prediction.data[i][j] - target.data[i][j],2);
+    if (prediction.is_contiguous() && target.is_contiguous()){
+        loss = k.squared_diff_sum(prediction.data(), target.data(), prediction.size());
+    }else{
+        for(int i=0;i<prediction.rows;++i){
+            loss += k.squared_diff_sum(prediction.row(i), target.row(i), prediction.cols);
         }
     }
 
@@ -38,18 +44,28 @@ double LossMSE::forward(const Matrix& prediction, const Matrix& target){
 ///
 /// Gradient of MSE with respect to prediction:
 ///     dL/dy_pred = (2 / n) * (y_pred - y_true)
+/// times the gradient scale, folded into the same factor
 ///
-/// Returns matrix of gradients with the same shape as the prediction
-Matrix LossMSE::backward(){
-    Matrix grad_input = Matrix(prediction_cache.rows, prediction_cache.cols);
+/// Writes a matrix of gradients with the same shape as the prediction
+template <typename T>
+void LossMSE<T>::backward_into(Matrix<T>& grad_input){
+    if (!prediction_cache){
+        throw std::invalid_argument("LossMSE::backward: forward must be called first");
+    }
+    const Matrix<T>& prediction = *prediction_cache;
+    const Matrix<T>& target = *target_cache;
 
-    int total_elements = prediction_cache.rows*prediction_cache.cols;
+    grad_input.resize(prediction.rows, prediction.cols);
 
-    for(int i=0;i<grad_input.rows;++i){
-        for(int j=0;j<grad_input.cols;++j){
-            grad_input.data[i][j] = (2.0/total_elements)*(prediction_cache.data[i][j]-target_cache.data[i][j]);
-        }
-    }
+    int total_elements = prediction.rows*prediction.cols;
+
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(prediction.is_contiguous() && target.is_contiguous(),
+                           prediction.rows, prediction.cols, [&](int i, std::size_t n){
+        k.scaled_diff(prediction.row(i), target.row(i), 2.0/total_elements*this->gradient_scale,
+                      grad_input.row(i), n);
+    });
+}
 
-    return grad_input;
-}
\ No newline at end of file
+template class LossMSE<float>;
+template class LossMSE<double>;
@@ -1,153 +1,488 @@
 #include <matrix.hpp>
+#include "aligned_memory.hpp"
+#include "profiler.hpp"
+#include "kernels.hpp"
+#include "thread_pool.hpp"
 #include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
-Matrix::Matrix():rows(0),cols(0),data() {}
+template <typename T>
+Matrix<T>::Matrix():rows(0),cols(0),stride(0),ptr(nullptr),capacity(0),owning(true) {}
 
-Matrix::Matrix(int rows, int cols)
-    : rows(rows), cols(cols), data(rows, std::vector<double>(cols, 0.0)) {}
+template <typename T>
+Matrix<T>::Matrix(int rows, int cols)
+    : rows(0), cols(0), stride(0), ptr(nullptr), capacity(0), owning(true) {
+        allocate(rows, cols);
+        fill(0.0);
+    }
+
+template <typename T>
+Matrix<T>::Matrix(int rows, int cols, T init_val)
+    : rows(0), cols(0), stride(0), ptr(nullptr), capacity(0), owning(true) {
+        allocate(rows, cols);
+        fill(init_val);
+    }
 
-Matrix::Matrix(int rows, int cols, double init_val)
-    : rows(rows), cols(cols), data(rows, std::vector<double>(cols, 0.0)) {
-        for (int i=0;i<rows;++i){
-            for(int j=0;j<cols;++j){
-                data[i][j] = init_val;
+template <typename T>
+Matrix<T>::Matrix(const std::vector<std::vector<T>>& values)
+    : rows(0), cols(0), stride(0), ptr(nullptr), capacity(0), owning(true) {
+        int r = values.size();
+        int c = values.empty() ? 0 : values[0].size();
+        allocate(r, c);
+        for(int i=0;i<r;++i){
+            if ((int)values[i].size() != c){
+                throw std::invalid_argument("Matrix: Ragged rows in initializer.");
             }
+            std::copy(values[i].begin(), values[i].end(), row(i));
         }
     }
 
-Matrix::Matrix(const std::vector<std::vector<double>>& values)
-    : rows(values.size()), cols(values[0].size()), data(values) {}
+template <typename T>
+Matrix<T>::Matrix(const Matrix& other)
+    : rows(0), cols(0), stride(0), ptr(nullptr), capacity(0), owning(true) {
+        allocate(other.rows, other.cols);
+        copy_from(other);
+    }
 
-Matrix Matrix::col_sum() const{
-    Matrix result = Matrix(1,cols);
+template <typename T>
+Matrix<T>::Matrix(Matrix&& other) noexcept
+    : rows(other.rows), cols(other.cols), stride(other.stride),
+      ptr(other.ptr), capacity(other.capacity), owning(other.owning) {
+        other.rows = other.cols = other.stride = 0;
+        other.ptr = nullptr;
+        other.capacity = 0;
+        other.owning = true;
+    }
 
-    for(int i=0;i<rows;++i){
-        for(int j=0;j<cols;++j){
-            result.data[0][j] += data[i][j];
+template <typename T>
+Matrix<T>& Matrix<T>::operator=(const Matrix& other){
+    if (this == &other) return *this;
+
+    if (!owning && capacity == 0){
+        // A view stays bound to its storage; only the contents change
+        if (rows != other.rows || cols != other.cols){
+            throw std::invalid_argument("Matrix::operator=: Shape mismatch when assigning to a view.");
         }
+    }else{
+        resize(other.rows, other.cols);
     }
 
-    return result;
+    copy_from(other);
+    return *this;
 }
 
-Matrix Matrix::dot(const Matrix& A, const Matrix& B){
+template <typename T>
+Matrix<T>& Matrix<T>::operator=(Matrix&& other){
+    if (this == &other) return *this;
 
-    if (A.cols != B.rows){
-        throw std::invalid_argument("Dot: Incompatible dimensions");
-    }
-
-    Matrix result(A.rows, B.cols);
-    for(int i=0;i<A.rows;++i){
-        for(int j=0;j<B.cols;++j){
-            for(int k=0;k<A.cols;++k){
-                result.data[i][j] += A.data[i][k] * B.data[k][j];
-            }
+    if (!owning){
+        // Views never adopt another buffer; fall back to an element copy
+        if (capacity > 0){
+            resize(other.rows, other.cols);
+        }else if (rows != other.rows || cols != other.cols){
+            throw std::invalid_argument("Matrix::operator=: Shape mismatch when assigning to a view.");
         }
+        copy_from(other);
+        return *this;
     }
 
-    return result;
+    release();
+    rows = other.rows;
+    cols = other.cols;
+    stride = other.stride;
+    ptr = other.ptr;
+    capacity = other.capacity;
+    owning = other.owning;
+
+    other.rows = other.cols = other.stride = 0;
+    other.ptr = nullptr;
+    other.capacity = 0;
+    other.owning = true;
+    return *this;
 }
 
-Matrix Matrix::transpose() const {
-    Matrix result(cols, rows);
-    for(int i=0;i<rows;++i){
-        for(int j=0;j<cols;++j){
-            result.data[j][i] = data[i][j];
-        }
+template <typename T>
+Matrix<T>::~Matrix(){
+    release();
+}
+
+template <typename T>
+Matrix<T> Matrix<T>::view(T* ptr, int rows, int cols, int stride){
+    if (stride < cols){
+        throw std::invalid_argument("Matrix::view: Stride smaller than column count.");
     }
+    Matrix result;
+    result.rows = rows;
+    result.cols = cols;
+    result.stride = stride;
+    result.ptr = ptr;
+    result.owning = false;
     return result;
 }
 
-Matrix Matrix::operator+(const Matrix&other) const{
-    Matrix result(rows, cols);
+template <typename T>
+void Matrix<T>::allocate(int rows, int cols){
+    if (rows < 0 || cols < 0){
+        throw std::invalid_argument("Matrix: Negative dimensions.");
+    }
+    this->rows = rows;
+    this->cols = cols;
+    this->stride = cols;
+    this->capacity = static_cast<std::size_t>(rows) * cols;
+    this->ptr = static_cast<T*>(aligned_malloc(capacity * sizeof(T)));
+    this->owning = true;
+    if (profiling::tracking()) profiling::count_matrix_bytes(static_cast<long long>(capacity * sizeof(T)));
+}
+
+template <typename T>
+void Matrix<T>::rebind(T* ptr, int rows, int cols, std::size_t capacity){
+    release();
+    this->ptr = ptr;
+    this->rows = rows;
+    this->cols = cols;
+    this->capacity = capacity;
+    stride = cols;
+    owning = false;
+}
 
-    if (rows == other.rows && cols == other.cols){
-        // matrices with same dimension
-        for(int i=0;i<rows;++i){
-            for(int j=0;j<cols;++j){
-                result.data[i][j] = data[i][j] + other.data[i][j];
-            }
+template <typename T>
+void Matrix<T>::release(){
+    if (owning){
+        if (ptr && profiling::tracking()) profiling::count_matrix_bytes(-static_cast<long long>(capacity * sizeof(T)));
+        aligned_free(ptr);
+    }
+    ptr = nullptr;
+    capacity = 0;
+}
+
+template <typename T>
+void Matrix<T>::resize(int rows, int cols){
+    if (this->rows == rows && this->cols == cols) return;
+    if (rows < 0 || cols < 0){
+        throw std::invalid_argument("Matrix: Negative dimensions.");
+    }
+    if (!owning){
+        if (capacity == 0){
+            throw std::invalid_argument("Matrix::resize: Cannot change the shape of a view.");
         }
-    }else if (other.rows == 1 && other.cols == cols){
-        // 2D matrix + 1D matrix
-        for(int i=0;i<rows;++i){
-            for(int j=0;j<cols;++j){
-                result.data[i][j] = data[i][j] + other.data[0][j];
-            }
+        if (static_cast<std::size_t>(rows) * cols > capacity){
+            throw std::invalid_argument("Matrix::resize: Shape exceeds the storage the view was placed in.");
         }
-    }else{
-        throw std::invalid_argument("Matrix::operator+: Shape mismatch for addition.");
     }
+    if (static_cast<std::size_t>(rows) * cols > capacity){
+        release();
+        allocate(rows, cols);
+        return;
+    }
+    this->rows = rows;
+    this->cols = cols;
+    this->stride = cols;
+}
+
+template <typename T>
+void Matrix<T>::copy_from(const Matrix& other){
+    if (is_contiguous() && other.is_contiguous()){
+        if (size() > 0) std::memcpy(ptr, other.ptr, size() * sizeof(T));
+        return;
+    }
+    for(int i=0;i<rows;++i){
+        std::memcpy(row(i), other.row(i), cols * sizeof(T));
+    }
+}
+
+template <typename T>
+void Matrix<T>::fill(T value){
+    if (is_contiguous()){
+        std::fill(ptr, ptr + size(), value);
+        return;
+    }
+    for(int i=0;i<rows;++i){
+        std::fill(row(i), row(i) + cols, value);
+    }
+}
 
+template <typename T>
+Matrix<T> Matrix<T>::col_sum() const{
+    Matrix result;
+    col_sum_into(result);
     return result;
 }
 
-Matrix Matrix::operator-(const Matrix&other) const{
-    Matrix result(rows, cols);
+template <typename T>
+void Matrix<T>::col_sum_into(Matrix& result) const{
+    result.resize(1, cols);
+    result.fill(0);
+    T* out = result.data();
+    const kernels::KernelTable<T>& k = kernels::active<T>();
 
-    if (rows == other.rows && cols == other.cols){
+    // Threads own disjoint column ranges and each sweeps every row, so the
+    // partial sums never need combining
+    std::size_t col_grain = std::max<std::size_t>(64, kernels::PARALLEL_GRAIN / std::max(rows, 1));
+    parallel_for(static_cast<std::size_t>(cols), col_grain, [&](std::size_t j0, std::size_t j1){
         for(int i=0;i<rows;++i){
-            for(int j=0;j<cols;++j){
-                result.data[i][j] = data[i][j] - other.data[i][j];
-            }
-        }
-    }else if(other.rows == 1 && other.cols == cols){
-        // 2D matrix - 1D matrix
-        for(int i=0;i<rows;++i){
-            for(int j=0;j<cols;++j){
-                result.data[i][j] = data[i][j] - other.data[0][j];
-            }
+            k.add(out + j0, row(i) + j0, out + j0, j1 - j0);
         }
-    }else{
-        throw std::invalid_argument("Matrix::operator-: Shape mismatch for subtraction.");
+    }, 8);
+}
+
+template <typename T>
+void Matrix<T>::dot_accumulate(const Matrix& A, Transpose trans_a,
+                            const Matrix& B, Transpose trans_b,
+                            Matrix& C, T alpha, T beta){
+    int M = (trans_a == Transpose::No) ? A.rows : A.cols;
+    int K = (trans_a == Transpose::No) ? A.cols : A.rows;
+    int K_b = (trans_b == Transpose::No) ? B.rows : B.cols;
+    int N = (trans_b == Transpose::No) ? B.cols : B.rows;
+
+    if (K != K_b){
+        throw std::invalid_argument("Dot: Incompatible dimensions");
+    }
+    if (C.rows != M || C.cols != N){
+        throw std::invalid_argument("Dot: Output shape mismatch");
     }
 
-    return result;
+    gemm(trans_a, trans_b, M, N, K,
+         alpha, A.data(), A.stride,
+         B.data(), B.stride,
+         beta, C.data(), C.stride);
 }
 
-Matrix Matrix::operator*(double scalar) const{
-    Matrix result(rows, cols);
+template <typename T>
+void Matrix<T>::dot_into(const Matrix& A, Transpose trans_a,
+                         const Matrix& B, Transpose trans_b, Matrix& C){
+    int M = (trans_a == Transpose::No) ? A.rows : A.cols;
+    int N = (trans_b == Transpose::No) ? B.cols : B.rows;
+    C.resize(M, N);
+    // beta = 0 overwrites C, so the resized buffer needs no clearing
+    dot_accumulate(A, trans_a, B, trans_b, C, T(1), T(0));
+}
 
-    for(int i=0;i<rows;++i){
-        for(int j=0;j<cols;++j){
-            result.data[i][j] = data[i][j] * scalar;
-        }
+template <typename T>
+void Matrix<T>::dot_bias_act_into(const Matrix& A, Transpose trans_a,
+                                  const Matrix& B, Transpose trans_b,
+                                  const Matrix& bias, Activation activation,
+                                  Matrix& C){
+    int M = (trans_a == Transpose::No) ? A.rows : A.cols;
+    int K = (trans_a == Transpose::No) ? A.cols : A.rows;
+    int K_b = (trans_b == Transpose::No) ? B.rows : B.cols;
+    int N = (trans_b == Transpose::No) ? B.cols : B.rows;
+
+    if (K != K_b){
+        throw std::invalid_argument("Dot: Incompatible dimensions");
+    }
+    if (bias.rows != 1 || bias.cols != N){
+        throw std::invalid_argument("Dot: Bias must be a (1 × N) row");
     }
 
+    C.resize(M, N);
+    GemmEpilogue<T> epilogue;
+    epilogue.bias = bias.data();
+    epilogue.activation = activation;
+    gemm(trans_a, trans_b, M, N, K,
+         T(1), A.data(), A.stride,
+         B.data(), B.stride,
+         T(0), C.data(), C.stride, epilogue);
+}
+
+template <typename T>
+Matrix<T> Matrix<T>::dot(const Matrix& A, const Matrix& B){
+    Matrix result;
+    dot_into(A, Transpose::No, B, Transpose::No, result);
     return result;
 }
 
-Matrix Matrix::operator*(const Matrix&other) const{
-    Matrix result(rows, cols);
+template <typename T>
+Matrix<T> Matrix<T>::dot_tn(const Matrix& A, const Matrix& B){
+    Matrix result;
+    dot_into(A, Transpose::Yes, B, Transpose::No, result);
+    return result;
+}
 
-    if (rows == other.rows && cols == other.cols){
-        for(int i=0;i<rows;++i){
-            for(int j=0;j<cols;++j){
-                result.data[i][j] = data[i][j] * other.data[i][j];
+template <typename T>
+Matrix<T> Matrix<T>::dot_nt(const Matrix& A, const Matrix& B){
+    Matrix result;
+    dot_into(A, Transpose::No, B, Transpose::Yes, result);
+    return result;
+}
+
+template <typename T>
+void Matrix<T>::gather_rows(const Matrix& src, const int* rows, int count, Matrix& out){
+    out.resize(count, src.cols);
+    std::size_t row_grain = (kernels::PARALLEL_GRAIN + src.cols - 1) / std::max(src.cols, 1);
+    parallel_for(static_cast<std::size_t>(count), row_grain, [&](std::size_t k0, std::size_t k1){
+        for(std::size_t k=k0;k<k1;++k){
+            if (rows[k] < 0 || rows[k] >= src.rows){
+                throw std::invalid_argument("Matrix::gather_rows: Row index out of range.");
             }
+            std::memcpy(out.row(static_cast<int>(k)), src.row(rows[k]), src.cols * sizeof(T));
         }
-    }else if(other.rows == 1 && other.cols == cols){
-        // 2D matrix * 1D matrix
-        for(int i=0;i<rows;++i){
-            for(int j=0;j<cols;++j){
-                result.data[i][j] = data[i][j] * other.data[0][j];
+    });
+}
+
+template <typename T>
+Matrix<T> Matrix<T>::transpose() const {
+    // Tiled so both the reads and the strided writes stay within a few
+    // cache lines per tile; tile rows are split across threads
+    constexpr int TILE = 32;
+    Matrix result(cols, rows);
+
+    std::size_t tile_rows = (rows + TILE - 1) / TILE;
+    std::size_t tile_grain = std::max<std::size_t>(1, kernels::PARALLEL_GRAIN / (static_cast<std::size_t>(TILE) * std::max(cols, 1)));
+
+    parallel_for(tile_rows, tile_grain, [&](std::size_t t0, std::size_t t1){
+        for(int ii = static_cast<int>(t0) * TILE; ii < std::min(rows, static_cast<int>(t1) * TILE); ii += TILE){
+            int i_end = std::min(rows, ii + TILE);
+            for(int jj=0;jj<cols;jj+=TILE){
+                int j_end = std::min(cols, jj + TILE);
+                for(int i=ii;i<i_end;++i){
+                    const T* a = row(i);
+                    for(int j=jj;j<j_end;++j){
+                        result(j, i) = a[j];
+                    }
+                }
             }
         }
+    });
+    return result;
+}
+
+// Shared body of the elementwise operators: same-shape operands go through
+// the contiguous kernel, a (1 × cols) right-hand side through the row
+// broadcast kernel. The kernels allow out to alias a, which is what the
+// compound assignments rely on.
+template <typename T>
+static void elementwise(const Matrix<T>& a, const Matrix<T>& b, Matrix<T>& result,
+                        decltype(kernels::KernelTable<T>::add) same_shape,
+                        decltype(kernels::KernelTable<T>::add_row) broadcast,
+                        const char* error){
+    bool same = (a.rows == b.rows && a.cols == b.cols);
+    if (!same && !(b.rows == 1 && b.cols == a.cols)){
+        throw std::invalid_argument(error);
+    }
+    if (&result != &a) result.resize(a.rows, a.cols);
+
+    if (same){
+        bool packed = a.is_contiguous() && b.is_contiguous() && result.is_contiguous();
+        kernels::for_each_span(packed, a.rows, a.cols, [&](int i, std::size_t n){
+            same_shape(a.row(i), b.row(i), result.row(i), n);
+        });
     }else{
-        throw std::invalid_argument("Matrix::operator*: Shape mismatch for multiplication.");
+        // 2D matrix (op) 1D matrix
+        std::size_t row_grain = (kernels::PARALLEL_GRAIN + a.cols - 1) / std::max(a.cols, 1);
+        parallel_for(static_cast<std::size_t>(a.rows), row_grain, [&](std::size_t r0, std::size_t r1){
+            broadcast(a.row(r0), a.stride, b.data(), result.row(r0), result.stride,
+                      static_cast<int>(r1 - r0), a.cols);
+        });
     }
+}
+
+template <typename T>
+void Matrix<T>::add_into(const Matrix& a, const Matrix& b, Matrix& out){
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    elementwise(a, b, out, k.add, k.add_row,
+                "Matrix::operator+: Shape mismatch for addition.");
+}
 
+template <typename T>
+void Matrix<T>::sub_into(const Matrix& a, const Matrix& b, Matrix& out){
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    elementwise(a, b, out, k.sub, k.sub_row,
+                "Matrix::operator-: Shape mismatch for subtraction.");
+}
+
+template <typename T>
+void Matrix<T>::mul_into(const Matrix& a, const Matrix& b, Matrix& out){
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    elementwise(a, b, out, k.mul, k.mul_row,
+                "Matrix::operator*: Shape mismatch for multiplication.");
+}
+
+template <typename T>
+Matrix<T> Matrix<T>::operator+(const Matrix&other) const{
+    Matrix result;
+    add_into(*this, other, result);
+    return result;
+}
+
+template <typename T>
+Matrix<T> Matrix<T>::operator-(const Matrix&other) const{
+    Matrix result;
+    sub_into(*this, other, result);
+    return result;
+}
+
+template <typename T>
+Matrix<T> Matrix<T>::operator*(T scalar) const{
+    Matrix result;
+    result.resize(rows, cols);
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+
+    kernels::for_each_span(is_contiguous(), rows, cols, [&](int i, std::size_t n){
+        k.scale(row(i), scalar, result.row(i), n);
+    });
+
+    return result;
+}
+
+template <typename T>
+Matrix<T> Matrix<T>::operator*(const Matrix&other) const{
+    Matrix result;
+    mul_into(*this, other, result);
     return result;
 }
 
-void Matrix::print() const {
+template <typename T>
+Matrix<T>& Matrix<T>::operator+=(const Matrix& other){
+    add_into(*this, other, *this);
+    return *this;
+}
+
+template <typename T>
+Matrix<T>& Matrix<T>::operator-=(const Matrix& other){
+    sub_into(*this, other, *this);
+    return *this;
+}
+
+template <typename T>
+Matrix<T>& Matrix<T>::operator*=(const Matrix& other){
+    mul_into(*this, other, *this);
+    return *this;
+}
+
+template <typename T>
+Matrix<T>& Matrix<T>::operator*=(T scalar){
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(is_contiguous(), rows, cols, [&](int i, std::size_t n){
+        k.scale(row(i), scalar, row(i), n);
+    });
+    return *this;
+}
+
+template <typename T>
+void Matrix<T>::axpy(T alpha, const Matrix& x){
+    if (rows != x.rows || cols != x.cols){
+        throw std::invalid_argument("Matrix::axpy: Shape mismatch.");
+    }
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    kernels::for_each_span(is_contiguous() && x.is_contiguous(), rows, cols, [&](int i, std::size_t n){
+        k.axpy(x.row(i), alpha, row(i), n);
+    });
+}
+
+template <typename T>
+void Matrix<T>::print() const {
     std::cout << "[\n";
-    for (const auto& row : data) {
+    for (int i = 0; i < rows; ++i) {
         std::cout << "  [ ";
-        for (double val : row) {
-            std::cout << std::setw(8) << std::fixed << std::setprecision(4) << val << " ";
+        for (int j = 0; j < cols; ++j) {
+            std::cout << std::setw(8) << std::fixed << std::setprecision(4) << (*this)(i, j) << " ";
         }
         std::cout << "]\n";
     }
     std::cout << "]\n";
-}
\ No newline at end of file
+}
+
+template class Matrix<float>;
+template class Matrix<double>;
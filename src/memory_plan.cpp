@@ -0,0 +1,75 @@
+#include "memory_plan.hpp"
+#include "aligned_memory.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+
+std::size_t round_up(std::size_t bytes){
+    return (bytes + NEURONITE_ALIGNMENT - 1) / NEURONITE_ALIGNMENT * NEURONITE_ALIGNMENT;
+}
+
+bool coexist(const TensorLifetime& a, const TensorLifetime& b){
+    for (const std::pair<int,int>& x : a.live){
+        for (const std::pair<int,int>& y : b.live){
+            if (x.first <= y.second && y.first <= x.second) return true;
+        }
+    }
+    return false;
+}
+
+// Step at which the tensor is first written
+int first_step(const TensorLifetime& t){
+    return t.live.empty() ? 0 : t.live.front().first;
+}
+
+} // namespace
+
+std::size_t plan_memory(const std::vector<TensorLifetime>& tensors, std::vector<std::size_t>& offsets){
+    for (const TensorLifetime& t : tensors){
+        for (const std::pair<int,int>& range : t.live){
+            if (range.second < range.first){
+                throw std::invalid_argument("plan_memory: Lifetime ends before it starts");
+            }
+        }
+    }
+
+    // Largest first; ties go to the tensor that is created first, which
+    // keeps the plan deterministic
+    std::vector<std::size_t> order(tensors.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b){
+        if (tensors[a].bytes != tensors[b].bytes) return tensors[a].bytes > tensors[b].bytes;
+        return first_step(tensors[a]) < first_step(tensors[b]);
+    });
+
+    offsets.assign(tensors.size(), 0);
+    std::vector<std::size_t> placed;
+    std::vector<std::size_t> conflicts;
+    std::size_t total = 0;
+
+    for (std::size_t i : order){
+        const TensorLifetime& t = tensors[i];
+
+        conflicts.clear();
+        for (std::size_t p : placed){
+            if (coexist(tensors[p], t)) conflicts.push_back(p);
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [&](std::size_t a, std::size_t b){
+            return offsets[a] < offsets[b];
+        });
+
+        // First gap below, between or above the coexisting tensors
+        std::size_t offset = 0;
+        for (std::size_t p : conflicts){
+            if (offset + t.bytes <= offsets[p]) break;
+            offset = std::max(offset, round_up(offsets[p] + tensors[p].bytes));
+        }
+
+        offsets[i] = offset;
+        placed.push_back(i);
+        total = std::max(total, offset + t.bytes);
+    }
+    return round_up(total);
+}
@@ -2,27 +2,243 @@
 #include "layer.hpp"
 #include "loss.hpp"
 #include "optimizer.hpp"
+#include "utils_random.hpp"
+#include "dense_layer.hpp"
+#include "dropout.hpp"
+#include "quantized_dense_layer.hpp"
+#include "kernels.hpp"
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+#include "memory_plan.hpp"
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+// Scratch of the predict overloads that take none
+template <typename T>
+PredictScratch<T>& thread_scratch(){
+    static thread_local PredictScratch<T> scratch;
+    return scratch;
+}
+
+// Rows [row0, row0 + rows) of a batch, without copying
+template <typename T>
+Matrix<T> row_block(const Matrix<T>& x, int row0, int rows){
+    return Matrix<T>::view(const_cast<T*>(x.row(row0)), rows, x.cols, x.stride);
+}
+
+template <typename T>
+SparseMatrix<T> row_block(const SparseMatrix<T>& x, int row0, int rows){
+    return x.view_rows(row0, rows);
+}
+
+// A replica's first layer on its shard of a dense or sparse batch
+template <typename T>
+void first_forward(Layer<T>& layer, const Matrix<T>& x, Matrix<T>& output, bool replay){
+    if (replay) layer.recompute_into(x, output);
+    else layer.forward_into(x, output);
+}
+
+// A sparse forward keeps only a pointer to its input, so a replay runs it again
+template <typename T>
+void first_forward(Layer<T>& layer, const SparseMatrix<T>& x, Matrix<T>& output, bool /*replay*/){
+    layer.forward_sparse_into(x, output);
+}
+
+template <typename T>
+void first_backward(Layer<T>& layer, const Matrix<T>& /*x*/, const Matrix<T>& grad_output, Matrix<T>& grad_input){
+    layer.backward_into(grad_output, grad_input);
+}
+
+template <typename T>
+void first_backward(Layer<T>& layer, const SparseMatrix<T>& /*x*/, const Matrix<T>& grad_output, Matrix<T>& /*grad_input*/){
+    layer.backward_sparse_into(grad_output);
+}
+
+} // namespace
+
+/// Layers passed to add() outlive the model and keep working without it:
+/// their parameters, gradients and placed caches move out of the model's
+/// buffers into storage of their own, and they go back to a private
+/// workspace. Loaded layers go with the model
+template <typename T>
+Model<T>::~Model(){
+    if (compiled) drop_memory_plan();
+    for (Layer<T>* layer : layers){
+        bool owned = false;
+        for (const std::unique_ptr<Layer<T>>& o : owned_layers) owned = owned || o.get() == layer;
+        if (owned) continue;
+        unbind_parameters(layer);
+        layer->set_workspace(nullptr);
+    }
+}
 
 /// Adds a layer to the model
 /// Layers are stored in a sequential order for forward and backward chaining
-void Model::add(Layer* layer){
+template <typename T>
+void Model<T>::add(Layer<T>* layer){
+    if (!layer->supports_precision(precision)){
+        throw std::invalid_argument("Model::add: " + layer->get_name() +
+                                    " does not support " + half::precision_name(precision));
+    }
+    if (compiled) drop_memory_plan();
     layers.push_back(layer);
+    layer->set_workspace(&workspace);
+    layer->set_precision(precision);
+    activations.emplace_back();
+    gradients.emplace_back();
+    parameters_bound = false;
+}
+
+/// Gathers the parameters of every layer into param_buffer/grad_buffer
+///
+/// Current values are copied into place and each layer matrix is rebound
+/// to its slice, so layers keep reading and writing "their" matrices while
+/// optimizers see one contiguous buffer. Slices are padded to the
+/// allocation alignment so every one of them starts SIMD-aligned.
+template <typename T>
+void Model<T>::bind_parameters(){
+    if (parameters_bound) return;
+
+    constexpr std::size_t align = NEURONITE_ALIGNMENT / sizeof(T);
+    auto padded = [](std::size_t n){ return (n + align - 1) / align * align; };
+
+    std::vector<Parameter<T>> params;
+    for (auto& layer : layers){
+        for (const Parameter<T>& p : layer->parameters()) params.push_back(p);
+    }
+
+    std::size_t total = 0;
+    for (const Parameter<T>& p : params) total += padded(p.value->size());
+
+    Matrix<T> new_params(1, static_cast<int>(total));
+    Matrix<T> new_grads(1, static_cast<int>(total));
+
+    std::size_t offset = 0;
+    for (const Parameter<T>& p : params){
+        int rows = p.value->rows, cols = p.value->cols;
+        if (p.grad->rows != rows || p.grad->cols != cols){
+            throw std::invalid_argument("Model: Parameter and gradient shapes differ");
+        }
+        Matrix<T> value = Matrix<T>::view(new_params.data() + offset, rows, cols);
+        Matrix<T> grad = Matrix<T>::view(new_grads.data() + offset, rows, cols);
+        value = *p.value;
+        // Gradients of loaded layers have no storage yet and start at zero
+        if (p.grad->data()) grad = *p.grad;
+        p.value->rebind(value.data(), rows, cols);
+        p.grad->rebind(grad.data(), rows, cols);
+        offset += padded(static_cast<std::size_t>(rows) * cols);
+    }
+
+    // Views into the old buffers were rebound above, so they can go;
+    // replicas still point into them and are rebuilt on the next step
+    replicas.clear();
+    gradient_sync_planned = false;
+    param_buffer = std::move(new_params);
+    grad_buffer = std::move(new_grads);
+    parameters_bound = true;
+    collect_half_parameters();
+}
+
+template <typename T>
+void Model<T>::unbind_parameters(Layer<T>* layer){
+    if (!parameters_bound) return;
+    for (const Parameter<T>& p : layer->parameters()){
+        for (Matrix<T>* m : {p.value, p.grad}){
+            if (m->owns_data()) continue;
+            Matrix<T> owned(*m);
+            Matrix<T> placed(std::move(*m));
+            *m = std::move(owned);
+        }
+    }
 }
 
 /// Performs the forward pass through all layers
 ///
 /// Each layer applies a transformation:
 ///     x_{i+1} = layer_i.forward(x_i)
-/// Final output is returned (typically used for loss computation)
-Matrix Model::forward(const Matrix& input){
-    Matrix out = input;
-    for(auto& layer : layers){
-        out = layer->forward(out);
+/// Final output is returned (typically used for loss computation). The
+/// input is copied first: backward reads it again, and the caller's matrix
+/// may be a temporary
+template <typename T>
+Matrix<T> Model<T>::forward(const Matrix<T>& input){
+    forward_copy = input;
+    Matrix<T> output = forward_pass(forward_copy);
+    workspace.reset();
+    return output;
+}
+
+template <typename T>
+Matrix<T> Model<T>::forward(const SparseMatrix<T>& input){
+    sparse_forward_copy = input;
+    Matrix<T> output = forward_pass(sparse_forward_copy);
+    workspace.reset();
+    return output;
+}
+
+/// Runs the forward pass into the model's activation buffers and returns
+/// a reference to the last one
+template <typename T>
+const Matrix<T>& Model<T>::forward_pass(const Matrix<T>& input){
+    check_plan(input.rows, input.cols, false);
+    forward_input = &input;
+    sparse_input = nullptr;
+    for(std::size_t i = 0; i < layers.size(); ++i) forward_layer(static_cast<int>(i), false);
+    return layers.empty() ? input : activations.back();
+}
+
+/// The same with a sparse input, which only the first layer reads
+template <typename T>
+const Matrix<T>& Model<T>::forward_pass(const SparseMatrix<T>& input){
+    if (layers.empty()){
+        throw std::invalid_argument("Model: A sparse input needs a first layer that takes it");
     }
-    return out;
+    check_plan(input.rows, input.cols, true);
+    forward_input = nullptr;
+    sparse_input = &input;
+    for(std::size_t i = 0; i < layers.size(); ++i) forward_layer(static_cast<int>(i), false);
+    return activations.back();
+}
+
+template <typename T>
+void Model<T>::check_plan(int rows, int cols, bool sparse) const{
+    if (compiled && sparse != memory_plan.sparse_input){
+        throw std::invalid_argument(std::string("Model: The plan was compiled for ") +
+                                    (memory_plan.sparse_input ? "sparse" : "dense") + " input; recompile for " +
+                                    (sparse ? "sparse" : "dense") + " input");
+    }
+    if (compiled && (rows > memory_plan.max_batch || cols != memory_plan.input_dim)){
+        throw std::invalid_argument("Model: A (" + std::to_string(rows) + " × " + std::to_string(cols) +
+                                    ") input does not fit the plan compiled for up to " +
+                                    std::to_string(memory_plan.max_batch) + " rows of " +
+                                    std::to_string(memory_plan.input_dim) + " columns");
+    }
+}
+
+template <typename T>
+void Model<T>::forward_layer(int i, bool replay){
+    Layer<T>& layer = *layers[i];
+    Profiler::Mark mark;
+    if (profiler) mark = profiler->begin();
+    LayerCost cost;
+    if (i == 0 && sparse_input){
+        // Nothing to replay beyond the product itself
+        layer.forward_sparse_into(*sparse_input, activations[0]);
+        if (profiler) cost = layer.forward_sparse_cost(*sparse_input, activations[0]);
+    }else{
+        const Matrix<T>& in = i == 0 ? *forward_input : activations[i - 1];
+        if (replay) layer.recompute_into(in, activations[i]);
+        else layer.forward_into(in, activations[i]);
+        if (profiler) cost = layer.forward_cost(in, activations[i]);
+    }
+    if (profiler) profiler->end(mark, layer.get_name(), replay ? "recompute" : "forward", i, cost.flops, cost.bytes);
 }
 
 /// Performs the backward pass (backpropagation) through all layers in reverse
@@ -31,33 +247,132 @@ Matrix Model::forward(const Matrix& input){
 ///     grad_{i} = layer_{i}.backward(grad_{i+1})
 ///
 /// This propagates gradients from loss back to the first layer
-Matrix Model::backward(const Matrix& grad_output){
-    Matrix grad = grad_output;
-    for(auto it = layers.rbegin(); it!=layers.rend();++it){
-        grad = (*it)->backward(grad);
+template <typename T>
+Matrix<T> Model<T>::backward(const Matrix<T>& grad_output){
+    // Gives loaded layers gradient storage before backward writes to it
+    bind_parameters();
+    Matrix<T> grad_input = backward_pass(grad_output);
+    workspace.reset();
+    return grad_input;
+}
+
+/// Backward pass into the model's gradient buffers; returns ∂L/∂input,
+/// which is empty after a sparse forward_pass
+template <typename T>
+const Matrix<T>& Model<T>::backward_pass(const Matrix<T>& grad_output, GradientSync<T>* sync){
+    const Matrix<T>* grad = &grad_output;
+    for(std::size_t i = layers.size(); i-- > 0;){
+        if (!checkpoint_from.empty() && checkpoint_from[i] >= 0) recompute(checkpoint_from[i], static_cast<int>(i));
+        bool sparse = i == 0 && sparse_input;
+        Profiler::Mark mark;
+        if (profiler) mark = profiler->begin();
+        if (sparse) layers[i]->backward_sparse_into(*grad);
+        else layers[i]->backward_into(*grad, gradients[i]);
+        if (profiler){
+            LayerCost cost = sparse ? layers[i]->backward_sparse_cost(*grad)
+                                    : layers[i]->backward_cost(*grad, gradients[i]);
+            profiler->end(mark, layers[i]->get_name(), "backward", static_cast<int>(i), cost.flops, cost.bytes);
+        }
+        if (!sparse) grad = &gradients[i];
+        if (sync) sync->layer_done(i);
+    }
+    if (sparse_input){
+        static const Matrix<T> no_gradient;
+        return no_gradient;
     }
-    return grad;
+    return *grad;
+}
+
+template <typename T>
+void Model<T>::recompute(int first, int last){
+    for (int j = first; j <= last; ++j) forward_layer(j, true);
+}
+
+template <typename T>
+void Model<T>::predict(const Matrix<T>& input, Matrix<T>& output, PredictScratch<T>& scratch) const{
+    if (layers.empty()){
+        output = input;
+        return;
+    }
+    infer_layers(0, input, output, scratch);
+}
+
+template <typename T>
+void Model<T>::predict(const SparseMatrix<T>& input, Matrix<T>& output, PredictScratch<T>& scratch) const{
+    if (layers.empty()){
+        throw std::invalid_argument("Model::predict: A sparse input needs a first layer that takes it");
+    }
+    Matrix<T>& first = layers.size() == 1 ? output : scratch.ping;
+    layers[0]->infer_sparse_into(input, first, scratch.workspace);
+    infer_layers(1, first, output, scratch);
+}
+
+template <typename T>
+void Model<T>::infer_layers(std::size_t first, const Matrix<T>& input, Matrix<T>& output,
+                            PredictScratch<T>& scratch) const{
+    // Alternate between the two scratch buffers; the last layer writes
+    // straight into the caller's output
+    const Matrix<T>* x = &input;
+    Matrix<T>* buffers[2] = {&scratch.ping, &scratch.pong};
+    for(std::size_t i = first; i < layers.size(); ++i){
+        Matrix<T>& out = (i + 1 == layers.size()) ? output : *buffers[i % 2];
+        layers[i]->infer_into(*x, out, scratch.workspace);
+        x = &out;
+    }
+    scratch.workspace.reset();
+}
+
+template <typename T>
+void Model<T>::predict(const Matrix<T>& input, Matrix<T>& output) const{
+    predict(input, output, thread_scratch<T>());
+}
+
+template <typename T>
+Matrix<T> Model<T>::predict(const Matrix<T>& input) const{
+    Matrix<T> output;
+    predict(input, output);
+    return output;
+}
+
+template <typename T>
+void Model<T>::predict(const SparseMatrix<T>& input, Matrix<T>& output) const{
+    predict(input, output, thread_scratch<T>());
+}
+
+template <typename T>
+Matrix<T> Model<T>::predict(const SparseMatrix<T>& input) const{
+    Matrix<T> output;
+    predict(input, output);
+    return output;
 }
 
 /// Updates all layers using their stored gradients and a learning rate
 ///
 /// Typically used after `forward` + `backward` to perform one optimization step
-void Model::update(double learning_rate){
+template <typename T>
+void Model<T>::update(double learning_rate){
     for(auto& layer: layers){
         layer->update(learning_rate);
     }
 }
 
-double Model::compute_accuracy(const Matrix& prediction, const Matrix& target) {
+template <typename T>
+double Model<T>::compute_accuracy(const Matrix<T>& prediction, const Matrix<T>& target) {
+    return static_cast<double>(count_correct(prediction, target)) / prediction.rows;
+}
+
+template <typename T>
+int Model<T>::count_correct(const Matrix<T>& prediction, const Matrix<T>& target,
+                            double threshold) {
     int correct = 0;
     int total = prediction.rows;
 
     for (int i = 0; i < total; ++i) {
-        double pred = prediction.data[i][0];
-        double true_val = target.data[i][0];
+        double pred = prediction(i, 0);
+        double true_val = target(i, 0);
 
-        // Binary threshold
-        int predicted_class = (pred >= 0.5) ? 1 : 0;
+        // Binary threshold (0.5 on probabilities, 0 on logits)
+        int predicted_class = (pred >= threshold) ? 1 : 0;
         int true_class = (true_val >= 0.5) ? 1 : 0;
 
         if (predicted_class == true_class) {
@@ -65,65 +380,534 @@ double Model::compute_accuracy(const Matrix& prediction, const Matrix& target) {
         }
     }
 
-    return static_cast<double>(correct) / total;
+    return correct;
+}
+
+template <typename T>
+void Model<T>::train(const Matrix<T>& input,
+                  const Matrix<T>& target,
+                  Loss<T>& loss_fn,
+                  Optimizer<T>& optimizer,
+                  int epochs,
+                  int patience,
+                  int batch_size,
+                  bool shuffle,
+                  LastBatch last_batch) {
+    train_rows(input, target, loss_fn, optimizer, epochs, patience, batch_size, shuffle, last_batch);
 }
 
-void Model::train(const Matrix& input,
-                  const Matrix& target,
-                  Loss& loss_fn,
-                  Optimizer& optimizer,
+template <typename T>
+void Model<T>::train(const SparseMatrix<T>& input,
+                  const Matrix<T>& target,
+                  Loss<T>& loss_fn,
+                  Optimizer<T>& optimizer,
+                  int epochs,
+                  int patience,
+                  int batch_size,
+                  bool shuffle,
+                  LastBatch last_batch) {
+    if (layers.empty()){
+        throw std::invalid_argument("Model::train: A sparse input needs a first layer that takes it");
+    }
+    train_rows(input, target, loss_fn, optimizer, epochs, patience, batch_size, shuffle, last_batch);
+}
+
+template <typename T>
+const Matrix<T>& Model<T>::gather_batch(const Matrix<T>& input, const int* rows, int count){
+    Matrix<T>::gather_rows(input, rows, count, input_batch);
+    return input_batch;
+}
+
+template <typename T>
+const SparseMatrix<T>& Model<T>::gather_batch(const SparseMatrix<T>& input, const int* rows, int count){
+    SparseMatrix<T>::gather_rows(input, rows, count, sparse_batch);
+    return sparse_batch;
+}
+
+template <typename T>
+template <typename Input>
+void Model<T>::train_rows(const Input& input, const Matrix<T>& target,
+                  Loss<T>& loss_fn, Optimizer<T>& optimizer, int epochs,
+                  int patience, int batch_size, bool shuffle, LastBatch last_batch) {
+
+    if (input.rows != target.rows){
+        throw std::invalid_argument("Model::train: Input and target row counts differ");
+    }
+
+    // Replicas copy the loss of this call (a new one may sit at an old address)
+    replica_loss_source = nullptr;
+
+    int num_rows = input.rows;
+    if (num_rows == 0){
+        throw std::invalid_argument("Model::train: Empty input");
+    }
+    if (batch_size <= 0 || batch_size > num_rows) batch_size = num_rows;
+
+    // A single batch covering the dataset needs no permutation
+    bool full_batch = (batch_size == num_rows);
+    shuffle = shuffle && !full_batch;
+
+    int num_batches = num_rows / batch_size;
+    if (num_rows % batch_size != 0 && last_batch == LastBatch::Keep) ++num_batches;
+    if (num_batches == 0){
+        throw std::invalid_argument("Model::train: No complete batch to train on");
+    }
+
+    // Row order for the current epoch; batches are gathered through it so
+    // the dataset itself is never reordered
+    std::vector<int> order;
+    if (shuffle){
+        order.resize(num_rows);
+        for (int i = 0; i < num_rows; ++i) order[i] = i;
+    }
+
+    double best_loss = std::numeric_limits<double>::infinity();
+    int epochs_without_improvement = 0;
+    int step = 0;
+
+    for (int epoch = 0; epoch < epochs; ++epoch) {
+        Profiler::Mark epoch_mark;
+        if (profiler) epoch_mark = profiler->begin();
+        if (shuffle) shuffle_indices(order);
+
+        double loss_sum = 0.0;
+        int correct = 0;
+        int rows_seen = 0;
+
+        for (int b = 0; b < num_batches; ++b) {
+            int row0 = b * batch_size;
+            int rows = std::min(batch_size, num_rows - row0);
+
+            const Input* x = &input;
+            const Matrix<T>* y = &target;
+            Input x_view;
+            Matrix<T> y_view;
+            if (shuffle){
+                x = &gather_batch(input, order.data() + row0, rows);
+                Matrix<T>::gather_rows(target, order.data() + row0, rows, target_batch);
+                y = &target_batch;
+            }else if (!full_batch){
+                // Consecutive rows: views into the caller's data, no copy
+                x_view = row_block(input, row0, rows);
+                y_view = row_block(target, row0, rows);
+                x = &x_view;
+                y = &y_view;
+            }
+
+            train_step(*x, *y, loss_fn, optimizer, ++step, loss_sum, correct);
+            rows_seen += rows;
+        }
+
+        if (communicator) reduce_epoch_totals(loss_sum, correct, rows_seen);
+        if (profiler) profiler->end(epoch_mark, "epoch", "epoch", -1);
+        double loss = loss_sum / rows_seen;
+        double acc = static_cast<double>(correct) / rows_seen;
+
+        if (end_epoch(epoch, loss, acc, patience, best_loss, epochs_without_improvement)) break;
+    }
+}
+
+template <typename T>
+void Model<T>::train(BatchLoader<T>& loader,
+                  Loss<T>& loss_fn,
+                  Optimizer<T>& optimizer,
                   int epochs,
                   int patience) {
-    
+
+    if (loader.batches_per_epoch() == 0){
+        throw std::invalid_argument("Model::train: Empty input");
+    }
+
+    replica_loss_source = nullptr;
+
     double best_loss = std::numeric_limits<double>::infinity();
     int epochs_without_improvement = 0;
+    int step = 0;
 
     for (int epoch = 0; epoch < epochs; ++epoch) {
-        // Forward pass
-        Matrix prediction = this->forward(input);
+        Profiler::Mark epoch_mark;
+        if (profiler) epoch_mark = profiler->begin();
+        double loss_sum = 0.0;
+        int correct = 0;
+        int rows_seen = 0;
+
+        for (int b = 0; b < loader.batches_per_epoch(); ++b) {
+            // Blocks only if the loader thread has fallen behind
+            const typename BatchLoader<T>::Batch& batch = loader.next();
 
-        // Loss computation
-        double loss = loss_fn.forward(prediction, target);
+            train_step(batch.input, batch.target, loss_fn, optimizer, ++step, loss_sum, correct);
+            rows_seen += batch.input.rows;
+        }
+
+        if (communicator) reduce_epoch_totals(loss_sum, correct, rows_seen);
+        if (profiler) profiler->end(epoch_mark, "epoch", "epoch", -1);
+        double loss = loss_sum / rows_seen;
+        double acc = static_cast<double>(correct) / rows_seen;
 
-        // Backward pass
-        Matrix grad = loss_fn.backward();
-        this->backward(grad);
+        if (end_epoch(epoch, loss, acc, patience, best_loss, epochs_without_improvement)) break;
+    }
+}
 
-        // Optimizer step for each layer
-        for (auto& layer : layers) {
-            optimizer.step(layer, epoch + 1);
+template <typename T>
+template <typename Input>
+void Model<T>::train_step(const Input& x, const Matrix<T>& y,
+                  Loss<T>& loss_fn, Optimizer<T>& optimizer, int step,
+                  double& loss_sum, int& correct) {
+    bind_parameters();
+    if (gradient_sync) prepare_gradient_sync();
+
+    // A sparse first layer writes only the weight-gradient rows of the
+    // features in its batch and counts on the others still being zero.
+    // Reducing or averaging across workers writes every row, so start
+    // from zero instead (a sweep those already make)
+    if constexpr (std::is_same<Input, SparseMatrix<T>>::value){
+        if (data_parallel > 1 || gradient_sync) grad_buffer.fill(T(0));
+    }
+
+    // Float16: scale ∂L/∂prediction up so small gradients survive the
+    // 16-bit copies backward makes; finish_step scales them back down
+    T gradient_scale = precision == Precision::Float16 ? static_cast<T>(loss_scale) : T(1);
+    loss_fn.set_gradient_scale(gradient_scale);
+
+    int workers = std::min(data_parallel, x.rows);
+    if (workers > 1){
+        prepare_replicas(loss_fn);
+        for (std::unique_ptr<Replica>& r : replicas) r->loss->set_gradient_scale(gradient_scale);
+
+        // One shard per worker; kernels inside a worker run inline
+        parallel_for(workers, 1, [&](std::size_t begin, std::size_t end){
+            for (std::size_t w = begin; w < end; ++w){
+                int row0 = static_cast<int>(x.rows * w / workers);
+                int row1 = static_cast<int>(x.rows * (w + 1) / workers);
+                train_shard(static_cast<int>(w), x, y, row0, row1 - row0, loss_fn);
+            }
+        });
+
+        // Each shard's gradient is a mean over its rows, so the batch mean
+        // is their sum weighted by shard size: grad = Σ (rows_w / rows) g_w,
+        // summed chunk by chunk across threads
+        std::vector<T>& weights = shard_weights;
+        for (int w = 0; w < workers; ++w){
+            int rows = static_cast<int>(x.rows * (w + 1) / workers) - static_cast<int>(x.rows * w / workers);
+            weights[w] = static_cast<T>(rows) / x.rows;
+            loss_sum += shard_loss[w] * rows;
+            correct += shard_correct[w];
+        }
+        Profiler::Mark reduce_mark;
+        if (profiler) reduce_mark = profiler->begin();
+        const kernels::KernelTable<T>& k = kernels::active<T>();
+        auto reduce = [&](T* out, const std::vector<T*>& parts, std::size_t begin, std::size_t end){
+            k.scale(out + begin, weights[0], out + begin, end - begin);
+            for (int w = 1; w < workers; ++w){
+                k.axpy(parts[w - 1] + begin, weights[w], out + begin, end - begin);
+            }
+        };
+        std::vector<T*>& parts = shard_parts;
+        for (int w = 1; w < workers; ++w) parts[w - 1] = replicas[w - 1]->grad_buffer.data();
+        parallel_for(grad_buffer.size(), REDUCE_GRAIN, [&](std::size_t begin, std::size_t end){
+            reduce(grad_buffer.data(), parts, begin, end);
+        }, NEURONITE_ALIGNMENT / sizeof(T));
+
+        // Running statistics: the same weighted mean, then every replica
+        // continues from it
+        for (std::size_t s = 0; s < layer_state.size(); ++s){
+            for (int w = 1; w < workers; ++w) parts[w - 1] = replicas[w - 1]->state[s]->data();
+            reduce(layer_state[s]->data(), parts, 0, layer_state[s]->size());
+            for (std::unique_ptr<Replica>& r : replicas) *r->state[s] = *layer_state[s];
         }
+        if (profiler){
+            double n = static_cast<double>(grad_buffer.size());
+            profiler->end(reduce_mark, "gradient reduce", "reduce", -1,
+                          2.0 * n * workers, (workers + 1) * n * sizeof(T));
+        }
+
+        // Across processes the buffer is complete only now, so nothing
+        // overlaps backward here
+        finish_step(optimizer, step);
+        return;
+    }
+
+    // Forward pass
+    const Matrix<T>& prediction = this->forward_pass(x);
 
-        // Logging
-        double acc = Model::compute_accuracy(prediction, target);
-        std::cout << "Epoch " << epoch
-                << " | Loss: " << loss
-                << " | Accuracy: " << std::fixed << std::setprecision(4)
-                << acc * 100 << "%\n";
+    // Loss computation
+    Profiler::Mark loss_mark;
+    if (profiler) loss_mark = profiler->begin();
+    double loss = loss_fn.forward(prediction, y);
+    loss_fn.backward_into(loss_grad);
+    if (profiler){
+        double n = static_cast<double>(prediction.size());
+        profiler->end(loss_mark, "loss", "loss", -1, 0.0, 3.0 * n * sizeof(T));
+    }
+
+    // Backward pass
+    this->backward_pass(loss_grad, gradient_sync.get());
+    finish_step(optimizer, step);
+
+    // The per-batch loss is a mean, so weight it by the batch size
+    loss_sum += loss * x.rows;
+    correct += count_correct(prediction, y, loss_fn.decision_threshold());
+}
 
-        // Early stopping logic
-        if (loss < best_loss - 1e-6) {
-            best_loss = loss;
-            epochs_without_improvement = 0;
-        } else {
-            epochs_without_improvement++;
+template <typename T>
+void Model<T>::finish_step(Optimizer<T>& optimizer, int step){
+    if (gradient_sync){
+        Profiler::Mark mark;
+        if (profiler) mark = profiler->begin();
+        gradient_sync->finish();
+        if (profiler) profiler->end(mark, "gradient all-reduce wait", "sync", -1);
+    }
+
+    if (precision == Precision::Float16 && !unscale_gradients()){
+        // Overflow: drop this step and retry the next with half the scale
+        loss_scale = std::max(1.0, loss_scale / 2);
+        steps_since_rescale = 0;
+        ++skipped_steps;
+        workspace.reset();
+        return;
+    }
+
+    // One optimizer sweep over the flat parameter buffer
+    Profiler::Mark mark;
+    if (profiler) mark = profiler->begin();
+    optimizer.step(param_buffer, grad_buffer, step);
+    if (profiler){
+        // Reads θ and g and writes θ, plus a read and a write of each
+        // per-parameter state buffer
+        double n = static_cast<double>(param_buffer.size());
+        double buffers = 3.0 + 2.0 * optimizer.state().size();
+        profiler->end(mark, "optimizer step", "optimizer", -1, 0.0, buffers * n * sizeof(T));
+    }
+    if (precision == Precision::Float16 && ++steps_since_rescale >= loss_scale_growth_interval){
+        loss_scale *= 2;
+        steps_since_rescale = 0;
+    }
+    refresh_half_parameters();
+
+    // Every layer temporary of this step is dead now
+    workspace.reset();
+}
+
+template <typename T>
+template <typename Input>
+void Model<T>::train_shard(int w, const Input& x, const Matrix<T>& y,
+                  int row0, int rows, Loss<T>& loss_fn) {
+    Input xs = row_block(x, row0, rows);
+    Matrix<T> ys = row_block(y, row0, rows);
+
+    if (w == 0){
+        const Matrix<T>& prediction = forward_pass(xs);
+        shard_loss[0] = loss_fn.forward(prediction, ys);
+        loss_fn.backward_into(loss_grad);
+        backward_pass(loss_grad);
+        shard_correct[0] = count_correct(prediction, ys, loss_fn.decision_threshold());
+        return;
+    }
+
+    Replica& r = *replicas[w - 1];
+    const Matrix<T>* out = nullptr;
+    if constexpr (std::is_same<Input, Matrix<T>>::value) out = &xs;
+    for (std::size_t i = 0; i < r.layers.size(); ++i){
+        if (i == 0) first_forward(*r.layers[0], xs, r.activations[0], false);
+        else r.layers[i]->forward_into(*out, r.activations[i]);
+        out = &r.activations[i];
+    }
+    shard_loss[w] = r.loss->forward(*out, ys);
+    r.loss->backward_into(r.loss_grad);
+
+    const Matrix<T>* grad = &r.loss_grad;
+    for (std::size_t i = r.layers.size(); i-- > 0;){
+        if (!checkpoint_from.empty() && checkpoint_from[i] >= 0){
+            for (int j = checkpoint_from[i]; j <= static_cast<int>(i); ++j){
+                if (j == 0) first_forward(*r.layers[0], xs, r.activations[0], true);
+                else r.layers[j]->recompute_into(r.activations[j - 1], r.activations[j]);
+            }
+        }
+        if (i == 0) first_backward(*r.layers[0], xs, *grad, r.gradients[0]);
+        else r.layers[i]->backward_into(*grad, r.gradients[i]);
+        grad = &r.gradients[i];
+    }
+    shard_correct[w] = count_correct(*out, ys, r.loss->decision_threshold());
+    r.workspace.reset();
+}
+
+/// Builds the replicas for data-parallel training
+///
+/// Each replica layer is made from the model layer's spec(); its parameter
+/// matrices are rebound to the model's (so optimizer updates reach every
+/// replica for free) and its gradients to the same offsets of a private
+/// buffer shaped like grad_buffer, which makes the reduction a plain
+/// element-wise sum of flat buffers. State such as running statistics is
+/// copied, since every replica updates its own.
+template <typename T>
+void Model<T>::prepare_replicas(const Loss<T>& loss_fn){
+    std::size_t count = static_cast<std::size_t>(data_parallel - 1);
+    if (replicas.size() != count){
+        replicas.clear();
+        layer_state.clear();
+        for (Layer<T>* layer : layers){
+            for (Matrix<T>* s : layer->state()) layer_state.push_back(s);
         }
 
-        if (epochs_without_improvement >= patience) {
-            std::cout << "Early stopping at epoch " << epoch
-                      << " (best loss = " << best_loss << ")\n";
-            break;
+        for (std::size_t n = 0; n < count; ++n){
+            std::unique_ptr<Replica> r = std::make_unique<Replica>();
+            r->grad_buffer = Matrix<T>(1, grad_buffer.cols);
+
+            for (Layer<T>* layer : layers){
+                LayerSpec spec = layer->spec();
+                if (spec.kind == LayerKind::Unknown){
+                    throw std::invalid_argument("Model::train: " + layer->get_name() +
+                                                " cannot be replicated for data-parallel training");
+                }
+                std::unique_ptr<Layer<T>> copy = make_layer<T>(spec);
+                copy->set_workspace(&r->workspace);
+                copy->set_precision(precision);
+                if (const Dropout<T>* dropout = dynamic_cast<const Dropout<T>*>(layer)){
+                    static_cast<Dropout<T>&>(*copy).set_training(dropout->get_training());
+                }
+
+                std::vector<Parameter<T>> source = layer->parameters();
+                std::vector<Parameter<T>> target = copy->parameters();
+                for (std::size_t i = 0; i < source.size(); ++i){
+                    int rows = source[i].value->rows, cols = source[i].value->cols;
+                    target[i].value->rebind(source[i].value->data(), rows, cols);
+                    target[i].grad->rebind(r->grad_buffer.data() + (source[i].grad->data() - grad_buffer.data()),
+                                           rows, cols);
+                    if (source[i].half && target[i].half){
+                        target[i].half->rebind(source[i].half->data(), rows, cols);
+                        target[i].half->precision = source[i].half->precision;
+                    }
+                }
+
+                std::vector<Matrix<T>*> source_state = layer->state();
+                std::vector<Matrix<T>*> target_state = copy->state();
+                for (std::size_t i = 0; i < source_state.size(); ++i){
+                    *target_state[i] = *source_state[i];
+                    r->state.push_back(target_state[i]);
+                }
+
+                r->layers.push_back(std::move(copy));
+                r->activations.emplace_back();
+                r->gradients.emplace_back();
+            }
+            if (compiled){
+                int shard_rows = (memory_plan.max_batch + data_parallel - 1) / data_parallel;
+                std::vector<Layer<T>*> stack;
+                for (std::unique_ptr<Layer<T>>& layer : r->layers) stack.push_back(layer.get());
+                place_buffers(shard_rows, stack, r->activations, r->gradients, r->loss_grad, r->slab);
+            }
+            replicas.push_back(std::move(r));
         }
+
+        shard_loss.assign(data_parallel, 0.0);
+        shard_correct.assign(data_parallel, 0);
+        shard_weights.assign(data_parallel, T(0));
+        shard_parts.assign(data_parallel, nullptr);
+        replica_loss_source = nullptr;
+    }
+
+    if (replica_loss_source != &loss_fn){
+        for (std::unique_ptr<Replica>& r : replicas){
+            r->loss = loss_fn.clone();
+            if (!r->loss){
+                throw std::invalid_argument("Model::train: Data-parallel training needs a loss that implements clone()");
+            }
+        }
+        replica_loss_source = &loss_fn;
     }
 }
 
-void Model::summarize(int input_dim){
-    // Step 1: Run dummy forward
-    Matrix dummy_input(1, input_dim);  // [1 × input_dim], batch size = 1
-    for (auto& row : dummy_input.data)
-        std::fill(row.begin(), row.end(), 0.0);  // optional: fill with 0s
+template <typename T>
+void Model<T>::prepare_gradient_sync(){
+    if (gradient_sync_planned) return;
+
+    communicator->broadcast(param_buffer.data(), param_buffer.size(), 0);
+    for (Layer<T>* layer : layers){
+        for (Matrix<T>* s : layer->state()){
+            if (!s->is_contiguous()){
+                throw std::invalid_argument("Model::train: Layer state must be contiguous to broadcast");
+            }
+            communicator->broadcast(s->data(), s->size(), 0);
+        }
+    }
+
+    // Layers without parameters start where the next layer does
+    std::vector<std::size_t> layer_begin(layers.size());
+    std::size_t begin = grad_buffer.size();
+    for (std::size_t i = layers.size(); i-- > 0;){
+        std::vector<Parameter<T>> params = layers[i]->parameters();
+        if (!params.empty()) begin = static_cast<std::size_t>(params.front().grad->data() - grad_buffer.data());
+        layer_begin[i] = begin;
+    }
+    gradient_sync->plan(grad_buffer.data(), grad_buffer.size(), layer_begin);
+    gradient_sync_planned = true;
+}
 
-    this->forward(dummy_input);  // populates input/output shapes in layers
+template <typename T>
+void Model<T>::reduce_epoch_totals(double& loss_sum, int& correct, int& rows_seen){
+    double totals[3] = {loss_sum, static_cast<double>(correct), static_cast<double>(rows_seen)};
+    communicator->all_reduce(totals, 3);
+    loss_sum = totals[0];
+    correct = static_cast<int>(totals[1]);
+    rows_seen = static_cast<int>(totals[2]);
+}
+
+template <typename T>
+void Model<T>::set_communicator(Communicator* comm, std::size_t bucket_bytes){
+    gradient_sync.reset();
+    communicator = comm;
+    if (comm) gradient_sync = std::make_unique<GradientSync<T>>(*comm, bucket_bytes);
+    gradient_sync_planned = false;
+}
+
+template <typename T>
+void Model<T>::set_profiler(Profiler* profiler){
+    this->profiler = profiler;
+}
+
+template <typename T>
+void Model<T>::set_data_parallel(int workers){
+    if (workers < 1){
+        throw std::invalid_argument("Model::set_data_parallel: Need at least one worker");
+    }
+    if (workers != data_parallel) replicas.clear();
+    data_parallel = workers;
+}
+
+template <typename T>
+int Model<T>::get_data_parallel() const{
+    return data_parallel;
+}
+
+template <typename T>
+bool Model<T>::end_epoch(int epoch, double loss, double acc, int patience,
+                  double& best_loss, int& epochs_without_improvement) {
+    // Logging
+    std::cout << "Epoch " << epoch
+            << " | Loss: " << loss
+            << " | Accuracy: " << std::fixed << std::setprecision(4)
+            << acc * 100 << "%\n";
+
+    // Early stopping logic
+    if (loss < best_loss - 1e-6) {
+        best_loss = loss;
+        epochs_without_improvement = 0;
+    } else {
+        epochs_without_improvement++;
+    }
+
+    if (epochs_without_improvement >= patience) {
+        std::cout << "Early stopping at epoch " << epoch
+                  << " (best loss = " << best_loss << ")\n";
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+void Model<T>::summarize(int input_dim){
+    // Step 1: Infer the shapes of a single row
+    std::vector<std::pair<int,int>> shapes = infer_shapes(input_dim, 1, "Model::summarize");
 
     // Step 2: Print header
     std::cout << "# Model Summary\n";
@@ -137,9 +921,10 @@ void Model::summarize(int input_dim){
 
     int total_params = 0;
 
-    for (const auto& layer : layers) {
-        auto in_shape = layer->get_input_shape();
-        auto out_shape = layer->get_output_shape();
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        const Layer<T>* layer = layers[i];
+        std::pair<int,int> in_shape = i == 0 ? std::make_pair(1, input_dim) : shapes[i - 1];
+        std::pair<int,int> out_shape = shapes[i];
         int params = layer->param_count();
 
         std::string in_shape_str = "[" + std::to_string(in_shape.first) + " × " + std::to_string(in_shape.second) + "]";
@@ -157,4 +942,362 @@ void Model::summarize(int input_dim){
     std::cout << "──────────────────────────────────────────────────────────────\n";
     std::cout << "Total Parameters: " << total_params << "\n";
     std::cout << "\n";
-}
\ No newline at end of file
+}
+
+template <typename T>
+std::vector<std::pair<int,int>> Model<T>::infer_shapes(int input_dim, int rows, const char* caller) const{
+    std::vector<std::pair<int,int>> shapes;
+    std::pair<int,int> shape = {rows, input_dim};
+    for (std::size_t i = 0; i < layers.size(); ++i){
+        try{
+            shape = layers[i]->infer_output_shape(shape);
+        }catch(const std::invalid_argument& e){
+            throw std::invalid_argument(std::string(caller) + ": Layer " + std::to_string(i) +
+                                        " (" + layers[i]->get_name() + "): " + e.what());
+        }
+        shapes.push_back(shape);
+    }
+    return shapes;
+}
+
+/// Lays out one training step's buffers in a single slab
+///
+/// The step is replayed as a schedule, one slot per operation: forward of
+/// every layer, the loss, then backward from the last layer down, with a
+/// checkpointed segment's recomputation just before its backward. A
+/// forward (or recomputation) reads the layer's input and writes its
+/// output and caches. A layer may hold on to its input and output until
+/// its own backward, which reads them, its caches and the incoming
+/// gradient, and writes the outgoing one. The prediction and ∂L/∂input
+/// are read once more at the end of the step.
+///
+/// Each write opens a live range and each read extends it, so a tensor
+/// that is recomputed has one range per write. plan_memory packs the
+/// tensors by those ranges.
+template <typename T>
+std::size_t Model<T>::place_buffers(int rows, const std::vector<Layer<T>*>& stack,
+                                    std::vector<Matrix<T>>& activations,
+                                    std::vector<Matrix<T>>& gradients, Matrix<T>& loss_grad,
+                                    Matrix<T>& slab){
+    int L = static_cast<int>(layers.size());
+    std::vector<std::pair<int,int>> outputs = infer_shapes(memory_plan.input_dim, rows, "Model::compile");
+    std::vector<std::pair<int,int>> inputs(L);
+    for (int i = 0; i < L; ++i) inputs[i] = i == 0 ? std::make_pair(rows, memory_plan.input_dim) : outputs[i - 1];
+
+    // A sparse input gets no ∂L/∂input (an empty one is placed) and its
+    // layer keeps no caches
+    std::pair<int,int> input_gradient = memory_plan.sparse_input ? std::make_pair(0, memory_plan.input_dim) : inputs[0];
+
+    // Tensors 0..L-1 are the activations, L..2L-1 the gradients, 2L is
+    // loss_grad, and the caches of layer i follow from cache_begin[i]
+    std::vector<TensorLifetime> tensors;
+    auto add = [&](std::pair<int,int> shape, std::size_t element_bytes = sizeof(T)){
+        tensors.push_back({static_cast<std::size_t>(shape.first) * shape.second * element_bytes, {}});
+    };
+    for (int i = 0; i < L; ++i) add(outputs[i]);
+    for (int i = 0; i < L; ++i) add(i == 0 ? input_gradient : inputs[i]);
+    add(outputs[L - 1]);
+    std::vector<std::vector<BatchCache<T>>> caches(L);
+    std::vector<int> cache_begin(L);
+    for (int i = 0; i < L; ++i){
+        if (i > 0 || !memory_plan.sparse_input) caches[i] = stack[i]->caches(inputs[i]);
+        cache_begin[i] = static_cast<int>(tensors.size());
+        for (const BatchCache<T>& c : caches[i]) add({c.rows, c.cols}, c.half ? sizeof(std::uint16_t) : sizeof(T));
+    }
+
+    int slot = 0;
+    auto write = [&](int t){ tensors[t].live.push_back({slot, slot}); };
+    auto read = [&](int t){ tensors[t].live.back().second = slot; };
+    auto forward = [&](int i){
+        if (i > 0) read(i - 1);
+        write(i);
+        for (std::size_t c = 0; c < caches[i].size(); ++c) write(cache_begin[i] + static_cast<int>(c));
+        ++slot;
+    };
+
+    for (int i = 0; i < L; ++i) forward(i);
+    read(L - 1);
+    write(2 * L);
+    ++slot;
+    for (int i = L; i-- > 0;){
+        if (checkpoint_from[i] >= 0){
+            for (int j = checkpoint_from[i]; j <= i; ++j) forward(j);
+        }
+        read(i == L - 1 ? 2 * L : L + i + 1);
+        if (i > 0 && stack[i]->backward_reads_input()) read(i - 1);
+        if (stack[i]->backward_reads_output()) read(i);
+        for (std::size_t c = 0; c < caches[i].size(); ++c) read(cache_begin[i] + static_cast<int>(c));
+        write(L + i);
+        ++slot;
+    }
+    read(L - 1);
+    read(L);
+
+    std::vector<std::size_t> offsets;
+    std::size_t total = plan_memory(tensors, offsets);
+    slab = Matrix<T>(1, static_cast<int>(total / sizeof(T)));
+
+    auto place = [&](Matrix<T>& m, int t, int r, int c){
+        m.rebind(slab.data() + offsets[t] / sizeof(T), r, c, tensors[t].bytes / sizeof(T));
+    };
+    for (int i = 0; i < L; ++i){
+        place(activations[i], i, outputs[i].first, outputs[i].second);
+        std::pair<int,int> g = i == 0 ? input_gradient : inputs[i];
+        place(gradients[i], L + i, g.first, g.second);
+        for (std::size_t c = 0; c < caches[i].size(); ++c){
+            const BatchCache<T>& cache = caches[i][c];
+            int t = cache_begin[i] + static_cast<int>(c);
+            if (cache.half){
+                std::uint16_t* base = reinterpret_cast<std::uint16_t*>(slab.data());
+                cache.half->rebind(base + offsets[t] / sizeof(std::uint16_t), cache.rows, cache.cols,
+                                   tensors[t].bytes / sizeof(std::uint16_t));
+            }else{
+                place(*cache.tensor, t, cache.rows, cache.cols);
+            }
+        }
+    }
+    place(loss_grad, 2 * L, outputs[L - 1].first, outputs[L - 1].second);
+
+    std::size_t unshared = 0;
+    for (const TensorLifetime& t : tensors) unshared += t.bytes;
+    return unshared;
+}
+
+// Moving out of a placed matrix leaves an empty owning one behind
+template <typename T>
+void Model<T>::drop_memory_plan(){
+    for (Matrix<T>& m : activations) Matrix<T> placed(std::move(m));
+    for (Matrix<T>& m : gradients) Matrix<T> placed(std::move(m));
+    Matrix<T> placed(std::move(loss_grad));
+    for (Layer<T>* layer : layers){
+        for (const BatchCache<T>& c : layer->caches({0, 0})){
+            if (c.half) HalfMatrix cache(std::move(*c.half));
+            else Matrix<T> cache(std::move(*c.tensor));
+        }
+    }
+    activation_slab = Matrix<T>();
+    replicas.clear();
+    checkpoint_from.clear();
+    memory_plan = MemoryPlan();
+    compiled = false;
+}
+
+template <typename T>
+const MemoryPlan& Model<T>::compile(int input_dim, int max_batch, int checkpoint_segments,
+                                    bool sparse_input){
+    int L = static_cast<int>(layers.size());
+    if (L == 0){
+        throw std::invalid_argument("Model::compile: The model has no layers");
+    }
+    if (input_dim <= 0 || max_batch <= 0){
+        throw std::invalid_argument("Model::compile: input_dim and max_batch must be positive");
+    }
+    if (checkpoint_segments < 1 || checkpoint_segments > L){
+        throw std::invalid_argument("Model::compile: checkpoint_segments must be between 1 and the number of layers");
+    }
+    if (compiled) drop_memory_plan();
+    bind_parameters();
+
+    MemoryPlan plan;
+    plan.input_dim = input_dim;
+    plan.max_batch = max_batch;
+    plan.segments = checkpoint_segments;
+    plan.sparse_input = sparse_input;
+    plan.shapes = infer_shapes(input_dim, max_batch, "Model::compile");
+    memory_plan = plan;
+
+    // Segment s covers layers [s·L/S, (s+1)·L/S); all but the last are
+    // recomputed
+    checkpoint_from.assign(L, -1);
+    for (int s = 0; s + 1 < checkpoint_segments; ++s){
+        checkpoint_from[(s + 1) * L / checkpoint_segments - 1] = s * L / checkpoint_segments;
+    }
+
+    memory_plan.unshared_bytes = place_buffers(max_batch, layers, activations, gradients, loss_grad, activation_slab);
+    memory_plan.slab_bytes = activation_slab.size() * sizeof(T);
+    memory_plan.parameter_bytes = (param_buffer.size() + grad_buffer.size()) * sizeof(T);
+
+    // predict alternates even and odd layers between ping and pong; the
+    // last layer writes to the caller's output
+    std::size_t ping = 0, pong = 0;
+    for (std::size_t i = 0; i + 1 < layers.size(); ++i){
+        std::size_t n = static_cast<std::size_t>(plan.shapes[i].first) * plan.shapes[i].second;
+        std::size_t& buffer = i % 2 ? pong : ping;
+        buffer = std::max(buffer, n);
+    }
+    memory_plan.inference_bytes = (ping + pong) * sizeof(T);
+
+    // Replicas are rebuilt and placed at their shard size on the next step
+    replicas.clear();
+    compiled = true;
+    return memory_plan;
+}
+
+template <typename T>
+bool Model<T>::is_compiled() const{
+    return compiled;
+}
+
+template <typename T>
+void Model<T>::reserve(PredictScratch<T>& scratch) const{
+    if (!compiled){
+        throw std::invalid_argument("Model::reserve: compile the model first");
+    }
+    Matrix<T>* buffers[2] = {&scratch.ping, &scratch.pong};
+    for (std::size_t i = 0; i + 1 < layers.size(); ++i){
+        const std::pair<int,int>& shape = memory_plan.shapes[i];
+        Matrix<T>& buffer = *buffers[i % 2];
+        if (static_cast<std::size_t>(shape.first) * shape.second > buffer.size()) buffer.resize(shape.first, shape.second);
+    }
+}
+
+template <typename T>
+void Model<T>::quantize(){
+    if (precision != Precision::Full){
+        throw std::invalid_argument("Model::quantize: The model must be at Full precision");
+    }
+    // The plan placed the replaced layers' caches; replicas clone them
+    if (compiled) drop_memory_plan();
+    replicas.clear();
+    for (Layer<T>*& layer : layers){
+        const DenseLayer<T>* dense = dynamic_cast<const DenseLayer<T>*>(layer);
+        if (!dense) continue;
+        std::unique_ptr<Layer<T>> q = std::make_unique<QuantizedDenseLayer<T>>(*dense);
+        q->set_workspace(&workspace);
+        // The next bind_parameters frees the buffers the replaced layer
+        // points into
+        unbind_parameters(layer);
+        layer = q.get();
+        owned_layers.push_back(std::move(q));
+    }
+    parameters_bound = false;
+}
+
+template <typename T>
+QuantizationReport Model<T>::quantize(const Matrix<T>& input, const Matrix<T>& target, double threshold){
+    if (input.rows != target.rows){
+        throw std::invalid_argument("Model::quantize: Input and target row counts differ");
+    }
+    Matrix<T> reference = predict(input);
+    quantize();
+    Matrix<T> quantized = predict(input);
+
+    QuantizationReport report{};
+    report.reference_accuracy = static_cast<double>(count_correct(reference, target, threshold)) / input.rows;
+    report.quantized_accuracy = static_cast<double>(count_correct(quantized, target, threshold)) / input.rows;
+    report.accuracy_delta = report.quantized_accuracy - report.reference_accuracy;
+
+    double sum = 0.0;
+    for (int i = 0; i < reference.rows; ++i){
+        for (int j = 0; j < reference.cols; ++j){
+            double e = std::fabs(static_cast<double>(quantized(i, j)) - reference(i, j));
+            report.max_abs_error = std::max(report.max_abs_error, e);
+            sum += e;
+        }
+    }
+    report.mean_abs_error = reference.size() ? sum / reference.size() : 0.0;
+    return report;
+}
+
+template <typename T>
+Matrix<T>& Model<T>::get_parameters(){
+    bind_parameters();
+    return param_buffer;
+}
+
+template <typename T>
+Matrix<T>& Model<T>::get_gradients(){
+    bind_parameters();
+    return grad_buffer;
+}
+
+template <typename T>
+void Model<T>::set_precision(Precision precision){
+    // Checked up front so a rejected call leaves every layer as it was
+    for (Layer<T>* layer : layers){
+        if (!layer->supports_precision(precision)){
+            throw std::invalid_argument("Model::set_precision: " + layer->get_name() +
+                                        " does not support " + half::precision_name(precision));
+        }
+    }
+    if (compiled) drop_memory_plan();
+    replicas.clear();
+    this->precision = precision;
+    for (Layer<T>* layer : layers) layer->set_precision(precision);
+    collect_half_parameters();
+    steps_since_rescale = 0;
+}
+
+template <typename T>
+Precision Model<T>::get_precision() const{
+    return precision;
+}
+
+template <typename T>
+void Model<T>::set_loss_scaling(double initial_scale, int growth_interval){
+    if (!(initial_scale >= 1.0) || growth_interval < 1){
+        throw std::invalid_argument("Model::set_loss_scaling: Need a scale of at least 1 and a positive growth interval");
+    }
+    loss_scale = initial_scale;
+    loss_scale_growth_interval = growth_interval;
+    steps_since_rescale = 0;
+}
+
+template <typename T>
+double Model<T>::get_loss_scale() const{
+    return loss_scale;
+}
+
+template <typename T>
+long long Model<T>::get_skipped_steps() const{
+    return skipped_steps;
+}
+
+template <typename T>
+void Model<T>::collect_half_parameters(){
+    half_parameters.clear();
+    for (Layer<T>* layer : layers){
+        for (const Parameter<T>& p : layer->parameters()){
+            if (p.half) half_parameters.push_back(p);
+        }
+    }
+    refresh_half_parameters();
+}
+
+// Parameters without storage yet (loaded layers before binding) are
+// encoded once bind_parameters gives them some
+template <typename T>
+void Model<T>::refresh_half_parameters(){
+    for (const Parameter<T>& p : half_parameters){
+        if (p.value->data()) p.half->assign(*p.value, precision);
+    }
+}
+
+// One pass over the flat gradient buffer: g /= scale, and a finiteness
+// check on the result (an overflow anywhere shows up as inf or NaN)
+template <typename T>
+bool Model<T>::unscale_gradients(){
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    T inverse = static_cast<T>(1.0 / loss_scale);
+    std::atomic<bool> finite{true};
+    parallel_for(grad_buffer.size(), REDUCE_GRAIN, [&](std::size_t begin, std::size_t end){
+        T* g = grad_buffer.data() + begin;
+        std::size_t n = end - begin;
+        k.scale(g, inverse, g, n);
+        for (std::size_t i = 0; i < n; ++i){
+            if (!std::isfinite(g[i])){
+                finite.store(false, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }, NEURONITE_ALIGNMENT / sizeof(T));
+    return finite.load();
+}
+
+template <typename T>
+Workspace& Model<T>::get_workspace(){
+    return workspace;
+}
+
+template class Model<float>;
+template class Model<double>;
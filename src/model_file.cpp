@@ -0,0 +1,297 @@
+#include "model.hpp"
+#include "model_file.hpp"
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MODEL_MAGIC[8] = {'N', 'N', 'M', 'O', 'D', 'E', 'L', '\0'};
+
+template <typename T> constexpr TensorDType dtype_of();
+template <> constexpr TensorDType dtype_of<float>(){ return TensorDType::Float32; }
+template <> constexpr TensorDType dtype_of<double>(){ return TensorDType::Float64; }
+
+std::uint64_t page_align(std::uint64_t n){
+    return (n + MODEL_FILE_PAGE - 1) / MODEL_FILE_PAGE * MODEL_FILE_PAGE;
+}
+
+TensorRecord make_record(TensorRole role, int rows, int cols, std::uint32_t layer, std::uint32_t index){
+    TensorRecord r{};
+    r.rows = static_cast<std::uint32_t>(rows);
+    r.cols = static_cast<std::uint32_t>(cols);
+    r.role = static_cast<std::uint32_t>(role);
+    r.layer = layer;
+    r.index = index;
+    return r;
+}
+
+} // namespace
+
+/// Saves the model (see model_file.hpp for the layout)
+///
+/// Parameters are written as the flat buffer they already live in, so
+/// this is one sequential write per section.
+template <typename T>
+void Model<T>::save(const std::string& path, Optimizer<T>* optimizer){
+    bind_parameters();
+
+    std::vector<LayerRecord> layer_records;
+    for (Layer<T>* layer : layers){
+        LayerSpec spec = layer->spec();
+        if (spec.kind == LayerKind::Unknown){
+            throw std::invalid_argument("Model::save: Layer " + layer->get_name() + " cannot be saved");
+        }
+        LayerRecord r{};
+        r.kind = static_cast<std::uint32_t>(spec.kind);
+        r.activation = spec.activation;
+        r.input_dim = spec.input_dim;
+        r.output_dim = spec.output_dim;
+        r.value = spec.value;
+        layer_records.push_back(r);
+    }
+
+    // Records of tensors that own a section, and what to write there;
+    // Parameter records point into the parameter section and own none
+    std::vector<TensorRecord> records;
+    std::vector<const Matrix<T>*> sections;
+    std::vector<std::size_t> parameter_offsets;   // elements into param_buffer
+
+    records.push_back(make_record(TensorRole::ParameterBuffer, param_buffer.rows, param_buffer.cols, 0, 0));
+    sections.push_back(&param_buffer);
+
+    for (std::size_t i = 0; i < layers.size(); ++i){
+        std::vector<Parameter<T>> params = layers[i]->parameters();
+        for (std::size_t j = 0; j < params.size(); ++j){
+            const Matrix<T>& value = *params[j].value;
+            records.push_back(make_record(TensorRole::Parameter, value.rows, value.cols,
+                                          static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j)));
+            sections.push_back(nullptr);
+            parameter_offsets.push_back(static_cast<std::size_t>(value.data() - param_buffer.data()));
+        }
+        std::vector<Matrix<T>*> state = layers[i]->state();
+        for (std::size_t j = 0; j < state.size(); ++j){
+            records.push_back(make_record(TensorRole::LayerState, state[j]->rows, state[j]->cols,
+                                          static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j)));
+            sections.push_back(state[j]);
+        }
+    }
+
+    if (optimizer){
+        std::vector<Matrix<T>*> state = optimizer->state();
+        // An optimizer that has not stepped yet has nothing to save
+        bool stepped = !state.empty() && state[0]->size() > 0;
+        for (std::size_t j = 0; stepped && j < state.size(); ++j){
+            if (state[j]->rows != param_buffer.rows || state[j]->cols != param_buffer.cols){
+                throw std::invalid_argument("Model::save: Optimizer state does not match the model's parameters");
+            }
+            records.push_back(make_record(TensorRole::OptimizerState, state[j]->rows, state[j]->cols,
+                                          0, static_cast<std::uint32_t>(j)));
+            sections.push_back(state[j]);
+        }
+    }
+
+    // Lay out the sections after the tables, each on its own pages
+    std::uint64_t end = sizeof(ModelFileHeader) + layer_records.size() * sizeof(LayerRecord)
+                      + records.size() * sizeof(TensorRecord);
+    for (std::size_t k = 0; k < records.size(); ++k){
+        if (!sections[k]) continue;
+        records[k].offset = page_align(end);
+        end = records[k].offset + sections[k]->size() * sizeof(T);
+    }
+    std::size_t next_parameter = 0;
+    for (TensorRecord& r : records){
+        if (r.role == static_cast<std::uint32_t>(TensorRole::Parameter)){
+            r.offset = records[0].offset + parameter_offsets[next_parameter++] * sizeof(T);
+        }
+    }
+
+    ModelFileHeader header{};
+    std::memcpy(header.magic, MODEL_MAGIC, sizeof(header.magic));
+    header.version = MODEL_FILE_VERSION;
+    header.dtype = static_cast<std::uint32_t>(dtype_of<T>());
+    header.layer_count = static_cast<std::uint32_t>(layer_records.size());
+    header.tensor_count = static_cast<std::uint32_t>(records.size());
+    header.file_bytes = end;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out){
+        throw std::runtime_error("Model::save: Cannot open " + path);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(layer_records.data()),
+              static_cast<std::streamsize>(layer_records.size() * sizeof(LayerRecord)));
+    out.write(reinterpret_cast<const char*>(records.data()),
+              static_cast<std::streamsize>(records.size() * sizeof(TensorRecord)));
+
+    std::uint64_t position = sizeof(ModelFileHeader) + layer_records.size() * sizeof(LayerRecord)
+                           + records.size() * sizeof(TensorRecord);
+    const char zeros[MODEL_FILE_PAGE] = {};
+    for (std::size_t k = 0; k < records.size(); ++k){
+        if (!sections[k]) continue;
+        out.write(zeros, static_cast<std::streamsize>(records[k].offset - position));
+        const Matrix<T>& m = *sections[k];
+        for (int i = 0; i < m.rows; ++i){
+            out.write(reinterpret_cast<const char*>(m.row(i)), static_cast<std::streamsize>(m.cols * sizeof(T)));
+        }
+        position = records[k].offset + m.size() * sizeof(T);
+    }
+    if (!out){
+        throw std::runtime_error("Model::save: Write failed for " + path);
+    }
+}
+
+/// Loads a saved model by mapping it (see model.hpp)
+///
+/// Only the header and the two tables are read here. Layers are built with
+/// deferred parameters, which are then rebound to their mapped slices;
+/// the tensors are validated against the file size but not touched.
+template <typename T>
+void Model<T>::load(const std::string& path, Optimizer<T>* optimizer){
+    if (!layers.empty()){
+        throw std::invalid_argument("Model::load: The model already has layers");
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        throw std::runtime_error("Model::load: Cannot open " + path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0){
+        ::close(fd);
+        throw std::runtime_error("Model::load: Cannot stat " + path);
+    }
+    std::size_t file_bytes = static_cast<std::size_t>(st.st_size);
+    if (file_bytes < sizeof(ModelFileHeader)){
+        ::close(fd);
+        throw std::invalid_argument("Model::load: File too small for a header: " + path);
+    }
+
+    // Private and writable: pages are shared with the page cache until a
+    // write copies them, and the file itself never changes
+    void* p = ::mmap(nullptr, file_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED){
+        throw std::runtime_error("Model::load: mmap failed for " + path);
+    }
+    std::shared_ptr<void> file(p, [file_bytes](void* q){ ::munmap(q, file_bytes); });
+    char* base = static_cast<char*>(p);
+
+    const ModelFileHeader* header = reinterpret_cast<const ModelFileHeader*>(base);
+    std::uint64_t tables_end = sizeof(ModelFileHeader)
+                             + std::uint64_t(header->layer_count) * sizeof(LayerRecord)
+                             + std::uint64_t(header->tensor_count) * sizeof(TensorRecord);
+    if (std::memcmp(header->magic, MODEL_MAGIC, sizeof(MODEL_MAGIC)) != 0){
+        throw std::invalid_argument("Model::load: Bad magic in " + path);
+    }
+    if (header->version != MODEL_FILE_VERSION){
+        throw std::invalid_argument("Model::load: Unsupported version in " + path);
+    }
+    if (header->dtype != static_cast<std::uint32_t>(dtype_of<T>())){
+        throw std::invalid_argument("Model::load: Element type does not match in " + path);
+    }
+    if (header->file_bytes != file_bytes || tables_end > file_bytes){
+        throw std::invalid_argument("Model::load: Truncated file " + path);
+    }
+
+    const LayerRecord* layer_records = reinterpret_cast<const LayerRecord*>(base + sizeof(ModelFileHeader));
+    const TensorRecord* records = reinterpret_cast<const TensorRecord*>(layer_records + header->layer_count);
+
+    std::vector<std::unique_ptr<Layer<T>>> built;
+    std::vector<std::vector<Parameter<T>>> params;
+    std::vector<std::vector<Matrix<T>*>> states;
+    std::vector<std::vector<bool>> bound;
+    for (std::uint32_t i = 0; i < header->layer_count; ++i){
+        const LayerRecord& r = layer_records[i];
+        LayerSpec spec;
+        spec.kind = static_cast<LayerKind>(r.kind);
+        spec.activation = r.activation;
+        spec.input_dim = r.input_dim;
+        spec.output_dim = r.output_dim;
+        spec.value = r.value;
+        built.push_back(make_layer<T>(spec));
+        params.push_back(built.back()->parameters());
+        states.push_back(built.back()->state());
+        bound.emplace_back(params.back().size() + states.back().size(), false);
+    }
+
+    const TensorRecord* parameter_buffer = nullptr;
+    std::vector<const TensorRecord*> optimizer_state;
+
+    for (std::uint32_t k = 0; k < header->tensor_count; ++k){
+        const TensorRecord& r = records[k];
+        std::uint64_t bytes = std::uint64_t(r.rows) * r.cols * sizeof(T);
+        if (r.rows > static_cast<std::uint32_t>(std::numeric_limits<int>::max()) ||
+            r.cols > static_cast<std::uint32_t>(std::numeric_limits<int>::max()) ||
+            r.offset % sizeof(T) != 0 || r.offset < tables_end ||
+            r.offset > file_bytes || bytes > file_bytes - r.offset){
+            throw std::invalid_argument("Model::load: Tensor outside the file in " + path);
+        }
+        T* data = reinterpret_cast<T*>(base + r.offset);
+
+        TensorRole role = static_cast<TensorRole>(r.role);
+        if (role == TensorRole::ParameterBuffer){
+            parameter_buffer = &r;
+        }else if (role == TensorRole::OptimizerState){
+            optimizer_state.push_back(&r);
+        }else if (role == TensorRole::Parameter || role == TensorRole::LayerState){
+            bool is_parameter = role == TensorRole::Parameter;
+            std::size_t count = r.layer < built.size()
+                              ? (is_parameter ? params[r.layer].size() : states[r.layer].size()) : 0;
+            if (r.index >= count){
+                throw std::invalid_argument("Model::load: Tensor for a missing layer slot in " + path);
+            }
+            Matrix<T>& m = is_parameter ? *params[r.layer][r.index].value : *states[r.layer][r.index];
+            if (m.rows != static_cast<int>(r.rows) || m.cols != static_cast<int>(r.cols)){
+                throw std::invalid_argument("Model::load: Tensor shape does not match its layer in " + path);
+            }
+            m.rebind(data, m.rows, m.cols);
+            bound[r.layer][is_parameter ? r.index : params[r.layer].size() + r.index] = true;
+        }else{
+            throw std::invalid_argument("Model::load: Unknown tensor role in " + path);
+        }
+    }
+
+    for (const std::vector<bool>& flags : bound){
+        for (bool b : flags){
+            if (!b) throw std::invalid_argument("Model::load: Layer tensor missing from " + path);
+        }
+    }
+
+    // Optimizer state is indexed like the flat parameter buffer, which
+    // bind_parameters lays out again in the same order
+    if (optimizer && !optimizer_state.empty()){
+        std::vector<Matrix<T>*> state = optimizer->state();
+        if (!parameter_buffer || state.size() != optimizer_state.size()){
+            throw std::invalid_argument("Model::load: Optimizer state does not match the optimizer in " + path);
+        }
+        for (const TensorRecord* r : optimizer_state){
+            if (r->index >= state.size() || r->rows != parameter_buffer->rows || r->cols != parameter_buffer->cols){
+                throw std::invalid_argument("Model::load: Optimizer state does not match the model in " + path);
+            }
+        }
+        for (const TensorRecord* r : optimizer_state){
+            // Copied: the optimizer may outlive the mapping
+            Matrix<T> saved = Matrix<T>::view(reinterpret_cast<T*>(base + r->offset),
+                                              static_cast<int>(r->rows), static_cast<int>(r->cols));
+            *state[r->index] = saved;
+        }
+    }
+
+    for (std::unique_ptr<Layer<T>>& layer : built){
+        add(layer.get());
+        owned_layers.push_back(std::move(layer));
+    }
+    mapping = std::move(file);
+}
+
+template void Model<float>::save(const std::string&, Optimizer<float>*);
+template void Model<double>::save(const std::string&, Optimizer<double>*);
+template void Model<float>::load(const std::string&, Optimizer<float>*);
+template void Model<double>::load(const std::string&, Optimizer<double>*);
@@ -0,0 +1,230 @@
+#include "profiler.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace profiling {
+
+std::atomic<int> active_profilers{0};
+
+namespace {
+
+std::atomic<std::uint64_t> allocation_count{0};
+std::atomic<std::uint64_t> allocation_bytes{0};
+std::atomic<long long> matrix_live{0};
+std::atomic<long long> matrix_peak{0};
+
+} // namespace
+
+void count_allocation(std::size_t bytes){
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void count_matrix_bytes(long long delta){
+    long long now = matrix_live.fetch_add(delta, std::memory_order_relaxed) + delta;
+    long long peak = matrix_peak.load(std::memory_order_relaxed);
+    while (now > peak && !matrix_peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)){}
+}
+
+} // namespace profiling
+
+namespace {
+
+// Small per-thread ids for the trace, in order of first use
+int thread_index(){
+    static std::atomic<int> next{0};
+    thread_local int index = next.fetch_add(1);
+    return index;
+}
+
+std::string json_string(const std::string& s){
+    std::string out = "\"";
+    for (char c : s){
+        if (c == '"' || c == '\\'){
+            out += '\\';
+            out += c;
+        }else if (static_cast<unsigned char>(c) < 0x20){
+            // Control characters may not appear raw in a JSON string
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            out += escaped;
+        }else{
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Summary order of the phases; unknown categories sort last
+int phase_rank(const std::string& category){
+    static const char* const order[] = {"forward", "recompute", "backward", "loss", "reduce", "sync", "optimizer", "epoch"};
+    for (int i = 0; i < 8; ++i){
+        if (category == order[i]) return i;
+    }
+    return 8;
+}
+
+} // namespace
+
+Profiler::Profiler(std::size_t max_events) : origin(Clock::now()), max_events(max_events){
+    profiling::active_profilers.fetch_add(1);
+    reset();
+}
+
+Profiler::~Profiler(){
+    profiling::active_profilers.fetch_sub(1);
+}
+
+std::uint64_t Profiler::now_ns() const {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - origin).count());
+}
+
+Profiler::Mark Profiler::begin() const {
+    return {now_ns(),
+            profiling::allocation_count.load(std::memory_order_relaxed),
+            profiling::allocation_bytes.load(std::memory_order_relaxed)};
+}
+
+void Profiler::end(const Mark& mark, const std::string& name, const char* category, int layer,
+                   double flops, double bytes){
+    std::uint64_t stop = now_ns();
+    // Allocation counts are process-wide: with several threads recording,
+    // an event also sees the allocations of whatever overlapped it
+    std::uint64_t allocations = profiling::allocation_count.load(std::memory_order_relaxed) - mark.allocations;
+    std::uint64_t allocated = profiling::allocation_bytes.load(std::memory_order_relaxed) - mark.allocated_bytes;
+    long long live = profiling::matrix_live.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Totals& t = totals[{layer, category}];
+    if (t.calls == 0) t.name = name;
+    t.calls++;
+    t.ns += stop - mark.start_ns;
+    t.flops += flops;
+    t.bytes += bytes;
+    t.allocations += allocations;
+
+    if (recorded.size() >= max_events){
+        dropped++;
+        return;
+    }
+    recorded.push_back({name, category, layer, mark.start_ns, stop - mark.start_ns, flops, bytes,
+                        allocations, allocated, live - matrix_base, thread_index()});
+}
+
+void Profiler::reset(){
+    std::lock_guard<std::mutex> lock(mutex);
+    recorded.clear();
+    totals.clear();
+    dropped = 0;
+    allocation_base = profiling::allocation_count.load();
+    allocated_bytes_base = profiling::allocation_bytes.load();
+    matrix_base = profiling::matrix_live.load();
+    profiling::matrix_peak.store(matrix_base);
+}
+
+std::vector<Profiler::Event> Profiler::events() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recorded;
+}
+
+std::uint64_t Profiler::allocations() const {
+    return profiling::allocation_count.load() - allocation_base;
+}
+
+std::uint64_t Profiler::allocated_bytes() const {
+    return profiling::allocation_bytes.load() - allocated_bytes_base;
+}
+
+long long Profiler::peak_matrix_bytes() const {
+    return profiling::matrix_peak.load() - matrix_base;
+}
+
+void Profiler::print_summary(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    using Row = std::pair<const std::pair<int, std::string>, Totals>;
+    std::vector<const Row*> rows;
+    // Epochs contain every other event, so they stay out of the share of time
+    std::uint64_t total_ns = 0;
+    std::size_t events = 0;
+    for (const Row& row : totals){
+        rows.push_back(&row);
+        events += row.second.calls;
+        if (row.first.second != "epoch") total_ns += row.second.ns;
+    }
+    // Layers in model order, then the model-level phases
+    std::sort(rows.begin(), rows.end(), [](const Row* a, const Row* b){
+        int la = a->first.first < 0 ? 1 << 30 : a->first.first;
+        int lb = b->first.first < 0 ? 1 << 30 : b->first.first;
+        if (la != lb) return la < lb;
+        return phase_rank(a->first.second) < phase_rank(b->first.second);
+    });
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-32s %-10s %8s %11s %11s %7s %9s %8s %8s\n",
+                  "Layer", "Phase", "Calls", "Total ms", "Mean us", "Time %", "GFLOP/s", "GB/s", "Allocs");
+    out << line << std::string(112, '-') << "\n";
+    for (const Row* row : rows){
+        const Totals& t = row->second;
+        std::string label = row->first.first < 0
+            ? t.name
+            : "[" + std::to_string(row->first.first) + "] " + t.name;
+        double seconds = t.ns * 1e-9;
+        double share = total_ns && row->first.second != "epoch" ? 100.0 * t.ns / total_ns : 0.0;
+        std::snprintf(line, sizeof(line), "%-32.32s %-10s %8llu %11.3f %11.2f %7.1f %9.2f %8.2f %8llu\n",
+                      label.c_str(), row->first.second.c_str(),
+                      static_cast<unsigned long long>(t.calls),
+                      seconds * 1e3, seconds * 1e6 / t.calls, share,
+                      seconds > 0 ? t.flops / seconds * 1e-9 : 0.0,
+                      seconds > 0 ? t.bytes / seconds * 1e-9 : 0.0,
+                      static_cast<unsigned long long>(t.allocations));
+        out << line;
+    }
+    out << std::string(112, '-') << "\n";
+
+    std::snprintf(line, sizeof(line), "Profiled time: %.3f ms over %zu events", total_ns * 1e-6, events);
+    out << line;
+    if (dropped) out << " (" << dropped << " not kept for the trace)";
+    std::snprintf(line, sizeof(line), "\nHeap allocations: %llu (%.2f MB), peak live Matrix memory: %.2f MB\n",
+                  static_cast<unsigned long long>(allocations()), allocated_bytes() / 1048576.0,
+                  peak_matrix_bytes() / 1048576.0);
+    out << line;
+}
+
+void Profiler::write_chrome_trace(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out){
+        throw std::runtime_error("Profiler::write_chrome_trace: Cannot open " + path);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    char number[64];
+    auto us = [&](std::uint64_t ns) -> const char* {
+        std::snprintf(number, sizeof(number), "%.3f", ns * 1e-3);
+        return number;
+    };
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": \"Neuronite\"}}";
+    for (const Event& e : recorded){
+        out << ",\n  {\"name\": " << json_string(e.name)
+            << ", \"cat\": " << json_string(e.category)
+            << ", \"ph\": \"X\", \"pid\": 0, \"tid\": " << e.thread
+            << ", \"ts\": " << us(e.start_ns);
+        out << ", \"dur\": " << us(e.duration_ns)
+            << ", \"args\": {\"layer\": " << e.layer
+            << ", \"flops\": " << e.flops
+            << ", \"bytes\": " << e.bytes
+            << ", \"allocations\": " << e.allocations
+            << ", \"allocated_bytes\": " << e.allocated_bytes << "}}";
+        out << ",\n  {\"name\": \"Matrix memory\", \"ph\": \"C\", \"pid\": 0, \"ts\": " << us(e.start_ns + e.duration_ns)
+            << ", \"args\": {\"live_bytes\": " << e.live_matrix_bytes << "}}";
+    }
+    out << "\n]}\n";
+    if (!out){
+        throw std::runtime_error("Profiler::write_chrome_trace: Failed writing " + path);
+    }
+}
@@ -0,0 +1,133 @@
+#include "qgemm.hpp"
+#include "qgemm_impl.hpp"
+#include "kernels.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define NEURONITE_HAS_CPUID 1
+#endif
+
+namespace qgemm {
+
+namespace {
+
+using impl::PANEL;
+using impl::GROUP;
+
+// Portable kernel, also the reference for the vector ones
+void scalar_kernel(int M, int N, int K4,
+                   const std::int8_t* A, int lda,
+                   const std::int8_t* packed_b, const std::int32_t* /*col_sums*/,
+                   int p0, int p1, std::int32_t* C, int ldc){
+    for (int p = p0; p < p1; ++p){
+        const std::int8_t* panel = packed_b + static_cast<std::size_t>(p) * K4 * PANEL;
+        int cols = std::min(PANEL, N - p * PANEL);
+        for (int i = 0; i < M; ++i){
+            const std::int8_t* a = A + static_cast<std::size_t>(i) * lda;
+            std::int32_t acc[PANEL] = {};
+            for (int g = 0; g < K4 / GROUP; ++g){
+                const std::int8_t* b = panel + g * PANEL * GROUP;
+                const std::int8_t* x = a + g * GROUP;
+                for (int c = 0; c < PANEL; ++c){
+                    for (int u = 0; u < GROUP; ++u) acc[c] += x[u] * b[c * GROUP + u];
+                }
+            }
+            std::copy(acc, acc + cols, C + static_cast<std::size_t>(i) * ldc + p * PANEL);
+        }
+    }
+}
+
+// AVX-512 VNNI needs AVX512BW for its byte lanes as well; the ZMM state
+// check is already part of kernels::detect_isa
+bool cpu_has_vnni(){
+#ifdef NEURONITE_HAS_CPUID
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    bool avx512bw = ebx & (1u << 30);
+    bool avx512_vnni = ecx & (1u << 11);
+    return avx512bw && avx512_vnni;
+#else
+    return false;
+#endif
+}
+
+struct Selected {
+    impl::Kernel kernel;
+    const char* name;
+};
+
+Selected select_kernel(){
+    kernels::Isa isa = kernels::active<float>().isa;
+    if (isa >= kernels::Isa::AVX512 && cpu_has_vnni()){
+        if (impl::Kernel k = impl::vnni_kernel()) return {k, "vnni"};
+    }
+    if (isa >= kernels::Isa::AVX2){
+        if (impl::Kernel k = impl::avx2_kernel()) return {k, "avx2"};
+    }
+    return {&scalar_kernel, "scalar"};
+}
+
+const Selected& selected(){
+    static const Selected s = select_kernel();
+    return s;
+}
+
+// Multiply-adds per parallel chunk; smaller products run on the caller
+constexpr std::size_t PARALLEL_MACS = std::size_t(1) << 18;
+
+} // namespace
+
+int padded_k(int K){
+    return (K + GROUP - 1) / GROUP * GROUP;
+}
+
+int padded_n(int N){
+    return (N + PANEL - 1) / PANEL * PANEL;
+}
+
+void pack_b(const std::int8_t* B, int ldb, int K, int N,
+            std::int8_t* packed, std::int32_t* col_sums){
+    int K4 = padded_k(K);
+    int NP = padded_n(N);
+    std::fill(packed, packed + static_cast<std::size_t>(K4) * NP, std::int8_t(0));
+    std::fill(col_sums, col_sums + NP, 0);
+
+    for (int k = 0; k < K; ++k){
+        const std::int8_t* row = B + static_cast<std::size_t>(k) * ldb;
+        for (int j = 0; j < N; ++j){
+            int p = j / PANEL, c = j % PANEL;
+            std::size_t at = static_cast<std::size_t>(p) * K4 * PANEL
+                           + static_cast<std::size_t>(k / GROUP) * PANEL * GROUP
+                           + c * GROUP + k % GROUP;
+            packed[at] = row[j];
+            col_sums[j] += row[j];
+        }
+    }
+}
+
+void gemm(int M, int N, int K,
+          const std::int8_t* A, int lda,
+          const std::int8_t* packed_b, const std::int32_t* col_sums,
+          std::int32_t* C, int ldc){
+    if (M <= 0 || N <= 0) return;
+    int K4 = padded_k(K);
+    int panels = padded_n(N) / PANEL;
+
+    // Panels are independent, so threads split the columns; one batch
+    // row (latency-bound serving) still gets every core
+    std::size_t macs_per_panel = static_cast<std::size_t>(M) * std::max(K4, GROUP) * PANEL;
+    std::size_t grain = std::max<std::size_t>(1, PARALLEL_MACS / macs_per_panel);
+
+    impl::Kernel kernel = selected().kernel;
+    parallel_for(static_cast<std::size_t>(panels), grain, [&](std::size_t p0, std::size_t p1){
+        kernel(M, N, K4, A, lda, packed_b, col_sums, static_cast<int>(p0), static_cast<int>(p1), C, ldc);
+    });
+}
+
+const char* kernel_name(){
+    return selected().name;
+}
+
+} // namespace qgemm
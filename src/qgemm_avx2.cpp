@@ -0,0 +1,94 @@
+#include "qgemm_impl.hpp"
+
+// Built with -mavx2 (see CMakeLists.txt). Only reached after
+// kernels::detect_isa() has confirmed AVX2 at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__AVX2__)
+
+#include <immintrin.h>
+#include <cstring>
+
+namespace qgemm {
+namespace impl {
+
+namespace {
+
+constexpr int MR = 4;
+constexpr int HALF = PANEL / 2;   // 8 columns, one ymm of int32 results
+
+// vpmaddubsw would saturate its int16 pair sums on full-range int8 data,
+// so both operands are sign-extended to int16 and multiplied with
+// vpmaddwd, which adds pairs into exact int32 lanes. One 4-deep group of
+// 8 columns is 32 bytes of B: sign-extended, columns 0-3 fill `lo` and 4-7
+// fill `hi`, each column as two adjacent pair sums that are folded
+// together at the end.
+template <int R>
+void tile(int K4, const std::int8_t* A, int lda, const std::int8_t* panel,
+          std::int32_t* C, int ldc, int cols){
+    __m256i lo[R], hi[R];
+    for (int r = 0; r < R; ++r){
+        lo[r] = _mm256_setzero_si256();
+        hi[r] = _mm256_setzero_si256();
+    }
+
+    for (int g = 0; g < K4 / GROUP; ++g){
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(panel + g * PANEL * GROUP));
+        __m256i b_lo = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(b));
+        __m256i b_hi = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(b, 1));
+        for (int r = 0; r < R; ++r){
+            std::int32_t quad;
+            std::memcpy(&quad, A + static_cast<std::size_t>(r) * lda + g * GROUP, sizeof(quad));
+            __m256i a = _mm256_cvtepi8_epi16(_mm_set1_epi32(quad));
+            lo[r] = _mm256_add_epi32(lo[r], _mm256_madd_epi16(b_lo, a));
+            hi[r] = _mm256_add_epi32(hi[r], _mm256_madd_epi16(b_hi, a));
+        }
+    }
+
+    // hadd leaves columns in the order 0 1 4 5 | 2 3 6 7
+    const __m256i order = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+    __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(cols), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    for (int r = 0; r < R; ++r){
+        __m256i sums = _mm256_permutevar8x32_epi32(_mm256_hadd_epi32(lo[r], hi[r]), order);
+        _mm256_maskstore_epi32(reinterpret_cast<int*>(C + static_cast<std::size_t>(r) * ldc), mask, sums);
+    }
+}
+
+using Tile = void (*)(int, const std::int8_t*, int, const std::int8_t*, std::int32_t*, int, int);
+
+const Tile tiles[MR + 1] = {nullptr, &tile<1>, &tile<2>, &tile<3>, &tile<4>};
+
+void kernel(int M, int N, int K4,
+            const std::int8_t* A, int lda,
+            const std::int8_t* packed_b, const std::int32_t* /*col_sums*/,
+            int p0, int p1, std::int32_t* C, int ldc){
+    for (int p = p0; p < p1; ++p){
+        const std::int8_t* panel = packed_b + static_cast<std::size_t>(p) * K4 * PANEL;
+        for (int h = 0; h < 2; ++h){
+            int j0 = p * PANEL + h * HALF;
+            if (j0 >= N) break;
+            int cols = N - j0 < HALF ? N - j0 : HALF;
+            // The half's 32 bytes sit at offset 32h of every 64-byte group
+            for (int i = 0; i < M; i += MR){
+                int rows = M - i < MR ? M - i : MR;
+                tiles[rows](K4, A + static_cast<std::size_t>(i) * lda, lda, panel + h * HALF * GROUP,
+                            C + static_cast<std::size_t>(i) * ldc + j0, ldc, cols);
+            }
+        }
+    }
+}
+
+} // namespace
+
+Kernel avx2_kernel(){ return &kernel; }
+
+} // namespace impl
+} // namespace qgemm
+
+#else
+
+namespace qgemm {
+namespace impl {
+Kernel avx2_kernel(){ return nullptr; }
+} // namespace impl
+} // namespace qgemm
+
+#endif
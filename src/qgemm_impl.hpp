@@ -0,0 +1,29 @@
+#ifndef QGEMM_IMPL_HPP
+#define QGEMM_IMPL_HPP
+
+#include <cstdint>
+
+// Micro-kernels behind qgemm::gemm (see qgemm.hpp). Like kernel_table.hpp,
+// this header holds declarations only, because qgemm_avx2.cpp and
+// qgemm_vnni.cpp include it under -mavx2 / -mavx512vnni.
+namespace qgemm {
+namespace impl {
+
+constexpr int PANEL = 16;   // columns per packed panel
+constexpr int GROUP = 4;    // k values per column within a group
+
+// Computes the columns of C covered by panels [p0, p1), for all M rows.
+// K4 is the padded depth; only columns below N are written.
+using Kernel = void (*)(int M, int N, int K4,
+                        const std::int8_t* A, int lda,
+                        const std::int8_t* packed_b, const std::int32_t* col_sums,
+                        int p0, int p1, std::int32_t* C, int ldc);
+
+// Each returns nullptr when its instruction set was not compiled in
+Kernel avx2_kernel();
+Kernel vnni_kernel();
+
+} // namespace impl
+} // namespace qgemm
+
+#endif
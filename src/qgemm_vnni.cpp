@@ -0,0 +1,81 @@
+#include "qgemm_impl.hpp"
+
+// Built with -mavx512f -mavx512bw -mavx512vnni (see CMakeLists.txt). Only
+// reached after qgemm has confirmed AVX-512 VNNI at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__AVX512VNNI__) && defined(__AVX512BW__)
+
+#include <immintrin.h>
+#include <cstring>
+
+namespace qgemm {
+namespace impl {
+
+namespace {
+
+constexpr int MR = 8;
+
+// vpdpbusd multiplies unsigned by signed bytes, so A is shifted into
+// [1, 255] by flipping its sign bits (x + 128), and the extra
+// 128 · Σ_k B(k, j) is taken off each column at the end.
+template <int R>
+void tile(int K4, const std::int8_t* A, int lda, const std::int8_t* panel,
+          const std::int32_t* col_sums, std::int32_t* C, int ldc, __mmask16 mask){
+    __m512i acc[R];
+    for (int r = 0; r < R; ++r) acc[r] = _mm512_setzero_si512();
+
+    const __m512i flip = _mm512_set1_epi32(static_cast<int>(0x80808080u));
+    for (int g = 0; g < K4 / GROUP; ++g){
+        __m512i b = _mm512_loadu_si512(panel + g * PANEL * GROUP);
+        for (int r = 0; r < R; ++r){
+            std::int32_t quad;
+            std::memcpy(&quad, A + static_cast<std::size_t>(r) * lda + g * GROUP, sizeof(quad));
+            __m512i a = _mm512_xor_si512(_mm512_set1_epi32(quad), flip);
+            acc[r] = _mm512_dpbusd_epi32(acc[r], a, b);
+        }
+    }
+
+    __m512i correction = _mm512_slli_epi32(_mm512_maskz_loadu_epi32(mask, col_sums), 7);
+    for (int r = 0; r < R; ++r){
+        _mm512_mask_storeu_epi32(C + static_cast<std::size_t>(r) * ldc, mask,
+                                 _mm512_sub_epi32(acc[r], correction));
+    }
+}
+
+using Tile = void (*)(int, const std::int8_t*, int, const std::int8_t*,
+                      const std::int32_t*, std::int32_t*, int, __mmask16);
+
+const Tile tiles[MR + 1] = {nullptr, &tile<1>, &tile<2>, &tile<3>, &tile<4>,
+                            &tile<5>, &tile<6>, &tile<7>, &tile<8>};
+
+void kernel(int M, int N, int K4,
+            const std::int8_t* A, int lda,
+            const std::int8_t* packed_b, const std::int32_t* col_sums,
+            int p0, int p1, std::int32_t* C, int ldc){
+    for (int p = p0; p < p1; ++p){
+        const std::int8_t* panel = packed_b + static_cast<std::size_t>(p) * K4 * PANEL;
+        int cols = N - p * PANEL;
+        __mmask16 mask = cols >= PANEL ? __mmask16(0xFFFF) : __mmask16((1u << cols) - 1);
+        for (int i = 0; i < M; i += MR){
+            int rows = M - i < MR ? M - i : MR;
+            tiles[rows](K4, A + static_cast<std::size_t>(i) * lda, lda, panel, col_sums + p * PANEL,
+                        C + static_cast<std::size_t>(i) * ldc + p * PANEL, ldc, mask);
+        }
+    }
+}
+
+} // namespace
+
+Kernel vnni_kernel(){ return &kernel; }
+
+} // namespace impl
+} // namespace qgemm
+
+#else
+
+namespace qgemm {
+namespace impl {
+Kernel vnni_kernel(){ return nullptr; }
+} // namespace impl
+} // namespace qgemm
+
+#endif
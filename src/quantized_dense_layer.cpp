@@ -0,0 +1,171 @@
+#include "quantized_dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "aligned_memory.hpp"
+#include "kernels.hpp"
+#include "qgemm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+// Nearest integer to x / scale, saturated to the symmetric int8 range
+template <typename T>
+std::int8_t quantize(T x, T inv_scale){
+    T q = std::nearbyint(x * inv_scale);
+    return static_cast<std::int8_t>(std::min(T(127), std::max(T(-127), q)));
+}
+
+} // namespace
+
+// Quantizes the source's current weights column by column and packs them
+// for qgemm; the bias is kept as is
+template <typename T>
+QuantizedDenseLayer<T>::QuantizedDenseLayer(const DenseLayer<T>& source)
+    : input_dim(source.weights.rows),
+      output_dim(source.weights.cols),
+      activation(Activation::None),
+      column_sums(qgemm::padded_n(source.weights.cols)),
+      weight_scales(source.weights.cols),
+      bias(source.bias){
+    if (input_dim > qgemm::MAX_K){
+        throw std::invalid_argument("QuantizedDenseLayer: Input dimension too large for int32 accumulation");
+    }
+    if (const FusedDenseLayer<T>* fused = dynamic_cast<const FusedDenseLayer<T>*>(&source)){
+        activation = fused->get_activation();
+    }
+
+    const Matrix<T>& w = source.weights;
+
+    // s_j = max_k |W(k, j)| / 127; an all-zero column keeps scale 1
+    std::vector<T> column_max(output_dim, T(0));
+    for (int k = 0; k < input_dim; ++k){
+        for (int j = 0; j < output_dim; ++j){
+            column_max[j] = std::max(column_max[j], std::abs(w(k, j)));
+        }
+    }
+    std::vector<T> inv_scales(output_dim);
+    for (int j = 0; j < output_dim; ++j){
+        weight_scales[j] = column_max[j] > 0 ? column_max[j] / 127 : T(1);
+        inv_scales[j] = T(1) / weight_scales[j];
+    }
+
+    std::vector<std::int8_t> q(static_cast<std::size_t>(input_dim) * output_dim);
+    for (int k = 0; k < input_dim; ++k){
+        for (int j = 0; j < output_dim; ++j){
+            q[static_cast<std::size_t>(k) * output_dim + j] = quantize(w(k, j), inv_scales[j]);
+        }
+    }
+
+    packed_weights = static_cast<std::int8_t*>(aligned_malloc(weight_bytes()));
+    qgemm::pack_b(q.data(), output_dim, input_dim, output_dim, packed_weights, column_sums.data());
+}
+
+template <typename T>
+QuantizedDenseLayer<T>::~QuantizedDenseLayer(){
+    aligned_free(packed_weights);
+}
+
+// Inference pass
+// 1. s_x = max |X| / 127 over the batch; X is quantized into the workspace
+//    with its rows padded to the packed depth
+// 2. int8 GEMM into an int32 block, also from the workspace
+// 3. Y = act(C · s_x s_j + b), one row at a time
+template <typename T>
+void QuantizedDenseLayer<T>::infer_into(const Matrix<T>& input, Matrix<T>& output, Workspace& ws) const{
+    if (input.cols != input_dim){
+        throw std::invalid_argument("QuantizedDenseLayer: Input has " + std::to_string(input.cols) +
+                                    " columns, expected " + std::to_string(input_dim));
+    }
+    int M = input.rows;
+    output.resize(M, output_dim);
+    if (M == 0) return;
+
+    T amax = 0;
+    for (int i = 0; i < M; ++i){
+        const T* x = input.row(i);
+        for (int k = 0; k < input_dim; ++k) amax = std::max(amax, std::abs(x[k]));
+    }
+    T x_scale = amax > 0 ? amax / 127 : T(1);
+    T inv_x_scale = T(1) / x_scale;
+
+    int K4 = qgemm::padded_k(input_dim);
+    std::int8_t* qx = static_cast<std::int8_t*>(ws.allocate(static_cast<std::size_t>(M) * K4));
+    for (int i = 0; i < M; ++i){
+        const T* x = input.row(i);
+        std::int8_t* q = qx + static_cast<std::size_t>(i) * K4;
+        for (int k = 0; k < input_dim; ++k) q[k] = quantize(x[k], inv_x_scale);
+        std::fill(q + input_dim, q + K4, std::int8_t(0));
+    }
+
+    std::int32_t* acc = static_cast<std::int32_t*>(
+        ws.allocate(static_cast<std::size_t>(M) * output_dim * sizeof(std::int32_t)));
+    qgemm::gemm(M, output_dim, input_dim, qx, K4, packed_weights, column_sums.data(), acc, output_dim);
+
+    T* scale = static_cast<T*>(ws.allocate(output_dim * sizeof(T)));
+    for (int j = 0; j < output_dim; ++j) scale[j] = x_scale * weight_scales[j];
+
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    const T* b = bias.data();
+    for (int i = 0; i < M; ++i){
+        const std::int32_t* c = acc + static_cast<std::size_t>(i) * output_dim;
+        T* y = output.row(i);
+        for (int j = 0; j < output_dim; ++j) y[j] = static_cast<T>(c[j]) * scale[j] + b[j];
+        if (activation == Activation::ReLU){
+            k.relu(y, y, output_dim);
+        }else if (activation == Activation::Sigmoid){
+            k.sigmoid_forward(y, y, output_dim);
+        }
+    }
+}
+
+template <typename T>
+void QuantizedDenseLayer<T>::forward_into(const Matrix<T>& input, Matrix<T>& output){
+    input_shape = {input.rows, input.cols};
+    infer_into(input, output, this->begin_scratch());
+    output_shape = {output.rows, output.cols};
+}
+
+template <typename T>
+void QuantizedDenseLayer<T>::backward_into(const Matrix<T>& /*grad_output*/, Matrix<T>& /*grad_input*/){
+    throw std::invalid_argument("QuantizedDenseLayer::backward: Quantized layers are inference-only.");
+}
+
+template <typename T>
+std::string QuantizedDenseLayer<T>::get_name() const {
+    std::string act = (activation == Activation::ReLU) ? "+ReLU"
+                    : (activation == Activation::Sigmoid) ? "+Sigmoid" : "";
+    return "QDense" + act + "(" + std::to_string(input_dim) + " -> " + std::to_string(output_dim) + ")";
+}
+
+template <typename T>
+std::pair<int,int> QuantizedDenseLayer<T>::get_input_shape() const {
+    return input_shape;
+}
+
+template <typename T>
+std::pair<int,int> QuantizedDenseLayer<T>::get_output_shape() const {
+    return output_shape;
+}
+
+template <typename T>
+int QuantizedDenseLayer<T>::param_count() const{
+    return input_dim * output_dim + output_dim;
+}
+
+template <typename T>
+std::pair<int,int> QuantizedDenseLayer<T>::infer_output_shape(std::pair<int,int> input) const{
+    if (input.second != input_dim){
+        throw std::invalid_argument("QuantizedDenseLayer: Expected " + std::to_string(input_dim) +
+                                    " input columns, got " + std::to_string(input.second));
+    }
+    return {input.first, output_dim};
+}
+
+template <typename T>
+std::size_t QuantizedDenseLayer<T>::weight_bytes() const{
+    return static_cast<std::size_t>(qgemm::padded_k(input_dim)) * qgemm::padded_n(output_dim);
+}
+
+template class QuantizedDenseLayer<float>;
+template class QuantizedDenseLayer<double>;
@@ -0,0 +1,49 @@
+#include "sgd_optimizer.hpp"
+#include "kernels.hpp"
+#include <stdexcept>
+
+template <typename T>
+SGDOptimizer<T>::SGDOptimizer(double lr, double momentum, bool nesterov, double weight_decay)
+    : lr(lr), momentum(momentum), nesterov(nesterov), weight_decay(weight_decay) {
+    if (nesterov && momentum <= 0){
+        throw std::invalid_argument("SGDOptimizer: Nesterov momentum needs momentum > 0");
+    }
+}
+
+/// One SGD step over the model's flat parameter buffer
+///
+/// The velocity buffer is sized on the first step (and reset if the
+/// parameter count changes). Chunks of the buffer go to the thread pool.
+template <typename T>
+void SGDOptimizer<T>::step(Matrix<T>& params, const Matrix<T>& grads, int /*t*/) {
+    if (params.rows != grads.rows || params.cols != grads.cols){
+        throw std::invalid_argument("SGDOptimizer::step: Parameter and gradient shapes differ");
+    }
+
+    if (velocity.rows != params.rows || velocity.cols != params.cols){
+        velocity = Matrix<T>(params.rows, params.cols);
+    }
+
+    kernels::SgdStep<T> s;
+    s.lr = static_cast<T>(lr);
+    s.momentum = static_cast<T>(momentum);
+    s.weight_decay = static_cast<T>(weight_decay);
+    s.nesterov = nesterov;
+
+    T* theta = params.data();
+    const T* g = grads.data();
+    T* u = velocity.data();
+
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    parallel_for(params.size(), kernels::PARALLEL_GRAIN, [&](std::size_t i0, std::size_t i1){
+        k.sgd_momentum(theta + i0, g + i0, u + i0, s, i1 - i0);
+    }, NEURONITE_ALIGNMENT / sizeof(T));
+}
+
+template <typename T>
+std::vector<Matrix<T>*> SGDOptimizer<T>::state(){
+    return {&velocity};
+}
+
+template class SGDOptimizer<float>;
+template class SGDOptimizer<double>;
@@ -0,0 +1,258 @@
+#include "shm_communicator.hpp"
+#include "kernels.hpp"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::uint32_t SEGMENT_READY = 0x4e4e5348;   // "NNSH"
+constexpr std::size_t HEADER_BYTES = 4096;            // keeps the slots page-aligned
+constexpr int SPINS = 200;
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free,
+              "Shared-memory synchronization needs lock-free 32-bit atomics");
+
+void futex_wait(std::atomic<std::uint32_t>& word, std::uint32_t value){
+    timespec ts{0, 10 * 1000 * 1000};   // re-check the deadline every 10 ms
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, value, &ts, nullptr, 0);
+}
+
+void futex_wake_all(std::atomic<std::uint32_t>& word){
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+} // namespace
+
+// Control block at the start of the segment; the staging slots and result
+// buffers follow at HEADER_BYTES
+struct ShmCommunicator::Header {
+    std::atomic<std::uint32_t> ready;
+    std::uint32_t size;
+    std::uint64_t slot_bytes;
+
+    // Barrier: ranks count in on `arrived`; the last one resets it and
+    // bumps `generation`, which the others wait on
+    alignas(64) std::atomic<std::uint32_t> arrived;
+    alignas(64) std::atomic<std::uint32_t> generation;
+    std::atomic<std::uint32_t> sleepers;   // ranks inside futex_wait
+};
+
+ShmCommunicator::ShmCommunicator(const std::string& name, int rank, int size,
+                                 std::size_t slot_bytes, std::chrono::milliseconds timeout)
+    : name(name), my_rank(rank), world_size(size),
+      slot_bytes((slot_bytes + 63) / 64 * 64), timeout(timeout){
+    if (size < 1 || rank < 0 || rank >= size){
+        throw std::invalid_argument("ShmCommunicator: Rank must be in [0, size)");
+    }
+    if (slot_bytes < sizeof(double)){
+        throw std::invalid_argument("ShmCommunicator: Slot too small");
+    }
+    if (world_size == 1) return;   // nothing to share
+
+    mapped_bytes = HEADER_BYTES + (static_cast<std::size_t>(world_size) + 2) * this->slot_bytes;
+    try{
+        attach();
+        barrier();
+    }catch(...){
+        if (base) munmap(base, mapped_bytes);
+        if (name_linked) shm_unlink(name.c_str());
+        throw;
+    }
+
+    // Everyone is mapped; the name is no longer needed
+    if (name_linked){
+        shm_unlink(name.c_str());
+        name_linked = false;
+    }
+}
+
+ShmCommunicator::~ShmCommunicator(){
+    if (base) munmap(base, mapped_bytes);
+    if (name_linked) shm_unlink(name.c_str());
+}
+
+/// Rank 0 replaces any stale segment of the same name with a fresh one;
+/// the other ranks poll until it exists and is initialized
+void ShmCommunicator::attach(){
+    if (my_rank == 0){
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0){
+            throw std::runtime_error("ShmCommunicator: Cannot create " + name);
+        }
+        name_linked = true;
+        if (ftruncate(fd, static_cast<off_t>(mapped_bytes)) != 0){
+            close(fd);
+            throw std::runtime_error("ShmCommunicator: Cannot size " + name);
+        }
+        void* p = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED){
+            throw std::runtime_error("ShmCommunicator: mmap failed for " + name);
+        }
+        base = static_cast<unsigned char*>(p);
+        header = new (base) Header{};
+        header->size = static_cast<std::uint32_t>(world_size);
+        header->slot_bytes = slot_bytes;
+        header->ready.store(SEGMENT_READY, std::memory_order_release);
+        return;
+    }
+
+    Clock::time_point deadline = Clock::now() + timeout;
+    for (;;){
+        if (Clock::now() >= deadline){
+            throw std::runtime_error("ShmCommunicator: Timed out waiting for rank 0 to create " + name);
+        }
+        int fd = shm_open(name.c_str(), O_RDWR, 0600);
+        if (fd < 0){
+            if (errno != ENOENT) throw std::runtime_error("ShmCommunicator: Cannot open " + name);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < mapped_bytes){
+            // Not sized yet, or a leftover of another job
+            close(fd);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        void* p = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED){
+            throw std::runtime_error("ShmCommunicator: mmap failed for " + name);
+        }
+        Header* h = static_cast<Header*>(p);
+        if (h->ready.load(std::memory_order_acquire) != SEGMENT_READY){
+            munmap(p, mapped_bytes);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (h->size != static_cast<std::uint32_t>(world_size) || h->slot_bytes != slot_bytes){
+            munmap(p, mapped_bytes);
+            throw std::invalid_argument("ShmCommunicator: Ranks disagree on size or slot_bytes for " + name);
+        }
+        base = static_cast<unsigned char*>(p);
+        header = h;
+        return;
+    }
+}
+
+unsigned char* ShmCommunicator::slot(int rank) const{
+    return base + HEADER_BYTES + static_cast<std::size_t>(rank) * slot_bytes;
+}
+
+unsigned char* ShmCommunicator::result(int index) const{
+    return slot(world_size + index);
+}
+
+void ShmCommunicator::barrier(){
+    if (world_size == 1) return;
+    // A rank that gave up is still counted in `arrived`, and would let
+    // the next barrier through before the others reach it
+    if (timed_out){
+        throw std::runtime_error("ShmCommunicator: Unusable after a timed-out collective");
+    }
+
+    std::uint32_t generation = header->generation.load(std::memory_order_acquire);
+    if (header->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == static_cast<std::uint32_t>(world_size)){
+        header->arrived.store(0, std::memory_order_relaxed);
+        header->generation.fetch_add(1, std::memory_order_seq_cst);
+        if (header->sleepers.load(std::memory_order_seq_cst) > 0) futex_wake_all(header->generation);
+        return;
+    }
+
+    for (int i = 0; i < SPINS; ++i){
+        if (header->generation.load(std::memory_order_acquire) != generation) return;
+        std::this_thread::yield();
+    }
+
+    Clock::time_point deadline = Clock::now() + timeout;
+    while (header->generation.load(std::memory_order_acquire) == generation){
+        if (Clock::now() >= deadline){
+            timed_out = true;
+            throw std::runtime_error("ShmCommunicator: Timed out waiting for the other ranks");
+        }
+        header->sleepers.fetch_add(1, std::memory_order_seq_cst);
+        futex_wait(header->generation, generation);
+        header->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+    }
+}
+
+/// Per piece of at most one slot:
+/// 1. every rank copies its piece into its slot                 | barrier
+/// 2. rank r sums share r of all slots, in rank order, into the
+///    current result buffer                                     | barrier
+/// 3. every rank copies the whole result out
+/// Step 3 needs no barrier of its own: the next piece reduces into the
+/// other result buffer, and this one is only written again after the
+/// next piece's first barrier, which every rank reaches after step 3.
+template <typename T>
+void ShmCommunicator::all_reduce_impl(T* data, std::size_t n){
+    if (world_size == 1) return;
+
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    std::size_t capacity = slot_bytes / sizeof(T);
+
+    for (std::size_t offset = 0; offset < n; offset += capacity){
+        std::size_t count = std::min(capacity, n - offset);
+        std::memcpy(slot(my_rank), data + offset, count * sizeof(T));
+        barrier();
+
+        T* sum = reinterpret_cast<T*>(result(next_result));
+        std::size_t lo = count * my_rank / world_size;
+        std::size_t hi = count * (my_rank + 1) / world_size;
+        if (hi > lo){
+            std::memcpy(sum + lo, reinterpret_cast<const T*>(slot(0)) + lo, (hi - lo) * sizeof(T));
+            for (int r = 1; r < world_size; ++r){
+                k.add(sum + lo, reinterpret_cast<const T*>(slot(r)) + lo, sum + lo, hi - lo);
+            }
+        }
+        barrier();
+
+        std::memcpy(data + offset, sum, count * sizeof(T));
+        next_result ^= 1;
+    }
+}
+
+/// The root writes each piece to the current result buffer and the others
+/// copy it out after one barrier; reuse is safe for the same reason as in
+/// all_reduce_impl
+template <typename T>
+void ShmCommunicator::broadcast_impl(T* data, std::size_t n, int root){
+    if (root < 0 || root >= world_size){
+        throw std::invalid_argument("ShmCommunicator::broadcast: Root must be in [0, size)");
+    }
+    if (world_size == 1) return;
+
+    std::size_t capacity = slot_bytes / sizeof(T);
+    for (std::size_t offset = 0; offset < n; offset += capacity){
+        std::size_t count = std::min(capacity, n - offset);
+        unsigned char* buffer = result(next_result);
+        if (my_rank == root) std::memcpy(buffer, data + offset, count * sizeof(T));
+        barrier();
+        if (my_rank != root) std::memcpy(data + offset, buffer, count * sizeof(T));
+        next_result ^= 1;
+    }
+}
+
+void ShmCommunicator::all_reduce(float* data, std::size_t n){ all_reduce_impl(data, n); }
+void ShmCommunicator::all_reduce(double* data, std::size_t n){ all_reduce_impl(data, n); }
+void ShmCommunicator::broadcast(float* data, std::size_t n, int root){ broadcast_impl(data, n, root); }
+void ShmCommunicator::broadcast(double* data, std::size_t n, int root){ broadcast_impl(data, n, root); }
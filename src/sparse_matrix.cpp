@@ -0,0 +1,291 @@
+#include "sparse_matrix.hpp"
+#include "kernels.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+// Offsets of a matrix without rows or storage
+const int no_offsets[1] = {0};
+} // namespace
+
+template <typename T>
+SparseMatrix<T>::SparseMatrix()
+    : rows(0), cols(0) {
+        point_at_storage();
+    }
+
+template <typename T>
+SparseMatrix<T>::SparseMatrix(int rows, int cols, std::vector<int> row_offsets,
+                              std::vector<int> columns, std::vector<T> values)
+    : rows(rows), cols(cols), offset_storage(std::move(row_offsets)),
+      column_storage(std::move(columns)), value_storage(std::move(values)) {
+        if (rows < 0 || cols < 0){
+            throw std::invalid_argument("SparseMatrix: Negative dimensions.");
+        }
+        if (offset_storage.size() != static_cast<std::size_t>(rows) + 1 || offset_storage[0] != 0){
+            throw std::invalid_argument("SparseMatrix: Need rows + 1 row offsets starting at 0.");
+        }
+        if (column_storage.size() != value_storage.size() ||
+            static_cast<std::size_t>(offset_storage[rows]) != column_storage.size()){
+            throw std::invalid_argument("SparseMatrix: Offsets, columns and values disagree on the nonzero count.");
+        }
+        for (int i = 0; i < rows; ++i){
+            if (offset_storage[i + 1] < offset_storage[i]){
+                throw std::invalid_argument("SparseMatrix: Row offsets must not decrease.");
+            }
+            for (int k = offset_storage[i]; k < offset_storage[i + 1]; ++k){
+                int j = column_storage[k];
+                if (j < 0 || j >= cols || (k > offset_storage[i] && j <= column_storage[k - 1])){
+                    throw std::invalid_argument("SparseMatrix: Columns must be in range and increasing within a row.");
+                }
+            }
+        }
+        point_at_storage();
+    }
+
+template <typename T>
+SparseMatrix<T>::SparseMatrix(const SparseMatrix& other)
+    : rows(0), cols(0) {
+        *this = other;
+    }
+
+// Moving a vector keeps its buffer, so the pointers carry over whether
+// `other` owns its arrays or views someone else's
+template <typename T>
+SparseMatrix<T>::SparseMatrix(SparseMatrix&& other) noexcept
+    : rows(other.rows), cols(other.cols),
+      offset_storage(std::move(other.offset_storage)),
+      column_storage(std::move(other.column_storage)),
+      value_storage(std::move(other.value_storage)),
+      offsets(other.offsets), column_data(other.column_data), value_data(other.value_data) {
+        other.rows = other.cols = 0;
+        other.offset_storage.clear();
+        other.column_storage.clear();
+        other.value_storage.clear();
+        other.point_at_storage();
+    }
+
+template <typename T>
+SparseMatrix<T>& SparseMatrix<T>::operator=(const SparseMatrix& other){
+    if (this == &other) return *this;
+    std::size_t count = other.nnz();
+    int base = other.offsets[0];
+
+    // Copy out first: `other` may view this matrix's own arrays
+    std::vector<int> new_offsets(static_cast<std::size_t>(other.rows) + 1);
+    for (int i = 0; i <= other.rows; ++i) new_offsets[i] = other.offsets[i] - base;
+    std::vector<int> new_columns(other.column_data + base, other.column_data + base + count);
+    std::vector<T> new_values(other.value_data + base, other.value_data + base + count);
+
+    rows = other.rows;
+    cols = other.cols;
+    offset_storage = std::move(new_offsets);
+    column_storage = std::move(new_columns);
+    value_storage = std::move(new_values);
+    point_at_storage();
+    return *this;
+}
+
+template <typename T>
+SparseMatrix<T>& SparseMatrix<T>::operator=(SparseMatrix&& other) noexcept{
+    if (this == &other) return *this;
+    rows = other.rows;
+    cols = other.cols;
+    offset_storage = std::move(other.offset_storage);
+    column_storage = std::move(other.column_storage);
+    value_storage = std::move(other.value_storage);
+    offsets = other.offsets;
+    column_data = other.column_data;
+    value_data = other.value_data;
+
+    other.rows = other.cols = 0;
+    other.offset_storage.clear();
+    other.column_storage.clear();
+    other.value_storage.clear();
+    other.point_at_storage();
+    return *this;
+}
+
+template <typename T>
+void SparseMatrix<T>::point_at_storage(){
+    offsets = offset_storage.empty() ? no_offsets : offset_storage.data();
+    column_data = column_storage.data();
+    value_data = value_storage.data();
+}
+
+template <typename T>
+SparseMatrix<T> SparseMatrix<T>::from_dense(const Matrix<T>& dense){
+    std::vector<int> row_offsets(static_cast<std::size_t>(dense.rows) + 1, 0);
+    std::vector<int> columns;
+    std::vector<T> values;
+    for (int i = 0; i < dense.rows; ++i){
+        const T* x = dense.row(i);
+        for (int j = 0; j < dense.cols; ++j){
+            if (x[j] != T(0)){
+                columns.push_back(j);
+                values.push_back(x[j]);
+            }
+        }
+        row_offsets[i + 1] = static_cast<int>(columns.size());
+    }
+    return SparseMatrix(dense.rows, dense.cols, std::move(row_offsets), std::move(columns), std::move(values));
+}
+
+template <typename T>
+SparseMatrix<T> SparseMatrix<T>::view_rows(int row0, int count) const{
+    if (row0 < 0 || count < 0 || row0 + count > rows){
+        throw std::invalid_argument("SparseMatrix::view_rows: Rows out of range.");
+    }
+    SparseMatrix result;
+    result.rows = count;
+    result.cols = cols;
+    result.offsets = offsets + row0;
+    result.column_data = column_data;
+    result.value_data = value_data;
+    return result;
+}
+
+template <typename T>
+void SparseMatrix<T>::gather_rows(const SparseMatrix& src, const int* rows, int count, SparseMatrix& out){
+    if (&src == &out){
+        throw std::invalid_argument("SparseMatrix::gather_rows: Source and output must differ.");
+    }
+    out.offset_storage.resize(static_cast<std::size_t>(count) + 1);
+    out.offset_storage[0] = 0;
+    for (int k = 0; k < count; ++k){
+        if (rows[k] < 0 || rows[k] >= src.rows){
+            throw std::invalid_argument("SparseMatrix::gather_rows: Row index out of range.");
+        }
+        int r = rows[k];
+        out.offset_storage[k + 1] = out.offset_storage[k] + (src.offsets[r + 1] - src.offsets[r]);
+    }
+
+    std::size_t total = static_cast<std::size_t>(out.offset_storage[count]);
+    out.column_storage.resize(total);
+    out.value_storage.resize(total);
+    for (int k = 0; k < count; ++k){
+        int r = rows[k];
+        int n = src.offsets[r + 1] - src.offsets[r];
+        if (n == 0) continue;
+        std::memcpy(out.column_storage.data() + out.offset_storage[k], src.column_data + src.offsets[r], n * sizeof(int));
+        std::memcpy(out.value_storage.data() + out.offset_storage[k], src.value_data + src.offsets[r], n * sizeof(T));
+    }
+    out.rows = count;
+    out.cols = src.cols;
+    out.point_at_storage();
+}
+
+template <typename T>
+void SparseMatrix<T>::dot_bias_act_into(const SparseMatrix& A, const Matrix<T>& B,
+                                        const Matrix<T>& bias, Activation activation, Matrix<T>& C){
+    if (A.cols != B.rows){
+        throw std::invalid_argument("Dot: Incompatible dimensions");
+    }
+    if (bias.rows != 1 || bias.cols != B.cols){
+        throw std::invalid_argument("Dot: Bias must be a (1 × N) row");
+    }
+    int N = B.cols;
+    C.resize(A.rows, N);
+
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    std::size_t per_row = (A.nnz() / std::max(A.rows, 1) + 1) * static_cast<std::size_t>(std::max(N, 1));
+    std::size_t row_grain = std::max<std::size_t>(1, kernels::PARALLEL_GRAIN / per_row);
+    parallel_for(static_cast<std::size_t>(A.rows), row_grain, [&](std::size_t i0, std::size_t i1){
+        for (std::size_t i = i0; i < i1; ++i){
+            T* c = C.row(static_cast<int>(i));
+            std::memcpy(c, bias.data(), N * sizeof(T));
+            for (int p = A.offsets[i]; p < A.offsets[i + 1]; ++p){
+                k.axpy(B.row(A.column_data[p]), A.value_data[p], c, N);
+            }
+            // Applied while the row is still in cache
+            if (activation == Activation::ReLU) k.relu(c, c, N);
+            else if (activation == Activation::Sigmoid) k.sigmoid_forward(c, c, N);
+        }
+    });
+}
+
+template <typename T>
+Matrix<T> SparseMatrix<T>::to_dense() const{
+    Matrix<T> dense(rows, cols);
+    for (int i = 0; i < rows; ++i){
+        for (int p = offsets[i]; p < offsets[i + 1]; ++p) dense(i, column_data[p]) = value_data[p];
+    }
+    return dense;
+}
+
+// The nonzeros are bucketed by column with a counting sort over the
+// columns present (slot maps a column to its bucket and is reset after
+// use), so each row of D is produced by one thread from its own bucket
+template <typename T>
+void SparseRowGradient<T>::compute(const SparseMatrix<T>& A, const Matrix<T>& G, Matrix<T>& D){
+    if (G.rows != A.rows || D.rows != A.cols || D.cols != G.cols){
+        throw std::invalid_argument("SparseRowGradient: Shape mismatch");
+    }
+    if (slot.size() != static_cast<std::size_t>(A.cols)){
+        slot.assign(A.cols, -1);
+        previous.clear();
+        touched.clear();
+    }
+    previous.swap(touched);
+    touched.clear();
+    fill.clear();
+
+    const int* offsets = A.row_offsets();
+    const int* columns = A.columns();
+    const T* values = A.values();
+    for (int p = offsets[0]; p < offsets[A.rows]; ++p){
+        int j = columns[p];
+        if (slot[j] < 0){
+            slot[j] = static_cast<int>(touched.size());
+            touched.push_back(j);
+            fill.push_back(0);
+        }
+        ++fill[slot[j]];
+    }
+
+    begin.resize(touched.size() + 1);
+    begin[0] = 0;
+    for (std::size_t t = 0; t < touched.size(); ++t){
+        begin[t + 1] = begin[t] + fill[t];
+        fill[t] = begin[t];
+    }
+    entries.resize(A.nnz());
+    entry_row.resize(A.nnz());
+    for (int i = 0; i < A.rows; ++i){
+        for (int p = offsets[i]; p < offsets[i + 1]; ++p){
+            int at = fill[slot[columns[p]]]++;
+            entries[at] = p;
+            entry_row[at] = i;
+        }
+    }
+
+    // Rows written last time and not this time go back to zero
+    int N = D.cols;
+    for (int j : previous){
+        if (slot[j] < 0) std::memset(D.row(j), 0, N * sizeof(T));
+    }
+
+    const kernels::KernelTable<T>& k = kernels::active<T>();
+    std::size_t per_row = (A.nnz() / std::max<std::size_t>(touched.size(), 1) + 1) * static_cast<std::size_t>(std::max(N, 1));
+    std::size_t grain = std::max<std::size_t>(1, kernels::PARALLEL_GRAIN / per_row);
+    parallel_for(touched.size(), grain, [&](std::size_t t0, std::size_t t1){
+        for (std::size_t t = t0; t < t1; ++t){
+            T* d = D.row(touched[t]);
+            int e = begin[t];
+            k.scale(G.row(entry_row[e]), values[entries[e]], d, N);
+            for (++e; e < begin[t + 1]; ++e){
+                k.axpy(G.row(entry_row[e]), values[entries[e]], d, N);
+            }
+        }
+    });
+
+    for (int j : touched) slot[j] = -1;
+}
+
+template class SparseMatrix<float>;
+template class SparseMatrix<double>;
+template class SparseRowGradient<float>;
+template class SparseRowGradient<double>;
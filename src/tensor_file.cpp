@@ -0,0 +1,105 @@
+#include "tensor_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char TENSOR_MAGIC[8] = {'N', 'N', 'T', 'E', 'N', 'S', 'O', 'R'};
+
+template <typename T> constexpr TensorDType dtype_of();
+template <> constexpr TensorDType dtype_of<float>(){ return TensorDType::Float32; }
+template <> constexpr TensorDType dtype_of<double>(){ return TensorDType::Float64; }
+
+} // namespace
+
+template <typename T>
+void write_tensor_file(const std::string& path, const Matrix<T>& m){
+    TensorFileHeader header{};
+    std::memcpy(header.magic, TENSOR_MAGIC, sizeof(header.magic));
+    header.version = TENSOR_FILE_VERSION;
+    header.dtype = static_cast<std::uint32_t>(dtype_of<T>());
+    header.rows = static_cast<std::uint64_t>(m.rows);
+    header.cols = static_cast<std::uint64_t>(m.cols);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out){
+        throw std::runtime_error("write_tensor_file: Cannot open " + path);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int i = 0; i < m.rows; ++i){
+        out.write(reinterpret_cast<const char*>(m.row(i)), static_cast<std::streamsize>(m.cols * sizeof(T)));
+    }
+    if (!out){
+        throw std::runtime_error("write_tensor_file: Write failed for " + path);
+    }
+}
+
+template <typename T>
+MappedTensor<T>::MappedTensor(const std::string& path){
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        throw std::runtime_error("MappedTensor: Cannot open " + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0){
+        ::close(fd);
+        throw std::runtime_error("MappedTensor: Cannot stat " + path);
+    }
+    std::size_t file_bytes = static_cast<std::size_t>(st.st_size);
+    if (file_bytes < sizeof(TensorFileHeader)){
+        ::close(fd);
+        throw std::invalid_argument("MappedTensor: File too small for a header: " + path);
+    }
+
+    void* p = ::mmap(nullptr, file_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps the file referenced; the descriptor is not needed
+    ::close(fd);
+    if (p == MAP_FAILED){
+        throw std::runtime_error("MappedTensor: mmap failed for " + path);
+    }
+    mapping = p;
+    mapped_bytes = file_bytes;
+
+    const TensorFileHeader* header = static_cast<const TensorFileHeader*>(mapping);
+    const char* error = nullptr;
+    if (std::memcmp(header->magic, TENSOR_MAGIC, sizeof(TENSOR_MAGIC)) != 0){
+        error = "MappedTensor: Bad magic in ";
+    }else if (header->version != TENSOR_FILE_VERSION){
+        error = "MappedTensor: Unsupported version in ";
+    }else if (header->dtype != static_cast<std::uint32_t>(dtype_of<T>())){
+        error = "MappedTensor: Element type does not match in ";
+    }else if (header->rows > static_cast<std::uint64_t>(std::numeric_limits<int>::max()) ||
+               header->cols > static_cast<std::uint64_t>(std::numeric_limits<int>::max())){
+        error = "MappedTensor: Shape too large in ";
+    }else if ((file_bytes - sizeof(TensorFileHeader)) / sizeof(T) / std::max<std::uint64_t>(header->cols, 1) < header->rows){
+        error = "MappedTensor: Truncated payload in ";
+    }
+    if (error){
+        ::munmap(mapping, mapped_bytes);
+        mapping = nullptr;
+        throw std::invalid_argument(error + path);
+    }
+
+    T* data = reinterpret_cast<T*>(static_cast<char*>(mapping) + sizeof(TensorFileHeader));
+    view = Matrix<T>::view(data, static_cast<int>(header->rows), static_cast<int>(header->cols));
+}
+
+template <typename T>
+MappedTensor<T>::~MappedTensor(){
+    if (mapping) ::munmap(mapping, mapped_bytes);
+}
+
+template void write_tensor_file<float>(const std::string&, const Matrix<float>&);
+template void write_tensor_file<double>(const std::string&, const Matrix<double>&);
+
+template class MappedTensor<float>;
+template class MappedTensor<double>;
@@ -0,0 +1,173 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+thread_local bool tls_in_parallel_region = false;
+
+int default_thread_count(){
+    if (const char* env = std::getenv("NEURONITE_NUM_THREADS")){
+        int n = std::atoi(env);
+        if (n > 0) return n;
+    }
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? static_cast<int>(hw) : 1;
+}
+
+// Marks the current thread as inside a parallel region for the lifetime of
+// the guard, so nested parallel_for calls run inline.
+struct RegionGuard {
+    bool previous;
+    RegionGuard() : previous(tls_in_parallel_region){ tls_in_parallel_region = true; }
+    ~RegionGuard(){ tls_in_parallel_region = previous; }
+};
+
+} // namespace
+
+ThreadPool::ThreadPool(int num_threads){
+    start(num_threads);
+}
+
+ThreadPool::~ThreadPool(){
+    stop();
+}
+
+ThreadPool& ThreadPool::instance(){
+    static ThreadPool pool(default_thread_count());
+    return pool;
+}
+
+bool ThreadPool::in_parallel_region(){
+    return tls_in_parallel_region;
+}
+
+void ThreadPool::resize(int num_threads){
+    std::lock_guard<std::mutex> submit(submit_mutex);
+    stop();
+    start(num_threads);
+}
+
+void ThreadPool::start(int num_threads){
+    num_threads = std::max(1, num_threads);
+    stopping = false;
+    workers.reserve(num_threads - 1);
+    for (int i = 0; i < num_threads - 1; ++i){
+        workers.emplace_back([this]{ worker_main(); });
+    }
+}
+
+void ThreadPool::stop(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+    workers.clear();
+}
+
+void ThreadPool::worker_main(){
+    tls_in_parallel_region = true;
+    unsigned long long seen = 0;
+
+    while (true){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]{ return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            // Registered under the lock so run() cannot return while this
+            // worker can still touch the job fields
+            active_workers.fetch_add(1, std::memory_order_relaxed);
+        }
+        execute_chunks();
+        active_workers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void ThreadPool::execute_chunks(){
+    std::size_t c;
+    while ((c = next_chunk.fetch_add(1, std::memory_order_relaxed)) < job_chunks){
+        std::size_t begin = c * job_n / job_chunks;
+        std::size_t end = (c + 1) * job_n / job_chunks;
+        begin = begin / job_align * job_align;
+        end = (c + 1 == job_chunks) ? job_n : end / job_align * job_align;
+
+        if (begin < end){
+            try {
+                job_fn(job_ctx, begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!job_error) job_error = std::current_exception();
+            }
+        }
+
+        if (done_chunks.fetch_add(1, std::memory_order_acq_rel) + 1 == job_chunks){
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+    }
+}
+
+void ThreadPool::run(std::size_t n, std::size_t grain, std::size_t align, RangeFn fn, void* ctx){
+    if (n == 0) return;
+
+    grain = std::max<std::size_t>(grain, 1);
+    std::size_t chunks = std::min<std::size_t>(n / grain, static_cast<std::size_t>(size()));
+
+    // Small problems, nested regions and contended pools run inline
+    if (chunks <= 1 || tls_in_parallel_region){
+        fn(ctx, 0, n);
+        return;
+    }
+    std::unique_lock<std::mutex> submit(submit_mutex, std::try_to_lock);
+    if (!submit.owns_lock()){
+        fn(ctx, 0, n);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // A worker that slept through the previous job may have registered
+        // for it late; let it drain before the job fields are reused.
+        // Registration needs this mutex, so no new worker can join meanwhile.
+        while (active_workers.load(std::memory_order_acquire) != 0){
+            std::this_thread::yield();
+        }
+        job_fn = fn;
+        job_ctx = ctx;
+        job_n = n;
+        job_chunks = chunks;
+        job_align = std::max<std::size_t>(align, 1);
+        job_error = nullptr;
+        next_chunk.store(0, std::memory_order_relaxed);
+        done_chunks.store(0, std::memory_order_relaxed);
+        ++generation;
+    }
+    wake.notify_all();
+
+    {
+        RegionGuard guard;
+        execute_chunks();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]{ return done_chunks.load(std::memory_order_acquire) == job_chunks; });
+    }
+    // Wait for late workers to notice the job is exhausted
+    while (active_workers.load(std::memory_order_acquire) != 0){
+        std::this_thread::yield();
+    }
+
+    if (job_error) std::rethrow_exception(job_error);
+}
+
+void set_num_threads(int num_threads){
+    ThreadPool::instance().resize(num_threads);
+}
+
+int get_num_threads(){
+    return ThreadPool::instance().size();
+}
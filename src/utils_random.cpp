@@ -1,25 +1,53 @@
 #include "utils_random.hpp"
 #include "random"
+#include <algorithm>
 
 static std::mt19937 rng(std::random_device{}());
 
+// One generator per thread: Dropout seeds its masks from it, and
+// data-parallel training runs Dropout layers on several threads at once
+static std::mt19937& thread_generator(){
+    thread_local std::mt19937 gen(std::random_device{}());
+    return gen;
+}
+
+// The calling thread's generator is reseeded too, from a different
+// stream, so Dropout masks drawn on it repeat along with the weights
 void set_random_seed(unsigned int seed){
     rng.seed(seed);
+    std::seed_seq thread_seed{seed, 1u};
+    thread_generator().seed(thread_seed);
 }
 
-void initialize_random(Matrix &mat, double min, double max){
+template <typename T>
+void initialize_random(Matrix<T> &mat, double min, double max){
     std::uniform_real_distribution<double> dist(min, max);
 
     for(int i=0;i< mat.rows; ++i){
+        T* r = mat.row(i);
         for(int j=0;j<mat.cols;++j){
-            mat.data[i][j] = dist(rng);
+            r[j] = static_cast<T>(dist(rng));
         }
     }
 }
 
+template void initialize_random<float>(Matrix<float>&, double, double);
+template void initialize_random<double>(Matrix<double>&, double, double);
+
 double random_double(double min, double max) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
     std::uniform_real_distribution<> dis(min, max);
-    return dis(gen);
-}
\ No newline at end of file
+    return dis(thread_generator());
+}
+
+std::uint64_t random_u64(){
+    std::mt19937& gen = thread_generator();
+    std::uint64_t high = gen();
+    return (high << 32) | gen();
+}
+
+void shuffle_indices(std::vector<int>& values){
+    std::shuffle(values.begin(), values.end(), rng);
+}
+unsigned int random_seed(){
+    return static_cast<unsigned int>(rng());
+}
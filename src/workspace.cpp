@@ -0,0 +1,72 @@
+#include "workspace.hpp"
+#include "aligned_memory.hpp"
+#include <algorithm>
+
+namespace {
+
+// Smallest block worth allocating; keeps tiny models from chaining many blocks
+constexpr std::size_t MIN_BLOCK_BYTES = 64 * 1024;
+
+std::size_t round_up(std::size_t bytes){
+    return (bytes + NEURONITE_ALIGNMENT - 1) / NEURONITE_ALIGNMENT * NEURONITE_ALIGNMENT;
+}
+
+} // namespace
+
+Workspace::Workspace(std::size_t initial_bytes){
+    if (initial_bytes > 0) add_block(round_up(initial_bytes));
+}
+
+Workspace::~Workspace(){
+    release_blocks();
+}
+
+void* Workspace::allocate(std::size_t bytes){
+    bytes = round_up(std::max<std::size_t>(bytes, 1));
+
+    if (blocks.empty() || offset + bytes > blocks.back().size){
+        // Chain a new block; slices handed out earlier must not move
+        std::size_t grow = blocks.empty() ? 0 : 2 * blocks.back().size;
+        add_block(std::max({bytes, grow, MIN_BLOCK_BYTES}));
+    }
+
+    void* p = blocks.back().ptr + offset;
+    offset += bytes;
+    used_bytes += bytes;
+    peak_bytes = std::max(peak_bytes, used_bytes);
+    return p;
+}
+
+void Workspace::reset(){
+    // Merge a chained (or too small) arena into one block so the next step
+    // fits without allocating
+    std::size_t target = round_up(std::max(peak_bytes, reserved_bytes));
+    if (blocks.size() > 1 || (target > 0 && capacity() < target)){
+        release_blocks();
+        add_block(target);
+    }
+    offset = 0;
+    used_bytes = 0;
+}
+
+void Workspace::reserve(std::size_t bytes){
+    reserved_bytes = std::max(reserved_bytes, bytes);
+    // Live slices must stay put, so otherwise this waits for the next reset
+    if (used_bytes == 0) reset();
+}
+
+std::size_t Workspace::capacity() const{
+    std::size_t total = 0;
+    for (const Block& b : blocks) total += b.size;
+    return total;
+}
+
+void Workspace::add_block(std::size_t bytes){
+    blocks.push_back({static_cast<char*>(aligned_malloc(bytes)), bytes});
+    offset = 0;
+}
+
+void Workspace::release_blocks(){
+    for (Block& b : blocks) aligned_free(b.ptr);
+    blocks.clear();
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+// Counts every heap allocation (operator new in all its forms, plus
+// aligned_alloc behind aligned_malloc) and checks that once the first
+// epochs have sized the model's buffers, further Model::train epochs do
+// not allocate at all.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "activation_sigmoid.hpp"
+#include "loss_mse.hpp"
+#include "sgd_optimizer.hpp"
+#include "adam_optimizer.hpp"
+#include "utils_random.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace {
+
+std::atomic<long> allocations{0};
+
+void* counted(std::size_t bytes, std::size_t alignment){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (bytes == 0) bytes = 1;
+    void* p = nullptr;
+    if (alignment <= alignof(std::max_align_t)) p = std::malloc(bytes);
+    else if (posix_memalign(&p, alignment, bytes) != 0) p = nullptr;
+    return p;
+}
+
+void* counted_or_throw(std::size_t bytes, std::size_t alignment){
+    void* p = counted(bytes, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+} // namespace
+
+void* operator new(std::size_t n){ return counted_or_throw(n, 0); }
+void* operator new[](std::size_t n){ return counted_or_throw(n, 0); }
+void* operator new(std::size_t n, std::align_val_t a){ return counted_or_throw(n, static_cast<std::size_t>(a)); }
+void* operator new[](std::size_t n, std::align_val_t a){ return counted_or_throw(n, static_cast<std::size_t>(a)); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return counted(n, 0); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return counted(n, 0); }
+void* operator new(std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return counted(n, static_cast<std::size_t>(a)); }
+void* operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return counted(n, static_cast<std::size_t>(a)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+
+// aligned_malloc (Matrix storage) goes through the C library directly
+extern "C" void* aligned_alloc(std::size_t alignment, std::size_t bytes){
+    return counted(bytes, alignment);
+}
+
+namespace {
+
+struct Config {
+    const char* name;
+    bool fused;
+    bool compiled;
+    bool momentum;      // SGD with momentum instead of Adam
+    int batch_size;     // 0 = full batch
+    bool shuffle;
+};
+
+struct Network {
+    std::vector<std::unique_ptr<Layer<double>>> layers;
+    Model<double> model;
+};
+
+void build(Network& net, int input_dim, bool fused){
+    if (fused) net.layers.emplace_back(new FusedDenseLayer<double>(input_dim, 16, Activation::ReLU));
+    else {
+        net.layers.emplace_back(new DenseLayer<double>(input_dim, 16));
+        net.layers.emplace_back(new ActivationReLU<double>());
+    }
+    net.layers.emplace_back(new DenseLayer<double>(16, 1));
+    net.layers.emplace_back(new ActivationSigmoid<double>());
+    for (auto& layer : net.layers) net.model.add(layer.get());
+}
+
+/// Allocations made by `epochs` epochs of training
+long allocations_for(Model<double>& model, const Matrix<double>& x, const Matrix<double>& y,
+                     Loss<double>& loss, Optimizer<double>& optimizer, int epochs, const Config& config){
+    long before = allocations.load();
+    model.train(x, y, loss, optimizer, epochs, epochs + 1, config.batch_size, config.shuffle);
+    return allocations.load() - before;
+}
+
+} // namespace
+
+int main(){
+    const int rows = 100, input_dim = 8;
+    set_random_seed(3);
+    Matrix<double> x(rows, input_dim), y(rows, 1);
+    initialize_random(x, -1.0, 1.0);
+    for (int i = 0; i < rows; ++i) y(i, 0) = x(i, 0) + x(i, 1) > 0 ? 1.0 : 0.0;
+
+    const Config configs[] = {
+        {"full batch, Adam", false, false, false, 0, false},
+        {"shuffled, partial last batch, momentum", false, false, true, 32, true},
+        {"compiled, fused", true, true, false, 25, true},
+    };
+    test::QuietCout quiet;
+    for (const Config& config : configs){
+        Network net;
+        build(net, input_dim, config.fused);
+        if (config.compiled) net.model.compile(input_dim, config.batch_size ? config.batch_size : rows);
+        LossMSE<double> loss;
+        AdamOptimizer<double> adam(0.01);
+        SGDOptimizer<double> sgd(0.05, 0.9);
+        Optimizer<double>& optimizer = config.momentum ? static_cast<Optimizer<double>&>(sgd) : adam;
+
+        // Warm-up sizes the scratch buffers, optimizer state and epoch log
+        allocations_for(net.model, x, y, loss, optimizer, 2, config);
+        long short_run = allocations_for(net.model, x, y, loss, optimizer, 2, config);
+        long long_run = allocations_for(net.model, x, y, loss, optimizer, 6, config);
+        if (long_run != short_run)
+            std::fprintf(stderr, "%s: %ld allocations per steady-state epoch\n",
+                         config.name, (long_run - short_run) / 4);
+        CHECK(long_run == short_run);
+    }
+    return test::result();
+}
@@ -0,0 +1,136 @@
+// BatchLoader: every epoch visits each row once, in order or shuffled,
+// with the partial last batch kept or dropped; batches wrap into later
+// epochs; and the loader shuts down cleanly while its thread is blocked
+// on a full ring or the consumer still holds a batch.
+#include "test_support.hpp"
+#include "batch_loader.hpp"
+#include "utils_random.hpp"
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Row i of the input is (i, -i), its target 2i, so a batch names its rows
+struct Dataset {
+    Matrix<double> input, target;
+
+    explicit Dataset(int rows) : input(rows, 2), target(rows, 1) {
+        for (int i = 0; i < rows; ++i){
+            input(i, 0) = i;
+            input(i, 1) = -i;
+            target(i, 0) = 2 * i;
+        }
+    }
+};
+
+/// Draws `epochs` epochs and checks batch sizes, row pairing and that no
+/// row repeats within an epoch; returns the row order of each epoch
+std::vector<std::vector<int>> draw(BatchLoader<double>& loader, int rows, int batch_size,
+                                   int last_rows, int epochs){
+    std::vector<std::vector<int>> orders;
+    for (int e = 0; e < epochs; ++e){
+        std::vector<int> order;
+        std::vector<bool> seen(rows, false);
+        for (int b = 0; b < loader.batches_per_epoch(); ++b){
+            const BatchLoader<double>::Batch& batch = loader.next();
+            bool last = b == loader.batches_per_epoch() - 1;
+            CHECK(batch.input.rows == (last ? last_rows : batch_size));
+            CHECK(batch.target.rows == batch.input.rows);
+            for (int k = 0; k < batch.input.rows; ++k){
+                int i = static_cast<int>(batch.input(k, 0));
+                CHECK(i >= 0 && i < rows);
+                if (i < 0 || i >= rows) continue;
+                CHECK(batch.input(k, 1) == -i);
+                CHECK(batch.target(k, 0) == 2 * i);
+                CHECK(!seen[i]);
+                seen[i] = true;
+                order.push_back(i);
+            }
+        }
+        orders.push_back(order);
+    }
+    return orders;
+}
+
+bool is_identity(const std::vector<int>& order){
+    for (int i = 0; i < static_cast<int>(order.size()); ++i) if (order[i] != i) return false;
+    return true;
+}
+
+template <typename Fn>
+bool rejects(Fn&& fn){
+    try {
+        fn();
+    } catch (const std::invalid_argument&){
+        return true;
+    }
+    return false;
+}
+
+void check_keep_and_drop(){
+    Dataset data(23);
+    {
+        BatchLoader<double> loader(data.input, data.target, 5, false, LastBatch::Keep);
+        CHECK(loader.batches_per_epoch() == 5);
+        for (const std::vector<int>& order : draw(loader, 23, 5, 3, 3)){
+            CHECK(order.size() == 23);
+            CHECK(is_identity(order));
+        }
+    }
+    {
+        BatchLoader<double> loader(data.input, data.target, 5, false, LastBatch::Drop);
+        CHECK(loader.batches_per_epoch() == 4);
+        for (const std::vector<int>& order : draw(loader, 23, 5, 5, 3)){
+            CHECK(order.size() == 20);
+            CHECK(is_identity(order));
+        }
+    }
+    {
+        // Shuffled, triple-buffered: each epoch a new permutation
+        BatchLoader<double> loader(data.input, data.target, 5, true, LastBatch::Keep, 3);
+        std::vector<std::vector<int>> orders = draw(loader, 23, 5, 3, 4);
+        for (const std::vector<int>& order : orders) CHECK(order.size() == 23);
+        CHECK(orders[0] != orders[1] || orders[1] != orders[2]);
+    }
+    {
+        // Batch size above the row count: one full-size batch, never shuffled
+        BatchLoader<double> loader(data.input, data.target, 100, true, LastBatch::Drop);
+        CHECK(loader.batch_size() == 23);
+        for (const std::vector<int>& order : draw(loader, 23, 23, 23, 2)) CHECK(is_identity(order));
+    }
+}
+
+void check_shutdown(){
+    Dataset data(64);
+    // The loader thread fills the ring and blocks; nothing is consumed
+    for (int depth : {2, 3, 8}){
+        BatchLoader<double> loader(data.input, data.target, 4, true, LastBatch::Keep, depth);
+    }
+    // Destroyed while the consumer holds a batch, mid-epoch
+    for (int n : {1, 5, 17}){
+        BatchLoader<double> loader(data.input, data.target, 4, true, LastBatch::Keep);
+        for (int i = 0; i < n; ++i) loader.next();
+    }
+    // Back to back, so some loaders die before their thread has started
+    for (int i = 0; i < 200; ++i){
+        BatchLoader<double> loader(data.input, data.target, 4, true, LastBatch::Keep, 2 + i % 3);
+        if (i % 2) loader.next();
+    }
+}
+
+void check_rejects(){
+    Dataset data(10), other(9), empty(0);
+    CHECK(rejects([&]{ BatchLoader<double>(data.input, other.target, 2); }));
+    CHECK(rejects([&]{ BatchLoader<double>(data.input, data.target, 2, true, LastBatch::Keep, 1); }));
+    CHECK(rejects([&]{ BatchLoader<double>(empty.input, empty.target, 2); }));
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(3);
+    check_keep_and_drop();
+    check_shutdown();
+    check_rejects();
+    return test::result();
+}
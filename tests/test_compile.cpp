@@ -0,0 +1,159 @@
+// Model::compile: training a compiled model gives bit for bit the batch
+// losses, weights and predictions of the same model uncompiled, with
+// Dropout and BatchNorm, a partial last batch and dense or sparse input,
+// and with any number of checkpoint segments, also in data-parallel
+// replicas; the plan shares memory, and checkpointing shrinks it; and
+// inputs outside the plan are rejected.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "activation_sigmoid.hpp"
+#include "batch_norm.hpp"
+#include "dropout.hpp"
+#include "loss_mse.hpp"
+#include "adam_optimizer.hpp"
+#include "sparse_matrix.hpp"
+#include "utils_random.hpp"
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+const int rows = 53, input_dim = 12, batch_size = 16;
+
+/// MSE that records the loss of every batch
+class RecordingLoss: public LossMSE<double> {
+    public:
+        std::vector<double> losses;
+
+        double forward(const Matrix<double>& prediction, const Matrix<double>& target) override {
+            double loss = LossMSE<double>::forward(prediction, target);
+            losses.push_back(loss);
+            return loss;
+        }
+};
+
+struct Network {
+    FusedDenseLayer<double> hidden{input_dim, 32, Activation::ReLU};
+    Dropout<double> dropout{0.25};
+    DenseLayer<double> dense{32, 16};
+    BatchNorm<double> norm{16, 16};
+    ActivationReLU<double> relu;
+    DenseLayer<double> mid{16, 8};
+    ActivationSigmoid<double> squash;
+    DenseLayer<double> output{8, 1};
+    ActivationSigmoid<double> sigmoid;
+    Model<double> model;
+
+    Network(){
+        for (Layer<double>* layer : std::vector<Layer<double>*>{&hidden, &dropout, &dense, &norm, &relu,
+                                                                &mid, &squash, &output, &sigmoid}){
+            model.add(layer);
+        }
+    }
+};
+
+bool same(const Matrix<double>& a, const Matrix<double>& b){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (a(i, j) != b(i, j)) return false;
+    return true;
+}
+
+struct Run {
+    std::vector<double> losses;
+    Matrix<double> parameters;
+    Matrix<double> prediction;
+};
+
+/// Trains a fresh network, compiled with `segments` checkpoint segments
+/// unless `segments` is 0, on `workers` data-parallel workers. Replicas
+/// draw Dropout masks on pool threads, which set_random_seed does not
+/// reach, so with several workers Dropout is switched to inference mode
+template <typename Input>
+Run train(const Input& x, const Matrix<double>& y, int segments, int workers = 1){
+    constexpr bool sparse = std::is_same<Input, SparseMatrix<double>>::value;
+    set_random_seed(6);
+    Network net;
+    net.model.set_data_parallel(workers);
+    if (workers > 1) net.dropout.set_training(false);
+    if (segments > 0){
+        const MemoryPlan& plan = net.model.compile(input_dim, batch_size, segments, sparse);
+        CHECK(plan.segments == segments);
+        CHECK(plan.slab_bytes > 0 && plan.slab_bytes < plan.unshared_bytes);
+    }
+    RecordingLoss loss;
+    AdamOptimizer<double> optimizer(0.01);
+    {
+        test::QuietCout quiet;
+        net.model.train(x, y, loss, optimizer, 3, 10, batch_size, true);
+    }
+    net.dropout.set_training(false);
+    return {loss.losses, net.model.get_parameters(), net.model.predict(x)};
+}
+
+template <typename Input>
+void check_matches_uncompiled(const Input& x, const Matrix<double>& y, int segments, int workers = 1){
+    Run expected = train(x, y, 0, workers);
+    Run compiled = train(x, y, segments, workers);
+    CHECK(expected.losses.size() == 12);
+    CHECK(compiled.losses == expected.losses);
+    CHECK(same(compiled.parameters, expected.parameters));
+    CHECK(same(compiled.prediction, expected.prediction));
+}
+
+template <typename Fn>
+bool rejects(Fn&& fn){
+    try {
+        fn();
+    } catch (const std::invalid_argument&){
+        return true;
+    }
+    return false;
+}
+
+void check_rejects(const Matrix<double>& x){
+    Network net;
+    net.model.compile(input_dim, batch_size);
+    Matrix<double> too_many(batch_size + 1, input_dim), too_wide(4, input_dim + 1);
+    CHECK(rejects([&]{ net.model.forward(too_many); }));
+    CHECK(rejects([&]{ net.model.forward(too_wide); }));
+    CHECK(rejects([&]{ net.model.forward(SparseMatrix<double>::from_dense(x)); }));
+    CHECK(rejects([&]{ net.model.compile(input_dim + 1, batch_size); }));
+}
+
+void check_checkpoint_slab(){
+    // Only the segment boundaries and one segment's activations and
+    // caches are stored
+    Network net;
+    std::size_t whole = net.model.compile(input_dim, batch_size, 1).slab_bytes;
+    std::size_t three = net.model.compile(input_dim, batch_size, 3).slab_bytes;
+    CHECK(three < whole);
+    CHECK(rejects([&]{ net.model.compile(input_dim, batch_size, 0); }));
+    CHECK(rejects([&]{ net.model.compile(input_dim, batch_size, 10); }));
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(2);
+    Matrix<double> x(rows, input_dim), y(rows, 1);
+    initialize_random(x, -1.0, 1.0);
+    for (int i = 0; i < rows; ++i){
+        for (int j = 0; j < input_dim; ++j) if ((i * 7 + j) % 4) x(i, j) = 0.0;
+        y(i, 0) = x(i, 0) + x(i, 5) - x(i, 6) > 0 ? 1.0 : 0.0;
+    }
+
+    for (int segments : {1, 2, 3, 9}){
+        check_matches_uncompiled(x, y, segments);
+        check_matches_uncompiled(SparseMatrix<double>::from_dense(x), y, segments);
+    }
+    check_matches_uncompiled(x, y, 3, 3);
+    check_matches_uncompiled(SparseMatrix<double>::from_dense(x), y, 4, 2);
+    check_rejects(x);
+    check_checkpoint_slab();
+    return test::result();
+}
@@ -0,0 +1,135 @@
+// Model::predict from many threads at once on one shared model gives the
+// outputs a single thread gets, for dense and sparse input, batches of
+// mixed sizes, with a caller's scratch or the thread-local one, before
+// and after int8 quantization.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "batch_norm.hpp"
+#include "activation_relu.hpp"
+#include "activation_sigmoid.hpp"
+#include "dropout.hpp"
+#include "loss_mse.hpp"
+#include "adam_optimizer.hpp"
+#include "sparse_matrix.hpp"
+#include "thread_pool.hpp"
+#include "utils_random.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int input_dim = 24, threads = 8, rounds = 40;
+
+bool same(const Matrix<double>& a, const Matrix<double>& b){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (a(i, j) != b(i, j)) return false;
+    return true;
+}
+
+struct Network {
+    DenseLayer<double> dense{input_dim, 32};
+    BatchNorm<double> norm{32, 32};
+    ActivationReLU<double> relu;
+    Dropout<double> dropout{0.2};
+    FusedDenseLayer<double> hidden{32, 16, Activation::Sigmoid};
+    DenseLayer<double> output{16, 3};
+    ActivationSigmoid<double> sigmoid;
+    Model<double> model;
+
+    Network(){
+        model.add(&dense);
+        model.add(&norm);
+        model.add(&relu);
+        model.add(&dropout);
+        model.add(&hidden);
+        model.add(&output);
+        model.add(&sigmoid);
+    }
+};
+
+/// Mostly-zero inputs, so the same rows serve as dense and CSR batches
+Matrix<double> inputs(int rows){
+    Matrix<double> x(rows, input_dim);
+    initialize_random(x, -1.0, 1.0);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < input_dim; ++j) if ((i + j) % 3) x(i, j) = 0.0;
+    return x;
+}
+
+/// Every thread predicts every batch `rounds` times, in its own order,
+/// alternating between a scratch of its own, the thread-local one and
+/// the allocating overload, and between dense and CSR input unless
+/// `dense_only`; returns the number of outputs that differ from the
+/// single-threaded ones
+int mismatches(const Model<double>& model, const std::vector<Matrix<double>>& batches,
+               const std::vector<SparseMatrix<double>>& sparse, bool dense_only,
+               const std::vector<Matrix<double>>& expected,
+               const std::vector<Matrix<double>>& expected_sparse){
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t){
+        pool.emplace_back([&, t]{
+            PredictScratch<double> scratch;
+            Matrix<double> output;
+            for (int r = 0; r < rounds; ++r){
+                std::size_t b = (t + r) % batches.size();
+                int mode = (t + r) % (dense_only ? 2 : 4);
+                switch (mode){
+                    case 0: model.predict(batches[b], output, scratch); break;
+                    case 1: model.predict(batches[b], output); break;
+                    case 2: model.predict(sparse[b], output, scratch); break;
+                    default: output = model.predict(sparse[b]); break;
+                }
+                if (!same(output, mode < 2 ? expected[b] : expected_sparse[b])) ++wrong;
+            }
+        });
+    }
+    for (std::thread& thread : pool) thread.join();
+    return wrong.load();
+}
+
+// A CSR batch sums its products in another order than the dense one, so
+// each kind of input is compared with its own single-threaded outputs
+void check(Model<double>& model, const std::vector<Matrix<double>>& batches, bool dense_only){
+    std::vector<SparseMatrix<double>> sparse;
+    std::vector<Matrix<double>> expected, expected_sparse;
+    for (const Matrix<double>& x : batches){
+        sparse.push_back(SparseMatrix<double>::from_dense(x));
+        expected.push_back(model.predict(x));
+        if (!dense_only) expected_sparse.push_back(model.predict(sparse.back()));
+    }
+    CHECK(mismatches(model, batches, sparse, dense_only, expected, expected_sparse) == 0);
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(14);
+    set_num_threads(4);
+    Network net;
+
+    // Training leaves BatchNorm with running statistics and the
+    // parameters away from their initial values
+    Matrix<double> x = inputs(64), y(64, 3);
+    initialize_random(y, 0.0, 1.0);
+    LossMSE<double> loss;
+    AdamOptimizer<double> optimizer(0.01);
+    {
+        test::QuietCout quiet;
+        net.model.train(x, y, loss, optimizer, 3, 10, 16);
+    }
+
+    // Batch sizes below and above the kernels' parallel grain
+    std::vector<Matrix<double>> batches;
+    for (int rows : {1, 3, 16, 64, 257}) batches.push_back(inputs(rows));
+
+    check(net.model, batches, false);
+    // Quantized layers take dense input only
+    net.model.quantize();
+    check(net.model, batches, true);
+    return test::result();
+}
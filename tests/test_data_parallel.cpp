@@ -0,0 +1,141 @@
+// Model::set_data_parallel: training with several replicas gives the
+// weights one worker gets, up to rounding, for dense and sparse input,
+// compiled or not, with shards of unequal size; replicas are rebuilt
+// when a new layer moves the flat parameter buffers; and BatchNorm's
+// running mean is averaged across shards.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_sigmoid.hpp"
+#include "batch_norm.hpp"
+#include "loss_mse.hpp"
+#include "sgd_optimizer.hpp"
+#include "adam_optimizer.hpp"
+#include "sparse_matrix.hpp"
+#include "thread_pool.hpp"
+#include "utils_random.hpp"
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+const int rows = 47, input_dim = 10, batch_size = 10;
+
+struct Network {
+    FusedDenseLayer<double> hidden{input_dim, 12, Activation::ReLU};
+    DenseLayer<double> output{12, 1};
+    ActivationSigmoid<double> sigmoid;
+    DenseLayer<double> extra{1, 1};
+    Model<double> model;
+
+    explicit Network(int workers){
+        model.add(&hidden);
+        model.add(&output);
+        model.add(&sigmoid);
+        model.set_data_parallel(workers);
+    }
+};
+
+bool close(Matrix<double>& a, Matrix<double>& b){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (!test::close(a(i, j), b(i, j), 1e-12)) return false;
+    return true;
+}
+
+/// Trains a network with `workers` replicas for a few epochs, adds a
+/// layer and trains some more; returns its parameters
+template <typename Input>
+Matrix<double> train(const Input& x, const Matrix<double>& y, int workers, bool compiled){
+    set_random_seed(5);
+    Network net(workers);
+    if (compiled) net.model.compile(input_dim, batch_size, 1, std::is_same<Input, SparseMatrix<double>>::value);
+    LossMSE<double> loss;
+    AdamOptimizer<double> optimizer(0.01);
+    test::QuietCout quiet;
+    net.model.train(x, y, loss, optimizer, 3, 10, batch_size, false);
+
+    // bind_parameters moves every parameter into new buffers, which the
+    // replicas must follow
+    net.model.add(&net.extra);
+    SGDOptimizer<double> sgd(0.1);
+    net.model.train(x, y, loss, sgd, 2, 10, batch_size, false);
+    return net.model.get_parameters();
+}
+
+template <typename Input>
+void check_matches_one_worker(const Input& x, const Matrix<double>& y){
+    for (int compiled = 0; compiled < 2; ++compiled){
+        Matrix<double> expected = train(x, y, 1, compiled);
+        // 3 workers split the 7-row batch 2/2/3; 8 leave some without rows
+        for (int workers : {2, 3, 8}){
+            Matrix<double> params = train(x, y, workers, compiled);
+            CHECK(close(params, expected));
+        }
+    }
+}
+
+void check_running_mean(const Matrix<double>& x, const Matrix<double>& y){
+    // With a zero learning rate the batch mean of every step is the
+    // row-weighted mean of the shard means, so the running means match
+    Matrix<double> means[2];
+    for (int w = 0; w < 2; ++w){
+        set_random_seed(5);
+        DenseLayer<double> dense(input_dim, 4);
+        BatchNorm<double> norm(4, 4);
+        DenseLayer<double> output(4, 1);
+        Model<double> model;
+        model.add(&dense);
+        model.add(&norm);
+        model.add(&output);
+        model.set_data_parallel(w == 0 ? 1 : 3);
+        LossMSE<double> loss;
+        SGDOptimizer<double> optimizer(0.0);
+        test::QuietCout quiet;
+        model.train(x, y, loss, optimizer, 2, 10, batch_size, false);
+        means[w] = *norm.state()[0];
+    }
+    CHECK(close(means[1], means[0]));
+}
+
+/// A loss without clone() cannot be given to the replicas
+class UncloneableLoss: public LossMSE<double> {
+    public:
+        std::unique_ptr<Loss<double>> clone() const override { return nullptr; }
+};
+
+void check_rejects_uncloneable_loss(const Matrix<double>& x, const Matrix<double>& y){
+    Network net(2);
+    UncloneableLoss loss;
+    SGDOptimizer<double> optimizer(0.1);
+    bool threw = false;
+    try {
+        test::QuietCout quiet;
+        net.model.train(x, y, loss, optimizer, 1, 10, batch_size, false);
+    } catch (const std::invalid_argument&){
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+} // namespace
+
+int main(){
+    set_num_threads(4);
+    set_random_seed(11);
+    Matrix<double> x(rows, input_dim), y(rows, 1);
+    initialize_random(x, -1.0, 1.0);
+    for (int i = 0; i < rows; ++i){
+        // Mostly zero, for the sparse runs
+        for (int j = 0; j < input_dim; ++j) if ((i + j) % 3) x(i, j) = 0.0;
+        y(i, 0) = x(i, 0) + x(i, 1) - x(i, 4) > 0 ? 1.0 : 0.0;
+    }
+
+    check_matches_one_worker(x, y);
+    check_matches_one_worker(SparseMatrix<double>::from_dense(x), y);
+    check_running_mean(x, y);
+    check_rejects_uncloneable_loss(x, y);
+    return test::result();
+}
@@ -0,0 +1,38 @@
+// Model::train rejects a dataset with no rows instead of dividing the
+// epoch loss by zero.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "loss_mse.hpp"
+#include "sgd_optimizer.hpp"
+#include "sparse_matrix.hpp"
+#include <stdexcept>
+
+namespace {
+
+template <typename Input>
+bool rejects(Model<double>& model, const Input& input, const Matrix<double>& target, int batch_size){
+    LossMSE<double> loss;
+    SGDOptimizer<double> optimizer(0.1);
+    try {
+        model.train(input, target, loss, optimizer, 1, 2, batch_size);
+    } catch (const std::invalid_argument&){
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main(){
+    DenseLayer<double> dense(4, 1);
+    Model<double> model;
+    model.add(&dense);
+
+    test::QuietCout quiet;
+    Matrix<double> input(0, 4), target(0, 1);
+    CHECK(rejects(model, input, target, 0));
+    CHECK(rejects(model, input, target, 8));
+    CHECK(rejects(model, SparseMatrix<double>::from_dense(input), target, 8));
+    return test::result();
+}
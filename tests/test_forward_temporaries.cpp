@@ -0,0 +1,85 @@
+// The allocating forward() of layers and models may be given a temporary:
+// the layer keeps its own copy of the input for backward, so the
+// gradients match those of a forward on a matrix that stays alive.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "sparse_matrix.hpp"
+#include "utils_random.hpp"
+
+namespace {
+
+Matrix<double> make_batch(){
+    set_random_seed(5);
+    Matrix<double> x(12, 6);
+    initialize_random(x, -1.0, 1.0);
+    // Some zeros, so the sparse copy below has fewer entries
+    for (int i = 0; i < x.rows; ++i) x(i, i % x.cols) = 0.0;
+    return x;
+}
+
+Matrix<double> make_gradient(int rows, int cols){
+    set_random_seed(6);
+    Matrix<double> g(rows, cols);
+    initialize_random(g, -1.0, 1.0);
+    return g;
+}
+
+bool same(const Matrix<double>& a, const Matrix<double>& b, double tolerance = 0.0){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (!test::close(a(i, j), b(i, j), tolerance)) return false;
+    return true;
+}
+
+/// d_weights and ∂L/∂X after forward on a temporary, then on a live input
+template <typename Layer>
+void check_layer(Layer& layer){
+    Matrix<double> g = make_gradient(12, layer.weights.cols);
+
+    layer.forward(make_batch());
+    // Reuse the freed stack and heap before backward reads the input
+    Matrix<double> other = make_gradient(12, 6);
+    Matrix<double> grad_input = layer.backward(g);
+    Matrix<double> d_weights = layer.get_d_weights();
+
+    Matrix<double> x = make_batch();
+    layer.forward(x);
+    CHECK(same(layer.backward(g), grad_input));
+    CHECK(same(layer.get_d_weights(), d_weights));
+}
+
+} // namespace
+
+int main(){
+    DenseLayer<double> dense(6, 4);
+    check_layer(dense);
+    FusedDenseLayer<double> fused(6, 4, Activation::ReLU);
+    check_layer(fused);
+
+    // Model::forward, dense and sparse input
+    DenseLayer<double> first(6, 5), second(5, 3);
+    ActivationReLU<double> relu;
+    Model<double> model;
+    model.add(&first);
+    model.add(&relu);
+    model.add(&second);
+    Matrix<double> g = make_gradient(12, 3);
+
+    model.forward(make_batch());
+    model.backward(g);
+    Matrix<double> d_weights = first.get_d_weights();
+
+    // The sparse product sums in another order
+    model.forward(SparseMatrix<double>::from_dense(make_batch()));
+    model.backward(g);
+    CHECK(same(first.get_d_weights(), d_weights, 1e-12));
+
+    Matrix<double> x = make_batch();
+    model.forward(x);
+    model.backward(g);
+    CHECK(same(first.get_d_weights(), d_weights));
+    return test::result();
+}
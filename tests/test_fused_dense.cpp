@@ -0,0 +1,73 @@
+// FusedDenseLayer against a DenseLayer followed by the same activation
+// as a separate layer: outputs, parameter gradients and ∂L/∂input agree
+// for every activation, through batches whose shape changes from one
+// call to the next.
+#include "test_support.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "activation_sigmoid.hpp"
+#include "utils_random.hpp"
+#include <memory>
+
+namespace {
+
+bool close(const Matrix<double>& a, const Matrix<double>& b){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (!test::close(a(i, j), b(i, j), 1e-12)) return false;
+    return true;
+}
+
+std::unique_ptr<Layer<double>> activation_layer(Activation activation){
+    if (activation == Activation::ReLU) return std::make_unique<ActivationReLU<double>>();
+    if (activation == Activation::Sigmoid) return std::make_unique<ActivationSigmoid<double>>();
+    return nullptr;
+}
+
+void check(Activation activation){
+    const int input_dim = 9, output_dim = 13;
+    FusedDenseLayer<double> fused(input_dim, output_dim, activation);
+    DenseLayer<double> dense(input_dim, output_dim);
+    dense.weights = fused.weights;
+    dense.bias = fused.bias;
+    std::unique_ptr<Layer<double>> act = activation_layer(activation);
+
+    Workspace ws;
+    // Full batches, then a smaller last batch, then full again
+    for (int rows : {32, 32, 7, 32, 1}){
+        Matrix<double> x(rows, input_dim), g(rows, output_dim);
+        initialize_random(x, -1.0, 1.0);
+        initialize_random(g, -1.0, 1.0);
+
+        Matrix<double> y_fused, z, y, grad_fused, grad_z, grad_input;
+        fused.forward_into(x, y_fused);
+        dense.forward_into(x, z);
+        if (act) act->forward_into(z, y);
+        else y = z;
+        CHECK(close(y_fused, y));
+
+        Matrix<double> inferred;
+        fused.infer_into(x, inferred, ws);
+        CHECK(close(inferred, y_fused));
+
+        fused.backward_into(g, grad_fused);
+        if (act) act->backward_into(g, grad_z);
+        else grad_z = g;
+        dense.backward_into(grad_z, grad_input);
+        CHECK(close(grad_fused, grad_input));
+        CHECK(close(fused.get_d_weights(), dense.get_d_weights()));
+        CHECK(close(fused.get_d_bias(), dense.get_d_bias()));
+
+        fused.update(0.05);
+        dense.update(0.05);
+    }
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(12);
+    for (Activation activation : {Activation::None, Activation::ReLU, Activation::Sigmoid}) check(activation);
+    return test::result();
+}
@@ -0,0 +1,88 @@
+// FusedDenseLayer under BFloat16 and Float16: training runs (compiled or
+// not, dense or sparse input) and follows the same path as a DenseLayer
+// with a separate activation layer.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "activation_sigmoid.hpp"
+#include "loss_mse.hpp"
+#include "adam_optimizer.hpp"
+#include "sparse_matrix.hpp"
+#include "utils_random.hpp"
+#include <cmath>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+const int rows = 96, input_dim = 10, batch_size = 32;
+
+struct Network {
+    std::vector<std::unique_ptr<Layer<float>>> layers;
+    Model<float> model;
+
+    explicit Network(bool fused){
+        set_random_seed(21);
+        if (fused) layers.emplace_back(new FusedDenseLayer<float>(input_dim, 16, Activation::ReLU));
+        else {
+            layers.emplace_back(new DenseLayer<float>(input_dim, 16));
+            layers.emplace_back(new ActivationReLU<float>());
+        }
+        if (fused) layers.emplace_back(new FusedDenseLayer<float>(16, 1, Activation::Sigmoid));
+        else {
+            layers.emplace_back(new DenseLayer<float>(16, 1));
+            layers.emplace_back(new ActivationSigmoid<float>());
+        }
+        for (auto& layer : layers) model.add(layer.get());
+    }
+};
+
+/// Predictions after a few epochs of training
+template <typename Input>
+Matrix<float> train(bool fused, Precision precision, bool compiled, const Input& x, const Matrix<float>& y){
+    Network net(fused);
+    net.model.set_precision(precision);
+    if (compiled) net.model.compile(input_dim, batch_size, 1, std::is_same<Input, SparseMatrix<float>>::value);
+    LossMSE<float> loss;
+    AdamOptimizer<float> optimizer(0.01);
+    test::QuietCout quiet;
+    net.model.train(x, y, loss, optimizer, 5, 10, batch_size, false);
+    return net.model.predict(x);
+}
+
+double max_difference(const Matrix<float>& a, const Matrix<float>& b){
+    if (a.rows != b.rows || a.cols != b.cols) return 1e9;
+    double worst = 0.0;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) worst = std::fmax(worst, std::fabs(double(a(i, j)) - b(i, j)));
+    return worst;
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(4);
+    Matrix<float> x(rows, input_dim), y(rows, 1);
+    initialize_random(x, -1.0, 1.0);
+    for (int i = 0; i < rows; ++i){
+        for (int j = 0; j < input_dim; ++j) if ((i + j) % 3 == 0) x(i, j) = 0.0f;
+        y(i, 0) = x(i, 0) + x(i, 1) > 0 ? 1.0f : 0.0f;
+    }
+    SparseMatrix<float> sparse = SparseMatrix<float>::from_dense(x);
+
+    for (Precision precision : {Precision::BFloat16, Precision::Float16}){
+        for (int compiled = 0; compiled < 2; ++compiled){
+            Matrix<float> fused = train(true, precision, compiled, x, y);
+            Matrix<float> separate = train(false, precision, compiled, x, y);
+            CHECK(max_difference(fused, separate) <= 1e-3);
+
+            Matrix<float> fused_sparse = train(true, precision, compiled, sparse, y);
+            Matrix<float> separate_sparse = train(false, precision, compiled, sparse, y);
+            CHECK(max_difference(fused_sparse, separate_sparse) <= 1e-3);
+        }
+    }
+    return test::result();
+}
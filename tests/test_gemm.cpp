@@ -0,0 +1,143 @@
+// gemm() against a naive triple loop: every transpose combination, sizes
+// around the packing block edges, padded strides, alpha/beta, the fused
+// bias/activation epilogue and 16-bit operands.
+#include "test_support.hpp"
+#include "gemm.hpp"
+#include "half.hpp"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::mt19937 generator(11);
+
+template <typename T>
+std::vector<T> random_buffer(std::size_t n){
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::vector<T> buffer(n);
+    for (T& value : buffer) value = static_cast<T>(uniform(generator));
+    return buffer;
+}
+
+double activate(double x, Activation activation){
+    if (activation == Activation::ReLU) return x > 0 ? x : 0;
+    if (activation == Activation::Sigmoid) return 1.0 / (1.0 + std::exp(-x));
+    return x;
+}
+
+/// C = act(alpha · op(A) · op(B) + beta · C + bias), in double
+template <typename T>
+void reference(Transpose ta, Transpose tb, int M, int N, int K,
+               double alpha, const T* A, int lda, const T* B, int ldb,
+               double beta, T* C, int ldc, const GemmEpilogue<T>& epilogue){
+    for (int i = 0; i < M; ++i){
+        for (int j = 0; j < N; ++j){
+            double sum = 0.0;
+            for (int k = 0; k < K; ++k){
+                double a = ta == Transpose::No ? A[i * lda + k] : A[k * lda + i];
+                double b = tb == Transpose::No ? B[k * ldb + j] : B[j * ldb + k];
+                sum += a * b;
+            }
+            double c = alpha * sum + (beta == 0 ? 0.0 : beta * C[i * ldc + j]);
+            if (epilogue.bias) c += epilogue.bias[j];
+            C[i * ldc + j] = static_cast<T>(activate(c, epilogue.activation));
+        }
+    }
+}
+
+template <typename T>
+double max_difference(const std::vector<T>& a, const std::vector<T>& b){
+    double worst = 0.0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        worst = std::fmax(worst, std::fabs(double(a[i]) - double(b[i])));
+    return worst;
+}
+
+template <typename T>
+void check_shapes(double tolerance){
+    const int sizes[][3] = {
+        {1, 1, 1}, {3, 5, 7}, {17, 1, 33}, {1, 65, 9}, {64, 64, 64},
+        {71, 129, 257}, {300, 23, 517}, {5, 300, 2}
+    };
+    for (const auto& size : sizes){
+        int M = size[0], N = size[1], K = size[2];
+        for (Transpose ta : {Transpose::No, Transpose::Yes}){
+            for (Transpose tb : {Transpose::No, Transpose::Yes}){
+                // Stored shapes, with padded row strides
+                int a_rows = ta == Transpose::No ? M : K, a_cols = ta == Transpose::No ? K : M;
+                int b_rows = tb == Transpose::No ? K : N, b_cols = tb == Transpose::No ? N : K;
+                int lda = a_cols + 3, ldb = b_cols + 1, ldc = N + 2;
+                std::vector<T> A = random_buffer<T>(std::size_t(a_rows) * lda);
+                std::vector<T> B = random_buffer<T>(std::size_t(b_rows) * ldb);
+                std::vector<T> bias = random_buffer<T>(N);
+                std::vector<T> C0 = random_buffer<T>(std::size_t(M) * ldc);
+
+                // Plain product overwriting C (which starts out as NaN)
+                std::vector<T> C(C0.size(), static_cast<T>(NAN)), expected = C0;
+                gemm<T>(ta, tb, M, N, K, T(1), A.data(), lda, B.data(), ldb, T(0), C.data(), ldc);
+                reference<T>(ta, tb, M, N, K, 1.0, A.data(), lda, B.data(), ldb, 0.0, expected.data(), ldc, {});
+                for (int i = 0; i < M; ++i)
+                    for (int j = N; j < ldc; ++j) C[i * ldc + j] = expected[i * ldc + j];
+                CHECK(max_difference(C, expected) <= tolerance * K);
+
+                // alpha, beta and the epilogue
+                for (Activation activation : {Activation::None, Activation::ReLU, Activation::Sigmoid}){
+                    GemmEpilogue<T> epilogue;
+                    epilogue.bias = bias.data();
+                    epilogue.activation = activation;
+                    C = C0;
+                    expected = C0;
+                    gemm<T>(ta, tb, M, N, K, T(0.5), A.data(), lda, B.data(), ldb, T(-2), C.data(), ldc, epilogue);
+                    reference<T>(ta, tb, M, N, K, 0.5, A.data(), lda, B.data(), ldb, -2.0, expected.data(), ldc, epilogue);
+                    CHECK(max_difference(C, expected) <= tolerance * K);
+                }
+            }
+        }
+    }
+}
+
+/// 16-bit operands give exactly the product of their widened values
+template <typename T>
+void check_half_operands(Precision precision, double tolerance){
+    const int M = 37, N = 45, K = 130;
+    std::vector<T> A = random_buffer<T>(std::size_t(M) * K), B = random_buffer<T>(std::size_t(K) * N);
+    std::vector<std::uint16_t> A_half(A.size()), B_half(B.size());
+    half::encode(precision, A.data(), A_half.data(), A.size());
+    half::encode(precision, B.data(), B_half.data(), B.size());
+    std::vector<T> A_wide(A.size()), B_wide(B.size());
+    half::decode(precision, A_half.data(), A_wide.data(), A.size());
+    half::decode(precision, B_half.data(), B_wide.data(), B.size());
+
+    std::vector<T> bias = random_buffer<T>(N);
+    GemmEpilogue<T> epilogue;
+    epilogue.bias = bias.data();
+    epilogue.activation = Activation::ReLU;
+
+    std::vector<T> expected(std::size_t(M) * N), C(expected.size());
+    reference<T>(Transpose::No, Transpose::No, M, N, K, 1.0, A_wide.data(), K, B_wide.data(), N,
+                 0.0, expected.data(), N, epilogue);
+
+    // Half A with T B, and both half
+    gemm<T>(Transpose::No, Transpose::No, M, N, K, T(1),
+            GemmOperand<T>(A_half.data(), K, precision), GemmOperand<T>(B_wide.data(), N),
+            T(0), C.data(), N, epilogue);
+    CHECK(max_difference(C, expected) <= tolerance * K);
+    gemm<T>(Transpose::No, Transpose::No, M, N, K, T(1),
+            GemmOperand<T>(A_half.data(), K, precision), GemmOperand<T>(B_half.data(), N, precision),
+            T(0), C.data(), N, epilogue);
+    CHECK(max_difference(C, expected) <= tolerance * K);
+}
+
+} // namespace
+
+int main(){
+    check_shapes<double>(1e-14);
+    check_shapes<float>(1e-6);
+    for (Precision precision : {Precision::BFloat16, Precision::Float16}){
+        check_half_operands<double>(precision, 1e-14);
+        check_half_operands<float>(precision, 1e-6);
+    }
+    return test::result();
+}
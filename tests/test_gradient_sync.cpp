@@ -0,0 +1,112 @@
+// GradientSync against an in-process stand-in for the other ranks:
+// buckets close at layer boundaries once they reach the bucket size and
+// cover the buffer back to front, layer_done sends only complete buckets,
+// finish leaves the mean, and a communication error surfaces from finish
+// without poisoning the next step.
+#include "test_support.hpp"
+#include "gradient_sync.hpp"
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// Two ranks, the other of which always holds 3 · this rank's data; records
+/// the range of every all_reduce relative to `base`
+class FakeCommunicator: public Communicator {
+    public:
+        const double* base = nullptr;
+        bool fail = false;
+        std::mutex mutex;
+        std::vector<std::pair<std::size_t, std::size_t>> calls;
+
+        int rank() const override { return 0; }
+        int size() const override { return 2; }
+
+        void all_reduce(float*, std::size_t) override { throw std::logic_error("unexpected float"); }
+        void all_reduce(double* data, std::size_t n) override {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                calls.push_back({static_cast<std::size_t>(data - base), static_cast<std::size_t>(data - base) + n});
+            }
+            if (fail) throw std::runtime_error("link down");
+            for (std::size_t i = 0; i < n; ++i) data[i] *= 4;
+        }
+        void broadcast(float*, std::size_t, int) override {}
+        void broadcast(double*, std::size_t, int) override {}
+        void barrier() override {}
+
+        std::size_t call_count(){
+            std::lock_guard<std::mutex> lock(mutex);
+            return calls.size();
+        }
+};
+
+void check_buckets(){
+    // Five layers; the third has no parameters
+    const std::vector<std::size_t> layer_begin = {0, 40, 100, 100, 130};
+    const std::size_t n = 300;
+    std::vector<double> grads(n);
+
+    FakeCommunicator comm;
+    comm.base = grads.data();
+    GradientSync<double> sync(comm, 50 * sizeof(double));
+    sync.plan(grads.data(), n, layer_begin);
+
+    for (int step = 0; step < 3; ++step){
+        comm.calls.clear();
+        for (std::size_t i = 0; i < n; ++i) grads[i] = static_cast<double>(i + step);
+
+        // Layer 4 alone fills a bucket; layers 3 and 2 add 30 elements,
+        // not enough, so layer_done(2) sends nothing new
+        for (std::size_t layer = layer_begin.size(); layer-- > 0;){
+            sync.layer_done(layer);
+        }
+        sync.finish();
+
+        std::vector<std::pair<std::size_t, std::size_t>> expected = {{130, 300}, {40, 130}, {0, 40}};
+        CHECK(comm.calls == expected);
+        bool mean = true;
+        for (std::size_t i = 0; i < n; ++i) mean = mean && grads[i] == 2.0 * (i + step);
+        CHECK(mean);
+    }
+}
+
+void check_error(){
+    std::vector<double> grads(100, 1.0);
+    FakeCommunicator comm;
+    comm.base = grads.data();
+    GradientSync<double> sync(comm, 10 * sizeof(double));
+    sync.plan(grads.data(), grads.size(), {0, 50});
+
+    comm.fail = true;
+    sync.layer_done(1);
+    sync.layer_done(0);
+    bool threw = false;
+    try {
+        sync.finish();
+    } catch (const std::runtime_error&){
+        threw = true;
+    }
+    CHECK(threw);
+    // The bucket after the failed one was not sent
+    CHECK(comm.call_count() == 1);
+
+    comm.fail = false;
+    comm.calls.clear();
+    sync.layer_done(1);
+    sync.layer_done(0);
+    sync.finish();
+    CHECK(comm.calls.size() == 2);
+    CHECK(grads[0] == 2.0 && grads[99] == 2.0);
+}
+
+} // namespace
+
+int main(){
+    check_buckets();
+    check_error();
+    return test::result();
+}
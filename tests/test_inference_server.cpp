@@ -0,0 +1,176 @@
+// InferenceServer: results match Model::predict through futures and
+// callbacks; requests are batched up to max_batch_size, and a partial
+// batch is served once its oldest request has waited max_wait; errors
+// from predict reach every request of the batch; submitters block on a
+// full queue and all get served; and destroying the server serves what
+// is still queued without waiting out max_wait.
+#include "test_support.hpp"
+#include "inference_server.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "activation_sigmoid.hpp"
+#include "utils_random.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+const int input_dim = 5;
+
+struct Network {
+    DenseLayer<double> hidden{input_dim, 7};
+    ActivationSigmoid<double> sigmoid;
+    DenseLayer<double> output{7, 3};
+    Model<double> model;
+
+    Network(){
+        model.add(&hidden);
+        model.add(&sigmoid);
+        model.add(&output);
+    }
+};
+
+std::vector<double> row(const Matrix<double>& m, int i){
+    return std::vector<double>(m.row(i), m.row(i) + m.cols);
+}
+
+bool matches(const std::vector<double>& output, const Matrix<double>& expected, int i){
+    if (static_cast<int>(output.size()) != expected.cols) return false;
+    for (int j = 0; j < expected.cols; ++j) if (!test::close(output[j], expected(i, j), 1e-12)) return false;
+    return true;
+}
+
+void check_results(const Network& net, const Matrix<double>& x, const Matrix<double>& expected){
+    InferenceServer<double> server(net.model, input_dim, 8, std::chrono::microseconds(200));
+
+    std::vector<std::future<std::vector<double>>> futures;
+    for (int i = 0; i < x.rows; ++i) futures.push_back(server.submit(row(x, i)));
+    for (int i = 0; i < x.rows; ++i) CHECK(matches(futures[i].get(), expected, i));
+
+    std::vector<std::promise<bool>> delivered(x.rows);
+    for (int i = 0; i < x.rows; ++i){
+        server.submit(row(x, i), [&, i](std::vector<double> output, std::exception_ptr error){
+            delivered[i].set_value(!error && matches(output, expected, i));
+        });
+    }
+    for (int i = 0; i < x.rows; ++i) CHECK(delivered[i].get_future().get());
+
+    bool threw = false;
+    try {
+        server.submit(std::vector<double>(input_dim + 1));
+    } catch (const std::invalid_argument&){
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(server.stats().requests == static_cast<std::size_t>(2 * x.rows));
+}
+
+void check_batching(const Network& net, const Matrix<double>& x, const Matrix<double>& expected){
+    // A long max_wait: 20 quick requests fill two batches, and the last
+    // 4 go out only when the first of them has waited max_wait
+    const milliseconds max_wait(300);
+    InferenceServer<double> server(net.model, input_dim, 8, max_wait);
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::future<std::vector<double>>> futures;
+    for (int i = 0; i < 20; ++i) futures.push_back(server.submit(row(x, i)));
+    for (int i = 0; i < 20; ++i) CHECK(matches(futures[i].get(), expected, i));
+    Clock::duration elapsed = Clock::now() - start;
+
+    ServerStats stats = server.stats();
+    CHECK(stats.requests == 20);
+    CHECK(stats.batches == 3);
+    CHECK(stats.max_latency_us >= 0.9 * 1000 * max_wait.count());
+    CHECK(elapsed >= milliseconds(270));
+    CHECK(elapsed < milliseconds(5000));
+}
+
+void check_errors(const Network& net){
+    // The server takes rows one wider than the model, so predict throws
+    InferenceServer<double> server(net.model, input_dim + 1, 4, std::chrono::microseconds(100));
+    std::vector<double> input(input_dim + 1, 0.5);
+
+    std::vector<std::future<std::vector<double>>> futures;
+    for (int i = 0; i < 6; ++i) futures.push_back(server.submit(input));
+    for (std::future<std::vector<double>>& f : futures){
+        bool threw = false;
+        try {
+            f.get();
+        } catch (const std::invalid_argument&){
+            threw = true;
+        }
+        CHECK(threw);
+    }
+
+    std::promise<bool> delivered;
+    server.submit(input, [&](std::vector<double> output, std::exception_ptr error){
+        delivered.set_value(output.empty() && error);
+    });
+    CHECK(delivered.get_future().get());
+
+    // A throwing callback does not take the server down
+    server.submit(input, [](std::vector<double>, std::exception_ptr){ throw std::runtime_error("ignored"); });
+    std::future<std::vector<double>> after = server.submit(input);
+    CHECK(after.wait_for(milliseconds(5000)) == std::future_status::ready);
+    CHECK(server.stats().requests == 9);
+}
+
+void check_backpressure(const Network& net, const Matrix<double>& x, const Matrix<double>& expected){
+    // A queue of 2 and single-row batches: most submits find it full
+    InferenceServer<double> server(net.model, input_dim, 1, std::chrono::microseconds(0), 2);
+    const int clients = 8, per_client = 300;
+    std::atomic<int> wrong{0};
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c){
+        threads.emplace_back([&, c]{
+            std::vector<std::future<std::vector<double>>> futures;
+            for (int k = 0; k < per_client; ++k) futures.push_back(server.submit(row(x, (c + k) % x.rows)));
+            for (int k = 0; k < per_client; ++k){
+                if (!matches(futures[k].get(), expected, (c + k) % x.rows)) ++wrong;
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    CHECK(wrong == 0);
+    CHECK(server.stats().requests == static_cast<std::size_t>(clients * per_client));
+    CHECK(server.stats().batches == static_cast<std::size_t>(clients * per_client));
+}
+
+void check_shutdown(const Network& net, const Matrix<double>& x, const Matrix<double>& expected){
+    std::vector<std::future<std::vector<double>>> futures;
+    Clock::time_point start = Clock::now();
+    {
+        InferenceServer<double> server(net.model, input_dim, 1000, milliseconds(10000));
+        for (int i = 0; i < x.rows; ++i) futures.push_back(server.submit(row(x, i)));
+    }
+    CHECK(Clock::now() - start < milliseconds(5000));
+    for (int i = 0; i < x.rows; ++i){
+        CHECK(futures[i].wait_for(milliseconds(0)) == std::future_status::ready);
+        CHECK(matches(futures[i].get(), expected, i));
+    }
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(13);
+    Network net;
+    Matrix<double> x(24, input_dim);
+    initialize_random(x, -1.0, 1.0);
+    Matrix<double> expected = net.model.predict(x);
+
+    check_results(net, x, expected);
+    check_batching(net, x, expected);
+    check_errors(net);
+    check_backpressure(net, x, expected);
+    check_shutdown(net, x, expected);
+    return test::result();
+}
@@ -0,0 +1,160 @@
+// Every kernel of every instruction set this CPU supports against the
+// portable scalar table, on lengths that exercise the vector bodies and
+// their remainders, with unaligned pointers.
+#include "test_support.hpp"
+#include "kernels.hpp"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+using kernels::Isa;
+using kernels::KernelTable;
+
+std::mt19937 generator(5);
+
+template <typename T>
+std::vector<T> random_buffer(std::size_t n, double low = -2.0, double high = 2.0){
+    std::uniform_real_distribution<double> uniform(low, high);
+    // One element of slack so the kernels can be handed offset pointers
+    std::vector<T> buffer(n + 1);
+    for (T& value : buffer) value = static_cast<T>(uniform(generator));
+    return buffer;
+}
+
+template <typename T>
+bool same(const std::vector<T>& a, const std::vector<T>& b, double tolerance){
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (!test::close(a[i], b[i], tolerance)) return false;
+    return true;
+}
+
+template <typename T>
+void check_table(const KernelTable<T>& simd, const KernelTable<T>& scalar, double tolerance){
+    const std::size_t lengths[] = {1, 3, 7, 8, 15, 16, 17, 31, 64, 67, 1000};
+    for (std::size_t n : lengths){
+        auto a = random_buffer<T>(n), b = random_buffer<T>(n), c = random_buffer<T>(n);
+        auto positive = random_buffer<T>(n, 0.1, 2.0), unit = random_buffer<T>(n, 0.0, 1.0);
+        // Unaligned starts
+        const T *pa = a.data() + 1, *pb = b.data() + 1;
+
+        // Binary and scaling operations
+        using Binary = void (*)(const T*, const T*, T*, std::size_t);
+        for (auto op : {&KernelTable<T>::add, &KernelTable<T>::sub, &KernelTable<T>::mul,
+                        &KernelTable<T>::mul_add, &KernelTable<T>::relu_backward,
+                        &KernelTable<T>::relu_backward_output, &KernelTable<T>::sigmoid_backward}){
+            std::vector<T> x = c, y = c;
+            Binary(simd.*op)(pa, pb, x.data() + 1, n);
+            Binary(scalar.*op)(pa, pb, y.data() + 1, n);
+            CHECK(same(x, y, tolerance));
+        }
+        {
+            std::vector<T> x = c, y = c;
+            simd.scale(pa, T(-1.5), x.data() + 1, n);
+            scalar.scale(pa, T(-1.5), y.data() + 1, n);
+            CHECK(same(x, y, tolerance));
+            simd.axpy(pa, T(0.75), x.data() + 1, n);
+            scalar.axpy(pa, T(0.75), y.data() + 1, n);
+            CHECK(same(x, y, tolerance));
+        }
+
+        // Activations
+        {
+            std::vector<T> x = c, y = c, mx = c, my = c;
+            simd.relu_forward(pa, x.data() + 1, mx.data() + 1, n);
+            scalar.relu_forward(pa, y.data() + 1, my.data() + 1, n);
+            CHECK(same(x, y, 0) && same(mx, my, 0));
+            simd.relu(pa, x.data() + 1, n);
+            scalar.relu(pa, y.data() + 1, n);
+            CHECK(same(x, y, 0));
+            simd.sigmoid_forward(pa, x.data() + 1, n);
+            scalar.sigmoid_forward(pa, y.data() + 1, n);
+            CHECK(same(x, y, tolerance));
+        }
+
+        // Reductions and fused losses
+        {
+            CHECK_CLOSE(simd.squared_diff_sum(pa, pb, n), scalar.squared_diff_sum(pa, pb, n), tolerance * n);
+            std::vector<T> x = c, y = c;
+            simd.scaled_diff(pa, pb, T(0.3), x.data() + 1, n);
+            scalar.scaled_diff(pa, pb, T(0.3), y.data() + 1, n);
+            CHECK(same(x, y, tolerance));
+            const T* labels = unit.data() + 1;
+            CHECK_CLOSE(simd.bce_logits(pa, labels, T(0.1), x.data() + 1, n),
+                        scalar.bce_logits(pa, labels, T(0.1), y.data() + 1, n), tolerance * n);
+            CHECK(same(x, y, tolerance));
+            CHECK_CLOSE(simd.sigmoid_mse(pa, labels, T(0.1), x.data() + 1, n),
+                        scalar.sigmoid_mse(pa, labels, T(0.1), y.data() + 1, n), tolerance * n);
+            CHECK(same(x, y, tolerance));
+        }
+
+        // Optimizer updates
+        {
+            kernels::AdamStep<T> adam{T(0.9), T(0.1), T(0.999), T(0.001), T(0.01), T(3.2), T(1e-8), T(0.999)};
+            std::vector<T> px = c, py = c, mx = a, my = a, vx = positive, vy = positive;
+            simd.adam_update(px.data() + 1, pb, mx.data() + 1, vx.data() + 1, adam, n);
+            scalar.adam_update(py.data() + 1, pb, my.data() + 1, vy.data() + 1, adam, n);
+            CHECK(same(px, py, tolerance) && same(mx, my, tolerance) && same(vx, vy, tolerance));
+
+            for (bool nesterov : {false, true}){
+                kernels::SgdStep<T> sgd{T(0.05), T(0.9), T(0.01), nesterov};
+                std::vector<T> qx = c, qy = c, ux = a, uy = a;
+                simd.sgd_momentum(qx.data() + 1, pb, ux.data() + 1, sgd, n);
+                scalar.sgd_momentum(qy.data() + 1, pb, uy.data() + 1, sgd, n);
+                CHECK(same(qx, qy, tolerance) && same(ux, uy, tolerance));
+            }
+        }
+
+        // Batch norm input gradient
+        {
+            auto sums = random_buffer<T>(n), sums_xhat = random_buffer<T>(n);
+            std::vector<T> x = c, y = c;
+            simd.batchnorm_input_grad(pa, pb, sums.data(), sums_xhat.data(), positive.data(), T(32), x.data() + 1, n);
+            scalar.batchnorm_input_grad(pa, pb, sums.data(), sums_xhat.data(), positive.data(), T(32), y.data() + 1, n);
+            CHECK(same(x, y, tolerance * 32));
+        }
+    }
+
+    // Row-broadcast operations on a strided (rows × cols) block
+    const int rows = 5, cols = 19, ld = 23;
+    auto a = random_buffer<T>(std::size_t(rows) * ld), row = random_buffer<T>(cols), shift = random_buffer<T>(cols);
+    using RowOp = void (*)(const T*, int, const T*, T*, int, int, int);
+    for (auto op : {&KernelTable<T>::add_row, &KernelTable<T>::sub_row, &KernelTable<T>::mul_row}){
+        std::vector<T> x(a.size()), y(a.size());
+        RowOp(simd.*op)(a.data(), ld, row.data(), x.data(), ld, rows, cols);
+        RowOp(scalar.*op)(a.data(), ld, row.data(), y.data(), ld, rows, cols);
+        CHECK(same(x, y, tolerance));
+    }
+    std::vector<T> x(a.size()), y(a.size());
+    simd.affine_row(a.data(), ld, row.data(), shift.data(), x.data(), ld, rows, cols);
+    scalar.affine_row(a.data(), ld, row.data(), shift.data(), y.data(), ld, rows, cols);
+    CHECK(same(x, y, tolerance));
+}
+
+template <typename T>
+void check_all(double tolerance){
+    const KernelTable<T>* scalar = kernels::table_for<T>(Isa::Scalar);
+    CHECK(scalar != nullptr);
+    if (!scalar) return;
+    for (Isa isa : {Isa::SSE2, Isa::AVX2, Isa::AVX512}){
+        const KernelTable<T>* simd = kernels::table_for<T>(isa);
+        if (!simd){
+            std::printf("%s: not supported here, skipped\n", kernels::isa_name(isa));
+            continue;
+        }
+        int before = test::failures;
+        check_table(*simd, *scalar, tolerance);
+        if (test::failures != before)
+            std::fprintf(stderr, "%s (%s) differs from the scalar kernels\n",
+                         kernels::isa_name(isa), sizeof(T) == 4 ? "float" : "double");
+    }
+}
+
+} // namespace
+
+int main(){
+    check_all<double>(1e-12);
+    check_all<float>(1e-5);
+    return test::result();
+}
@@ -0,0 +1,109 @@
+// Training on a row count that is not a multiple of the batch size: the
+// final batch of each epoch is smaller (or dropped), FusedDenseLayer
+// copes with the batch shape changing under it, and the epoch loss
+// weights every batch by its row count.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_sigmoid.hpp"
+#include "loss_mse.hpp"
+#include "sgd_optimizer.hpp"
+#include "utils_random.hpp"
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// MSE that records the row count and loss of every batch it sees
+class RecordingLoss: public LossMSE<double> {
+    public:
+        std::vector<int> rows;
+        std::vector<double> losses;
+
+        double forward(const Matrix<double>& prediction, const Matrix<double>& target) override {
+            double loss = LossMSE<double>::forward(prediction, target);
+            rows.push_back(prediction.rows);
+            losses.push_back(loss);
+            return loss;
+        }
+};
+
+struct Network {
+    FusedDenseLayer<double> hidden{6, 12, Activation::ReLU};
+    DenseLayer<double> output{12, 1};
+    ActivationSigmoid<double> sigmoid;
+    Model<double> model;
+
+    Network(){
+        model.add(&hidden);
+        model.add(&output);
+        model.add(&sigmoid);
+    }
+};
+
+std::vector<int> expected_rows(int rows, int batch_size, int epochs, LastBatch last_batch){
+    std::vector<int> batches;
+    for (int e = 0; e < epochs; ++e){
+        for (int start = 0; start + batch_size <= rows; start += batch_size) batches.push_back(batch_size);
+        if (rows % batch_size != 0 && last_batch == LastBatch::Keep) batches.push_back(rows % batch_size);
+    }
+    return batches;
+}
+
+/// The loss Model::train printed for its last epoch
+double logged_loss(const std::string& log){
+    std::size_t at = log.rfind("Loss: ");
+    return at == std::string::npos ? -1.0 : std::stod(log.substr(at + 6));
+}
+
+} // namespace
+
+int main(){
+    const int rows = 103, batch_size = 25, input_dim = 6;
+    set_random_seed(7);
+    Matrix<double> x(rows, input_dim), y(rows, 1);
+    initialize_random(x, -1.0, 1.0);
+    for (int i = 0; i < rows; ++i) y(i, 0) = x(i, 0) - x(i, 2) > 0 ? 1.0 : 0.0;
+
+    // Shapes of the batches, shuffled or not, compiled or not
+    for (int compiled = 0; compiled < 2; ++compiled){
+        for (LastBatch last_batch : {LastBatch::Keep, LastBatch::Drop}){
+            for (bool shuffle : {false, true}){
+                Network net;
+                if (compiled) net.model.compile(input_dim, batch_size);
+                RecordingLoss loss;
+                SGDOptimizer<double> optimizer(0.1);
+                test::QuietCout quiet;
+                net.model.train(x, y, loss, optimizer, 3, 10, batch_size, shuffle, last_batch);
+                CHECK(loss.rows == expected_rows(rows, batch_size, 3, last_batch));
+            }
+        }
+    }
+
+    // With a zero learning rate the weights stay put, so the epoch loss
+    // must be the loss over the whole dataset: the 3-row batch counts for
+    // 3 rows, not for a full batch
+    for (int compiled = 0; compiled < 2; ++compiled){
+        Network net;
+        if (compiled) net.model.compile(input_dim, batch_size);
+        RecordingLoss loss;
+        SGDOptimizer<double> optimizer(0.0);
+        std::ostringstream log;
+        std::streambuf* saved = std::cout.rdbuf(log.rdbuf());
+        net.model.train(x, y, loss, optimizer, 1, 10, batch_size, true);
+        std::cout.rdbuf(saved);
+
+        CHECK(loss.rows.size() == 5 && loss.rows.back() == rows % batch_size);
+        double weighted = 0.0;
+        for (std::size_t b = 0; b < loss.rows.size(); ++b) weighted += loss.losses[b] * loss.rows[b];
+        weighted /= rows;
+
+        LossMSE<double> reference;
+        double full = reference.forward(net.model.predict(x), y);
+        CHECK_CLOSE(weighted, full, 1e-12);
+        CHECK_CLOSE(logged_loss(log.str()), full, 1e-4);
+    }
+    return test::result();
+}
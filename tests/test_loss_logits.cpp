@@ -0,0 +1,181 @@
+// The fused logit losses against the unfused computation: BCE with
+// logits against binary cross-entropy of σ(z), and SigmoidMSE against
+// ActivationSigmoid followed by LossMSE, in loss and ∂L/∂z, for float
+// and double, contiguous or strided inputs, with the gradient scale
+// applied; saturated logits stay finite.
+#include "test_support.hpp"
+#include "loss_logits.hpp"
+#include "loss_mse.hpp"
+#include "activation_sigmoid.hpp"
+#include "utils_random.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+template <typename T>
+bool close(const Matrix<T>& a, const Matrix<T>& b, double tolerance){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (!test::close(a(i, j), b(i, j), tolerance)) return false;
+    return true;
+}
+
+template <typename T>
+double tolerance(){ return sizeof(T) == sizeof(float) ? 1e-5 : 1e-12; }
+
+/// Binary cross-entropy of p = σ(z), as written in the textbook
+template <typename T>
+double bce(const Matrix<T>& z, const Matrix<T>& y, Matrix<T>& grad){
+    grad.resize(z.rows, z.cols);
+    double sum = 0.0;
+    int n = z.rows * z.cols;
+    for (int i = 0; i < z.rows; ++i){
+        for (int j = 0; j < z.cols; ++j){
+            double p = 1.0 / (1.0 + std::exp(-double(z(i, j))));
+            sum -= y(i, j) * std::log(p) + (1.0 - y(i, j)) * std::log(1.0 - p);
+            grad(i, j) = static_cast<T>((p - y(i, j)) / n);
+        }
+    }
+    return sum / n;
+}
+
+/// Logits in [-6, 6] and targets in [0, 1]; a view with a wider stride
+/// over `storage` when `strided`
+template <typename T>
+void batch(int rows, int cols, bool strided, std::vector<T>& storage, Matrix<T>& z, Matrix<T>& y){
+    Matrix<T> logits(rows, cols), target(rows, cols);
+    initialize_random(logits, T(-6), T(6));
+    initialize_random(target, T(0), T(1));
+    if (!strided){
+        z = logits;
+        y = target;
+        return;
+    }
+    int stride = cols + 3;
+    storage.assign(2 * rows * stride, T(0));
+    z = Matrix<T>::view(storage.data(), rows, cols, stride);
+    y = Matrix<T>::view(storage.data() + rows * stride, rows, cols, stride);
+    z = logits;
+    y = target;
+}
+
+template <typename T>
+void check_bce(int rows, int cols, bool strided){
+    std::vector<T> storage;
+    Matrix<T> z, y;
+    batch(rows, cols, strided, storage, z, y);
+
+    Matrix<T> expected_grad, grad;
+    double expected = bce(z, y, expected_grad);
+    LossBCEWithLogits<T> loss;
+    CHECK_CLOSE(loss.forward(z, y), expected, tolerance<T>());
+    loss.backward_into(grad);
+    CHECK(close(grad, expected_grad, tolerance<T>()));
+
+    // The scale multiplies the gradient only
+    loss.set_gradient_scale(T(8));
+    CHECK_CLOSE(loss.forward(z, y), expected, tolerance<T>());
+    loss.backward_into(grad);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j) CHECK_CLOSE(grad(i, j), 8.0 * expected_grad(i, j), tolerance<T>());
+}
+
+template <typename T>
+void check_sigmoid_mse(int rows, int cols, bool strided){
+    std::vector<T> storage;
+    Matrix<T> z, y;
+    batch(rows, cols, strided, storage, z, y);
+
+    ActivationSigmoid<T> sigmoid;
+    LossMSE<T> mse;
+    Matrix<T> p, grad_p, expected_grad, grad;
+    sigmoid.forward_into(z, p);
+    double expected = mse.forward(p, y);
+    mse.backward_into(grad_p);
+    sigmoid.backward_into(grad_p, expected_grad);
+
+    LossSigmoidMSE<T> loss;
+    CHECK_CLOSE(loss.forward(z, y), expected, tolerance<T>());
+    loss.backward_into(grad);
+    CHECK(close(grad, expected_grad, tolerance<T>()));
+}
+
+/// |z| far past where σ(z) rounds to 0 or 1: the unfused BCE takes log(0)
+/// there, the fused one returns max(z, 0) - z·y + log(1 + e^(-|z|))
+template <typename T>
+void check_saturated(){
+    const std::vector<T> logits = {T(-80), T(-40), T(40), T(80)};
+    const std::vector<T> targets = {T(1), T(0), T(0), T(1)};
+    Matrix<T> z(1, 4), y(1, 4), grad;
+    for (int j = 0; j < 4; ++j){
+        z(0, j) = logits[j];
+        y(0, j) = targets[j];
+    }
+    // Wrong-side logits cost |z|; right-side ones almost nothing
+    double expected = (80.0 + 0.0 + 40.0 + 0.0) / 4;
+    LossBCEWithLogits<T> loss;
+    double value = loss.forward(z, y);
+    CHECK(std::isfinite(value));
+    CHECK_CLOSE(value, expected, tolerance<T>());
+    loss.backward_into(grad);
+    CHECK_CLOSE(grad(0, 0), -0.25, tolerance<T>());
+    CHECK_CLOSE(grad(0, 1), 0.0, tolerance<T>());
+    CHECK_CLOSE(grad(0, 2), 0.25, tolerance<T>());
+    CHECK_CLOSE(grad(0, 3), 0.0, tolerance<T>());
+
+    LossSigmoidMSE<T> mse;
+    CHECK(std::isfinite(mse.forward(z, y)));
+    mse.backward_into(grad);
+    for (int j = 0; j < 4; ++j) CHECK(std::isfinite(grad(0, j)));
+}
+
+template <typename Loss>
+bool rejects(Loss& loss, const Matrix<double>& z, const Matrix<double>& y){
+    try {
+        loss.forward(z, y);
+    } catch (const std::invalid_argument&){
+        return true;
+    }
+    return false;
+}
+
+void check_rejects(){
+    LossBCEWithLogits<double> loss;
+    Matrix<double> grad, z(2, 3), y(3, 2);
+    z.fill(0.0);
+    y.fill(0.0);
+    CHECK(rejects(loss, z, y));
+    bool thrown = false;
+    try {
+        loss.backward_into(grad);
+    } catch (const std::invalid_argument&){
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+template <typename T>
+void check_all(){
+    // Sizes on and off the SIMD widths, one element, and strided rows
+    for (int cols : {1, 7, 16, 33}){
+        for (int strided = 0; strided < 2; ++strided){
+            check_bce<T>(5, cols, strided);
+            check_sigmoid_mse<T>(5, cols, strided);
+        }
+    }
+    check_bce<T>(1, 1, false);
+    check_sigmoid_mse<T>(1, 1, false);
+    check_saturated<T>();
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(21);
+    check_all<float>();
+    check_all<double>();
+    check_rejects();
+    return test::result();
+}
@@ -0,0 +1,242 @@
+// Model::save and Model::load: a saved model, optimizer state included,
+// loads to the same predictions and trains on to the same weights as the
+// original; saving it again reproduces the file; and corrupt files (bad
+// magic, truncation, tensors outside the file or of the wrong shape,
+// unknown roles and layers, missing tensors, mismatched optimizer state)
+// are rejected, leaving the model empty and loadable.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "model_file.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "activation_sigmoid.hpp"
+#include "batch_norm.hpp"
+#include "loss_mse.hpp"
+#include "adam_optimizer.hpp"
+#include "sgd_optimizer.hpp"
+#include "utils_random.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+const std::string path = "test_model_file_" + std::to_string(::getpid()) + ".nnm";
+const std::string corrupt_path = "test_model_file_" + std::to_string(::getpid()) + "_corrupt.nnm";
+
+struct Network {
+    FusedDenseLayer<double> hidden{5, 12, Activation::ReLU};
+    BatchNorm<double> norm{12, 12};
+    DenseLayer<double> dense{12, 6};
+    ActivationReLU<double> relu;
+    DenseLayer<double> output{6, 1};
+    ActivationSigmoid<double> sigmoid;
+    Model<double> model;
+
+    Network(){
+        model.add(&hidden);
+        model.add(&norm);
+        model.add(&dense);
+        model.add(&relu);
+        model.add(&output);
+        model.add(&sigmoid);
+    }
+};
+
+std::vector<char> read_bytes(const std::string& file){
+    std::ifstream in(file, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_bytes(const std::string& file, const std::vector<char>& bytes){
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+bool same(const Matrix<double>& a, const Matrix<double>& b){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (a(i, j) != b(i, j)) return false;
+    return true;
+}
+
+void check_round_trip(const Matrix<double>& x, const Matrix<double>& y){
+    test::QuietCout quiet;
+    LossMSE<double> loss;
+
+    set_random_seed(4);
+    Network original;
+    AdamOptimizer<double> optimizer(0.01);
+    original.model.train(x, y, loss, optimizer, 3, 10, 16, false);
+    original.model.save(path, &optimizer);
+
+    Model<double> loaded;
+    AdamOptimizer<double> loaded_optimizer(0.01);
+    loaded.load(path, &loaded_optimizer);
+    CHECK(same(loaded.predict(x), original.model.predict(x)));
+    CHECK(same(*loaded_optimizer.state()[0], *optimizer.state()[0]));
+    CHECK(same(*loaded_optimizer.state()[1], *optimizer.state()[1]));
+
+    // Saving the loaded model writes the same file
+    loaded.save(corrupt_path, &loaded_optimizer);
+    CHECK(read_bytes(corrupt_path) == read_bytes(path));
+
+    // Both train on identically, running statistics and moments included
+    original.model.train(x, y, loss, optimizer, 2, 10, 16, false);
+    loaded.train(x, y, loss, loaded_optimizer, 2, 10, 16, false);
+    CHECK(same(loaded.get_parameters(), original.model.get_parameters()));
+    CHECK(same(loaded.predict(x), original.model.predict(x)));
+
+    // The weights were trained in the model's own buffer; the file is as saved
+    Model<double> reloaded;
+    reloaded.load(path);
+    CHECK(read_bytes(corrupt_path) == read_bytes(path));
+
+    // A model with layers, and a file of another element type, are refused
+    bool threw = false;
+    try {
+        reloaded.load(path);
+    } catch (const std::invalid_argument&){
+        threw = true;
+    }
+    CHECK(threw);
+    Model<float> other_type;
+    threw = false;
+    try {
+        other_type.load(path);
+    } catch (const std::invalid_argument&){
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+/// Byte offsets of the tables of a model file
+std::size_t layer_record(std::size_t i){
+    return sizeof(ModelFileHeader) + i * sizeof(LayerRecord);
+}
+
+template <typename V>
+void patch(std::vector<char>& bytes, std::size_t offset, V value){
+    std::memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+template <typename V>
+V peek(const std::vector<char>& bytes, std::size_t offset){
+    V value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+void check_corrupt(){
+    const std::vector<char> good = read_bytes(path);
+    const std::uint32_t layer_count = peek<std::uint32_t>(good, offsetof(ModelFileHeader, layer_count));
+    const std::uint32_t tensor_count = peek<std::uint32_t>(good, offsetof(ModelFileHeader, tensor_count));
+    auto tensor_record = [&](std::size_t k){ return layer_record(layer_count) + k * sizeof(TensorRecord); };
+    // Record 0 is the parameter buffer, record 1 the first layer's weights
+    const std::size_t weights = tensor_record(1);
+    CHECK(peek<std::uint32_t>(good, weights + offsetof(TensorRecord, role)) ==
+          static_cast<std::uint32_t>(TensorRole::Parameter));
+
+    std::vector<std::pair<const char*, std::function<void(std::vector<char>&)>>> corruptions = {
+        {"bad magic", [](std::vector<char>& b){ b[0] = 'X'; }},
+        {"version", [](std::vector<char>& b){ patch(b, offsetof(ModelFileHeader, version), MODEL_FILE_VERSION + 1); }},
+        {"truncated", [](std::vector<char>& b){ b.pop_back(); }},
+        {"no sections", [&](std::vector<char>& b){ b.resize(tensor_record(tensor_count)); }},
+        {"header only", [](std::vector<char>& b){ b.resize(sizeof(ModelFileHeader) - 1); }},
+        {"empty", [](std::vector<char>& b){ b.clear(); }},
+        {"tables past the end", [](std::vector<char>& b){
+            patch(b, offsetof(ModelFileHeader, tensor_count), std::uint32_t(1) << 30); }},
+        {"offset past the end", [&](std::vector<char>& b){
+            patch(b, weights + offsetof(TensorRecord, offset), std::uint64_t(b.size())); }},
+        {"offset misaligned", [&](std::vector<char>& b){
+            patch(b, weights + offsetof(TensorRecord, offset),
+                  peek<std::uint64_t>(b, weights + offsetof(TensorRecord, offset)) + 1); }},
+        {"offset in the tables", [&](std::vector<char>& b){
+            patch(b, weights + offsetof(TensorRecord, offset), std::uint64_t(8)); }},
+        {"size overflows", [&](std::vector<char>& b){
+            patch(b, weights + offsetof(TensorRecord, rows), std::uint32_t(0xffffffff));
+            patch(b, weights + offsetof(TensorRecord, cols), std::uint32_t(0xffffffff)); }},
+        {"shape mismatch", [&](std::vector<char>& b){
+            patch(b, weights + offsetof(TensorRecord, rows), std::uint32_t(4)); }},
+        {"unknown role", [&](std::vector<char>& b){
+            patch(b, weights + offsetof(TensorRecord, role), std::uint32_t(9)); }},
+        {"missing layer", [&](std::vector<char>& b){
+            patch(b, weights + offsetof(TensorRecord, layer), layer_count); }},
+        {"missing slot", [&](std::vector<char>& b){
+            patch(b, weights + offsetof(TensorRecord, index), std::uint32_t(7)); }},
+        {"tensor missing", [&](std::vector<char>& b){
+            patch(b, weights + offsetof(TensorRecord, role), static_cast<std::uint32_t>(TensorRole::OptimizerState)); }},
+        {"unknown layer kind", [](std::vector<char>& b){
+            patch(b, layer_record(0) + offsetof(LayerRecord, kind), std::uint32_t(99)); }},
+        {"bad dimensions", [](std::vector<char>& b){
+            patch(b, layer_record(0) + offsetof(LayerRecord, input_dim), std::int32_t(-5)); }},
+        {"unknown activation", [](std::vector<char>& b){
+            patch(b, layer_record(0) + offsetof(LayerRecord, activation), std::uint32_t(42)); }},
+    };
+
+    for (auto& corruption : corruptions){
+        std::vector<char> bytes = good;
+        corruption.second(bytes);
+        write_bytes(corrupt_path, bytes);
+
+        Model<double> model;
+        AdamOptimizer<double> optimizer(0.01);
+        bool threw = false;
+        try {
+            model.load(corrupt_path, &optimizer);
+        } catch (const std::invalid_argument&){
+            threw = true;
+        }
+        if (!threw) std::fprintf(stderr, "not rejected: %s\n", corruption.first);
+        CHECK(threw);
+
+        // Nothing was added, so the good file still loads
+        model.load(path, &optimizer);
+        CHECK(model.get_parameters().cols > 0);
+    }
+
+    // Optimizer state for another optimizer
+    Model<double> model;
+    SGDOptimizer<double> sgd(0.1);
+    bool threw = false;
+    try {
+        model.load(path, &sgd);
+    } catch (const std::invalid_argument&){
+        threw = true;
+    }
+    CHECK(threw);
+
+    std::remove(path.c_str());
+    threw = false;
+    try {
+        model.load(path);
+    } catch (const std::runtime_error&){
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(8);
+    Matrix<double> x(64, 5), y(64, 1);
+    initialize_random(x, -1.0, 1.0);
+    for (int i = 0; i < x.rows; ++i) y(i, 0) = x(i, 0) * x(i, 1) > 0 ? 1.0 : 0.0;
+
+    check_round_trip(x, y);
+    check_corrupt();
+    std::remove(path.c_str());
+    std::remove(corrupt_path.c_str());
+    return test::result();
+}
@@ -0,0 +1,65 @@
+// Layers belong to the caller and may outlive the Model they were added
+// to: once the model is gone their parameters, gradients and caches are
+// matrices of their own, with the values the model left in them.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_sigmoid.hpp"
+#include "loss_mse.hpp"
+#include "sgd_optimizer.hpp"
+#include "utils_random.hpp"
+
+namespace {
+
+bool same(const Matrix<double>& a, const Matrix<double>& b){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (a(i, j) != b(i, j)) return false;
+    return true;
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(8);
+    Matrix<double> x(30, 5), y(30, 1);
+    initialize_random(x, -1.0, 1.0);
+    for (int i = 0; i < x.rows; ++i) y(i, 0) = x(i, 0) > 0 ? 1.0 : 0.0;
+
+    FusedDenseLayer<double> hidden(5, 7, Activation::ReLU);
+    DenseLayer<double> output(7, 1);
+    ActivationSigmoid<double> sigmoid;
+    Matrix<double> weights, d_weights, bias, prediction;
+
+    for (int compiled = 0; compiled < 2; ++compiled){
+        {
+            Model<double> model;
+            model.add(&hidden);
+            model.add(&output);
+            model.add(&sigmoid);
+            if (compiled) model.compile(5, 10);
+            LossMSE<double> loss;
+            SGDOptimizer<double> optimizer(0.1);
+            test::QuietCout quiet;
+            model.train(x, y, loss, optimizer, 2, 5, 10);
+
+            weights = hidden.weights;
+            d_weights = hidden.get_d_weights();
+            bias = output.bias;
+            prediction = model.predict(x);
+        }
+
+        // The model is gone; the layers still hold what it trained
+        CHECK(hidden.weights.owns_data() && hidden.get_d_weights().owns_data() && output.bias.owns_data());
+        CHECK(same(hidden.weights, weights));
+        CHECK(same(hidden.get_d_weights(), d_weights));
+        CHECK(same(output.bias, bias));
+        CHECK(same(sigmoid.forward(output.forward(hidden.forward(x))), prediction));
+
+        // and can be trained further, alone or in a new model
+        hidden.backward(Matrix<double>(30, 7));
+        hidden.update(0.1);
+    }
+    return test::result();
+}
@@ -0,0 +1,97 @@
+// Optimizer steps against the textbook update rules, computed
+// element by element in double over several steps. The parameter count
+// is above kernels::PARALLEL_GRAIN so the update is split across threads.
+#include "test_support.hpp"
+#include "sgd_optimizer.hpp"
+#include "adam_optimizer.hpp"
+#include "adamw_optimizer.hpp"
+#include "utils_random.hpp"
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const int rows = 157, cols = 301;
+const int steps = 5;
+
+struct AdamSettings { double lr, beta1, beta2, epsilon, weight_decay; };
+struct SgdSettings { double lr, momentum, weight_decay; bool nesterov; };
+
+template <typename T>
+std::vector<double> to_double(const Matrix<T>& m){
+    std::vector<double> values(m.size());
+    for (std::size_t i = 0; i < m.size(); ++i) values[i] = m.data()[i];
+    return values;
+}
+
+template <typename T>
+double max_difference(const Matrix<T>& m, const std::vector<double>& expected){
+    double worst = 0.0;
+    for (std::size_t i = 0; i < m.size(); ++i)
+        worst = std::fmax(worst, std::fabs(m.data()[i] - expected[i]) / std::fmax(1.0, std::fabs(expected[i])));
+    return worst;
+}
+
+template <typename T>
+void check_adam(Optimizer<T>& optimizer, const AdamSettings& s, double tolerance){
+    Matrix<T> params(rows, cols), grads(rows, cols);
+    initialize_random(params, -1.0, 1.0);
+    std::vector<double> theta = to_double(params), m(theta.size()), v(theta.size());
+
+    for (int t = 1; t <= steps; ++t){
+        initialize_random(grads, -1.0, 1.0);
+        optimizer.step(params, grads, t);
+        for (std::size_t i = 0; i < theta.size(); ++i){
+            double g = grads.data()[i];
+            m[i] = s.beta1 * m[i] + (1 - s.beta1) * g;
+            v[i] = s.beta2 * v[i] + (1 - s.beta2) * g * g;
+            double m_hat = m[i] / (1 - std::pow(s.beta1, t));
+            double v_hat = v[i] / (1 - std::pow(s.beta2, t));
+            theta[i] -= s.lr * s.weight_decay * theta[i] + s.lr * m_hat / (std::sqrt(v_hat) + s.epsilon);
+        }
+    }
+    CHECK(max_difference(params, theta) <= tolerance);
+}
+
+template <typename T>
+void check_sgd(const SgdSettings& s, double tolerance){
+    SGDOptimizer<T> optimizer(s.lr, s.momentum, s.nesterov, s.weight_decay);
+    Matrix<T> params(rows, cols), grads(rows, cols);
+    initialize_random(params, -1.0, 1.0);
+    std::vector<double> theta = to_double(params), u(theta.size());
+
+    for (int t = 1; t <= steps; ++t){
+        initialize_random(grads, -1.0, 1.0);
+        optimizer.step(params, grads, t);
+        for (std::size_t i = 0; i < theta.size(); ++i){
+            double g = grads.data()[i] + s.weight_decay * theta[i];
+            u[i] = s.momentum * u[i] + g;
+            theta[i] -= s.lr * (s.nesterov ? g + s.momentum * u[i] : u[i]);
+        }
+    }
+    CHECK(max_difference(params, theta) <= tolerance);
+}
+
+template <typename T>
+void check_all(double tolerance){
+    const AdamSettings adam{0.01, 0.9, 0.999, 1e-8, 0.0};
+    AdamOptimizer<T> plain(adam.lr, adam.beta1, adam.beta2, adam.epsilon);
+    check_adam(plain, adam, tolerance);
+
+    const AdamSettings adamw{0.003, 0.8, 0.99, 1e-6, 0.1};
+    AdamWOptimizer<T> decoupled(adamw.lr, adamw.weight_decay, adamw.beta1, adamw.beta2, adamw.epsilon);
+    check_adam(decoupled, adamw, tolerance);
+
+    check_sgd<T>({0.1, 0.0, 0.0, false}, tolerance);
+    check_sgd<T>({0.05, 0.9, 0.0, false}, tolerance);
+    check_sgd<T>({0.05, 0.9, 0.01, true}, tolerance);
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(17);
+    check_all<double>(1e-12);
+    check_all<float>(1e-5);
+    return test::result();
+}
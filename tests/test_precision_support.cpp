@@ -0,0 +1,62 @@
+// Layers opt in to 16-bit precisions: Model::set_precision and add()
+// reject a layer that has not, and a rejected call changes nothing.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "batch_norm.hpp"
+#include "dropout.hpp"
+#include "quantized_dense_layer.hpp"
+#include <initializer_list>
+#include <stdexcept>
+
+namespace {
+
+template <typename Fn>
+bool rejects(Fn&& fn){
+    try {
+        fn();
+    } catch (const std::invalid_argument&){
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main(){
+    DenseLayer<float> dense(4, 8), source(8, 2);
+    ActivationReLU<float> relu;
+    BatchNorm<float> norm(8, 8);
+    Dropout<float> dropout(0.1);
+    QuantizedDenseLayer<float> quantized(source);
+
+    // Every built-in trainable layer supports both 16-bit formats
+    Model<float> trainable;
+    for (Layer<float>* layer : std::initializer_list<Layer<float>*>{&dense, &relu, &norm, &dropout})
+        trainable.add(layer);
+    for (Precision precision : {Precision::BFloat16, Precision::Float16}){
+        CHECK(!rejects([&]{ trainable.set_precision(precision); }));
+        CHECK(trainable.get_precision() == precision);
+    }
+    trainable.set_precision(Precision::Full);
+
+    // The int8 layer does not
+    CHECK(quantized.supports_precision(Precision::Full));
+    CHECK(!quantized.supports_precision(Precision::BFloat16));
+    CHECK(rejects([&]{ quantized.set_precision(Precision::Float16); }));
+
+    Model<float> mixed;
+    DenseLayer<float> first(4, 8);
+    mixed.add(&first);
+    mixed.add(&quantized);
+    CHECK(rejects([&]{ mixed.set_precision(Precision::BFloat16); }));
+    CHECK(mixed.get_precision() == Precision::Full);
+
+    Model<float> half_model;
+    DenseLayer<float> second(4, 8);
+    half_model.add(&second);
+    half_model.set_precision(Precision::BFloat16);
+    CHECK(rejects([&]{ half_model.add(&quantized); }));
+    return test::result();
+}
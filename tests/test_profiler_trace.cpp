@@ -0,0 +1,314 @@
+// Profiler::write_chrome_trace writes valid JSON in the Chrome trace
+// event format: a training run's spans and memory counters, an empty
+// profiler, and event names that need escaping all parse, and every
+// recorded event appears once with its fields.
+#include "test_support.hpp"
+#include "profiler.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "activation_relu.hpp"
+#include "activation_sigmoid.hpp"
+#include "loss_mse.hpp"
+#include "sgd_optimizer.hpp"
+#include "utils_random.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const std::string path = "test_profiler_trace_" + std::to_string(::getpid()) + ".json";
+
+/// A parsed JSON value; only what the checks below read
+struct Json {
+    enum Kind { Null, Bool, Number, String, Array, Object } kind = Null;
+    double number = 0.0;
+    std::string text;
+    std::vector<Json> items;
+    std::map<std::string, Json> fields;
+
+    const Json* get(const std::string& key) const {
+        auto it = fields.find(key);
+        return it == fields.end() ? nullptr : &it->second;
+    }
+};
+
+/// Strict recursive-descent parser for RFC 8259 JSON; throws
+/// std::runtime_error at the first violation
+class Parser {
+    public:
+        explicit Parser(const std::string& text) : s(text) {}
+
+        Json document(){
+            Json value = parse_value();
+            skip_space();
+            if (at != s.size()) fail("trailing characters");
+            return value;
+        }
+
+    private:
+        const std::string& s;
+        std::size_t at = 0;
+
+        [[noreturn]] void fail(const char* what){
+            throw std::runtime_error(std::string(what) + " at offset " + std::to_string(at));
+        }
+
+        void skip_space(){
+            while (at < s.size() && (s[at] == ' ' || s[at] == '\t' || s[at] == '\n' || s[at] == '\r')) ++at;
+        }
+
+        void expect(char c){
+            skip_space();
+            if (at >= s.size() || s[at] != c) fail("unexpected character");
+            ++at;
+        }
+
+        bool literal(const char* word){
+            std::string w(word);
+            if (s.compare(at, w.size(), w) != 0) return false;
+            at += w.size();
+            return true;
+        }
+
+        Json parse_value(){
+            skip_space();
+            if (at >= s.size()) fail("unexpected end");
+            Json value;
+            char c = s[at];
+            if (c == '{'){
+                value.kind = Json::Object;
+                ++at;
+                skip_space();
+                if (at < s.size() && s[at] == '}'){ ++at; return value; }
+                do {
+                    skip_space();
+                    std::string key = parse_string();
+                    expect(':');
+                    if (value.fields.count(key)) fail("duplicate key");
+                    value.fields[key] = parse_value();
+                    skip_space();
+                } while (at < s.size() && s[at] == ',' && ++at);
+                expect('}');
+            }else if (c == '['){
+                value.kind = Json::Array;
+                ++at;
+                skip_space();
+                if (at < s.size() && s[at] == ']'){ ++at; return value; }
+                do {
+                    value.items.push_back(parse_value());
+                    skip_space();
+                } while (at < s.size() && s[at] == ',' && ++at);
+                expect(']');
+            }else if (c == '"'){
+                value.kind = Json::String;
+                value.text = parse_string();
+            }else if (literal("true") || literal("false")){
+                value.kind = Json::Bool;
+            }else if (literal("null")){
+                value.kind = Json::Null;
+            }else{
+                value.kind = Json::Number;
+                value.number = parse_number();
+            }
+            return value;
+        }
+
+        std::string parse_string(){
+            if (at >= s.size() || s[at] != '"') fail("expected a string");
+            ++at;
+            std::string out;
+            while (true){
+                if (at >= s.size()) fail("unterminated string");
+                unsigned char c = static_cast<unsigned char>(s[at++]);
+                if (c == '"') return out;
+                if (c < 0x20) fail("raw control character in string");
+                if (c != '\\'){
+                    out += static_cast<char>(c);
+                    continue;
+                }
+                if (at >= s.size()) fail("unterminated escape");
+                char e = s[at++];
+                switch (e){
+                    case '"': case '\\': case '/': out += e; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        if (at + 4 > s.size()) fail("short \\u escape");
+                        unsigned code = 0;
+                        for (int k = 0; k < 4; ++k){
+                            char h = s[at++];
+                            code <<= 4;
+                            if (h >= '0' && h <= '9') code |= h - '0';
+                            else if (h >= 'a' && h <= 'f') code |= h - 'a' + 10;
+                            else if (h >= 'A' && h <= 'F') code |= h - 'A' + 10;
+                            else fail("bad \\u escape");
+                        }
+                        // The trace only escapes ASCII control characters
+                        if (code > 0x7f) fail("unexpected non-ASCII escape");
+                        out += static_cast<char>(code);
+                        break;
+                    }
+                    default: fail("bad escape");
+                }
+            }
+        }
+
+        // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+        double parse_number(){
+            std::size_t start = at;
+            auto digits = [&]{
+                std::size_t first = at;
+                while (at < s.size() && s[at] >= '0' && s[at] <= '9') ++at;
+                if (at == first) fail("expected a digit");
+            };
+            if (at < s.size() && s[at] == '-') ++at;
+            if (at < s.size() && s[at] == '0') ++at;
+            else digits();
+            if (at < s.size() && s[at] == '.'){ ++at; digits(); }
+            if (at < s.size() && (s[at] == 'e' || s[at] == 'E')){
+                ++at;
+                if (at < s.size() && (s[at] == '+' || s[at] == '-')) ++at;
+                digits();
+            }
+            return std::strtod(s.substr(start, at - start).c_str(), nullptr);
+        }
+};
+
+/// Writes the trace and parses it; a null value when it is not JSON
+Json read_trace(const Profiler& profiler, bool& valid){
+    profiler.write_chrome_trace(path);
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    std::remove(path.c_str());
+    valid = true;
+    try {
+        return Parser(text.str()).document();
+    } catch (const std::runtime_error& error){
+        std::fprintf(stderr, "invalid trace JSON: %s\n", error.what());
+        valid = false;
+        return Json();
+    }
+}
+
+bool is(const Json* value, Json::Kind kind){ return value && value->kind == kind; }
+
+/// The trace holds the process name, then per recorded event one span
+/// ("X") with its fields and one memory counter ("C") sample
+void check_matches(const Json& trace, const std::vector<Profiler::Event>& events){
+    const Json* list = trace.get("traceEvents");
+    CHECK(is(list, Json::Array));
+    if (!is(list, Json::Array)) return;
+    CHECK(list->items.size() == 1 + 2 * events.size());
+    if (list->items.size() != 1 + 2 * events.size()) return;
+
+    const Json& meta = list->items[0];
+    CHECK(is(meta.get("ph"), Json::String) && meta.get("ph")->text == "M");
+    for (std::size_t k = 0; k < events.size(); ++k){
+        const Json& span = list->items[1 + 2 * k];
+        const Json& counter = list->items[2 + 2 * k];
+        const Profiler::Event& e = events[k];
+        CHECK(is(span.get("name"), Json::String) && span.get("name")->text == e.name);
+        CHECK(is(span.get("cat"), Json::String) && span.get("cat")->text == e.category);
+        CHECK(is(span.get("ph"), Json::String) && span.get("ph")->text == "X");
+        CHECK(is(span.get("tid"), Json::Number) && span.get("tid")->number == e.thread);
+        CHECK(is(span.get("ts"), Json::Number) && test::close(span.get("ts")->number, e.start_ns * 1e-3, 1e-3));
+        CHECK(is(span.get("dur"), Json::Number) && span.get("dur")->number >= 0.0);
+        const Json* args = span.get("args");
+        CHECK(is(args, Json::Object) && is(args->get("layer"), Json::Number)
+              && args->get("layer")->number == e.layer);
+        CHECK(is(args, Json::Object) && is(args->get("flops"), Json::Number));
+        CHECK(is(counter.get("ph"), Json::String) && counter.get("ph")->text == "C");
+        CHECK(is(counter.get("args"), Json::Object) && is(counter.get("args")->get("live_bytes"), Json::Number));
+    }
+}
+
+void check_training_trace(){
+    set_random_seed(21);
+    DenseLayer<double> hidden(6, 8);
+    ActivationReLU<double> relu;
+    DenseLayer<double> output(8, 1);
+    ActivationSigmoid<double> sigmoid;
+    Model<double> model;
+    model.add(&hidden);
+    model.add(&relu);
+    model.add(&output);
+    model.add(&sigmoid);
+
+    Matrix<double> x(40, 6), y(40, 1);
+    initialize_random(x, -1.0, 1.0);
+    initialize_random(y, 0.0, 1.0);
+    LossMSE<double> loss;
+    SGDOptimizer<double> optimizer(0.1);
+    Profiler profiler;
+    model.set_profiler(&profiler);
+    {
+        test::QuietCout quiet;
+        model.train(x, y, loss, optimizer, 2, 10, 16);
+    }
+    model.set_profiler(nullptr);
+
+    std::vector<Profiler::Event> events = profiler.events();
+    CHECK(!events.empty());
+    bool valid;
+    Json trace = read_trace(profiler, valid);
+    CHECK(valid);
+    if (valid) check_matches(trace, events);
+}
+
+void check_empty_trace(){
+    Profiler profiler;
+    bool valid;
+    Json trace = read_trace(profiler, valid);
+    CHECK(valid);
+    if (valid) check_matches(trace, {});
+}
+
+// Names are copied into the trace as JSON strings: quotes, backslashes
+// and control characters must be escaped, and come back unchanged
+void check_escaping(){
+    Profiler profiler;
+    const std::vector<std::string> names = {
+        "quote \" and backslash \\", "line\nbreak\ttab\r", std::string("bell\x01\x1f", 6), "path/to/layer",
+    };
+    for (const std::string& name : names){
+        Profiler::Mark mark = profiler.begin();
+        profiler.end(mark, name, "custom \"phase\"", 3, 1e30, 0.5);
+    }
+    bool valid;
+    Json trace = read_trace(profiler, valid);
+    CHECK(valid);
+    if (valid) check_matches(trace, profiler.events());
+}
+
+void check_unwritable(){
+    Profiler profiler;
+    bool thrown = false;
+    try {
+        profiler.write_chrome_trace("no_such_directory/trace.json");
+    } catch (const std::runtime_error&){
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+} // namespace
+
+int main(){
+    check_training_trace();
+    check_empty_trace();
+    check_escaping();
+    check_unwritable();
+    return test::result();
+}
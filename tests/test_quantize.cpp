@@ -0,0 +1,92 @@
+// Model::quantize: on a compiled model it drops the memory plan, so
+// predict on the quantized layers works and matches quantizing the
+// uncompiled model; the replaced layers stay usable after the flat
+// parameter buffers are rebuilt; and 16-bit models are rejected.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_sigmoid.hpp"
+#include "utils_random.hpp"
+#include <stdexcept>
+
+namespace {
+
+struct Network {
+    FusedDenseLayer<double> hidden{8, 16, Activation::ReLU};
+    DenseLayer<double> output{16, 1};
+    ActivationSigmoid<double> sigmoid;
+    Model<double> model;
+
+    Network(){
+        model.add(&hidden);
+        model.add(&output);
+        model.add(&sigmoid);
+    }
+};
+
+bool same(const Matrix<double>& a, const Matrix<double>& b){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (a(i, j) != b(i, j)) return false;
+    return true;
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(9);
+    Matrix<double> x(40, 8);
+    initialize_random(x, -1.0, 1.0);
+
+    // Compiled or not, the same quantized predictions
+    {
+        set_random_seed(1);
+        Network plain;
+        plain.model.quantize();
+        Matrix<double> expected = plain.model.predict(x);
+
+        set_random_seed(1);
+        Network compiled;
+        compiled.model.compile(8, 40);
+        compiled.model.predict(x);
+        compiled.model.quantize();
+        CHECK(!compiled.model.is_compiled());
+        Matrix<double> quantized = compiled.model.predict(x);
+
+        CHECK(quantized.rows == expected.rows && quantized.cols == expected.cols);
+        for (int i = 0; i < expected.rows; ++i) CHECK_CLOSE(quantized(i, 0), expected(i, 0), 1e-12);
+    }
+
+    // The replaced layers keep their parameters once the model rebinds
+    // its buffers without them
+    {
+        Network net;
+        net.model.get_parameters();
+        Matrix<double> weights = net.hidden.weights, bias = net.output.bias;
+        Matrix<double> reference = net.hidden.forward(x);
+
+        net.model.quantize();
+        net.model.get_parameters();
+        CHECK(net.hidden.weights.owns_data() && net.output.bias.owns_data());
+        CHECK(same(net.hidden.weights, weights));
+        CHECK(same(net.output.bias, bias));
+        CHECK(same(net.hidden.forward(x), reference));
+    }
+
+    // Quantizing a 16-bit model is refused and leaves it as it was
+    {
+        Network net;
+        net.model.set_precision(Precision::BFloat16);
+        bool threw = false;
+        try {
+            net.model.quantize();
+        } catch (const std::invalid_argument&){
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(net.model.get_precision() == Precision::BFloat16);
+        CHECK(net.model.get_parameters().cols > 0);
+    }
+    return test::result();
+}
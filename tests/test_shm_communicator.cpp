@@ -0,0 +1,214 @@
+// ShmCommunicator across forked processes: all_reduce sums in rank order
+// and broadcast copies from any root, for data spanning many slots;
+// collectives and construction time out when a rank is missing; and
+// two ranks training on halves of every batch end with the weights of
+// one process training on whole batches.
+#include "test_support.hpp"
+#include "shm_communicator.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_sigmoid.hpp"
+#include "loss_mse.hpp"
+#include "adam_optimizer.hpp"
+#include "utils_random.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using std::chrono::milliseconds;
+
+// Small slots, so every collective below goes through in many pieces
+const std::size_t slot_bytes = 256;
+const milliseconds timeout(10000);
+
+std::string segment_name(){
+    static int count = 0;
+    return "/neuronite-test-" + std::to_string(::getpid()) + "-" + std::to_string(count++);
+}
+
+/// Runs fn(rank) in `size` forked processes and checks that each exits
+/// cleanly. Ranks report their failed checks through the exit status.
+/// Nothing in the parent starts the thread pool, so the children do not
+/// inherit a pool whose threads they lack
+void run_ranks(int size, const std::function<void(int)>& fn){
+    std::fflush(nullptr);
+    std::vector<pid_t> children;
+    for (int rank = 0; rank < size; ++rank){
+        pid_t pid = ::fork();
+        if (pid == 0){
+            test::failures = 0;
+            try {
+                fn(rank);
+            } catch (const std::exception& e){
+                std::fprintf(stderr, "rank %d: %s\n", rank, e.what());
+                ++test::failures;
+            }
+            std::fflush(nullptr);
+            ::_exit(test::result());
+        }
+        CHECK(pid > 0);
+        children.push_back(pid);
+    }
+    for (pid_t pid : children){
+        int status = 0;
+        CHECK(::waitpid(pid, &status, 0) == pid);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+}
+
+/// The data rank `rank` contributes: the same on every process
+template <typename T>
+std::vector<T> rank_data(int rank, std::size_t n){
+    set_random_seed(100 + rank);
+    Matrix<T> m(1, static_cast<int>(n));
+    initialize_random(m, T(-1), T(1));
+    return std::vector<T>(m.data(), m.data() + n);
+}
+
+template <typename T>
+void check_collectives(ShmCommunicator& comm, std::size_t n){
+    int size = comm.size(), rank = comm.rank();
+
+    // Each element summed in rank order, so every rank can predict the bits
+    std::vector<T> expected = rank_data<T>(0, n);
+    for (int r = 1; r < size; ++r){
+        std::vector<T> other = rank_data<T>(r, n);
+        for (std::size_t i = 0; i < n; ++i) expected[i] = expected[i] + other[i];
+    }
+    std::vector<T> data = rank_data<T>(rank, n);
+    comm.all_reduce(data.data(), n);
+    CHECK(data == expected);
+
+    for (int root = 0; root < size; ++root){
+        std::vector<T> data = rank_data<T>(rank, n);
+        comm.broadcast(data.data(), n, root);
+        CHECK(data == rank_data<T>(root, n));
+    }
+}
+
+void check_three_ranks(){
+    std::string name = segment_name();
+    run_ranks(3, [&](int rank){
+        ShmCommunicator comm(name, rank, 3, slot_bytes, timeout);
+        CHECK(comm.rank() == rank && comm.size() == 3);
+        // Under a slot, exactly one, and many slots plus a remainder
+        for (std::size_t n : {std::size_t(1), std::size_t(5), slot_bytes / sizeof(double), std::size_t(1001)}){
+            check_collectives<double>(comm, n);
+            check_collectives<float>(comm, n);
+        }
+        comm.barrier();
+    });
+}
+
+template <typename Fn>
+bool times_out(Fn&& fn){
+    try {
+        fn();
+    } catch (const std::runtime_error&){
+        return true;
+    }
+    return false;
+}
+
+void check_timeouts(){
+    const milliseconds short_timeout(200);
+
+    // Rank 1 never shows up
+    std::string name = segment_name();
+    CHECK(times_out([&]{ ShmCommunicator comm(name, 0, 2, slot_bytes, short_timeout); }));
+    // Rank 0 never creates the segment
+    name = segment_name();
+    CHECK(times_out([&]{ ShmCommunicator comm(name, 1, 2, slot_bytes, short_timeout); }));
+
+    // Rank 1 leaves after attaching; rank 0's collectives give up
+    name = segment_name();
+    run_ranks(2, [&](int rank){
+        ShmCommunicator comm(name, rank, 2, slot_bytes, short_timeout);
+        if (rank == 1) return;
+        std::vector<double> data(1000, 1.0);
+        CHECK(times_out([&]{ comm.all_reduce(data.data(), data.size()); }));
+        // The barrier it left half done must not complete the next one
+        CHECK(times_out([&]{ comm.barrier(); }));
+        CHECK(times_out([&]{ comm.broadcast(data.data(), data.size(), 0); }));
+    });
+}
+
+struct Network {
+    FusedDenseLayer<double> hidden{6, 16, Activation::ReLU};
+    DenseLayer<double> output{16, 1};
+    ActivationSigmoid<double> sigmoid;
+    Model<double> model;
+
+    Network(){
+        model.add(&hidden);
+        model.add(&output);
+        model.add(&sigmoid);
+    }
+};
+
+void check_training(){
+    const int rows_per_rank = 40, batch_size = 8, epochs = 3;
+
+    // Batch b of the single process is batch b of rank 0 followed by
+    // batch b of rank 1, so its mean gradient is the mean of theirs
+    set_random_seed(21);
+    Matrix<double> x(2 * rows_per_rank, 6), y(2 * rows_per_rank, 1);
+    initialize_random(x, -1.0, 1.0);
+    for (int i = 0; i < x.rows; ++i) y(i, 0) = x(i, 0) - x(i, 3) > 0 ? 1.0 : 0.0;
+    auto rank_rows = [&](const Matrix<double>& m, int rank){
+        Matrix<double> part(rows_per_rank, m.cols);
+        for (int i = 0; i < rows_per_rank; ++i){
+            int row = (i / batch_size) * 2 * batch_size + rank * batch_size + i % batch_size;
+            for (int j = 0; j < m.cols; ++j) part(i, j) = m(row, j);
+        }
+        return part;
+    };
+
+    std::string name = segment_name();
+    run_ranks(2, [&](int rank){
+        test::QuietCout quiet;
+        LossMSE<double> loss;
+
+        set_random_seed(3);
+        Network single;
+        AdamOptimizer<double> single_optimizer(0.01);
+        single.model.train(x, y, loss, single_optimizer, epochs, 10, 2 * batch_size, false);
+
+        // Rank 1 starts from other weights, which the first step replaces
+        set_random_seed(3 + rank);
+        Network net;
+        ShmCommunicator comm(name, rank, 2, slot_bytes, timeout);
+        net.model.set_communicator(&comm, 128);
+        AdamOptimizer<double> optimizer(0.01);
+        net.model.train(rank_rows(x, rank), rank_rows(y, rank), loss, optimizer, epochs, 10, batch_size, false);
+
+        Matrix<double>& params = net.model.get_parameters();
+        Matrix<double>& expected = single.model.get_parameters();
+        for (int j = 0; j < params.cols; ++j) CHECK_CLOSE(params(0, j), expected(0, j), 1e-12);
+
+        // And the ranks agree to the bit
+        Matrix<double> root = params;
+        comm.broadcast(root.data(), root.size(), 0);
+        bool same = true;
+        for (int j = 0; j < params.cols; ++j) same = same && root(0, j) == params(0, j);
+        CHECK(same);
+    });
+}
+
+} // namespace
+
+int main(){
+    check_three_ranks();
+    check_timeouts();
+    check_training();
+    return test::result();
+}
@@ -0,0 +1,159 @@
+// Sparse (CSR) input against the same rows as a dense matrix: Dense and
+// FusedDense layers give the same output and weight gradients, with
+// empty rows and all-empty batches, when consecutive steps touch
+// different features (rows of the gradient written last step and not
+// this one must be cleared) and after a dense backward wrote every row;
+// Model::train and predict agree for both kinds of input.
+#include "test_support.hpp"
+#include "model.hpp"
+#include "dense_layer.hpp"
+#include "fused_dense_layer.hpp"
+#include "activation_sigmoid.hpp"
+#include "loss_mse.hpp"
+#include "adam_optimizer.hpp"
+#include "sparse_matrix.hpp"
+#include "utils_random.hpp"
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+const int input_dim = 20, output_dim = 6;
+
+bool close(const Matrix<double>& a, const Matrix<double>& b){
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int i = 0; i < a.rows; ++i)
+        for (int j = 0; j < a.cols; ++j) if (!test::close(a(i, j), b(i, j), 1e-12)) return false;
+    return true;
+}
+
+/// A (rows × input_dim) matrix that is nonzero only in columns
+/// [first, last), about one entry in three, with every third row empty
+Matrix<double> sparse_rows(int rows, int first, int last){
+    Matrix<double> x(rows, input_dim);
+    x.fill(0.0);
+    for (int i = 0; i < rows; ++i){
+        if (i % 3 == 2) continue;
+        for (int j = first; j < last; ++j){
+            if (random_double() < 0.35) x(i, j) = random_double() * 2.0 - 1.0;
+        }
+    }
+    return x;
+}
+
+/// Zero in every row of d_weights whose feature is absent from x
+bool zero_outside(const Matrix<double>& d_weights, const Matrix<double>& x){
+    for (int j = 0; j < x.cols; ++j){
+        bool present = false;
+        for (int i = 0; i < x.rows; ++i) present = present || x(i, j) != 0.0;
+        if (present) continue;
+        for (int k = 0; k < d_weights.cols; ++k) if (d_weights(j, k) != 0.0) return false;
+    }
+    return true;
+}
+
+template <typename Layer, typename... Args>
+void check_layer(Args... args){
+    set_random_seed(3);
+    Layer sparse(input_dim, output_dim, args...);
+    set_random_seed(3);
+    Layer dense(input_dim, output_dim, args...);
+
+    struct Step { int rows, first, last; bool dense_backward; };
+    // Disjoint features from one step to the next, a batch with no
+    // nonzeros at all, and dense backward passes in between, which write
+    // every row of d_weights
+    const std::vector<Step> steps = {
+        {9, 0, 8, false}, {9, 10, 20, false}, {5, 0, 0, false}, {9, 4, 12, false},
+        {7, 0, 20, true}, {8, 15, 20, false}, {1, 0, 20, false}, {9, 2, 6, true}, {9, 2, 6, false},
+    };
+    Workspace ws;
+    for (const Step& step : steps){
+        Matrix<double> x = sparse_rows(step.rows, step.first, step.last);
+        SparseMatrix<double> csr = SparseMatrix<double>::from_dense(x);
+        Matrix<double> g(step.rows, output_dim);
+        initialize_random(g, -1.0, 1.0);
+
+        Matrix<double> y_sparse, y_dense, inferred, grad_input;
+        dense.forward_into(x, y_dense);
+        dense.backward_into(g, grad_input);
+        if (step.dense_backward){
+            sparse.forward_into(x, y_sparse);
+            sparse.backward_into(g, grad_input);
+        } else {
+            sparse.forward_sparse_into(csr, y_sparse);
+            sparse.backward_sparse_into(g);
+            CHECK(zero_outside(sparse.get_d_weights(), x));
+        }
+        CHECK(close(y_sparse, y_dense));
+        CHECK(close(sparse.get_d_weights(), dense.get_d_weights()));
+        CHECK(close(sparse.get_d_bias(), dense.get_d_bias()));
+
+        sparse.infer_sparse_into(csr, inferred, ws);
+        CHECK(close(inferred, y_dense));
+
+        sparse.update(0.1);
+        dense.update(0.1);
+    }
+    CHECK(close(sparse.weights, dense.weights));
+}
+
+struct Network {
+    FusedDenseLayer<double> hidden{input_dim, 8, Activation::ReLU};
+    DenseLayer<double> output{8, 1};
+    ActivationSigmoid<double> sigmoid;
+    Model<double> model;
+
+    Network(){
+        model.add(&hidden);
+        model.add(&output);
+        model.add(&sigmoid);
+    }
+};
+
+template <typename Input>
+Matrix<double> train(const Input& x, const Matrix<double>& y, bool compiled, Matrix<double>& prediction){
+    set_random_seed(8);
+    Network net;
+    if (compiled) net.model.compile(input_dim, 8, 1, std::is_same<Input, SparseMatrix<double>>::value);
+    LossMSE<double> loss;
+    AdamOptimizer<double> optimizer(0.01);
+    test::QuietCout quiet;
+    net.model.train(x, y, loss, optimizer, 4, 10, 8, true);
+    prediction = net.model.predict(x);
+    return net.model.get_parameters();
+}
+
+void check_model(){
+    set_random_seed(4);
+    // Each block of rows uses its own features, so shuffled batches touch
+    // a different set every step
+    const int rows = 37;
+    Matrix<double> x(rows, input_dim), y(rows, 1);
+    for (int i = 0; i < rows; ++i){
+        int first = (i % 4) * 5;
+        Matrix<double> row = sparse_rows(1, first, first + 5);
+        for (int j = 0; j < input_dim; ++j) x(i, j) = i % 7 == 6 ? 0.0 : row(0, j);
+        y(i, 0) = i % 2;
+    }
+    SparseMatrix<double> csr = SparseMatrix<double>::from_dense(x);
+
+    for (int compiled = 0; compiled < 2; ++compiled){
+        Matrix<double> dense_prediction, sparse_prediction;
+        Matrix<double> expected = train(x, y, compiled, dense_prediction);
+        Matrix<double> params = train(csr, y, compiled, sparse_prediction);
+        CHECK(close(params, expected));
+        CHECK(close(sparse_prediction, dense_prediction));
+    }
+}
+
+} // namespace
+
+int main(){
+    check_layer<DenseLayer<double>>();
+    for (Activation activation : {Activation::None, Activation::ReLU, Activation::Sigmoid}){
+        check_layer<FusedDenseLayer<double>>(activation);
+    }
+    check_model();
+    return test::result();
+}
@@ -0,0 +1,55 @@
+#ifndef TEST_SUPPORT_HPP
+#define TEST_SUPPORT_HPP
+
+// Minimal checks for the test executables under tests/: every failed
+// CHECK is reported with its location, and main returns test::result()
+// so ctest sees a nonzero exit status.
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+
+namespace test {
+
+inline int failures = 0;
+
+inline int result(){
+    if (failures) std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
+
+/// |a - b| <= tolerance · max(1, |b|)
+inline bool close(double a, double b, double tolerance){
+    return std::fabs(a - b) <= tolerance * std::fmax(1.0, std::fabs(b));
+}
+
+/// Silences std::cout (Model::train's epoch log) while in scope
+class QuietCout {
+    public:
+        QuietCout() : saved(std::cout.rdbuf(nullptr)) {}
+        ~QuietCout(){ std::cout.rdbuf(saved); std::cout.clear(); }
+    private:
+        std::streambuf* saved;
+};
+
+} // namespace test
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)){ \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++test::failures; \
+        } \
+    } while (0)
+
+#define CHECK_CLOSE(a, b, tolerance) \
+    do { \
+        double check_a = (a), check_b = (b); \
+        if (!test::close(check_a, check_b, (tolerance))){ \
+            std::fprintf(stderr, "%s:%d: CHECK_CLOSE failed: %s = %.9g, %s = %.9g\n", \
+                         __FILE__, __LINE__, #a, check_a, #b, check_b); \
+            ++test::failures; \
+        } \
+    } while (0)
+
+#endif
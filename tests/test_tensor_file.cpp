@@ -0,0 +1,121 @@
+// Tensor files: write_tensor_file round-trips through MappedTensor for
+// both element types, and a missing file, a short or corrupt header and a
+// truncated payload are rejected instead of mapped.
+#include "test_support.hpp"
+#include "tensor_file.hpp"
+#include "utils_random.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+const std::string path = "test_tensor_file_" + std::to_string(::getpid()) + ".nnt";
+
+std::vector<char> read_bytes(){
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void write_bytes(const std::vector<char>& bytes){
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+/// True if mapping `path` as T throws std::invalid_argument
+template <typename T>
+bool rejects(){
+    try {
+        MappedTensor<T> mapped(path);
+    } catch (const std::invalid_argument&){
+        return true;
+    }
+    return false;
+}
+
+template <typename T>
+void check_round_trip(int rows, int cols){
+    Matrix<T> m(rows, cols);
+    initialize_random(m, T(-1), T(1));
+    write_tensor_file(path, m);
+
+    MappedTensor<T> mapped(path);
+    CHECK(mapped.rows() == rows);
+    CHECK(mapped.cols() == cols);
+    CHECK(!mapped.matrix().owns_data());
+    bool same = true;
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j) same = same && mapped.matrix()(i, j) == m(i, j);
+    CHECK(same);
+}
+
+void check_malformed(){
+    Matrix<float> m(5, 3);
+    initialize_random(m, -1.0f, 1.0f);
+    write_tensor_file(path, m);
+    const std::vector<char> good = read_bytes();
+    CHECK(good.size() == sizeof(TensorFileHeader) + 15 * sizeof(float));
+
+    std::vector<char> bytes = good;
+    bytes[0] = 'X';
+    write_bytes(bytes);
+    CHECK(rejects<float>());
+
+    bytes = good;
+    std::uint32_t version = TENSOR_FILE_VERSION + 1;
+    std::memcpy(bytes.data() + offsetof(TensorFileHeader, version), &version, sizeof(version));
+    write_bytes(bytes);
+    CHECK(rejects<float>());
+
+    // A float file read as double
+    write_bytes(good);
+    CHECK(rejects<double>());
+
+    std::uint64_t rows = std::uint64_t(1) << 40;
+    bytes = good;
+    std::memcpy(bytes.data() + offsetof(TensorFileHeader, rows), &rows, sizeof(rows));
+    write_bytes(bytes);
+    CHECK(rejects<float>());
+
+    // Header cut short, then payload one element short, then no payload
+    write_bytes(std::vector<char>(good.begin(), good.begin() + 40));
+    CHECK(rejects<float>());
+    write_bytes(std::vector<char>(good.begin(), good.end() - sizeof(float)));
+    CHECK(rejects<float>());
+    write_bytes(std::vector<char>(good.begin(), good.begin() + sizeof(TensorFileHeader)));
+    CHECK(rejects<float>());
+    write_bytes({});
+    CHECK(rejects<float>());
+}
+
+void check_missing(){
+    std::remove(path.c_str());
+    bool threw = false;
+    try {
+        MappedTensor<float> mapped(path);
+    } catch (const std::runtime_error&){
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+} // namespace
+
+int main(){
+    set_random_seed(9);
+    check_round_trip<float>(37, 5);
+    check_round_trip<double>(4, 17);
+    check_round_trip<float>(0, 3);
+    check_malformed();
+    check_missing();
+    std::remove(path.c_str());
+    return test::result();
+}